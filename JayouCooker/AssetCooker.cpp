@@ -0,0 +1,391 @@
+//
+// AssetCooker.cpp
+//
+
+#include "AssetCooker.h"
+#include "Core/Common/AssimpImporter.h"
+#include "Core/Common/TextureImporter.h"
+#include "Core/Common/MeshCache.h"
+#include "Core/Common/VirtualFileSystem.h"
+#include "Core/Common/FileManager.h"
+#include "Core/Common/ThreadManager.h"
+
+#include <experimental/filesystem>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <unordered_set>
+
+namespace fs = std::experimental::filesystem;
+
+using namespace Cooker;
+using namespace Core;
+using namespace Utility;
+using namespace WinUtility::FileManager;
+
+const char* AssetCooker::ManifestName = "Cooker.manifest";
+
+namespace
+{
+	// Everything but the source that changes what a model is cooked into.
+	uint64 GetModelSettings(const ImportGeoDesc& InGeoDesc)
+	{
+		const MeshCacheKey key = MeshCache::MakeKey(InGeoDesc, 0, 0);
+		const uint32 settings[] = { MeshCache::Version, key.PPSFlags, key.ImportFlags };
+		return HashMemory(settings, sizeof(settings));
+	}
+
+	uint64 GetTextureSettings(bool bInIsHDR)
+	{
+		const uint32 settings[] = { TextureImporter::CookedVersion, bInIsHDR ? 1u : 0u };
+		return HashMemory(settings, sizeof(settings));
+	}
+}
+
+AssetCooker::AssetCooker(const std::string& InAssetDir) :
+	m_assetDir(fs::path(InAssetDir).generic_string())
+{
+	// Names are what follows the directory and a separator.
+	while (m_assetDir.size() > 1 && m_assetDir.back() == '/')
+	{
+		m_assetDir.pop_back();
+	}
+}
+
+CookStats AssetCooker::Cook(bool bInForce /*= false*/)
+{
+	CookStats stats;
+	LoadManifest();
+
+	// Every source the engine imports.
+	std::vector<Asset> assets;
+	std::vector<std::string> skipped;
+	std::error_code error;
+	for (fs::recursive_directory_iterator it(m_assetDir, error), end; !error && it != end; it.increment(error))
+	{
+		if (!fs::is_regular_file(it->status()))
+			continue;
+
+		ESupportFileType fileType = SF_Unknown;
+		FileUtil::GetFileTypeFromPathW(it->path().wstring(), fileType);
+		if (fileType != SF_AssimpModel && fileType != SF_StdImage)
+			continue;
+
+		Asset asset;
+		asset.Path = it->path().generic_string();
+		asset.Name = asset.Path.substr(m_assetDir.size() + 1);
+
+#ifdef JAYOU_NO_ASSIMP
+		// Built without Assimp, models keep what they were cooked into last time.
+		if (fileType == SF_AssimpModel)
+		{
+			skipped.push_back(asset.Name);
+			continue;
+		}
+#endif
+		asset.Type = fileType == SF_AssimpModel ? AT_Model : AT_Texture;
+		asset.Entry.SourceSize = (uint64)fs::file_size(it->path());
+		asset.Entry.SourceTime = (int64)fs::last_write_time(it->path()).time_since_epoch().count();
+		asset.Entry.Settings = asset.Type == AT_Model ? GetModelSettings(ImportGeoDesc()) : GetTextureSettings(false);
+		assets.push_back(asset);
+	}
+	if (error)
+	{
+		printf("[Cooker] Can not read %s: %s\n", m_assetDir.c_str(), error.message().c_str());
+		return stats;
+	}
+
+	// Sources gone since the last cook take their outputs with them.
+	std::unordered_set<std::string> names(skipped.begin(), skipped.end());
+	for (const auto& asset : assets)
+	{
+		names.insert(asset.Name);
+	}
+	if (!skipped.empty())
+	{
+		printf("[Cooker] Built without Assimp, skipped %u models\n", (uint32)skipped.size());
+	}
+	for (auto it = m_manifest.begin(); it != m_manifest.end();)
+	{
+		if (names.count(it->first) != 0)
+		{
+			++it;
+			continue;
+		}
+
+		for (const auto& output : it->second.Outputs)
+		{
+			std::remove((m_assetDir + "/" + output).c_str());
+		}
+		printf("[Cooker] Removed %s\n", it->first.c_str());
+		it = m_manifest.erase(it);
+		stats.NumRemoved++;
+	}
+
+	// Same size, time and settings as last time, nothing to read.
+	std::vector<Asset*> dirty;
+	for (auto& asset : assets)
+	{
+		auto entry = m_manifest.find(asset.Name);
+		const bool bUnchanged = !bInForce && entry != m_manifest.end() &&
+			entry->second.SourceSize == asset.Entry.SourceSize &&
+			entry->second.SourceTime == asset.Entry.SourceTime &&
+			entry->second.Settings == asset.Entry.Settings &&
+			OutputsExist(entry->second);
+
+		if (bUnchanged)
+		{
+			stats.NumUpToDate++;
+		}
+		else
+		{
+			dirty.push_back(&asset);
+		}
+	}
+
+	// Largest first so one big source does not end up alone at the tail.
+	std::stable_sort(dirty.begin(), dirty.end(), [](const Asset* a, const Asset* b)
+	{
+		return a->Entry.SourceSize > b->Entry.SourceSize;
+	});
+
+	ThreadManager::JobSystem::Get().ParallelFor((uint32)dirty.size(), 1, [&](uint32 InBegin, uint32 InEnd)
+	{
+		for (uint32 i = InBegin; i < InEnd; ++i)
+		{
+			Asset& asset = *dirty[i];
+			if (!CookAsset(asset, bInForce))
+			{
+				printf("[Cooker] Failed %s: %s\n", asset.Name.c_str(), asset.Error.c_str());
+			}
+			else if (asset.bCooked)
+			{
+				printf("[Cooker] Cooked %s\n", asset.Name.c_str());
+			}
+		}
+	});
+
+	// A failed source keeps its old entry, it is tried again next time.
+	for (Asset* asset : dirty)
+	{
+		if (!asset->Error.empty())
+		{
+			stats.NumFailed++;
+			continue;
+		}
+
+		m_manifest[asset->Name] = asset->Entry;
+		if (asset->bCooked)
+		{
+			stats.NumCooked++;
+		}
+		else
+		{
+			stats.NumUpToDate++;
+		}
+	}
+
+	if (!SaveManifest())
+	{
+		printf("[Cooker] Can not write %s/%s\n", m_assetDir.c_str(), ManifestName);
+	}
+	return stats;
+}
+
+bool AssetCooker::CookAsset(Asset& InOutAsset, bool bInForce) const
+{
+	if (!HashFile(InOutAsset.Path, InOutAsset.Entry.SourceHash, InOutAsset.Entry.SourceSize))
+	{
+		InOutAsset.Error = "Can not read the source";
+		return false;
+	}
+
+	// Only touched, the content is what was cooked last time.
+	auto entry = m_manifest.find(InOutAsset.Name);
+	if (!bInForce && entry != m_manifest.end() &&
+		entry->second.SourceHash == InOutAsset.Entry.SourceHash &&
+		entry->second.SourceSize == InOutAsset.Entry.SourceSize &&
+		entry->second.Settings == InOutAsset.Entry.Settings &&
+		OutputsExist(entry->second))
+	{
+		InOutAsset.Entry.Outputs = entry->second.Outputs;
+		return true;
+	}
+
+	InOutAsset.bCooked = InOutAsset.Type == AT_Model ? CookModel(InOutAsset) : CookTexture(InOutAsset);
+	return InOutAsset.bCooked;
+}
+
+bool AssetCooker::CookModel(Asset& InOutAsset) const
+{
+#ifdef JAYOU_NO_ASSIMP
+	InOutAsset.Error = "Built without Assimp";
+	return false;
+#else
+	ImportGeoDesc desc;
+	desc.Name = fs::path(InOutAsset.Path).stem().string();
+	desc.PathName = InOutAsset.Path;
+
+	AssimpImporter importer;
+	if (!importer.Import(desc))
+	{
+		InOutAsset.Error = importer.GetLastError();
+		return false;
+	}
+
+	// The picking structures too, as GWorld::AddRenderItem builds them next to an import.
+	const std::unordered_map<std::string, Geometry> geos = importer.TakeGeometries();
+	std::unordered_map<std::string, TriangleBVH> bvhs;
+	std::vector<const Geometry*> bvhGeos;
+	std::vector<TriangleBVH*> bvhTargets;
+	for (const auto& pair : geos)
+	{
+		bvhGeos.push_back(&pair.second);
+		bvhTargets.push_back(&bvhs[pair.first]);
+	}
+
+	ThreadManager::JobSystem::Get().ParallelFor((uint32)bvhGeos.size(), 1, [&](uint32 InBegin, uint32 InEnd)
+	{
+		for (uint32 i = InBegin; i < InEnd; ++i)
+		{
+			bvhTargets[i]->Build(bvhGeos[i]->Data.Vertices, bvhGeos[i]->Data.Indices32);
+		}
+	});
+
+	const std::string output = MeshCache::GetCachePath(InOutAsset.Path);
+	const MeshCacheKey key = MeshCache::MakeKey(desc, InOutAsset.Entry.SourceHash, InOutAsset.Entry.SourceSize);
+	if (!MeshCache::Save(output, key, geos, importer.GetNodes(), bvhs))
+	{
+		InOutAsset.Error = "Can not write " + output;
+		return false;
+	}
+
+	InOutAsset.Entry.Outputs = { MeshCache::GetCachePath(InOutAsset.Name) };
+	return true;
+#endif
+}
+
+bool AssetCooker::CookTexture(Asset& InOutAsset) const
+{
+	Texture texture;
+	texture.Data = nullptr;
+	texture.PathName = InOutAsset.Path;
+	texture.bIsHDR = false;
+
+	TextureImporter importer;
+	if (!importer.LoadTexture(&texture))
+	{
+		InOutAsset.Error = importer.GetLastError();
+		return false;
+	}
+
+	const std::string output = TextureImporter::GetCookedPath(InOutAsset.Path);
+	if (!TextureImporter::SaveCooked(output, InOutAsset.Entry.SourceHash, InOutAsset.Entry.SourceSize, texture))
+	{
+		InOutAsset.Error = "Can not write " + output;
+		return false;
+	}
+
+	InOutAsset.Entry.Outputs = { TextureImporter::GetCookedPath(InOutAsset.Name) };
+	return true;
+}
+
+bool AssetCooker::Pack(bool bInCompress, std::string& OutPakPath) const
+{
+	// Sources too, the caches are keyed by their hash.
+	std::vector<std::string> files;
+	std::error_code error;
+	for (fs::recursive_directory_iterator it(m_assetDir, error), end; !error && it != end; it.increment(error))
+	{
+		if (!fs::is_regular_file(it->status()))
+			continue;
+
+		const std::string name = it->path().generic_string().substr(m_assetDir.size() + 1);
+		if (name != ManifestName && it->path().extension() != ".tmp")
+		{
+			files.push_back(name);
+		}
+	}
+	if (error)
+	{
+		printf("[Cooker] Can not read %s: %s\n", m_assetDir.c_str(), error.message().c_str());
+		return false;
+	}
+
+	OutPakPath = m_assetDir + ".pak";
+	std::string buildError;
+	if (!PakArchive::Build(OutPakPath, m_assetDir, files, bInCompress, buildError))
+	{
+		printf("[Cooker] Can not pack %s: %s\n", OutPakPath.c_str(), buildError.c_str());
+		return false;
+	}
+	return true;
+}
+
+bool AssetCooker::OutputsExist(const ManifestEntry& InEntry) const
+{
+	for (const auto& output : InEntry.Outputs)
+	{
+		if (!fs::exists(m_assetDir + "/" + output))
+			return false;
+	}
+	return !InEntry.Outputs.empty();
+}
+
+// One source per line: name, size, time, hash, settings and the outputs, tab separated.
+void AssetCooker::LoadManifest()
+{
+	m_manifest.clear();
+
+	std::ifstream file(m_assetDir + "/" + ManifestName);
+	std::string line;
+	while (std::getline(file, line))
+	{
+		std::vector<std::string> fields;
+		std::istringstream stream(line);
+		for (std::string field; std::getline(stream, field, '\t');)
+		{
+			fields.push_back(field);
+		}
+		if (fields.size() < 5)
+			continue;
+
+		// A damaged line only costs a cook of its source.
+		ManifestEntry entry;
+		try
+		{
+			entry.SourceSize = std::stoull(fields[1]);
+			entry.SourceTime = std::stoll(fields[2]);
+			entry.SourceHash = std::stoull(fields[3], nullptr, 16);
+			entry.Settings = std::stoull(fields[4], nullptr, 16);
+		}
+		catch (const std::exception&)
+		{
+			continue;
+		}
+		entry.Outputs.assign(fields.begin() + 5, fields.end());
+		m_manifest[fields[0]] = entry;
+	}
+}
+
+bool AssetCooker::SaveManifest() const
+{
+	std::ofstream file(m_assetDir + "/" + ManifestName, std::ios::trunc);
+	for (const auto& pair : m_manifest)
+	{
+		const ManifestEntry& entry = pair.second;
+
+		char numbers[128] = {};
+		snprintf(numbers, sizeof(numbers), "%llu\t%lld\t%016llx\t%016llx",
+			(unsigned long long)entry.SourceSize, (long long)entry.SourceTime,
+			(unsigned long long)entry.SourceHash, (unsigned long long)entry.Settings);
+
+		file << pair.first << '\t' << numbers;
+		for (const auto& output : entry.Outputs)
+		{
+			file << '\t' << output;
+		}
+		file << '\n';
+	}
+	return file.good();
+}
@@ -0,0 +1,85 @@
+//
+// AssetCooker.h
+//
+
+#pragma once
+
+#include "Core/Common/TypeDef.h"
+
+namespace Cooker
+{
+	struct CookStats
+	{
+		uint32 NumCooked = 0;
+		uint32 NumUpToDate = 0;
+		uint32 NumFailed = 0;
+		uint32 NumRemoved = 0; // Sources gone since the last cook, their outputs were deleted.
+	};
+
+	///<summary>
+	/// Cooks the models and textures under an asset directory into what the engine loads without converting anything,
+	/// .jmesh (see Core::MeshCache) and .jtex (see Utility::TextureImporter::SaveCooked), written next to their sources.
+	/// Cooker.manifest in the directory keeps size, write time and hash of every source and the outputs it was cooked
+	/// into. A source whose size and time did not change is not even read again, one that was only touched is hashed
+	/// and left alone. Sources are cooked in parallel on the job system, largest first.
+	///</summary>
+	class AssetCooker
+	{
+	public:
+
+		static const char* ManifestName;
+
+		explicit AssetCooker(const std::string& InAssetDir);
+
+		// bInForce cooks every source, whatever the manifest says.
+		CookStats Cook(bool bInForce = false);
+
+		///<summary>
+		/// Packs everything under the directory, sources and what they were cooked into, into the directory path with
+		/// .pak appended, which the engine mounts in place of the directory (see Utility::VirtualFileSystem).
+		///</summary>
+		bool Pack(bool bInCompress, std::string& OutPakPath) const;
+
+	private:
+
+		enum EAssetType
+		{
+			AT_Model,
+			AT_Texture
+		};
+
+		struct ManifestEntry
+		{
+			uint64                   SourceSize = 0;
+			int64                    SourceTime = 0;
+			uint64                   SourceHash = 0;
+			uint64                   Settings = 0; // Hash of the import settings and the output format versions.
+			std::vector<std::string> Outputs;      // Relative to the asset directory.
+		};
+
+		struct Asset
+		{
+			std::string   Path; // As found under the asset directory.
+			std::string   Name; // Relative to the asset directory, the manifest key.
+			EAssetType    Type = AT_Model;
+			ManifestEntry Entry;
+			bool          bCooked = false;
+			std::string   Error;
+		};
+
+		void LoadManifest();
+		bool SaveManifest() const;
+
+		bool OutputsExist(const ManifestEntry& InEntry) const;
+
+		// Hashes the source and cooks it unless the manifest already has that content. False on failure, with Error set.
+		bool CookAsset(Asset& InOutAsset, bool bInForce) const;
+		bool CookModel(Asset& InOutAsset) const;
+		bool CookTexture(Asset& InOutAsset) const;
+
+		std::string                          m_assetDir;
+
+		// By source name, ordered so the manifest comes out the same for the same assets.
+		std::map<std::string, ManifestEntry> m_manifest;
+	};
+}
@@ -0,0 +1,67 @@
+//
+// JayouCooker.cpp
+//
+
+#include "AssetCooker.h"
+#include "Core/Common/ThreadManager.h"
+
+#include <chrono>
+#include <iostream>
+
+using namespace Cooker;
+
+int main(int argc, char* argv[])
+{
+	std::string assetDir;
+	bool bForce = false;
+	bool bPack = false;
+	bool bCompress = false;
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string arg = argv[i];
+		if (arg == "-f" || arg == "--force")
+		{
+			bForce = true;
+		}
+		else if (arg == "-p" || arg == "--pak")
+		{
+			bPack = true;
+		}
+		else if (arg == "-c" || arg == "--compress")
+		{
+			bPack = true;
+			bCompress = true;
+		}
+		else
+		{
+			assetDir = arg;
+		}
+	}
+
+	if (assetDir.empty())
+	{
+		std::cout << "usage: JayouCooker <asset directory> [--force] [--pak] [--compress]" << std::endl;
+		std::cout << "Cooks the models and textures under the directory into .jmesh/.jtex next to them, only the changed ones unless --force." << std::endl;
+		std::cout << "--pak then packs the directory into <asset directory>.pak, --compress does so with the entries compressed." << std::endl;
+		return 1;
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+
+	AssetCooker cooker(assetDir);
+	const CookStats stats = cooker.Cook(bForce);
+
+	std::string pakPath;
+	const bool bPacked = bPack && stats.NumFailed == 0 && cooker.Pack(bCompress, pakPath);
+
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::cout << stats.NumCooked << " cooked, " << stats.NumUpToDate << " up to date, " << stats.NumFailed << " failed, "
+		<< stats.NumRemoved << " removed in " << seconds << " s on "
+		<< Utility::ThreadManager::JobSystem::Get().GetNumThreads() << " threads" << std::endl;
+	if (bPacked)
+	{
+		std::cout << "Packed into " << pakPath << std::endl;
+	}
+
+	return stats.NumFailed == 0 && bPacked == bPack ? 0 : 1;
+}
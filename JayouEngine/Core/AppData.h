@@ -51,6 +51,10 @@ namespace Core
 		bool bShowBackGround = false;
 		bool bShowWireframe = false;
 		bool bShowSkySphere = false;
+		bool bEnableLOD = true;
+		float LODErrorThreshold = 1.0f; // Pixels.
+		bool bEnableFrustumCulling = true;
+		bool bEnableMeshletCulling = true;
 		bool bOptionsChanged = false;
 		std::wstring AppPath;
 		Vector4 ClearColor = { 0.608f, 0.689f, 0.730f, 1.0f };
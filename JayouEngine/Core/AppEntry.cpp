@@ -5,6 +5,9 @@
 #include "AppEntry.h"
 #include "Common/StringManager.h"
 #include "Common/InputManager.h"
+#include "Common/VertexPacker.h"
+#include "Common/VertexLayout.h"
+#include "Common/VirtualFileSystem.h"
 
 using namespace Utility;
 using namespace WinUtility;
@@ -13,6 +16,46 @@ using namespace WinUtility::InputManager;
 
 extern void ExitGame();
 
+namespace
+{
+	// Looked up every frame, interned once.
+	namespace PSONames
+	{
+		const NameId Default("Default");
+		const NameId Line("Line");
+		const NameId Wireframe("Wireframe");
+		const NameId FullscreenQuad("FullscreenQuad");
+		const NameId GBuffer("GBuffer");
+		const NameId PBR("PBR");
+		const NameId Shadow("Shadow");
+		const NameId SkySphere("SkySphere");
+		const NameId GBuffer_Packed("GBuffer_Packed");
+		const NameId Shadow_Packed("Shadow_Packed");
+		const NameId Wireframe_Packed("Wireframe_Packed");
+	}
+
+	const NameId GridName("grid");
+
+	template<typename T>
+	bool RenameInRegistry(T* InObject, const NameId& InName, std::unordered_map<NameId, std::unique_ptr<T>>& InOutRegistry)
+	{
+		if (InName == InObject->Name)
+			return true;
+		if (InName.empty() || InOutRegistry.find(InName) != InOutRegistry.end())
+			return false;
+
+		auto it = InOutRegistry.find(InObject->Name);
+		assert(it != InOutRegistry.end() && it->second.get() == InObject);
+
+		std::unique_ptr<T> object = std::move(it->second);
+		InOutRegistry.erase(it);
+		InObject->Name = InName;
+		InOutRegistry[InName] = std::move(object);
+
+		return true;
+	}
+}
+
 AppEntry::AppEntry(std::wstring appPath) noexcept(false)
 {
     m_deviceResources = std::make_unique<D3DDeviceResources>(
@@ -64,6 +107,18 @@ void AppEntry::PreInitialize(HWND window, int width, int height, std::wstring cm
 // Initialize the Direct3D resources required to run.
 void AppEntry::Initialize(HWND window, int width, int height, std::wstring cmdLine)
 {
+	// Archives next to the editor stand in for the directories they were packed from.
+	std::vector<std::wstring> paks;
+	FileUtil::WGetAllFilesUnder(m_appPath, paks, L".pak");
+	for (const auto& pak : paks)
+	{
+		const std::string pakPath = StringUtil::WStringToString(m_appPath + pak);
+		if (!VirtualFileSystem::Get().Mount(pakPath))
+		{
+			OutputDebugStringA(("[VFS] Could not mount " + pakPath + "\n").c_str());
+		}
+	}
+
 	PreInitialize(window, width, height, cmdLine);
 
 	m_appGui->GetAppData()->AppPath = m_appPath;
@@ -83,6 +138,7 @@ void AppEntry::Initialize(HWND window, int width, int height, std::wstring cmdLi
 // Executes the basic game loop.
 void AppEntry::Tick()
 {
+	FinishImports();
 	GarbageCollection();
 	HandleRebuildRenderItem();
 	HandleRenderItemStateChanged();
@@ -97,7 +153,13 @@ void AppEntry::Tick()
 	m_currFrameResource = m_frameResources[m_currFrameResourceIndex].get();
 	
 	UpdateCamera();
+	UpdateTransforms();
+	SyncRenderEntities();
+	CullRenderItems();
+	UpdateLOD();
+	CullMeshlets();
 	UpdatePerObjectCB();
+	UpdateLightClusters();
 	UpdateMainPassCB();
 	UpdateShadowPassCB();
 	UpdateLightSB();
@@ -153,9 +215,11 @@ void AppEntry::ResponseToGUIOptionChanged()
 				// Dynamic Create Resource Need WaitForGpu.
 				m_deviceResources->WaitForGpu();
 
-				m_allRItems["grid"]->NumVertices = (uint32)gridMesh.Vertices.size();
-				m_allRItems["grid"]->NumIndices = (uint32)gridMesh.Indices32.size();
-				m_deviceResources->CreateCommonGeometry<ColorVertex, uint32>(m_allRItems["grid"].get(), gridMesh.Vertices, gridMesh.Indices32);
+				m_allRItems[GridName]->NumVertices = (uint32)gridMesh.Vertices.size();
+				m_allRItems[GridName]->NumIndices = (uint32)gridMesh.Indices32.size();
+				m_allRItems[GridName]->Bounds = gridMesh.CalcBounds();
+				m_allRItems[GridName]->UpdateWorldBounds();
+				m_deviceResources->CreateCommonGeometry<ColorVertex, uint32>(m_allRItems[GridName].get(), gridMesh.Vertices, gridMesh.Indices32);
 			});
 		}
 	}
@@ -196,6 +260,9 @@ void AppEntry::UpdateMainPassCB()
 	passConstant.NumSpotLights = m_numSpotLights;
 
 	passConstant.CubeMapIndex = m_appGui->GetAppData()->CubeMapIndex;
+
+	passConstant.ClusterSliceScale = m_lightClusterBuilder.GetSliceScale();
+	passConstant.ClusterSliceBias = m_lightClusterBuilder.GetSliceBias();
 	
 	m_currFrameResource->CopyData<PassConstant>(0, passConstant);
 }
@@ -234,49 +301,105 @@ void AppEntry::UpdateShadowPassCB()
 
 void AppEntry::UpdateMaterialSB()
 {
-	for (auto& mat : m_allMaterialRefs)
+	htime_point updateStart = hclock::now();
+
+	m_numDirtyUpdates += m_materialDirtyList.Update(m_currFrameResourceIndex, [&](IObject* InObject)
+	{
+		const Material* mat = static_cast<const Material*>(InObject);
+
+		MaterialData materialData;
+		materialData.DiffuseAlbedo = mat->DiffuseAlbedo;
+		materialData.MatTransform = mat->MatTransform;
+		materialData.Roughness = mat->Roughness;
+		materialData.Metallicity = mat->Metallicity;
+		materialData.DiffuseMapIndex = mat->DiffuseMapIndex;
+		materialData.NormalMapIndex = mat->NormalMapIndex;
+		materialData.ORMMapIndex = mat->ORMMapIndex;
+
+		m_currFrameResource->CopyData<MaterialData>(mat->Index, materialData);
+	});
+
+	duration<double, std::milli> updateTime = hclock::now() - updateStart;
+	m_dirtyUpdateTime += updateTime.count();
+}
+
+void AppEntry::UpdateLightSB()
+{
+	htime_point updateStart = hclock::now();
+
+	m_numDirtyUpdates += m_lightDirtyList.Update(m_currFrameResourceIndex, [&](IObject* InObject)
 	{
-		if (mat->NumFrameDirty > 0)
+		const Light* lit = static_cast<const Light*>(InObject);
+
+		LightData lightData;
+		lightData.Position = lit->Position;
+		lightData.Strength = lit->Strength;
+		lightData.Direction = lit->Direction;
+		lightData.FalloffStart = lit->FalloffStart;
+		lightData.FalloffEnd = lit->FalloffEnd;
+		lightData.SpotPower = lit->SpotPower;
+
+		if (lit->bIsVisible == false)
 		{
-			MaterialData materialData;
-			materialData.DiffuseAlbedo = mat->DiffuseAlbedo;
-			materialData.MatTransform = mat->MatTransform;
-			materialData.Roughness = mat->Roughness;
-			materialData.Metallicity = mat->Metallicity;
-			materialData.DiffuseMapIndex = mat->DiffuseMapIndex;
-			materialData.NormalMapIndex = mat->NormalMapIndex;
-			materialData.ORMMapIndex = mat->ORMMapIndex;
-
-			m_currFrameResource->CopyData<MaterialData>(mat->Index, materialData);
-
-			mat->NumFrameDirty--;
+			lightData.Strength = XMFLOAT3(0.0f, 0.0f, 0.0f);
 		}
-	}
+
+		m_currFrameResource->CopyData<LightData>(lit->Index, lightData);
+	});
+
+	duration<double, std::milli> updateTime = hclock::now() - updateStart;
+	m_dirtyUpdateTime += updateTime.count();
 }
 
-void AppEntry::UpdateLightSB()
+void AppEntry::UpdateLightClusters()
 {
+	htime_point clusterStart = hclock::now();
+
+	m_clusterLights.clear();
+	m_dirLightIndices.clear();
 	for (auto& lit : m_allLightRefs)
 	{
-		if (lit->NumFrameDirty > 0)
+		// Every directional light is kept, the first one casts the shadow.
+		if (lit->LightType == LT_Directional)
 		{
-			LightData lightData;
-			lightData.Position = lit->Position;
-			lightData.Strength = lit->Strength;
-			lightData.Direction = lit->Direction;
-			lightData.FalloffStart = lit->FalloffStart;
-			lightData.FalloffEnd = lit->FalloffEnd;
-
-			if (lit->bIsVisible == false)
-			{
-				lightData.Strength = XMFLOAT3(0.0f, 0.0f, 0.0f);
-			}
+			m_dirLightIndices.push_back(lit->Index);
+			continue;
+		}
 
-			m_currFrameResource->CopyData<LightData>(lit->Index, lightData);
+		// Hidden lights have no strength, see UpdateLightSB.
+		if (lit->bIsVisible == false)
+			continue;
+
+		ClusterLight clusterLight;
+		clusterLight.Position = lit->Position;
+		clusterLight.Range = lit->FalloffEnd;
+		clusterLight.Direction = lit->Direction;
+		clusterLight.SpotPower = lit->SpotPower;
+		clusterLight.LightIndex = lit->Index;
+		clusterLight.bSpotLight = lit->LightType == LT_Spot;
+		m_clusterLights.push_back(clusterLight);
+	}
+
+	m_lightClusterBuilder.SetProjection(m_camera->GetProj4x4f(), m_camera->GetNearZ(), m_camera->GetFarZ());
+	const uint32 numIndices = m_lightClusterBuilder.Build(m_camera->GetView4x4f(), m_clusterLights, m_dirLightIndices);
 
-			lit->NumFrameDirty--;
+	if (numIndices > m_lightIndexCapacity)
+	{
+		// Dynamic Create Resource Need WaitForGpu.
+		m_deviceResources->WaitForGpu();
+
+		m_lightIndexCapacity = std::max(numIndices, 2 * m_lightIndexCapacity);
+		for (uint32 i = 0; i < m_deviceResources->GetBackBufferCount(); ++i)
+		{
+			m_frameResources[i]->ResizeBuffer<LightIndexData>(m_lightIndexCapacity);
 		}
 	}
+
+	const std::vector<uint32>& lightIndices = m_lightClusterBuilder.GetLightIndices();
+	m_currFrameResource->CopyData<LightClusterData>(0, m_lightClusterBuilder.GetClusters().data(), LightClusterBuilder::NumClusters);
+	m_currFrameResource->CopyData<LightIndexData>(0, reinterpret_cast<const LightIndexData*>(lightIndices.data()), numIndices);
+
+	m_lightClusterTime = duration<double, std::milli>(hclock::now() - clusterStart).count();
 }
 
 void AppEntry::UpdateCamera()
@@ -324,20 +447,224 @@ void AppEntry::UpdateCamera()
 	}
 }
 
-void AppEntry::UpdatePerObjectCB()
+void AppEntry::CullRenderItems()
 {
-	// PerObject Constant Buffer (Opaque).
-	for (auto& ri : m_renderItemLayer[RenderLayer::All])
+	const uint32 numItems = m_renderEntities.GetNumEntities();
+	const std::vector<uint8>& flags = m_renderEntities.GetFlags();
+	const std::vector<BoundingBox>& worldBounds = m_renderEntities.GetWorldBounds();
+
+	// Culler slots are entity indices, only refresh the ones whose bounds changed.
+	if (m_frustumCuller.GetNumBoxes() != numItems)
+	{
+		m_frustumCuller.Resize(numItems);
+	}
+	for (uint32 i = 0; i < numItems; ++i)
 	{
-		if (ri->NumFrameDirty > 0)
+		if (flags[i] & RenderEntityStore::EF_BoundsChanged)
 		{
-			ObjectConstant objectConstant;
-			objectConstant.World = ri->TransFormMatrix;
-			objectConstant.InvTWorld = Math::Transpose(Math::Invert(objectConstant.World));
-			objectConstant.MaterialIndex = ri->MaterialIndex;
-			m_currFrameResource->CopyData<ObjectConstant>(ri->Index, objectConstant);
+			m_frustumCuller.SetBounds(i, worldBounds[i]);
+			m_renderEntities.ClearFlag(i, RenderEntityStore::EF_BoundsChanged);
+		}
+	}
+
+	htime_point cullStart = hclock::now();
+
+	const bool bEnableFrustumCulling = m_appGui->GetAppData()->bEnableFrustumCulling;
 
-			ri->NumFrameDirty--;
+	// Only the first "main" light casts a shadow, see UpdateCamera.
+	const bool bDirLightShadow = !m_allLightRefs.empty() && m_allLightRefs[0]->LightType == LT_Directional;
+
+	if (bEnableFrustumCulling)
+	{
+		XMFLOAT4 frustumPlanes[6];
+		FrustumCuller::ExtractPlanes(XMMatrixMultiply(m_camera->GetView(), m_camera->GetProj()), frustumPlanes);
+		m_frustumCuller.Cull(frustumPlanes, 6, m_visibleIndices);
+
+		if (bDirLightShadow)
+		{
+			XMFLOAT4 lightPlanes[6];
+			FrustumCuller::ExtractPlanes(m_dirLightCamera->GetViewProj(), lightPlanes);
+
+			XMFLOAT3 lightDir;
+			XMStoreFloat3(&lightDir, XMVector3Normalize(XMLoadFloat3(&m_allLightRefs[0]->Direction)));
+
+			// No shadow reaches past the far side of the light frustum.
+			const float sweepLength = m_dirLightCamera->GetFarZ() - m_dirLightCamera->GetNearZ();
+			m_frustumCuller.CullShadowCasters(lightPlanes, frustumPlanes, lightDir, sweepLength, m_shadowCasterIndices);
+		}
+	}
+
+	if (!bEnableFrustumCulling)
+	{
+		m_visibleIndices.resize(numItems);
+		for (uint32 i = 0; i < numItems; ++i)
+			m_visibleIndices[i] = i;
+	}
+	if (!bEnableFrustumCulling || !bDirLightShadow)
+	{
+		m_shadowCasterIndices = m_visibleIndices;
+	}
+
+	// Line and sky entities sit in the culler as well, only RenderLayer::Opaque is drawn from these lists.
+	const std::vector<RenderItem*>& owners = m_renderEntities.GetOwners();
+	m_visibleEntities.clear();
+	m_visibleRenderItems.clear();
+	for (uint32 index : m_visibleIndices)
+	{
+		if (flags[index] & RenderEntityStore::EF_Opaque)
+		{
+			m_visibleEntities.push_back(index);
+			m_visibleRenderItems.push_back(owners[index]);
+		}
+	}
+
+	const uint8 shadowCasterFlags = RenderEntityStore::EF_Opaque | RenderEntityStore::EF_CastShadow;
+	m_shadowCasterEntities.clear();
+	for (uint32 index : m_shadowCasterIndices)
+	{
+		if ((flags[index] & shadowCasterFlags) == shadowCasterFlags)
+			m_shadowCasterEntities.push_back(index);
+	}
+
+	m_cullTime = duration<double, std::milli>(hclock::now() - cullStart).count();
+}
+
+void AppEntry::UpdateLOD()
+{
+	const bool  bEnableLOD = m_appGui->GetAppData()->bEnableLOD;
+	const float errorThreshold = m_appGui->GetAppData()->LODErrorThreshold;
+	const float fovY = m_camera->GetFovY();
+	const XMVECTOR eyePos = m_camera->GetPosition();
+
+	// Orthographic views keep a constant pixel size per unit, no point to switch there.
+	const bool bSelectLOD = bEnableLOD && m_camera->GetProjType() == CP_PerspectiveProj;
+
+	const std::vector<uint8>& flags = m_renderEntities.GetFlags();
+	const std::vector<BoundingSphere>& worldSpheres = m_renderEntities.GetWorldSpheres();
+	const std::vector<float>& worldScales = m_renderEntities.GetWorldScales();
+	const std::vector<const MeshLOD*>& lods = m_renderEntities.GetLODs();
+	const std::vector<uint32>& numLODs = m_renderEntities.GetNumLODs();
+
+	for (uint32 index = 0; index < m_renderEntities.GetNumEntities(); ++index)
+	{
+		uint32 lodIndex = 0;
+		if (bSelectLOD && numLODs[index] > 0 && (flags[index] & RenderEntityStore::EF_Opaque))
+		{
+			const BoundingSphere& worldSphere = worldSpheres[index];
+			const float distance = XMVectorGetX(XMVector3Length(XMLoadFloat3(&worldSphere.Center) - eyePos)) - worldSphere.Radius;
+
+			// Inside the bounds always gets the full mesh.
+			if (distance > 0.0f)
+			{
+				// Coarsest level whose projected error stays under the threshold. The error is in object space, the world
+				// scale is the largest axis scale so a non uniform scale never makes it look smaller than it is.
+				for (uint32 i = numLODs[index]; i > 0; --i)
+				{
+					float screenError = MeshSimplifier::ComputeScreenSpaceError(lods[index][i - 1].Error * worldScales[index], distance, fovY, (float)m_height);
+					if (screenError <= errorThreshold)
+					{
+						lodIndex = i;
+						break;
+					}
+				}
+			}
+		}
+
+		m_renderEntities.SetLODIndex(index, lodIndex);
+	}
+}
+
+void AppEntry::CullMeshlets()
+{
+	const bool bEnableMeshletCulling = m_appGui->GetAppData()->bEnableMeshletCulling;
+
+	// BoundingFrustum::CreateFromMatrix only understands perspective projections.
+	const bool bPerspective = m_camera->GetProjType() == CP_PerspectiveProj;
+
+	BoundingFrustum viewFrustum;
+	BoundingFrustum::CreateFromMatrix(viewFrustum, m_camera->GetProj());
+
+	XMMATRIX view = m_camera->GetView();
+	XMMATRIX invView = XMMatrixInverse(&XMMatrixDeterminant(view), view);
+
+	// Culled items are not drawn by the main view, their meshlet lists are left as they are.
+	for (auto& ri : m_visibleRenderItems)
+	{
+		ri->bMeshletCulled = false;
+		ri->VisibleMeshlets.clear();
+
+		if (!bEnableMeshletCulling || !bPerspective || ri->LODIndex > 0 || ri->RenderData == nullptr || ri->RenderData->Meshlets.empty())
+			continue;
+
+		// Frustum transform and normal cones only hold under uniform scale, that of the world matrix: the item's own
+		// Scale says nothing about its parents.
+		XMMATRIX W = ri->TransFormMatrix;
+		if (!MeshletBuilder::HasUniformScale(W))
+			continue;
+
+		// Cull in object space, one frustum transform per item instead of one bounds transform per meshlet.
+		XMMATRIX invWorld = XMMatrixInverse(&XMMatrixDeterminant(W), W);
+		XMMATRIX viewToLocal = XMMatrixMultiply(invView, invWorld);
+
+		BoundingFrustum localFrustum;
+		viewFrustum.Transform(localFrustum, viewToLocal);
+
+		XMFLOAT3 localEyePos;
+		XMStoreFloat3(&localEyePos, XMVector3TransformCoord(XMVectorZero(), viewToLocal));
+
+		const auto& meshlets = ri->RenderData->Meshlets;
+		for (uint32 i = 0; i < (uint32)meshlets.size(); ++i)
+		{
+			if (localFrustum.Contains(meshlets[i].Bounds.SphereBounds) == DISJOINT)
+				continue;
+
+			if (MeshletBuilder::IsBackfacing(meshlets[i], localEyePos))
+				continue;
+
+			ri->VisibleMeshlets.push_back(i);
+		}
+
+		ri->bMeshletCulled = true;
+	}
+}
+
+void AppEntry::UpdatePerObjectCB()
+{
+	htime_point updateStart = hclock::now();
+
+	// PerObject Constant Buffer, the dirty items only. Material & light ones follow in UpdateMaterialSB & UpdateLightSB.
+	m_numDirtyUpdates = m_renderItemDirtyList.Update(m_currFrameResourceIndex, [&](IObject* InObject)
+	{
+		const RenderItem* ri = static_cast<const RenderItem*>(InObject);
+
+		ObjectConstant objectConstant;
+		objectConstant.World = ri->TransFormMatrix;
+		objectConstant.InvTWorld = Math::AffineInverseTranspose(objectConstant.World);
+		objectConstant.MaterialIndex = ri->MaterialIndex;
+		objectConstant.PositionScale = ri->RenderData->PositionScale;
+		objectConstant.PositionBias = ri->RenderData->PositionBias;
+		m_currFrameResource->CopyData<ObjectConstant>(ri->Index, objectConstant);
+
+		InstanceData instanceData;
+		instanceData.World = objectConstant.World;
+		instanceData.InvTWorld = objectConstant.InvTWorld;
+		m_currFrameResource->CopyData<InstanceData>(ri->Index, instanceData);
+	});
+
+	duration<double, std::milli> updateTime = hclock::now() - updateStart;
+	m_dirtyUpdateTime = updateTime.count();
+
+	// Each instanced pass (GBuffer, wireframe, shadow) draws its items once at most.
+	const uint32 maxInstances = 2 * (uint32)m_visibleEntities.size() + (uint32)m_shadowCasterEntities.size();
+	if (maxInstances > m_instanceIndexCapacity)
+	{
+		// Dynamic Create Resource Need WaitForGpu.
+		m_deviceResources->WaitForGpu();
+
+		m_instanceIndexCapacity = std::max(maxInstances, 2 * m_instanceIndexCapacity);
+		for (uint32 i = 0; i < m_deviceResources->GetBackBufferCount(); ++i)
+		{
+			m_frameResources[i]->ResizeBuffer<InstanceIndexData>(m_instanceIndexCapacity);
 		}
 	}
 }
@@ -372,11 +699,21 @@ void AppEntry::Render()
 		commandList->SetDescriptorHeaps(_countof(descriptorHeaps), descriptorHeaps);		
 
 		commandList->SetGraphicsRootSignature(m_rootSIGs["Main"].Get());
+
+		m_numDrawPackets = 0;
+		m_numDrawInstances = 0;
+		m_numBufferBindings = 0;
+		m_drawSortTime = 0.0;
+		m_instanceBatcher.Reset();
 		
 		if (!m_allLights.empty())
 		{
 			commandList->SetGraphicsRootShaderResourceView(2, m_currFrameResource->GetBufferGPUVirtualAddress<LightData>());
 		}
+		commandList->SetGraphicsRootShaderResourceView(7, m_currFrameResource->GetBufferGPUVirtualAddress<LightClusterData>());
+		commandList->SetGraphicsRootShaderResourceView(8, m_currFrameResource->GetBufferGPUVirtualAddress<LightIndexData>());
+		commandList->SetGraphicsRootShaderResourceView(9, m_currFrameResource->GetBufferGPUVirtualAddress<InstanceData>());
+		commandList->SetGraphicsRootShaderResourceView(10, m_currFrameResource->GetBufferGPUVirtualAddress<InstanceIndexData>());
 		if (!m_allMaterials.empty())
 		{
 			commandList->SetGraphicsRootShaderResourceView(3, m_currFrameResource->GetBufferGPUVirtualAddress<MaterialData>());
@@ -394,7 +731,7 @@ void AppEntry::Render()
 
 		// GBuffer. Currently Only Support For Opaque.
 		{
-			commandList->SetPipelineState(m_PSOs["GBuffer"].Get());
+			commandList->SetPipelineState(m_PSOs[PSONames::GBuffer].Get());
 			commandList->OMSetRenderTargets(m_maxGBuffers, 
 				&m_deviceResources->GetOffscreenRenderTargetView(0), true, 
 				&m_deviceResources->GetActiveDepthStencilView());
@@ -405,7 +742,7 @@ void AppEntry::Render()
 				D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, 
 				DefaultClearValue::Depth, DefaultClearValue::Stencil, 0, nullptr);
 			
-			DrawRenderItem(m_renderItemLayer[RenderLayer::Opaque]);
+			DrawRenderEntities(m_visibleEntities, true, m_PSOs[PSONames::GBuffer_Packed].Get(), false, m_camera.get(), RenderLayer::Opaque, true);
 
 			for (uint32 i = 0; i < m_maxGBuffers; ++i)
 				commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(
@@ -422,7 +759,7 @@ void AppEntry::Render()
 		}
 
 		// Deferred Rendering.
-		commandList->SetPipelineState(m_PSOs["PBR"].Get());
+		commandList->SetPipelineState(m_PSOs[PSONames::PBR].Get());
 		DrawFullscreenQuad(commandList);
 
 		// Forward Rendering Here.
@@ -436,17 +773,17 @@ void AppEntry::Render()
 
 		if (m_appGui->GetAppData()->bShowGrid)
 		{
-			commandList->SetPipelineState(m_PSOs["Line"].Get());
+			commandList->SetPipelineState(m_PSOs[PSONames::Line].Get());
 			DrawRenderItem(m_renderItemLayer[RenderLayer::Line]);
 		}
 
 		if (m_appGui->GetAppData()->bShowWireframe)
 		{
-			commandList->SetPipelineState(m_PSOs["Wireframe"].Get());
+			commandList->SetPipelineState(m_PSOs[PSONames::Wireframe].Get());
 			for (auto& ri : m_renderItemLayer[RenderLayer::Opaque])
 				ri->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_LINELIST;
 
-			DrawRenderItem(m_renderItemLayer[RenderLayer::Opaque]);
+			DrawRenderEntities(m_visibleEntities, false, m_PSOs[PSONames::Wireframe_Packed].Get(), false, m_camera.get(), RenderLayer::Opaque, true);
 
 			for (auto& ri : m_renderItemLayer[RenderLayer::Opaque])
 				ri->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
@@ -454,13 +791,13 @@ void AppEntry::Render()
 
 		if (m_appGui->GetAppData()->bShowBackGround)
 		{
-			commandList->SetPipelineState(m_PSOs["FullscreenQuad"].Get());
+			commandList->SetPipelineState(m_PSOs[PSONames::FullscreenQuad].Get());
 			DrawFullscreenQuad(commandList);
 		}
 
 		if (m_appGui->GetAppData()->bShowSkySphere)
 		{
-			commandList->SetPipelineState(m_PSOs["SkySphere"].Get());
+			commandList->SetPipelineState(m_PSOs[PSONames::SkySphere].Get());
 			DrawRenderItem(m_renderItemLayer[RenderLayer::SkySphere]);
 		}
 
@@ -479,23 +816,137 @@ void AppEntry::Render()
     PIXEndEvent(m_deviceResources->GetCommandQueue());
 }
 
-void AppEntry::DrawRenderItem(std::vector<RenderItem*>& renderItemLayer)
+void AppEntry::DrawRenderItem(std::vector<RenderItem*>& renderItemLayer, bool bMeshletCulling, ID3D12PipelineState* InPackedPSO, bool bPositionOnly,
+	const Camera* InSortCamera, RenderLayer InLayer, bool bInstancing)
+{
+	m_drawEntities.clear();
+	for (RenderItem* ri : renderItemLayer)
+	{
+		if (ri->Entity != RenderEntityStore::NullEntity)
+			m_drawEntities.push_back(m_renderEntities.GetIndex(ri->Entity));
+	}
+
+	DrawRenderEntities(m_drawEntities, bMeshletCulling, InPackedPSO, bPositionOnly, InSortCamera, InLayer, bInstancing);
+}
+
+void AppEntry::DrawRenderEntities(const std::vector<uint32>& InEntities, bool bMeshletCulling, ID3D12PipelineState* InPackedPSO, bool bPositionOnly,
+	const Camera* InSortCamera, RenderLayer InLayer, bool bInstancing)
 {
 	auto commandList = m_deviceResources->GetCommandList();
 
-	for (auto& ri : renderItemLayer)
+	htime_point sortStart = hclock::now();
+
+	assert(InEntities.size() <= DrawPacketSorter::MaxPackets);
+
+	XMFLOAT4X4 view;
+	XMStoreFloat4x4(&view, XMMatrixIdentity());
+	if (InSortCamera != nullptr)
+		view = InSortCamera->GetView4x4f();
+
+	const std::vector<RenderItem*>& owners = m_renderEntities.GetOwners();
+	const std::vector<uint8>& flags = m_renderEntities.GetFlags();
+	const std::vector<BoundingBox>& worldBounds = m_renderEntities.GetWorldBounds();
+	const std::vector<D3DRenderData*>& renderData = m_renderEntities.GetRenderData();
+	const std::vector<uint32>& objectIndices = m_renderEntities.GetObjectIndices();
+	const std::vector<uint32>& materialIndices = m_renderEntities.GetMaterialIndices();
+	const std::vector<uint32>& lodIndices = m_renderEntities.GetLODIndices();
+
+	// One packet per entity. Pipeline 0 is the PSO already set, packed items need the packed input layout.
+	m_drawKeys.clear();
+	for (uint32 i = 0; i < (uint32)InEntities.size(); ++i)
 	{
-		if (ri->bIsVisible == false)
+		const uint32 e = InEntities[i];
+		if ((flags[e] & RenderEntityStore::EF_Visible) == 0)
+			continue;
+
+		const uint32 pipeline = (flags[e] & RenderEntityStore::EF_PackedVertices) ? 1 : 0;
+		if (pipeline == 1 && InPackedPSO == nullptr)
 			continue;
 
-		m_deviceResources->DrawRenderItem(ri, [&]()
+		const XMFLOAT3& center = worldBounds[e].Center;
+		const float viewDepth = InSortCamera == nullptr ? 0.0f : DrawPacketSorter::NormalizeDepth(
+			center.x * view._13 + center.y * view._23 + center.z * view._33 + view._43, InSortCamera->GetNearZ(), InSortCamera->GetFarZ());
+
+		if (InLayer == RenderLayer::Transparent)
+		{
+			m_drawKeys.push_back(DrawPacketSorter::MakeTransparentKey(InLayer, pipeline, viewDepth, materialIndices[e], i));
+		}
+		else
+		{
+			// Items sharing a D3DRenderData share the geometry id, so their bindings are made once.
+			const uint32 geometry = (uint32)(reinterpret_cast<uintptr_t>(renderData[e]) >> 4);
+			m_drawKeys.push_back(DrawPacketSorter::MakeOpaqueKey(InLayer, pipeline, viewDepth, geometry, materialIndices[e], i));
+		}
+	}
+
+	m_drawPacketSorter.Sort(m_drawKeys);
+
+	m_drawSortTime += duration<double, std::milli>(hclock::now() - sortStart).count();
+
+	DrawStreamState drawState;
+	uint32 currentPipeline = 0;
+
+	// Draws InNumInstances items from the sorted key InKeyIndex on, the first item binds the per object data.
+	auto drawPacket = [&](uint32 InKeyIndex, uint32 InInstanceOffset, uint32 InNumInstances)
+	{
+		const uint64 key = m_drawKeys[InKeyIndex];
+		if (DrawPacketSorter::GetPipeline(key) != currentPipeline)
+		{
+			currentPipeline = DrawPacketSorter::GetPipeline(key);
+			commandList->SetPipelineState(InPackedPSO);
+		}
+
+		const uint32 e = InEntities[DrawPacketSorter::GetPacket(key)];
+		m_deviceResources->DrawRenderItem(owners[e], [&]()
 		{
 			UINT objectCBufferByteSize = CalcConstantBufferByteSize(sizeof(ObjectConstant));
 			D3D12_GPU_VIRTUAL_ADDRESS objectCBufferAddress = m_currFrameResource->GetBufferGPUVirtualAddress<ObjectConstant>()
-				+ ri->Index * objectCBufferByteSize;
+				+ objectIndices[e] * objectCBufferByteSize;
 			commandList->SetGraphicsRootConstantBufferView(0, objectCBufferAddress);
-		});
+
+			if (bInstancing)
+				commandList->SetGraphicsRoot32BitConstant(11, InInstanceOffset, 0);
+		}, bMeshletCulling, bPositionOnly, &drawState, InNumInstances);
+	};
+
+	if (!bInstancing)
+	{
+		for (uint32 i = 0; i < (uint32)m_drawKeys.size(); ++i)
+			drawPacket(i, 0, 1);
 	}
+	else
+	{
+		// Neighbours in draw order that share geometry, material and LOD become one draw,
+		// so the object constants of the first item hold for the whole batch.
+		m_instanceBatcher.BeginPass();
+		for (uint32 i = 0; i < (uint32)m_drawKeys.size(); ++i)
+		{
+			const uint32 e = InEntities[DrawPacketSorter::GetPacket(m_drawKeys[i])];
+
+			InstanceBatchKey batchKey;
+			batchKey.Geometry = reinterpret_cast<uintptr_t>(renderData[e]);
+			batchKey.Material = materialIndices[e];
+			batchKey.Variant = lodIndices[e] | ((uint32)owners[e]->PrimitiveType << 24);
+			// Meshlet culled items draw their own cluster lists.
+			batchKey.bCanBatch = !(bMeshletCulling && owners[e]->bMeshletCulled);
+
+			m_instanceBatcher.Add(i, batchKey, objectIndices[e]);
+		}
+
+		const uint32 passInstanceOffset = m_instanceBatcher.GetPassInstanceOffset();
+		const uint32 numPassInstances = m_instanceBatcher.GetNumPassInstances();
+		assert(passInstanceOffset + numPassInstances <= m_instanceIndexCapacity);
+
+		const uint32* instanceIndices = m_instanceBatcher.GetInstanceIndices().data() + passInstanceOffset;
+		m_currFrameResource->CopyData<InstanceIndexData>(passInstanceOffset, reinterpret_cast<const InstanceIndexData*>(instanceIndices), numPassInstances);
+
+		for (const InstanceBatch& batch : m_instanceBatcher.GetBatches())
+			drawPacket(batch.Packet, batch.InstanceOffset, batch.InstanceCount);
+	}
+
+	m_numDrawPackets += drawState.NumDraws;
+	m_numDrawInstances += drawState.NumInstances;
+	m_numBufferBindings += drawState.NumBufferBindings;
 }
 
 void AppEntry::DrawFullscreenQuad(ID3D12GraphicsCommandList* commandList)
@@ -532,9 +983,9 @@ void AppEntry::DrawSceneToShadowMap()
 
 	commandList->SetGraphicsRootConstantBufferView(1, m_currFrameResource->GetBufferGPUVirtualAddress<PassConstant>() + passCBByteSize);
 
-	commandList->SetPipelineState(m_PSOs["Shadow"].Get());
+	commandList->SetPipelineState(m_PSOs[PSONames::Shadow].Get());
 
-	DrawRenderItem(m_renderItemLayer[RenderLayer::Opaque]);
+	DrawRenderEntities(m_shadowCasterEntities, false, m_PSOs[PSONames::Shadow_Packed].Get(), true, m_dirLightCamera.get(), RenderLayer::Opaque, true);
 
 	// Change back to GENERIC_READ so we can read the texture in a shader.
 	commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_shadowMap->Resource(),
@@ -557,7 +1008,7 @@ void AppEntry::DrawSceneToCubeMap()
 
 	commandList->OMSetRenderTargets(1, &m_cubeMap->Rtv(), true, nullptr);
 
-	commandList->SetPipelineState(m_PSOs["SkySphere"].Get());
+	commandList->SetPipelineState(m_PSOs[PSONames::SkySphere].Get());
 	m_deviceResources->DrawRenderItem(m_allRItems["SkySphere"].get(), [&]()
 	{
 		UINT objectCBufferByteSize = CalcConstantBufferByteSize(sizeof(ObjectConstant));
@@ -689,7 +1140,8 @@ void AppEntry::OnMouseMove(WPARAM btnState, int x, int y)
 		// Make each pixel correspond to 0.005 unit in the scene.
 		float dx = 0.005f*static_cast<float>(x - m_lastMousePos.x);
 		float dy = 0.005f*static_cast<float>(y - m_lastMousePos.y);
-		m_camera->FocusRadius(dx - dy);
+
+		m_camera->FocusRadius(dx - dy);
 	}
 
 	m_lastMousePos.x = x;
@@ -759,15 +1211,23 @@ void AppEntry::Pick(int InPosX, int InPosY)
 	XMMATRIX V = m_camera->GetView();
 	XMMATRIX invView = XMMatrixInverse(&XMMatrixDeterminant(V), V);
 
-	// Check if we picked an opaque render item.  A real app might keep a separate "picking list"
-	// of objects that can be selected.  
-	std::string tname = "";
+	// Ray definition in world space. Distances along the unnormalized direction are view space depths,
+	// which the view and object transforms below keep comparable between render items.
+	XMFLOAT3 worldOrigin;
+	XMFLOAT3 worldDirection;
+	XMStoreFloat3(&worldOrigin, XMVector3TransformCoord(XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f), invView));
+	XMStoreFloat3(&worldDirection, XMVector3TransformNormal(XMVectorSet(vx, vy, 1.0f, 0.0f), invView));
+
+	// Only the render items whose scene bounds the ray enters are tested, nearest first.
+	NameId tname;
 	float tmin0 = std::numeric_limits<float>::max();
-	for (auto& ri : m_renderItemLayer[RenderLayer::Selectable])
+	m_sceneBVH.QueryRay(worldOrigin, worldDirection, tmin0, GetRenderLayerMask(RenderLayer::Selectable), [&](IObject* InObject, float /*InEntryDistance*/)
 	{
+		RenderItem* ri = static_cast<RenderItem*>(InObject);
+
 		// Skip invisible render-items.
 		if (ri->bIsVisible == false || ri->bCanBeSelected == false)
-			continue;
+			return tmin0;
 
 		XMMATRIX W = ri->TransFormMatrix;
 		XMMATRIX invWorld = XMMatrixInverse(&XMMatrixDeterminant(W), W);
@@ -781,20 +1241,18 @@ void AppEntry::Pick(int InPosX, int InPosY)
 		rayOrigin = XMVector3TransformCoord(rayOrigin, toLocal);
 		rayDir = XMVector3TransformNormal(rayDir, toLocal);
 
-		// Make the ray direction unit length for the intersection tests.
-		rayDir = XMVector3Normalize(rayDir);
+		// Keep the local direction unnormalized, distances along it are view space depths
+		// and stay comparable between render items with different scales.
+		float rayLength = XMVectorGetX(XMVector3Length(rayDir));
+		XMVECTOR rayDirUnit = XMVectorScale(rayDir, 1.0f / rayLength);
 
-		// If we hit the bounding box of the Mesh, then we might have picked a Mesh triangle,
-		// so do the ray/triangle tests.
-		//
 		// If we did not hit the bounding box, then it is impossible that we hit 
 		// the Mesh, so do not waste effort doing ray/triangle tests.
-
 		float tdis = 0.0f;
-		if (ri->Bounds.BoxBounds.Intersects(rayOrigin, rayDir, tdis))
+		if (ri->Bounds.BoxBounds.Intersects(rayOrigin, rayDirUnit, tdis))
 		{
-			assert(DirectX::Internal::XMVector3IsUnit(rayDir));
-			if (ri->bIntersectBoundingOnly)
+			tdis /= rayLength;
+			if (ri->bIntersectBoundingOnly || ri->CachedBVH.IsEmpty())
 			{
 				if (tdis < tmin0)
 				{
@@ -802,79 +1260,26 @@ void AppEntry::Pick(int InPosX, int InPosY)
 					tname = ri->Name;
 				}
 			}
-			else
+			else if (tdis < tmin0)
 			{
-				// NOTE: For the demo, we know what to cast the vertex/index data to.  If we were mixing
-				// m_offscreenRTFormats, some metadata would be needed to figure out what to cast it to.
-				
-
-				std::uint32_t* indices32 = (std::uint32_t*)ri->RenderData->IndexBufferCPU->GetBufferPointer();
-				std::uint16_t* indices16 = (std::uint16_t*)ri->RenderData->IndexBufferCPU->GetBufferPointer();
-
-				UINT triCount = ri->NumIndices / 3;
-
-				// Find the nearest ray/triangle intersection.
-				float tmin1 = std::numeric_limits<float>::max();
-				for (UINT i = 0; i < triCount; ++i)
+				XMFLOAT3 origin;
+				XMFLOAT3 direction;
+				XMStoreFloat3(&origin, rayOrigin);
+				XMStoreFloat3(&direction, rayDir);
+
+				// Nearest triangle in front of the nearest hit so far.
+				TriangleHit hit;
+				if (ri->CachedBVH.IntersectNearest(origin, direction, hit, tmin0))
 				{
-					UINT i0;
-					UINT i1;
-					UINT i2;
-					// Indices for this triangle.
-					if (ri->RenderData->IndexFormat == DXGI_FORMAT_R32_UINT)
-					{
-						i0 = indices32[i * 3 + 0];
-						i1 = indices32[i * 3 + 1];
-						i2 = indices32[i * 3 + 2];
-					}
-					else
-					{
-						i0 = indices16[i * 3 + 0];
-						i1 = indices16[i * 3 + 1];
-						i2 = indices16[i * 3 + 2];
-					}
-
-					// Vertices for this triangle.
-					XMVECTOR v0;
-					XMVECTOR v1;
-					XMVECTOR v2;					
-					if (ri->RenderData->VertexFormat == VF_Vertex)
-					{
-						auto vertices = (Vertex*)ri->RenderData->VertexBufferCPU->GetBufferPointer();
-						v0 = XMLoadFloat3(&vertices[i0].Position);
-						v1 = XMLoadFloat3(&vertices[i1].Position);
-						v2 = XMLoadFloat3(&vertices[i2].Position);
-					}
-					else if (ri->RenderData->VertexFormat == VF_ColorVertex)
-					{
-						auto vertices = (ColorVertex*)ri->RenderData->VertexBufferCPU->GetBufferPointer();
-						v0 = XMLoadFloat3(&vertices[i0].Position);
-						v1 = XMLoadFloat3(&vertices[i1].Position);
-						v2 = XMLoadFloat3(&vertices[i2].Position);
-					}
-								
-					// We have to iterate over all the triangles in order to find the nearest intersection.
-					float t = 0.0f;
-					if (TriangleTests::Intersects(rayOrigin, rayDir, v0, v1, v2, t))
-					{
-						if (t < tmin0)
-						{
-							tmin0 = t;
-							tname = ri->Name;
-						}
-						break;
-						if (t < tmin1)
-						{
-							// This is the new nearest picked triangle.
-							tmin1 = t;
-							UINT pickedTriangle = i;
-						}
-					}
+					tmin0 = hit.Distance;
+					tname = ri->Name;
 				}
 			}
-
 		}
-	}
+
+		// Render items whose scene bounds start behind the nearest hit are skipped.
+		return tmin0;
+	});
 	
 	for (auto& ri : m_renderItemLayer[RenderLayer::Selectable])
 	{
@@ -929,7 +1334,6 @@ void AppEntry::CreateDeviceDependentResources()
 	Window window = { m_window, XMINT2(m_width, m_height) };
 	m_appGui = std::make_unique<AppGUI>(this, window, device, commandList, m_deviceResources->GetBackBufferCount());	
 
-	m_assimpImporter = std::make_unique<AssimpImporter>();
 	m_textureImporter = std::make_unique<TextureImporter>();
 
 	BuildDescriptorHeaps();
@@ -1010,8 +1414,6 @@ void AppEntry::CreateWindowSizeDependentResources()
 
 		GWorldCached(texture);
 
-		Texture::Count = 0;
-
 		bHasBeInit = true;
 	}
 	else
@@ -1052,8 +1454,6 @@ void AppEntry::CreateApplicationDependentResources()
 
 	GWorldCached(showMap);
 
-	Texture::Count = 0;
-
 #if 0
 	// CubeMap.
 	m_cubeMap->BuildDescriptors(
@@ -1067,8 +1467,9 @@ void AppEntry::CreateApplicationDependentResources()
 	texture->Name = "Default";
 	texture->bCanBeDeleted = false;
 	texture->PathName = "JayouEngine_BuiltIn";
-	texture->HCPUDescriptor = GetCPUDescriptorHeapStartOffset(m_maxPreGBuffers + m_maxGBuffers);
-	texture->HGPUDescriptor = GetGPUDescriptorHeapStartOffset(m_maxPreGBuffers + m_maxGBuffers);
+	m_textureSlots.Insert(texture.get());
+	texture->HCPUDescriptor = GetCPUDescriptorHeapStartOffset(m_maxPreGBuffers + m_maxGBuffers + texture->Index);
+	texture->HGPUDescriptor = GetGPUDescriptorHeapStartOffset(m_maxPreGBuffers + m_maxGBuffers + texture->Index);
 
 	m_textureImporter->CreateDefaultTexture(texture.get(), 128, 128);
 
@@ -1083,7 +1484,19 @@ void AppEntry::CreateApplicationDependentResources()
 	{
 		m_frameResources.push_back(std::make_unique<FrameResource>(m_deviceResources->GetD3DDevice()));
 		m_frameResources[i]->ResizeBuffer<PassConstant>(3); // Main & Shadow Pass & CubeMap.
+		m_frameResources[i]->ResizeBuffer<LightClusterData>(LightClusterBuilder::NumClusters);
+		m_frameResources[i]->ResizeBuffer<LightIndexData>(MaxLights);
+		m_frameResources[i]->ResizeBuffer<InstanceIndexData>(G_NUM_OBJECTCONSTANT);
 	}
+	m_lightIndexCapacity = MaxLights;
+	m_instanceIndexCapacity = G_NUM_OBJECTCONSTANT; // Grows in UpdatePerObjectCB.
+	m_objectBufferCapacity = 0;                     // Created by ReserveSlotBuffers.
+	m_materialBufferCapacity = 0;
+	m_lightBufferCapacity = 0;
+
+	m_renderItemDirtyList.Reset(m_deviceResources->GetBackBufferCount());
+	m_materialDirtyList.Reset(m_deviceResources->GetBackBufferCount());
+	m_lightDirtyList.Reset(m_deviceResources->GetBackBufferCount());
 
 	// Default Material & Light.
 	{
@@ -1124,7 +1537,7 @@ void AppEntry::BuildRootSignature()
 	// Cube Maps.
 	texTable[2].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, m_maxCubeMapSRVs, 0, 4);
 
-	const unsigned int NUM_ROOTPARAMETER = 7;
+	const unsigned int NUM_ROOTPARAMETER = 12;
 	CD3DX12_ROOT_PARAMETER slotRootParameter[NUM_ROOTPARAMETER];
 
 	// Per Object.
@@ -1141,6 +1554,13 @@ void AppEntry::BuildRootSignature()
 	slotRootParameter[5].InitAsDescriptorTable(1, &texTable[1], D3D12_SHADER_VISIBILITY_PIXEL);
 	// Cube Maps.
 	slotRootParameter[6].InitAsDescriptorTable(1, &texTable[2], D3D12_SHADER_VISIBILITY_PIXEL);
+	// Light Clusters & Light Indices.
+	slotRootParameter[7].InitAsShaderResourceView(1, 0, D3D12_SHADER_VISIBILITY_PIXEL);
+	slotRootParameter[8].InitAsShaderResourceView(2, 0, D3D12_SHADER_VISIBILITY_PIXEL);
+	// Instance Data & Instance Indices & Instance Offset Of The Draw.
+	slotRootParameter[9].InitAsShaderResourceView(3, 0, D3D12_SHADER_VISIBILITY_VERTEX);
+	slotRootParameter[10].InitAsShaderResourceView(4, 0, D3D12_SHADER_VISIBILITY_VERTEX);
+	slotRootParameter[11].InitAsConstants(1, 2, 0, D3D12_SHADER_VISIBILITY_VERTEX);
 
 	auto staticSamplers = m_deviceResources->GetAllStaticSamplers();
 
@@ -1155,10 +1575,16 @@ void AppEntry::BuildShadersAndInputLayout()
 {
 	std::string NumTextures = std::to_string(m_maxSupportTex2Ds);
 	std::string NumLights = std::to_string(MaxLights);
+	std::string NumClustersX = std::to_string(LightClusterBuilder::NumClustersX);
+	std::string NumClustersY = std::to_string(LightClusterBuilder::NumClustersY);
+	std::string NumClustersZ = std::to_string(LightClusterBuilder::NumClustersZ);
 	const D3D_SHADER_MACRO defines[] =
 	{
 		NameOf(NumTextures), NumTextures.c_str(),
 		NameOf(NumLights), NumLights.c_str(),
+		NameOf(NumClustersX), NumClustersX.c_str(),
+		NameOf(NumClustersY), NumClustersY.c_str(),
+		NameOf(NumClustersZ), NumClustersZ.c_str(),
 		"ALPHA_TEST", "1",
 		NULL, NULL
 	};
@@ -1176,22 +1602,47 @@ void AppEntry::BuildShadersAndInputLayout()
 	m_shaderByteCode["FullSQuadVS"] = WinUtility::CompileShader(m_appPath + L"../JayouEngine/Core/Shaders/FullscreenQuad.hlsl", defines, "VS", "vs_5_1");
 	m_shaderByteCode["FullSQuadPS"] = WinUtility::CompileShader(m_appPath + L"../JayouEngine/Core/Shaders/FullscreenQuad.hlsl", defines, "PS", "ps_5_1");
 
-	m_shaderByteCode["ShadowVS"] = WinUtility::CompileShader(m_appPath + L"../JayouEngine/Core/Shaders/Shadow.hlsl", defines, "VS", "vs_5_1");
-	m_shaderByteCode["ShadowPS"] = WinUtility::CompileShader(m_appPath + L"../JayouEngine/Core/Shaders/Shadow.hlsl", defines, "PS", "ps_5_1");
-
 	m_shaderByteCode["SkySphereVS"] = WinUtility::CompileShader(m_appPath + L"../JayouEngine/Core/Shaders/SkySphere.hlsl", defines, "VS", "vs_5_1");
 	m_shaderByteCode["SkySpherePS"] = WinUtility::CompileShader(m_appPath + L"../JayouEngine/Core/Shaders/SkySphere.hlsl", defines, "PS", "ps_5_1");
 
-	std::vector<D3D12_INPUT_ELEMENT_DESC> inputLayout =
+	// VF_PackedVertex variants.
+	const D3D_SHADER_MACRO packedDefines[] =
+	{
+		NameOf(NumTextures), NumTextures.c_str(),
+		NameOf(NumLights), NumLights.c_str(),
+		"ALPHA_TEST", "1",
+		"PACKED_VERTEX", "1",
+		NULL, NULL
+	};
+
+	m_shaderByteCode["WireframePackedVS"] = WinUtility::CompileShader(m_appPath + L"../JayouEngine/Core/Shaders/VertexColor.hlsl", packedDefines, "WireframeVS", "vs_5_1");
+	m_shaderByteCode["GBufferPackedVS"] = WinUtility::CompileShader(m_appPath + L"../JayouEngine/Core/Shaders/GBuffer.hlsl", packedDefines, "VS", "vs_5_1");
+
+	// Depth only, reads the position stream.
+	const D3D_SHADER_MACRO positionDefines[] =
 	{
-		{ "COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-		{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 16, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-		{ "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 28, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-		{ "TANGENT", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 40, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-		{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 52, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		NameOf(NumTextures), NumTextures.c_str(),
+		NameOf(NumLights), NumLights.c_str(),
+		"POSITION_ONLY", "1",
+		NULL, NULL
+	};
+	const D3D_SHADER_MACRO packedPositionDefines[] =
+	{
+		NameOf(NumTextures), NumTextures.c_str(),
+		NameOf(NumLights), NumLights.c_str(),
+		"PACKED_VERTEX", "1",
+		"POSITION_ONLY", "1",
+		NULL, NULL
 	};
 
-	m_inputLayout["BaseShaderInputLayout"] = inputLayout;
+	m_shaderByteCode["ShadowVS"] = WinUtility::CompileShader(m_appPath + L"../JayouEngine/Core/Shaders/Shadow.hlsl", positionDefines, "VS", "vs_5_1");
+	m_shaderByteCode["ShadowPackedVS"] = WinUtility::CompileShader(m_appPath + L"../JayouEngine/Core/Shaders/Shadow.hlsl", packedPositionDefines, "VS", "vs_5_1");
+
+	// ColorVertex is a prefix of Vertex, it shares the base layout.
+	m_inputLayout["BaseShaderInputLayout"] = DefaultVertexLayout::GetInputLayout();
+	m_inputLayout["PackedShaderInputLayout"] = PackedVertexLayout::GetInputLayout();
+	m_inputLayout["PositionInputLayout"] = PositionStreamLayout::GetInputLayout();
+	m_inputLayout["PackedPositionInputLayout"] = PackedPositionStreamLayout::GetInputLayout();
 }
 
 void AppEntry::BuildRenderItems()
@@ -1231,10 +1682,7 @@ void AppEntry::BuildRenderItems()
 
 	GWorldCached(skyRIem, RenderLayer::SkySphere, false);
 
-	for (uint32 i = 0; i < m_deviceResources->GetBackBufferCount(); ++i)
-	{
-		m_frameResources[i]->ResizeBuffer<ObjectConstant>((uint32)m_allRItems.size());
-	}
+	ReserveSlotBuffers();
 }
 
 void AppEntry::BuildPSO()
@@ -1246,14 +1694,14 @@ void AppEntry::BuildPSO()
 		m_rootSIGs["Main"].Get(),
 		m_shaderByteCode["ColorVS"].Get(),
 		m_shaderByteCode["ColorPS"].Get(),
-		&m_PSOs["Default"]);
+		&m_PSOs[PSONames::Default]);
 	//////////////////////////////////////////////////////////////////////////
 
 	//////////////////////////////////////////////////////////////////////////
 	// PSO Line.
 	D3D12_GRAPHICS_PIPELINE_STATE_DESC linePSO = defaultPSO;
 	linePSO.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_LINE;
-	m_deviceResources->CreateGraphicsPipelineState(&linePSO, &m_PSOs["Line"]);
+	m_deviceResources->CreateGraphicsPipelineState(&linePSO, &m_PSOs[PSONames::Line]);
 	//////////////////////////////////////////////////////////////////////////
 
 	//////////////////////////////////////////////////////////////////////////
@@ -1262,7 +1710,7 @@ void AppEntry::BuildPSO()
 	wireframePSO.RasterizerState.AntialiasedLineEnable = true;
 	wireframePSO.DepthStencilState.DepthFunc = D3D12_COMPARISON_FUNC_LESS_EQUAL;
 	wireframePSO.VS = CD3DX12_SHADER_BYTECODE(m_shaderByteCode["WireframeVS"].Get());
-	m_deviceResources->CreateGraphicsPipelineState(&wireframePSO, &m_PSOs["Wireframe"]);
+	m_deviceResources->CreateGraphicsPipelineState(&wireframePSO, &m_PSOs[PSONames::Wireframe]);
 	//////////////////////////////////////////////////////////////////////////
 
 	//////////////////////////////////////////////////////////////////////////
@@ -1271,7 +1719,7 @@ void AppEntry::BuildPSO()
 	fullQuadPSO.DepthStencilState.DepthFunc = D3D12_COMPARISON_FUNC_LESS_EQUAL;
 	fullQuadPSO.VS = CD3DX12_SHADER_BYTECODE(m_shaderByteCode["FullSQuadVS"].Get());
 	fullQuadPSO.PS = CD3DX12_SHADER_BYTECODE(m_shaderByteCode["FullSQuadPS"].Get());
-	m_deviceResources->CreateGraphicsPipelineState(&fullQuadPSO, &m_PSOs["FullscreenQuad"]);
+	m_deviceResources->CreateGraphicsPipelineState(&fullQuadPSO, &m_PSOs[PSONames::FullscreenQuad]);
 	//////////////////////////////////////////////////////////////////////////
 
 	//////////////////////////////////////////////////////////////////////////
@@ -1284,7 +1732,7 @@ void AppEntry::BuildPSO()
 	GBufferPSO.PS = CD3DX12_SHADER_BYTECODE(m_shaderByteCode["GBufferPS"].Get());
 	GBufferPSO.SampleDesc.Count = 1;
 	GBufferPSO.SampleDesc.Quality = 0;
-	m_deviceResources->CreateGraphicsPipelineState(&GBufferPSO, &m_PSOs["GBuffer"]);
+	m_deviceResources->CreateGraphicsPipelineState(&GBufferPSO, &m_PSOs[PSONames::GBuffer]);
 	//////////////////////////////////////////////////////////////////////////
 
 	//////////////////////////////////////////////////////////////////////////
@@ -1293,7 +1741,7 @@ void AppEntry::BuildPSO()
 	PBRPSO.DSVFormat = DXGI_FORMAT_UNKNOWN;
 	PBRPSO.VS = CD3DX12_SHADER_BYTECODE(m_shaderByteCode["PBRVS"].Get());
 	PBRPSO.PS = CD3DX12_SHADER_BYTECODE(m_shaderByteCode["PBRPS"].Get());
-	m_deviceResources->CreateGraphicsPipelineState(&PBRPSO, &m_PSOs["PBR"]);
+	m_deviceResources->CreateGraphicsPipelineState(&PBRPSO, &m_PSOs[PSONames::PBR]);
 	//////////////////////////////////////////////////////////////////////////
 
 	//////////////////////////////////////////////////////////////////////////
@@ -1302,12 +1750,14 @@ void AppEntry::BuildPSO()
 	ShadowPSO.RasterizerState.DepthBias = 100000;
 	ShadowPSO.RasterizerState.DepthBiasClamp = 0.0f;
 	ShadowPSO.RasterizerState.SlopeScaledDepthBias = 1.0f;
+	ShadowPSO.InputLayout = { m_inputLayout["PositionInputLayout"].data(), (UINT)m_inputLayout["PositionInputLayout"].size() };
 	ShadowPSO.VS = CD3DX12_SHADER_BYTECODE(m_shaderByteCode["ShadowVS"].Get());
-	ShadowPSO.PS = CD3DX12_SHADER_BYTECODE(m_shaderByteCode["ShadowPS"].Get());
+	// Depth only, the alpha test of Shadow.hlsl PS is disabled so no pixel shader is needed.
+	ShadowPSO.PS = { nullptr, 0 };
 	// Shadow map pass does not have a render target.
 	ShadowPSO.RTVFormats[0] = DXGI_FORMAT_UNKNOWN;
 	ShadowPSO.NumRenderTargets = 0;
-	m_deviceResources->CreateGraphicsPipelineState(&ShadowPSO, &m_PSOs["Shadow"]);
+	m_deviceResources->CreateGraphicsPipelineState(&ShadowPSO, &m_PSOs[PSONames::Shadow]);
 	//////////////////////////////////////////////////////////////////////////
 
 	//////////////////////////////////////////////////////////////////////////
@@ -1317,7 +1767,27 @@ void AppEntry::BuildPSO()
 	SkySpherePSO.DepthStencilState.DepthFunc = D3D12_COMPARISON_FUNC_LESS_EQUAL;
 	SkySpherePSO.VS = CD3DX12_SHADER_BYTECODE(m_shaderByteCode["SkySphereVS"].Get());
 	SkySpherePSO.PS = CD3DX12_SHADER_BYTECODE(m_shaderByteCode["SkySpherePS"].Get());
-	m_deviceResources->CreateGraphicsPipelineState(&SkySpherePSO, &m_PSOs["SkySphere"]);
+	m_deviceResources->CreateGraphicsPipelineState(&SkySpherePSO, &m_PSOs[PSONames::SkySphere]);
+	//////////////////////////////////////////////////////////////////////////
+
+	//////////////////////////////////////////////////////////////////////////
+	// PSO PackedVertex.
+	D3D12_INPUT_LAYOUT_DESC packedInputLayout = { m_inputLayout["PackedShaderInputLayout"].data(), (UINT)m_inputLayout["PackedShaderInputLayout"].size() };
+
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC GBufferPackedPSO = GBufferPSO;
+	GBufferPackedPSO.InputLayout = packedInputLayout;
+	GBufferPackedPSO.VS = CD3DX12_SHADER_BYTECODE(m_shaderByteCode["GBufferPackedVS"].Get());
+	m_deviceResources->CreateGraphicsPipelineState(&GBufferPackedPSO, &m_PSOs[PSONames::GBuffer_Packed]);
+
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC ShadowPackedPSO = ShadowPSO;
+	ShadowPackedPSO.InputLayout = { m_inputLayout["PackedPositionInputLayout"].data(), (UINT)m_inputLayout["PackedPositionInputLayout"].size() };
+	ShadowPackedPSO.VS = CD3DX12_SHADER_BYTECODE(m_shaderByteCode["ShadowPackedVS"].Get());
+	m_deviceResources->CreateGraphicsPipelineState(&ShadowPackedPSO, &m_PSOs[PSONames::Shadow_Packed]);
+
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC wireframePackedPSO = wireframePSO;
+	wireframePackedPSO.InputLayout = packedInputLayout;
+	wireframePackedPSO.VS = CD3DX12_SHADER_BYTECODE(m_shaderByteCode["WireframePackedVS"].Get());
+	m_deviceResources->CreateGraphicsPipelineState(&wireframePackedPSO, &m_PSOs[PSONames::Wireframe_Packed]);
 	//////////////////////////////////////////////////////////////////////////
 }
 
@@ -1373,29 +1843,64 @@ void AppEntry::ParseCommandLine(std::wstring cmdLine)
 
 void GWorld::GWorldCached(std::unique_ptr<Texture>& InTexture)
 {
+	// The GBuffers are not part of the texture array.
+	if (!InTexture->bIsBuiltIn && InTexture->Index == SlotMap::NullSlot)
+	{
+		m_textureSlots.Insert(InTexture.get());
+	}
 	m_allTextureRefs.push_back(InTexture.get());
 	m_allTextures[InTexture->Name] = std::move(InTexture);
 }
 
 void GWorld::GWorldCached(std::unique_ptr<Material>& InMaterial)
 {
+	if (InMaterial->Index == SlotMap::NullSlot)
+	{
+		m_materialSlots.Insert(InMaterial.get());
+	}
+	m_materialDirtyList.Add(InMaterial.get());
 	m_allMaterialRefs.push_back(InMaterial.get());
 	m_allMaterials[InMaterial->Name] = std::move(InMaterial);
 }
 
-void GWorld::GWorldCached(std::unique_ptr<RenderItem>& InRenderItem, const RenderLayer& InRenderLayer, bool bIsSelectable)
+void GWorld::GWorldCached(std::unique_ptr<RenderItem>& InRenderItem, const RenderLayer& InRenderLayer, bool bIsSelectable, int32 InParentNode)
 {
+	if (InRenderItem->Index == SlotMap::NullSlot)
+	{
+		m_renderItemSlots.Insert(InRenderItem.get());
+	}
+
+	// TransFormMatrix is the local matrix until the first UpdateTransforms.
+	InRenderItem->Transforms = &m_transformHierarchy;
+	InRenderItem->TransformNode = m_transformHierarchy.Insert(InParentNode, InRenderItem->TransFormMatrix, InRenderItem.get());
+
+	uint32 sceneMask = GetRenderLayerMask(InRenderLayer);
+	if (bIsSelectable)
+	{
+		sceneMask |= GetRenderLayerMask(RenderLayer::Selectable);
+	}
+	InRenderItem->WorldBounds = InRenderItem->GetWorldBounds();
+	m_renderEntities.Create(InRenderItem.get(), InRenderLayer == RenderLayer::Opaque);
+	InRenderItem->Scene = &m_sceneBVH;
+	InRenderItem->SceneProxy = m_sceneBVH.Insert(InRenderItem->WorldBounds, InRenderItem.get(), sceneMask);
+	m_renderItemDirtyList.Add(InRenderItem.get());
+
 	if (bIsSelectable)
 	{
-		m_renderItemLayer[RenderLayer::Selectable].push_back(InRenderItem.get());
+		AddToLayer(InRenderItem.get(), RenderLayer::Selectable);
 	}
-	m_renderItemLayer[InRenderLayer].push_back(InRenderItem.get());
-	m_renderItemLayer[RenderLayer::All].push_back(InRenderItem.get());
+	AddToLayer(InRenderItem.get(), InRenderLayer);
+	AddToLayer(InRenderItem.get(), RenderLayer::All);
 	m_allRItems[InRenderItem->Name] = std::move(InRenderItem);	
 }
 
 void GWorld::GWorldCached(std::unique_ptr<Light>& InLight)
 {
+	if (InLight->Index == SlotMap::NullSlot)
+	{
+		m_lightSlots.Insert(InLight.get());
+	}
+	m_lightDirtyList.Add(InLight.get());
 	m_allLightRefs.push_back(InLight.get());
 	m_allLights[InLight->Name] = std::move(InLight);
 }
@@ -1405,11 +1910,8 @@ void GWorld::AddRenderItem(const BuiltInGeoDesc& InGeoDesc)
 	m_deviceResources->ExecuteCommandLists([&]()
 	{
 		auto builtInRItem = std::make_unique<RenderItem>();
-		builtInRItem->Name = InGeoDesc.Name;
-
-		for (auto ri : m_renderItemLayer[RenderLayer::All])
-			if (builtInRItem->Name == ri->Name)
-				builtInRItem->Name = ri->Name + "_" + std::to_string(builtInRItem->Index);
+		builtInRItem->Name = MakeUniqueName(InGeoDesc.Name, m_allRItems, m_nameSuffixes);
+		m_renderItemSlots.Insert(builtInRItem.get());
 
 		GeometryData<Vertex> builtInMesh;
 		switch (InGeoDesc.GeoType)
@@ -1444,63 +1946,163 @@ void GWorld::AddRenderItem(const BuiltInGeoDesc& InGeoDesc)
 		builtInRItem->VertexColor = InGeoDesc.Color;
 		builtInRItem->CachedGeometryData = builtInMesh;
 
-		m_deviceResources->CreateCommonGeometry<Vertex, uint32>(builtInRItem.get(), builtInMesh.Vertices, builtInMesh.Indices32);
+		CreateRenderItemGeometry(builtInRItem.get());
 
 		GWorldCached(builtInRItem, RenderLayer::Opaque);
 	});
-	
-	for (auto& ri : m_allRItems)
-	{
-		ri.second->MarkAsDirty();
-	}
-	for (uint32 i = 0; i < m_deviceResources->GetBackBufferCount(); ++i)
-	{
-		m_frameResources[i]->ResizeBuffer<ObjectConstant>((uint32)m_allRItems.size());
-	}
+
+	ReserveSlotBuffers();
 }
 
 void GWorld::AddRenderItem(const ImportGeoDesc& InGeoDesc)
 {
-	m_deviceResources->ExecuteCommandLists([&]()
+	m_imports.Add(InGeoDesc);
+}
+
+void GWorld::FinishImports()
+{
+	const uint32 numFinished = m_imports.Drain([&](ImportTask& InTask)
 	{
-		if (m_assimpImporter->Import(InGeoDesc))
+		// Cancelled after the job was done, dropped all the same.
+		if (InTask.bSucceeded && !InTask.Progress.bCancel)
 		{
-			const std::unordered_map<std::string, Geometry>& geos = m_assimpImporter->GetAllGeometries();
-			for (auto pair : geos)
+			m_deviceResources->ExecuteCommandLists([&]()
 			{
-				auto importRItem = std::make_unique<RenderItem>();
-				importRItem->Name = InGeoDesc.Name;
+				AddImportedRenderItems(InTask);
+			});
+		}
+		else if (!InTask.bSucceeded)
+		{
+			char report[512] = {};
+			sprintf_s(report, "[Import] %s: %s\n", InTask.Desc.PathName.c_str(), InTask.Importer.GetLastError().c_str());
+			OutputDebugStringA(report);
+		}
+
+		if (InTask.bCacheNotWritten)
+		{
+			OutputDebugStringA(("[MeshCache] Could not write " + MeshCache::GetCachePath(InTask.Desc.PathName) + "\n").c_str());
+		}
+	});
+
+	if (numFinished > 0)
+	{
+		ReserveSlotBuffers();
+	}
+}
+
+void GWorld::CancelImports()
+{
+	m_imports.CancelAll();
+}
 
-				for (auto ri : m_renderItemLayer[RenderLayer::All])
-					if (importRItem->Name == ri->Name)
-						importRItem->Name = ri->Name + "_" + std::to_string(importRItem->Index);
+void GWorld::AddImportedRenderItems(ImportTask& InTask)
+{
+	// The task goes away after this, its buffers are moved into the render items rather than copied.
+	std::unordered_map<std::string, Geometry>& geos = InTask.Geometries;
+	const std::vector<ImportNode>& nodes = InTask.Nodes;
 
-				Geometry geo = pair.second;
-				geo.SetColor(InGeoDesc.Color);
-				GeometryData<Vertex> importMesh = geo.Data;
+	for (auto& pair : geos)
+	{
+		pair.second.SetColor(InTask.Desc.Color);
+	}
 
-				importRItem->PathName = InGeoDesc.PathName;
-				importRItem->SetTransFormMatrix(InGeoDesc.Translation, InGeoDesc.Rotation, InGeoDesc.Scale);
-				importRItem->NumVertices = (uint32)importMesh.Vertices.size();
-				importRItem->NumIndices = (uint32)importMesh.Indices32.size();
-				importRItem->Bounds = geo.Bounds;
-				importRItem->VertexColor = InGeoDesc.Color;
-				importRItem->CachedGeometryData = importMesh;
+	std::unordered_map<std::string, uint32> numNodesPerGeo;
+	for (const auto& node : nodes)
+		for (const auto& geoName : node.Geometries)
+			numNodesPerGeo[geoName]++;
+	const bool bHasLooseGeos = numNodesPerGeo.size() < geos.size();
 
-				m_deviceResources->CreateCommonGeometry<Vertex, uint32>(importRItem.get(), importMesh.Vertices, importMesh.Indices32);
+	// Render items still to make of each geometry, a loose one makes one.
+	std::unordered_map<std::string, uint32> numUsesLeft = numNodesPerGeo;
+	for (const auto& pair : geos)
+	{
+		numUsesLeft.emplace(pair.first, 1u);
+	}
 
-				GWorldCached(importRItem, RenderLayer::Opaque);
-			}
+	// One render item per geometry per node, under the group of its node.
+	const NameId importName(InTask.Desc.Name);
+	auto addImportRItem = [&](const std::string& InGeoName, int32 InParentNode)
+	{
+		Geometry& geo = geos.at(InGeoName);
+		TriangleBVH& bvh = InTask.BVHs.at(InGeoName);
+
+		auto importRItem = std::make_unique<RenderItem>();
+		importRItem->Name = MakeUniqueName(importName, m_allRItems, m_nameSuffixes);
+		m_renderItemSlots.Insert(importRItem.get());
+
+		importRItem->PathName = InTask.Desc.PathName;
+		importRItem->NumVertices = (uint32)geo.Data.Vertices.size();
+		importRItem->NumIndices = (uint32)geo.Data.Indices32.size();
+		importRItem->Bounds = geo.Bounds;
+		importRItem->VertexColor = InTask.Desc.Color;
+		importRItem->bPackVertices = InTask.Desc.bPackVertices;
+
+		// The last render item of a geometry takes its storage, the ones before it copy. The picking structure
+		// was built by the import job.
+		if (--numUsesLeft.at(InGeoName) == 0)
+		{
+			importRItem->CachedGeometryData = std::move(geo.Data);
+			importRItem->CachedLODs = std::move(geo.LODs);
+			importRItem->CachedMeshlets = std::move(geo.Meshlets);
+			importRItem->CachedBVH = std::move(bvh);
 		}
-	});
-	
-	for (auto& ri : m_allRItems)
+		else
+		{
+			importRItem->CachedGeometryData = geo.Data;
+			importRItem->CachedLODs = geo.LODs;
+			importRItem->CachedMeshlets = geo.Meshlets;
+			importRItem->CachedBVH = bvh;
+		}
+
+		CreateRenderItemGeometry(importRItem.get(), false);
+
+		GWorldCached(importRItem, RenderLayer::Opaque, true, InParentNode);
+	};
+
+	// Nodes without meshes below them (cameras, lights...) are left out.
+	std::vector<bool> bHasMeshes(nodes.size(), false);
+	for (size_t i = nodes.size(); i-- > 0;)
+	{
+		bHasMeshes[i] = bHasMeshes[i] || !nodes[i].Geometries.empty();
+		if (bHasMeshes[i] && nodes[i].Parent >= 0)
+		{
+			bHasMeshes[nodes[i].Parent] = true;
+		}
+	}
+	if (!nodes.empty() && bHasLooseGeos)
+	{
+		bHasMeshes[0] = true;
+	}
+
+	// The node tree becomes groups of the transform hierarchy, its root carries the placement of the import.
+	const Matrix4 placement = Matrix4(AffineTransform(InTask.Desc.Translation).Rotation(InTask.Desc.Rotation).Scale(InTask.Desc.Scale));
+	std::vector<int32> groupNodes(nodes.size(), TransformHierarchy::NullNode);
+	for (size_t i = 0; i < nodes.size(); ++i)
 	{
-		ri.second->MarkAsDirty();
+		if (!bHasMeshes[i])
+			continue;
+
+		const bool bIsRoot = nodes[i].Parent < 0;
+		groupNodes[i] = m_transformHierarchy.Insert(bIsRoot ? TransformHierarchy::NullNode : groupNodes[nodes[i].Parent],
+			bIsRoot ? nodes[i].LocalTransform * placement : nodes[i].LocalTransform);
+
+		for (const auto& geoName : nodes[i].Geometries)
+		{
+			addImportRItem(geoName, groupNodes[i]);
+		}
 	}
-	for (uint32 i = 0; i < m_deviceResources->GetBackBufferCount(); ++i)
+
+	// Meshes no node refers to hang under the root.
+	if (bHasLooseGeos)
 	{
-		m_frameResources[i]->ResizeBuffer<ObjectConstant>((uint32)m_allRItems.size());
+		const int32 rootNode = nodes.empty() ? m_transformHierarchy.Insert(TransformHierarchy::NullNode, placement) : groupNodes[0];
+		for (const auto& pair : geos)
+		{
+			if (numNodesPerGeo.find(pair.first) == numNodesPerGeo.end())
+			{
+				addImportRItem(pair.first, rootNode);
+			}
+		}
 	}
 }
 
@@ -1508,19 +2110,24 @@ void GWorld::AddTexture2D(const ImportTexDesc& InTexDesc)
 {
 	m_deviceResources->ExecuteCommandLists([&]()
 	{
-		auto texture = std::make_unique<Texture>();
-		texture->Name = InTexDesc.Name;
-
-		for (auto& tex : m_allTextureRefs)
-			if (texture->Name == tex->Name)
-				texture->Name = tex->Name + "_" + std::to_string(texture->Index);
-
-		texture->PathName = InTexDesc.PathName;
-		texture->HCPUDescriptor = GetCPUDescriptorHeapStartOffset((uint32)m_allTextureRefs.size());
-		texture->HGPUDescriptor = GetGPUDescriptorHeapStartOffset((uint32)m_allTextureRefs.size());
-		texture->bIsHDR = InTexDesc.bIsHDR;
-
-		m_textureImporter->LoadTexture(texture.get());
+		auto texture = std::make_unique<Texture>();
+		texture->PathName = InTexDesc.PathName;
+		texture->bIsHDR = InTexDesc.bIsHDR;
+
+		// Nothing to upload, no slot or name taken.
+		if (!m_textureImporter->LoadTexture(texture.get()))
+		{
+			char report[512] = {};
+			sprintf_s(report, "[Import] %s: %s\n", InTexDesc.PathName.c_str(), m_textureImporter->GetLastError().c_str());
+			OutputDebugStringA(report);
+			return;
+		}
+
+		texture->Name = MakeUniqueName(InTexDesc.Name, m_allTextures, m_nameSuffixes);
+		m_textureSlots.Insert(texture.get());
+		texture->HCPUDescriptor = GetCPUDescriptorHeapStartOffset(m_maxPreGBuffers + m_maxGBuffers + texture->Index);
+		texture->HGPUDescriptor = GetGPUDescriptorHeapStartOffset(m_maxPreGBuffers + m_maxGBuffers + texture->Index);
+
 		m_deviceResources->CreateTexture2D(texture.get());
 		GWorldCached(texture);
 	});
@@ -1529,11 +2136,8 @@ void GWorld::AddTexture2D(const ImportTexDesc& InTexDesc)
 void GWorld::AddMaterial(const MaterialDesc& InMaterialDesc, bool bUseTexture /*= true*/)
 {
 	auto material = std::make_unique<Material>();
-	material->Name = InMaterialDesc.Name;
-
-	for (auto& mat : m_allMaterialRefs)
-		if (material->Name == mat->Name)
-			material->Name = mat->Name + "_" + std::to_string(material->Index);
+	material->Name = MakeUniqueName(InMaterialDesc.Name, m_allMaterials, m_nameSuffixes);
+	m_materialSlots.Insert(material.get());
 
 	material->PathName = InMaterialDesc.PathName;
 	material->bCanBeDeleted = InMaterialDesc.bCanbeDeleted;
@@ -1555,26 +2159,14 @@ void GWorld::AddMaterial(const MaterialDesc& InMaterialDesc, bool bUseTexture /*
 
 	GWorldCached(material);
 
-	m_deviceResources->WaitForGpu();
-	
-	for (auto& mat : m_allMaterialRefs)
-	{
-		mat->MarkAsDirty();
-	}
-	for (uint32 i = 0; i < m_deviceResources->GetBackBufferCount(); ++i)
-	{
-		m_frameResources[i]->ResizeBuffer<MaterialData>((uint32)m_allMaterialRefs.size());
-	}
+	ReserveSlotBuffers();
 }
 
 void GWorld::AddLight(const LightDesc& InLightDesc)
 {
 	auto light = std::make_unique<Light>();
-	light->Name = InLightDesc.Name;
-
-	for (auto& lit : m_allLightRefs)
-		if (light->Name == lit->Name)
-			light->Name = lit->Name + "_" + std::to_string(light->Index);
+	light->Name = MakeUniqueName(InLightDesc.Name, m_allLights, m_nameSuffixes);
+	m_lightSlots.Insert(light.get());
 
 	light->PathName = InLightDesc.PathName;
 	light->bCanBeDeleted = InLightDesc.bCanbeDeleted;
@@ -1602,232 +2194,258 @@ void GWorld::AddLight(const LightDesc& InLightDesc)
 
 	GWorldCached(light);
 
-	m_deviceResources->WaitForGpu();
+	ReserveSlotBuffers();
+}
 
-	for (auto& lit : m_allLightRefs)
-	{
-		lit->MarkAsDirty();
-	}
-	for (uint32 i = 0; i < m_deviceResources->GetBackBufferCount(); ++i)
-	{
-		m_frameResources[i]->ResizeBuffer<LightData>((uint32)m_allLightRefs.size());
-	}
+bool GWorld::Rename(RenderItem* InRenderItem, const NameId& InName)
+{
+	return RenameInRegistry(InRenderItem, InName, m_allRItems);
 }
 
-void GWorld::GarbageCollection()
+bool GWorld::Rename(Material* InMaterial, const NameId& InName)
 {
-	// This Function Should Not Be Called Every Frame!!!
+	return RenameInRegistry(InMaterial, InName, m_allMaterials);
+}
 
-	bool bHasAnyItemsToDelete = false;
-	bool bResizeObjCBNeeded = false;
-	bool bResizeMatSBNeeded = false;
-	bool bResizeLitSBNeeded = false;
+bool GWorld::Rename(Light* InLight, const NameId& InName)
+{
+	return RenameInRegistry(InLight, InName, m_allLights);
+}
 
-	// First to Find Any Items that MarkAsDeleted, And Reset Index.
-	// One BuiltIn Mesh: Grid.
-	int32 index = 1;
-	std::map<int32, std::string> deletedItemIDNames[4];	
-	for (uint32 i = 1; i < m_renderItemLayer[RenderLayer::All].size(); ++i)
+void GWorld::GarbageCollection()
+{
+	// Called every frame. MarkAsDeleted puts an object on its dirty list, so only the dirty ones are looked at.
+	std::vector<RenderItem*> deletedRItems;
+	m_renderItemDirtyList.ForEach([&](IObject* InObject)
 	{
-		if (m_renderItemLayer[RenderLayer::All][i]->CanbeDeletedNow())
-		{
-			deletedItemIDNames[0][m_renderItemLayer[RenderLayer::All][i]->Index] = m_renderItemLayer[RenderLayer::All][i]->Name;
-			m_renderItemLayer[RenderLayer::All].erase(m_renderItemLayer[RenderLayer::All].begin() + index);		
-			bHasAnyItemsToDelete = true;
-			bResizeObjCBNeeded = true;
-			--i;
-			continue;
-		}
-		m_renderItemLayer[RenderLayer::All][i]->Index = index++;
-	}
+		if (InObject->CanbeDeletedNow())
+			deletedRItems.push_back(static_cast<RenderItem*>(InObject));
+	});
 
-	for (uint32 i = 0; i < (uint32)RenderLayer::All; ++i)
+	std::vector<Light*> deletedLights;
+	m_lightDirtyList.ForEach([&](IObject* InObject)
 	{
-		for (uint32 j = 0; j < (uint32)m_renderItemLayer[i].size(); ++j)
-		{
-			if (m_renderItemLayer[i][j]->CanbeDeletedNow())
-			{
-				m_renderItemLayer[i].erase(m_renderItemLayer[i].begin() + j);
-				--j;
-			}
-		}
-	}
+		if (InObject->CanbeDeletedNow())
+			deletedLights.push_back(static_cast<Light*>(InObject));
+	});
 
-	// One BuiltIn DirLight.
-	index = 1;	
-	for (uint32 i = 1; i < m_allLightRefs.size(); ++i)
+	std::vector<Material*> deletedMaterials;
+	m_materialDirtyList.ForEach([&](IObject* InObject)
 	{
-		if (m_allLightRefs[i]->CanbeDeletedNow())
-		{
-			switch (m_allLightRefs[i]->LightType)
-			{
-			case LT_Directional:
-				m_numDirLights--;
-				break;
-			case LT_Point:
-				m_numPointLights--;
-				break;
-			case LT_Spot:
-				m_numSpotLights--;
-				break;
-			default:
-				break;
-			}
-
-			deletedItemIDNames[1][m_allLightRefs[i]->Index] = m_allLightRefs[i]->Name;
-			m_allLightRefs.erase(m_allLightRefs.begin() + index);
-			bHasAnyItemsToDelete = true;
-			bResizeLitSBNeeded = true;
-			--i;
-			continue;
-		}
-		m_allLightRefs[i]->Index = index++;
-	}
+		if (InObject->CanbeDeletedNow())
+			deletedMaterials.push_back(static_cast<Material*>(InObject));
+	});
 
-	// One BuiltIn Default Material.
-	index = 1;	
-	for (uint32 i = 1; i < m_allMaterialRefs.size(); ++i)
+	// Textures have no dirty list, there are m_maxSupportTex2Ds at most.
+	std::vector<Texture*> deletedTextures;
+	for (auto& tex : m_allTextureRefs)
 	{
-		if (m_allMaterialRefs[i]->CanbeDeletedNow())
-		{
-			deletedItemIDNames[2][m_allMaterialRefs[i]->Index] = m_allMaterialRefs[i]->Name;
-			m_allMaterialRefs.erase(m_allMaterialRefs.begin() + index);
-			bHasAnyItemsToDelete = true;
-			bResizeMatSBNeeded = true;
-			--i;
-			continue;
-		}
-		m_allMaterialRefs[i]->Index = index++;
+		if (tex->CanbeDeletedNow())
+			deletedTextures.push_back(tex);
 	}
 
-	// BuiltIn GBuffers And One Texture.
-	index = 1;	
-	for (uint32 i = m_maxPreGBuffers + m_maxGBuffers + 1; i < m_allTextureRefs.size(); ++i)
-	{
-		if (m_allTextureRefs[i]->CanbeDeletedNow())
-		{
-			deletedItemIDNames[3][m_allTextureRefs[i]->Index] = m_allTextureRefs[i]->Name;
-			m_allTextureRefs.erase(m_allTextureRefs.begin() + index + m_maxPreGBuffers + m_maxGBuffers);
-			bHasAnyItemsToDelete = true;
-			--i;
-			continue;
-		}
-		index++;
-	}
+	if (deletedRItems.empty() && deletedLights.empty() && deletedMaterials.empty() && deletedTextures.empty())
+		return;
 
-	// Now Perform Truely Delete.
-	if (bHasAnyItemsToDelete)
-	{
-		m_deviceResources->WaitForGpu();
-	}
+	// The GPU may still read what is about to be deleted.
+	m_deviceResources->WaitForGpu();
 
 	// Delete RenderItems.
-	for (auto& id_name : deletedItemIDNames[0])
+	for (RenderItem* ri : deletedRItems)
+	{
+		m_sceneBVH.Remove(ri->SceneProxy);
+		ri->SceneProxy = SceneBVH::NullProxy;
+		m_renderItemDirtyList.Remove(ri);
+		m_renderEntities.Destroy(ri->Entity);
+		m_transformHierarchy.Remove(ri->TransformNode);
+		ri->Transforms = nullptr;
+		ri->TransformNode = TransformHierarchy::NullNode;
+		RemoveFromLayers(ri);
+		m_renderItemSlots.Remove(ri);
+		m_geometryCache.Remove(ri);
+
+		m_allRItems.erase(ri->Name);
+	}
+	if (!deletedRItems.empty())
 	{
-		m_allRItems.erase(id_name.second);
+		// Rebuilt by HandleRenderItemStateChanged.
+		m_renderItemLayer[RenderLayer::Selected].clear();
 	}
-	RenderItem::Count = (uint32)m_allRItems.size();
 
-	// Delete Lights.
-	for (auto& id_name : deletedItemIDNames[1])
+	// Delete Lights. The first one is the main light, it cannot be deleted.
+	for (Light* lit : deletedLights)
 	{
-		m_allLights.erase(id_name.second);
+		switch (lit->LightType)
+		{
+		case LT_Directional:
+			m_numDirLights--;
+			break;
+		case LT_Point:
+			m_numPointLights--;
+			break;
+		case LT_Spot:
+			m_numSpotLights--;
+			break;
+		default:
+			break;
+		}
+
+		m_lightDirtyList.Remove(lit);
+		m_allLightRefs.erase(std::find(m_allLightRefs.begin(), m_allLightRefs.end(), lit));
+		m_lightSlots.Remove(lit);
+
+		m_allLights.erase(lit->Name);
 	}
-	Light::Count = (uint32)m_allLights.size();
 
-	// Delete Materials.	
-	for (auto& id_name : deletedItemIDNames[2])
+	// Delete Materials, their render items fall back to the default one.
+	if (!deletedMaterials.empty())
 	{
-		// First to Find All References.
+		std::vector<uint8> bDeletedSlots(m_materialSlots.GetCapacity(), 0);
+		for (Material* mat : deletedMaterials)
+		{
+			bDeletedSlots[mat->Index] = 1;
+		}
 		for (auto& ri : m_allRItems)
 		{
-			if (ri.second->MaterialIndex == id_name.first)
+			if (bDeletedSlots[ri.second->MaterialIndex])
 			{
 				ri.second->MaterialIndex = 0;
 				ri.second->MarkAsDirty();
 			}
 		}
+	}
+	for (Material* mat : deletedMaterials)
+	{
+		m_materialDirtyList.Remove(mat);
+		m_allMaterialRefs.erase(std::find(m_allMaterialRefs.begin(), m_allMaterialRefs.end(), mat));
+		m_materialSlots.Remove(mat);
 
-		m_allMaterials.erase(id_name.second);
+		m_allMaterials.erase(mat->Name);
 	}
-	Material::Count = (uint32)m_allMaterials.size();
 
-	// Delete Textures.
-	for (auto& id_name : deletedItemIDNames[3])
+	// Delete Textures. The combo indices count the textures with a slot, in m_allTextureRefs order.
+	for (Texture* tex : deletedTextures)
 	{
-		int32 texID = id_name.first;
-		// First to Find All References.
-		for (auto& mat : m_allMaterials)
+		const int32 texID = tex->Index;
+
+		int32 comboIndex = 0;
+		for (auto& other : m_allTextureRefs)
 		{
-			if (mat.second->DiffuseMapIndex == texID)
-			{
-				mat.second->DiffuseMapIndex = -1;
-				mat.second->DiffuseMapComboIndex = -1;
-				mat.second->MarkAsDirty();
-			}
-			if (mat.second->NormalMapIndex == texID)
-			{
-				mat.second->NormalMapIndex = -1;
-				mat.second->NormalMapComboIndex = -1;
-				mat.second->MarkAsDirty();
-			}
-			if (mat.second->ORMMapIndex == texID)
-			{
-				mat.second->ORMMapIndex = -1;
-				mat.second->ORMMapComboIndex = -1;
-				mat.second->MarkAsDirty();
-			}
-			mat.second->DiffuseMapComboIndex--;
-			mat.second->NormalMapComboIndex--;
-			mat.second->ORMMapComboIndex--;
+			if (other == tex)
+				break;
+			if (other->Index != SlotMap::NullSlot)
+				comboIndex++;
 		}
 
-		if (m_appGui->GetAppData()->CubeMapIndex == texID)
+		// Returns whether the map itself was the deleted texture.
+		auto fixTextureRef = [&](int32& InOutMapIndex, int32& InOutComboIndex)
+		{
+			if (InOutComboIndex == comboIndex)
+				InOutComboIndex = -1;
+			else if (InOutComboIndex > comboIndex)
+				InOutComboIndex--;
+
+			if (InOutMapIndex != texID)
+				return false;
+			InOutMapIndex = -1;
+			return true;
+		};
+
+		for (auto& mat : m_allMaterialRefs)
 		{
-			m_appGui->GetAppData()->CubeMapIndex = -1;
-			m_appGui->GetAppData()->CubeMapComboIndex = -1;
+			bool bChanged = fixTextureRef(mat->DiffuseMapIndex, mat->DiffuseMapComboIndex);
+			bChanged |= fixTextureRef(mat->NormalMapIndex, mat->NormalMapComboIndex);
+			bChanged |= fixTextureRef(mat->ORMMapIndex, mat->ORMMapComboIndex);
+			if (bChanged)
+			{
+				mat->MarkAsDirty();
+			}
 		}
-		m_appGui->GetAppData()->CubeMapComboIndex--;	
+		fixTextureRef(m_appGui->GetAppData()->CubeMapIndex, m_appGui->GetAppData()->CubeMapComboIndex);
+
+		m_allTextureRefs.erase(std::find(m_allTextureRefs.begin(), m_allTextureRefs.end(), tex));
+		m_textureSlots.Remove(tex);
 
-		m_allTextures.erase(id_name.second);
+		m_allTextures.erase(tex->Name);
 	}
-	Texture::Count = (uint32)m_allTextures.size() - m_maxPreGBuffers - m_maxGBuffers;
+}
 
-	// Finally Resize Buffers if Needed.
-	if (bHasAnyItemsToDelete && bResizeObjCBNeeded)
-	{		
-		for (auto& ri : m_allRItems)
+void GWorld::ReserveSlotBuffers()
+{
+	const uint32 numObjectSlots = m_renderItemSlots.GetCapacity();
+	const uint32 numMaterialSlots = m_materialSlots.GetCapacity();
+	const uint32 numLightSlots = m_lightSlots.GetCapacity();
+	if (numObjectSlots <= m_objectBufferCapacity && numMaterialSlots <= m_materialBufferCapacity && numLightSlots <= m_lightBufferCapacity)
+		return;
+
+	// Dynamic Create Resource Need WaitForGpu.
+	m_deviceResources->WaitForGpu();
+
+	// New buffers start empty, everything of the kind is uploaded again.
+	if (numObjectSlots > m_objectBufferCapacity)
+	{
+		m_objectBufferCapacity = std::max(numObjectSlots, 2 * m_objectBufferCapacity);
+		for (uint32 i = 0; i < m_deviceResources->GetBackBufferCount(); ++i)
 		{
-			ri.second->MarkAsDirty();
+			m_frameResources[i]->ResizeBuffer<ObjectConstant>(m_objectBufferCapacity);
+			m_frameResources[i]->ResizeBuffer<InstanceData>(m_objectBufferCapacity);
 		}
-		for (uint32 i = 0; i < m_deviceResources->GetBackBufferCount(); ++i)
+		for (auto& ri : m_allRItems)
 		{
-			m_frameResources[i]->ResizeBuffer<ObjectConstant>((uint32)m_allRItems.size());
+			ri.second->MarkAsDirty();
 		}
 	}
-	if (bHasAnyItemsToDelete && bResizeMatSBNeeded)
+	if (numMaterialSlots > m_materialBufferCapacity)
 	{
-		for (auto& mat : m_allMaterials)
+		m_materialBufferCapacity = std::max(numMaterialSlots, 2 * m_materialBufferCapacity);
+		for (uint32 i = 0; i < m_deviceResources->GetBackBufferCount(); ++i)
 		{
-			mat.second->MarkAsDirty();
+			m_frameResources[i]->ResizeBuffer<MaterialData>(m_materialBufferCapacity);
 		}
-		for (uint32 i = 0; i < m_deviceResources->GetBackBufferCount(); ++i)
+		for (auto& mat : m_allMaterialRefs)
 		{
-			m_frameResources[i]->ResizeBuffer<MaterialData>((uint32)m_allMaterials.size());
+			mat->MarkAsDirty();
 		}
 	}
-	if (bHasAnyItemsToDelete && bResizeLitSBNeeded)
+	if (numLightSlots > m_lightBufferCapacity)
 	{
-		for (auto& lit : m_allLights)
+		m_lightBufferCapacity = std::max(numLightSlots, 2 * m_lightBufferCapacity);
+		for (uint32 i = 0; i < m_deviceResources->GetBackBufferCount(); ++i)
 		{
-			lit.second->MarkAsDirty();
+			m_frameResources[i]->ResizeBuffer<LightData>(m_lightBufferCapacity);
 		}
-		for (uint32 i = 0; i < m_deviceResources->GetBackBufferCount(); ++i)
+		for (auto& lit : m_allLightRefs)
 		{
-			m_frameResources[i]->ResizeBuffer<LightData>((uint32)m_allLights.size());
+			lit->MarkAsDirty();
 		}
 	}
+}
+
+void GWorld::AddToLayer(RenderItem* InRenderItem, RenderLayer InLayer)
+{
+	assert(InRenderItem->LayerPositions[InLayer] < 0);
 
+	InRenderItem->LayerPositions[InLayer] = (int32)m_renderItemLayer[InLayer].size();
+	m_renderItemLayer[InLayer].push_back(InRenderItem);
+}
+
+void GWorld::RemoveFromLayers(RenderItem* InRenderItem)
+{
+	for (uint32 layer = 0; layer < RenderLayer::Count; ++layer)
+	{
+		const int32 position = InRenderItem->LayerPositions[layer];
+		if (position < 0)
+			continue;
+
+		// The last item of the layer takes the place.
+		std::vector<RenderItem*>& items = m_renderItemLayer[layer];
+		RenderItem* last = items.back();
+		items[position] = last;
+		last->LayerPositions[layer] = position;
+		items.pop_back();
+
+		InRenderItem->LayerPositions[layer] = -1;
+	}
 }
 
 void GWorld::HandleRebuildRenderItem()
@@ -1874,19 +2492,146 @@ void GWorld::HandleRebuildRenderItem()
 					ri->CachedGeometryData = builtInMesh;
 					ri->NumVertices = (uint32)builtInMesh.Vertices.size();
 					ri->NumIndices = (uint32)builtInMesh.Indices32.size();
-					m_deviceResources->CreateCommonGeometry<Vertex, uint32>(ri, builtInMesh.Vertices, builtInMesh.Indices32);
+					ri->Bounds = builtInMesh.CalcBounds();
+					ri->UpdateWorldBounds();
+					CreateRenderItemGeometry(ri);
 				}
 				else
 				{
 					m_deviceResources->WaitForGpu();
 					ri->CachedGeometryData.SetColor(ri->VertexColor);
-					m_deviceResources->CreateCommonGeometry<Vertex, uint32>(ri, ri->CachedGeometryData.Vertices, ri->CachedGeometryData.Indices32);
+
+					// Only the color changed, the triangles are the same.
+					CreateRenderItemGeometry(ri, false);
 				}
 			});
 		}
 	}
 }
 
+void GWorld::CreateRenderItemGeometry(RenderItem* InRenderItem, bool bRebuildBVH /*= true*/)
+{
+	GeometryData<Vertex>& meshData = InRenderItem->CachedGeometryData;
+
+	if (bRebuildBVH)
+	{
+		InRenderItem->CachedBVH.Clear();
+		if (!InRenderItem->bIntersectBoundingOnly)
+		{
+			InRenderItem->CachedBVH.Build(meshData.Vertices, meshData.Indices32);
+		}
+	}
+
+	// A rebuild, what this item shared before is not what it holds now.
+	m_geometryCache.Remove(InRenderItem);
+
+	// The same content already lives on the GPU, e.g. a model imported many times or the same built-in box,
+	// share its buffers so the draws can be instanced. A hash collision uploads its own copy.
+	const uint64 geometryHash = ComputeGeometryHash(InRenderItem);
+	std::shared_ptr<D3DRenderData> renderData = m_geometryCache.Share(geometryHash, InRenderItem,
+		[&](const RenderItem& InSource) { return HasSameGeometry(InRenderItem, &InSource); });
+	if (renderData != nullptr)
+	{
+		InRenderItem->RenderData = renderData;
+		InRenderItem->MarkAsDirty();
+		return;
+	}
+
+	const bool bUse16BitIndices = meshData.CanUse16BitIndices();
+
+	std::vector<std::vector<uint8>> positionStream;
+
+	if (InRenderItem->bPackVertices)
+	{
+		std::vector<PackedVertex> packedVertices;
+		XMFLOAT3 positionScale;
+		XMFLOAT3 positionBias;
+		VertexPacker::PackVertices(meshData.Vertices, packedVertices, positionScale, positionBias);
+
+		if (bUse16BitIndices)
+			m_deviceResources->CreateCommonGeometry<PackedVertex, uint16>(InRenderItem, packedVertices, meshData.GetIndices16(), InRenderItem->CachedLODs, InRenderItem->CachedMeshlets);
+		else
+			m_deviceResources->CreateCommonGeometry<PackedVertex, uint32>(InRenderItem, packedVertices, meshData.Indices32, InRenderItem->CachedLODs, InRenderItem->CachedMeshlets);
+
+		InRenderItem->RenderData->PositionScale = positionScale;
+		InRenderItem->RenderData->PositionBias = positionBias;
+
+		VertexQuantization quantization;
+		quantization.PositionScale = positionScale;
+		quantization.PositionBias = positionBias;
+		PackedPositionStreamLayout::EmitStreams(meshData.Vertices, quantization, positionStream);
+		m_deviceResources->CreatePositionStream(InRenderItem, positionStream[0], PackedPositionStreamLayout::GetStride(0));
+	}
+	else
+	{
+		if (bUse16BitIndices)
+			m_deviceResources->CreateCommonGeometry<Vertex, uint16>(InRenderItem, meshData.Vertices, meshData.GetIndices16(), InRenderItem->CachedLODs, InRenderItem->CachedMeshlets);
+		else
+			m_deviceResources->CreateCommonGeometry<Vertex, uint32>(InRenderItem, meshData.Vertices, meshData.Indices32, InRenderItem->CachedLODs, InRenderItem->CachedMeshlets);
+
+		PositionStreamLayout::EmitStreams(meshData.Vertices, VertexQuantization(), positionStream);
+		m_deviceResources->CreatePositionStream(InRenderItem, positionStream[0], PositionStreamLayout::GetStride(0));
+	}
+
+	m_geometryCache.Add(geometryHash, InRenderItem, InRenderItem->RenderData);
+
+	// The entity store keeps a pointer to the render data, the object constants its position quantization.
+	InRenderItem->MarkAsDirty();
+}
+
+uint64 GWorld::ComputeGeometryHash(const RenderItem* InRenderItem) const
+{
+	const GeometryData<Vertex>& meshData = InRenderItem->CachedGeometryData;
+
+	uint64 hash = HashMemory(meshData.Vertices.data(), meshData.Vertices.size() * sizeof(Vertex));
+	hash = HashMemory(meshData.Indices32.data(), meshData.Indices32.size() * sizeof(uint32), hash);
+	for (const auto& lod : InRenderItem->CachedLODs)
+	{
+		hash = HashMemory(lod.Indices32.data(), lod.Indices32.size() * sizeof(uint32), hash);
+	}
+	for (const auto& meshlet : InRenderItem->CachedMeshlets)
+	{
+		hash = HashMemory(&meshlet.StartIndexLocation, sizeof(meshlet.StartIndexLocation), hash);
+		hash = HashMemory(&meshlet.IndexCount, sizeof(meshlet.IndexCount), hash);
+	}
+
+	const uint32 counts[3] = { (uint32)InRenderItem->CachedLODs.size(), (uint32)InRenderItem->CachedMeshlets.size(), InRenderItem->bPackVertices ? 1u : 0u };
+	return HashMemory(counts, sizeof(counts), hash);
+}
+
+bool GWorld::HasSameGeometry(const RenderItem* InA, const RenderItem* InB) const
+{
+	auto sameArray = [](const auto& a, const auto& b)
+	{
+		return a.size() == b.size() && (a.empty() || memcmp(a.data(), b.data(), a.size() * sizeof(a[0])) == 0);
+	};
+
+	const GeometryData<Vertex>& a = InA->CachedGeometryData;
+	const GeometryData<Vertex>& b = InB->CachedGeometryData;
+
+	if (InA->bPackVertices != InB->bPackVertices || !sameArray(a.Vertices, b.Vertices) || !sameArray(a.Indices32, b.Indices32))
+		return false;
+
+	if (InA->CachedLODs.size() != InB->CachedLODs.size() || InA->CachedMeshlets.size() != InB->CachedMeshlets.size())
+		return false;
+
+	for (size_t i = 0; i < InA->CachedLODs.size(); ++i)
+	{
+		if (!sameArray(InA->CachedLODs[i].Indices32, InB->CachedLODs[i].Indices32))
+			return false;
+	}
+
+	for (size_t i = 0; i < InA->CachedMeshlets.size(); ++i)
+	{
+		const Meshlet& meshletA = InA->CachedMeshlets[i];
+		const Meshlet& meshletB = InB->CachedMeshlets[i];
+		if (meshletA.StartIndexLocation != meshletB.StartIndexLocation || meshletA.IndexCount != meshletB.IndexCount)
+			return false;
+	}
+
+	return true;
+}
+
 void GWorld::HandleRenderItemStateChanged()
 {
 	m_renderItemLayer[RenderLayer::Selected].clear();
@@ -1899,6 +2644,40 @@ void GWorld::HandleRenderItemStateChanged()
 	}
 }
 
+void GWorld::UpdateTransforms()
+{
+	htime_point transformStart = hclock::now();
+
+	m_transformHierarchy.Update();
+	for (int32 node : m_transformHierarchy.GetChangedNodes())
+	{
+		// Groups have no render item.
+		RenderItem* ri = static_cast<RenderItem*>(m_transformHierarchy.GetObject(node));
+		if (ri == nullptr)
+			continue;
+
+		ri->TransFormMatrix = m_transformHierarchy.GetWorld(node);
+		ri->UpdateWorldBounds();
+		ri->MarkAsDirty();
+	}
+
+	duration<double, std::milli> transformTime = hclock::now() - transformStart;
+	m_transformTime = transformTime.count();
+}
+
+void GWorld::SyncRenderEntities()
+{
+	// Every change to a render item marks it dirty, the dirty ones are all that can be stale.
+	m_renderItemDirtyList.ForEach([&](IObject* InObject)
+	{
+		const RenderItem* ri = static_cast<const RenderItem*>(InObject);
+		if (ri->Entity != RenderEntityStore::NullEntity)
+		{
+			m_renderEntities.Sync(ri->Entity);
+		}
+	});
+}
+
 CD3DX12_CPU_DESCRIPTOR_HANDLE GWorld::GetCPUDescriptorHeapStartOffset(uint32 InOffset /*= 0*/)
 {
 	return CD3DX12_CPU_DESCRIPTOR_HANDLE(
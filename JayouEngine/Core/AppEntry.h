@@ -11,9 +11,20 @@
 #include "Common/Camera.h"
 #include "Common/TimerManager.h"
 #include "Common/AssimpImporter.h"
+#include "Common/MeshCache.h"
+#include "Common/ImportQueue.h"
 #include "Common/TextureImporter.h"
 #include "Common/ShadowMap.h"
 #include "Common/CubeMap.h"
+#include "Common/FrustumCuller.h"
+#include "Common/LightClusterBuilder.h"
+#include "Common/DrawPacketSorter.h"
+#include "Common/InstanceBatcher.h"
+#include "Common/DirtyList.h"
+#include "Common/RenderEntityStore.h"
+#include "Common/SlotMap.h"
+#include "Common/GeometryCache.h"
+#include "Common/ThreadManager.h"
 
 using namespace Core;
 using namespace D3DCore;
@@ -37,23 +48,89 @@ public:
 	std::unique_ptr<Camera>                                                m_camera = nullptr;
 	std::unique_ptr<Camera>                                                m_dirLightCamera = nullptr;
 
-	std::unique_ptr<AssimpImporter>                                        m_assimpImporter = nullptr;
 	std::unique_ptr<TextureImporter>                                       m_textureImporter = nullptr;
+
+	// Running imports and the finished ones not yet added, the GUI shows their progress. Finished ones are added to
+	// the world at the start of the next Tick, see GWorld::FinishImports.
+	ImportQueue                                                            m_imports;
 	
 	// Scene Resources (e.g. Geo, Mat, Tex).
-	std::unordered_map<std::string, std::unique_ptr<Texture>>              m_allTextures;
+	std::unordered_map<NameId, std::unique_ptr<Texture>>                   m_allTextures;
 	std::vector<Texture*>                                                  m_allTextureRefs;
 
-	std::unordered_map<std::string, std::unique_ptr<Material>>             m_allMaterials;
+	std::unordered_map<NameId, std::unique_ptr<Material>>                  m_allMaterials;
 	std::vector<Material*>                                                 m_allMaterialRefs;
 
-	std::unordered_map<std::string, std::unique_ptr<Light>>                m_allLights;
+	std::unordered_map<NameId, std::unique_ptr<Light>>                     m_allLights;
+
+	// Last suffix given to a taken name, see Utility::MakeUniqueName.
+	std::unordered_map<NameId, uint32>                                     m_nameSuffixes;
 	std::vector<Light*>                                                    m_allLightRefs;
 
+	// Index of every cached object, stable until GarbageCollection frees it. The buffers only grow, see GWorld::ReserveSlotBuffers.
+	SlotMap                                                                m_renderItemSlots;
+	SlotMap                                                                m_materialSlots;
+	SlotMap                                                                m_lightSlots;
+	SlotMap                                                                m_textureSlots;     // Descriptor m_maxPreGBuffers + m_maxGBuffers + Index.
+	uint32                                                                 m_objectBufferCapacity = 0;
+	uint32                                                                 m_materialBufferCapacity = 0;
+	uint32                                                                 m_lightBufferCapacity = 0;
+
 	// Render Data.
-	std::unordered_map<std::string, std::unique_ptr<RenderItem>>           m_allRItems;
+	std::unordered_map<NameId, std::unique_ptr<RenderItem>>                m_allRItems;
+
+	// Uploaded geometry by content hash, see CreateRenderItemGeometry. A hit is compared against the CPU data
+	// of an item sharing it, never shared on the hash alone.
+	GeometryCache<RenderItem, D3DRenderData>                               m_geometryCache;
 	std::vector<RenderItem*>                                               m_renderItemLayer[RenderLayer::Count];
 
+	// Parent links of every RenderItem, imported assets keep their node tree as groups, see GWorld::UpdateTransforms.
+	TransformHierarchy                                                     m_transformHierarchy;
+	double                                                                 m_transformTime = 0.0; // Milliseconds.
+
+	// World bounds of every RenderItem, masked by GetRenderLayerMask.
+	SceneBVH                                                               m_sceneBVH;
+
+	// Per frame data of every cached RenderItem, synced from the dirty ones, see GWorld::SyncRenderEntities.
+	RenderEntityStore                                                      m_renderEntities;
+
+	// Main view and shadow caster culling of RenderLayer::Opaque, see AppEntry::CullRenderItems.
+	// Culler slots are entity indices, the entity lists below are entity indices too.
+	FrustumCuller                                                          m_frustumCuller;
+	std::vector<uint32>                                                    m_visibleIndices;
+	std::vector<uint32>                                                    m_visibleEntities;
+	std::vector<RenderItem*>                                               m_visibleRenderItems;
+	std::vector<uint32>                                                    m_shadowCasterIndices;
+	std::vector<uint32>                                                    m_shadowCasterEntities; // bCastShadow items only.
+	double                                                                 m_cullTime = 0.0;     // Milliseconds.
+
+	// Point & spot lights binned into view clusters for the PBR pass, see AppEntry::UpdateLightClusters.
+	LightClusterBuilder                                                    m_lightClusterBuilder;
+	std::vector<ClusterLight>                                              m_clusterLights;
+	std::vector<uint32>                                                    m_dirLightIndices;
+	uint32                                                                 m_lightIndexCapacity = 0;
+	double                                                                 m_lightClusterTime = 0.0; // Milliseconds.
+
+	// Draw order of each DrawRenderItem call, see DrawPacketSorter. Statistics are per frame.
+	DrawPacketSorter                                                       m_drawPacketSorter;
+	std::vector<uint64>                                                    m_drawKeys;
+	std::vector<uint32>                                                    m_drawEntities;
+	uint32                                                                 m_numDrawPackets = 0;
+	uint32                                                                 m_numDrawInstances = 0;
+	uint32                                                                 m_numBufferBindings = 0;
+	double                                                                 m_drawSortTime = 0.0;     // Milliseconds.
+
+	// Instanced draws of the GBuffer, wireframe and shadow passes, see InstanceData.
+	InstanceBatcher                                                        m_instanceBatcher;
+	uint32                                                                 m_instanceIndexCapacity = 0;
+
+	// Objects to upload to the current frame resource, filled by MarkAsDirty. Items leave them in GarbageCollection.
+	DirtyList                                                              m_renderItemDirtyList;
+	DirtyList                                                              m_materialDirtyList;
+	DirtyList                                                              m_lightDirtyList;
+	uint32                                                                 m_numDirtyUpdates = 0;
+	double                                                                 m_dirtyUpdateTime = 0.0;  // Milliseconds.
+
 	// Constant Buffer & Structure Buffer Count.
 	UINT                                                                   m_passCount = 1;
 	UINT                                                                   m_objectCount = 0;
@@ -77,17 +154,55 @@ public:
 	void GWorldCached(std::unique_ptr<Texture>& InTexture);
 	void GWorldCached(std::unique_ptr<Material>& InMaterial);
 	void GWorldCached(std::unique_ptr<Light>& InLight);
-	void GWorldCached(std::unique_ptr<RenderItem>& InRenderItem, const RenderLayer& InRenderLayer, bool bIsSelectable = true);
+	void GWorldCached(std::unique_ptr<RenderItem>& InRenderItem, const RenderLayer& InRenderLayer, bool bIsSelectable = true,
+		int32 InParentNode = TransformHierarchy::NullNode);
 	void AddRenderItem(const BuiltInGeoDesc& InGeoDesc);
+	// Reads and converts the model on the job system, several imports run side by side. Returns at once.
 	void AddRenderItem(const ImportGeoDesc& InGeoDesc);
 	void AddTexture2D(const ImportTexDesc& InTexDesc);
 	void AddMaterial(const MaterialDesc& InMaterialDesc, bool bUseTexture = true);
 	void AddLight(const LightDesc& InLightDesc);
 
+	// Adds the render items of the imports finished since the last call, the GPU buffers are created here.
+	void FinishImports();
+
+	// Cancels the running imports and waits for them, nothing is added.
+	void CancelImports();
+	void AddImportedRenderItems(ImportTask& InTask);
+
+	// Re-keys the object in its registry. A name already in use is refused, the object keeps its old one.
+	bool Rename(RenderItem* InRenderItem, const NameId& InName);
+	bool Rename(Material* InMaterial, const NameId& InName);
+	bool Rename(Light* InLight, const NameId& InName);
+
+	// Frees the objects marked as deleted, found on the dirty lists. Slots stay put, nothing is renumbered or re-uploaded.
 	void GarbageCollection();
 	void HandleRebuildRenderItem();
 	void HandleRenderItemStateChanged();
-	virtual ~GWorld() {}
+
+	// Propagates the changed local transforms, the render items under them get their new world matrix and bounds.
+	void UpdateTransforms();
+
+	// Copies the render items marked dirty into m_renderEntities.
+	void SyncRenderEntities();
+
+	// Grows the per object, material and light buffers to their slot capacity, doubling. The grown kind is marked dirty.
+	void ReserveSlotBuffers();
+
+	// Swap removal, RenderItem::LayerPositions keeps track of where the item is.
+	void AddToLayer(RenderItem* InRenderItem, RenderLayer InLayer);
+	void RemoveFromLayers(RenderItem* InRenderItem);
+	virtual ~GWorld() { CancelImports(); }
+
+	// Uploads CachedGeometryData/LODs/Meshlets, packed if requested and with 16 bits indices when possible.
+	// Render items with the same geometry content share one D3DRenderData. Marks the item dirty, its RenderData changed.
+	void CreateRenderItemGeometry(RenderItem* InRenderItem, bool bRebuildBVH = true);
+
+	// Hash of everything CreateRenderItemGeometry uploads.
+	uint64 ComputeGeometryHash(const RenderItem* InRenderItem) const;
+
+	// Whether both items upload the same content, what ComputeGeometryHash hashes compared byte for byte.
+	bool HasSameGeometry(const RenderItem* InA, const RenderItem* InB) const;
 
 protected:
 
@@ -175,11 +290,21 @@ private:
 	void UpdateShadowPassCB();
 	void UpdateMaterialSB();
 	void UpdateLightSB();
+	void UpdateLightClusters();
 	void UpdateCamera();
+	void CullRenderItems();
+	void UpdateLOD();
+	void CullMeshlets();
 	void UpdatePerObjectCB();
 
 	void Render();
-	void DrawRenderItem(std::vector<RenderItem*>& renderItemLayer);
+	// InSortCamera: sort by view depth, front to back (back to front for RenderLayer::Transparent), nullptr keeps state order only.
+	// bInstancing: neighbours with the same geometry, material and LOD go out as one instanced draw, the shaders read InstanceData.
+	void DrawRenderItem(std::vector<RenderItem*>& renderItemLayer, bool bMeshletCulling = false, ID3D12PipelineState* InPackedPSO = nullptr, bool bPositionOnly = false,
+		const Camera* InSortCamera = nullptr, RenderLayer InLayer = RenderLayer::Opaque, bool bInstancing = false);
+	// Same as above from m_renderEntities indices.
+	void DrawRenderEntities(const std::vector<uint32>& InEntities, bool bMeshletCulling = false, ID3D12PipelineState* InPackedPSO = nullptr, bool bPositionOnly = false,
+		const Camera* InSortCamera = nullptr, RenderLayer InLayer = RenderLayer::Opaque, bool bInstancing = false);
 	void DrawFullscreenQuad(ID3D12GraphicsCommandList* commandList);
 
 	void DrawSceneToShadowMap();
@@ -210,7 +335,7 @@ private:
 	std::unordered_map<std::string, ComPtr<ID3D12RootSignature>>           m_rootSIGs;
 	std::unordered_map<std::string, ComPtr<ID3DBlob>>                      m_shaderByteCode;
 	std::unordered_map<std::string, std::vector<D3D12_INPUT_ELEMENT_DESC>> m_inputLayout;
-	std::unordered_map<std::string, ComPtr<ID3D12PipelineState>>           m_PSOs;
+	std::unordered_map<NameId, ComPtr<ID3D12PipelineState>>                m_PSOs;
 
 	std::unique_ptr<ShadowMap>                                             m_shadowMap = nullptr;
 	// std::unique_ptr<CubeMap>                                               m_cubeMap = nullptr;
@@ -140,6 +140,7 @@ void AppGUI::UpdateGUI()
 	m_blockAreaId = 0;	
 	
 	PopupModal_ProcessingOpenedFiles();
+	ImportProgressPanel();
 
 	MainPanel();
 	WorldOutliner();	
@@ -570,8 +571,8 @@ void AppGUI::MenuNew()
 					{
 						if (tex->Index != -1)
 						{
-							allTexNames.push_back(tex->Name);
-							allTexNames_Str += tex->Name + '\0';
+							allTexNames.push_back(tex->Name.ToString());
+							allTexNames_Str += tex->Name.ToString() + '\0';
 						}
 					}
 					if (!m_gWorld->m_allTextureRefs.empty())
@@ -628,6 +629,15 @@ void AppGUI::MenuOption()
 			SetBlockAreas();
 
 			ImGui::Checkbox(u8"ʾ߿", &m_appData->bShowWireframe);
+			ImGui::Checkbox(u8"LOD", &m_appData->bEnableLOD);
+			if (m_appData->bEnableLOD)
+			{
+				ImGui::SameLine();
+				ImGui::SetNextItemWidth(70);
+				ImGui::DragFloat(u8"()", &m_appData->LODErrorThreshold, 0.1f, 0.1f, 16.0f);
+			}
+			ImGui::Checkbox(u8"׶޳", &m_appData->bEnableFrustumCulling);
+			ImGui::Checkbox(u8"޳", &m_appData->bEnableMeshletCulling);
 			ImGui::Checkbox(u8"ʾ", &m_appData->bShowBackGround);			
 			ImGui::Checkbox(u8"ʾ", &m_appData->bShowGrid);
 			ImGui::SameLine();
@@ -654,12 +664,14 @@ void AppGUI::MenuOption()
 
 				static bool lockScale = true;
 
-				Vector3 trans = m_gWorld->m_allRItems["grid"]->Translation;
-				Vector3 rotat = m_gWorld->m_allRItems["grid"]->Rotation;
-				Vector3 scale = m_gWorld->m_allRItems["grid"]->Scale;
+				RenderItem* grid = m_gWorld->m_allRItems["grid"].get();
+
+				Vector3 trans = grid->Translation;
+				Vector3 rotat = grid->Rotation;
+				Vector3 scale = grid->Scale;
 
-				ImGui::LabelText(u8"", u8":  %d", m_gWorld->m_allRItems["grid"]->NumVertices);
-				ImGui::LabelText(u8"", u8":  %d", m_gWorld->m_allRItems["grid"]->NumIndices);
+				ImGui::LabelText(u8"", u8":  %d", grid->NumVertices);
+				ImGui::LabelText(u8"", u8":  %d", grid->NumIndices);
 
 				ImGui::Text(u8"任");
 				ImGui::Checkbox(u8"", &lockScale);
@@ -676,8 +688,8 @@ void AppGUI::MenuOption()
 					ImGui::DragFloat3(u8"", (float*)&scale, 0.01f, 0.0f, 10.0f);
 				}
 
-				m_gWorld->m_allRItems["grid"]->SetTransFormMatrix(trans, rotat, scale);
-				m_gWorld->m_allRItems["grid"]->MarkAsDirty();
+				grid->SetTransFormMatrix(trans, rotat, scale);
+				grid->MarkAsDirty();
 			}
 
 			ImGui::Separator();
@@ -693,8 +705,8 @@ void AppGUI::MenuOption()
 				{
 					if (tex->Index != -1)
 					{
-						allTexNames.push_back(tex->Name);
-						allTexNames_Str += tex->Name + '\0';
+						allTexNames.push_back(tex->Name.ToString());
+						allTexNames_Str += tex->Name.ToString() + '\0';
 					}
 				}
 				if (!m_gWorld->m_allTextureRefs.empty())
@@ -792,6 +804,15 @@ void AppGUI::MainPanel()
 		
 		ImGui::Separator();
 		ImGui::Text(u8"Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
+		ImGui::Text(u8"ɼ %u / %u, ӰͶ %u, ޳ %.3f ms", (uint32)m_gWorld->m_visibleRenderItems.size(),
+			(uint32)m_gWorld->m_renderItemLayer[RenderLayer::Opaque].size(), (uint32)m_gWorld->m_shadowCasterEntities.size(), m_gWorld->m_cullTime);
+		ImGui::Text(u8"ƹ %u ƹ,  %u,  %u, %.3f ms", (uint32)m_gWorld->m_clusterLights.size(),
+			(uint32)m_gWorld->m_lightClusterBuilder.GetLightIndices().size(), m_gWorld->m_lightClusterBuilder.GetMaxLightsPerCluster(), m_gWorld->m_lightClusterTime);
+		ImGui::Text(u8" %u, ʵ %u,  %u,  %.3f ms", m_gWorld->m_numDrawPackets, m_gWorld->m_numDrawInstances, m_gWorld->m_numBufferBindings, m_gWorld->m_drawSortTime);
+		ImGui::Text(u8" %u,  %u, ʱ %.3f ms", m_gWorld->m_numDirtyUpdates,
+			m_gWorld->m_renderItemDirtyList.GetNumDirty() + m_gWorld->m_materialDirtyList.GetNumDirty() + m_gWorld->m_lightDirtyList.GetNumDirty(), m_gWorld->m_dirtyUpdateTime);
+		ImGui::Text(u8"任ڵ %u, 㼶 %u,  %u, %.3f ms", m_gWorld->m_transformHierarchy.GetNumNodes(), m_gWorld->m_transformHierarchy.GetNumLevels(),
+			(uint32)m_gWorld->m_transformHierarchy.GetChangedNodes().size(), m_gWorld->m_transformTime);
 		ImGui::End();
 	}
 }
@@ -987,7 +1008,7 @@ void AppGUI::WorldOutliner()
 
 					char buffer[256];
 					uint32 bufferLen = (uint32)ri->Name.size();
-					ri->Name.copy(buffer, bufferLen);
+					memcpy(buffer, ri->Name.c_str(), bufferLen);
 					buffer[bufferLen] = '\0';
 
 					XMFLOAT4 color = ri->VertexColor;				
@@ -1010,18 +1031,27 @@ void AppGUI::WorldOutliner()
 						memcpy(mWorld, (const float*)&ri->TransFormMatrix, 16 * sizeof(float));
 
 						EditTransform(mView, mProj, mWorld);
-						memcpy((float*)&ri->TransFormMatrix, mWorld, 16 * sizeof(float));
+						if (memcmp((const float*)&ri->TransFormMatrix, mWorld, 16 * sizeof(float)) != 0)
+						{
+							memcpy((float*)&ri->TransFormMatrix, mWorld, 16 * sizeof(float));
+							ri->UpdateWorldBounds();
+						}
 					}		
 				
 					// Set Material.
-					std::string allMatNames;					
-					for (auto& mat : m_gWorld->m_allMaterialRefs)
+					// MaterialIndex is a slot, the combo counts the materials in list order.
+					std::string allMatNames;
+					int32 matComboIndex = -1;
+					for (uint32 i = 0; i < (uint32)m_gWorld->m_allMaterialRefs.size(); ++i)
 					{
-						allMatNames += mat->Name + '\0';
+						if (m_gWorld->m_allMaterialRefs[i]->Index == ri->MaterialIndex)
+							matComboIndex = (int32)i;
+						allMatNames += m_gWorld->m_allMaterialRefs[i]->Name.ToString() + '\0';
 					}
 					if (!m_gWorld->m_allMaterialRefs.empty())
 					{
-						ImGui::Combo(u8"ѡ", &ri->MaterialIndex, allMatNames.c_str(), (int)allMatNames.size());
+						if (ImGui::Combo(u8"ѡ", &matComboIndex, allMatNames.c_str(), (int)allMatNames.size()))
+							ri->MaterialIndex = m_gWorld->m_allMaterialRefs[matComboIndex]->Index;
 					}
 
 					if (ri->bIsBuiltIn)
@@ -1069,7 +1099,7 @@ void AppGUI::WorldOutliner()
 							ri->MarkAsDeleted();
 					}				
 
-					ri->Name = buffer;				
+					m_gWorld->Rename(ri, buffer);				
 					ri->bIsVisible = !hide;
 					ri->bCanBeSelected = !hide ? !lock : false;
 					
@@ -1090,7 +1120,7 @@ void AppGUI::WorldOutliner()
 				{
 					char buffer[256];
 					uint32 bufferLen = (uint32)lit->Name.size();
-					lit->Name.copy(buffer, bufferLen);
+					memcpy(buffer, lit->Name.c_str(), bufferLen);
 					buffer[bufferLen] = '\0';
 
 					ImGui::LabelText("ID##2", "ID:  %d", lit->Index);
@@ -1140,7 +1170,7 @@ void AppGUI::WorldOutliner()
 
 					static Vector3 dirCache = lit->Direction;
 
-					lit->Name = buffer;
+					m_gWorld->Rename(lit, buffer);
 					lit->bIsVisible = !hide;
 					lit->bCanBeSelected = !hide ? !lock : false;
 					lit->Position = XMFLOAT3(AffineTransform(lit->World).GetTranslation());
@@ -1162,7 +1192,7 @@ void AppGUI::WorldOutliner()
 				{
 					char buffer[256];
 					uint32 bufferLen = (uint32)mat->Name.size();
-					mat->Name.copy(buffer, bufferLen);
+					memcpy(buffer, mat->Name.c_str(), bufferLen);
 					buffer[bufferLen] = '\0';
 
 					ImGui::LabelText("ID##3", "ID:  %d", mat->Index);
@@ -1185,8 +1215,8 @@ void AppGUI::WorldOutliner()
 						{
 							if (tex->Index != -1)
 							{
-								allTexNames.push_back(tex->Name);
-								allTexNames_Str += tex->Name + '\0';
+								allTexNames.push_back(tex->Name.ToString());
+								allTexNames_Str += tex->Name.ToString() + '\0';
 							}
 						}
 						if (!m_gWorld->m_allTextureRefs.empty())
@@ -1239,7 +1269,7 @@ void AppGUI::WorldOutliner()
 					}				
 
 					mat->SetTransFormMatrix(mat->Translation, mat->Rotation, mat->Scale);
-					mat->Name = buffer;
+					m_gWorld->Rename(mat, buffer);
 					mat->MarkAsDirty();
 
 					break;
@@ -1398,6 +1428,8 @@ void AppGUI::PopupModal_ProcessingOpenedFiles()
 		static Vector3  scale = { 0.1f };
 		static bool     lockScale = true;
 		static bool     defaultName = true;
+		static bool     optimizeMesh = true;
+		static bool     packVertices = true;
 		static char     userNamed[256] = "Unnamed";
 		static XMFLOAT4 color = geoDesc.Color;
 
@@ -1417,8 +1449,12 @@ void AppGUI::PopupModal_ProcessingOpenedFiles()
 			ImGui::DragFloat(u8"", (float*)&scale, 0.1f, 0.0f, 100.0f);
 		}
 		ImGui::ColorEdit3(u8"Ĭɫ", (float*)&color);
+		ImGui::Checkbox(u8"Ż", &optimizeMesh);
+		ImGui::Checkbox(u8"ѹ", &packVertices);
 
 		geoDesc.Color = color;
+		geoDesc.bOptimizeMesh = optimizeMesh;
+		geoDesc.bPackVertices = packVertices;
 		geoDesc.Translation = trans;
 		geoDesc.Rotation = rotat;
 		geoDesc.Scale = scale;
@@ -1427,10 +1463,11 @@ void AppGUI::PopupModal_ProcessingOpenedFiles()
 
 		if (ImGui::Button(u8"", ImVec2(60, 0)))
 		{
-			for (auto pair : m_importPathMapTypes)
+			// Every selected model with these options, they are imported side by side in the background.
+			for (auto it = m_importPathMapTypes.begin(); it != m_importPathMapTypes.end();)
 			{
-				std::wstring wpath = pair.first;
-				ESupportFileType fileType = pair.second;
+				std::wstring wpath = it->first;
+				ESupportFileType fileType = it->second;
 
 				std::wstring wname;
 				std::wstring wexten;
@@ -1444,9 +1481,12 @@ void AppGUI::PopupModal_ProcessingOpenedFiles()
 					geoDesc.Name = defaultName ? name : userNamed;
 					geoDesc.PathName = path;
 					m_gWorld->AddRenderItem(geoDesc);
-					m_importPathMapTypes.erase(wpath);
-					break;
-				}				
+					it = m_importPathMapTypes.erase(it);
+				}
+				else
+				{
+					++it;
+				}
 			}
 
 			ImGui::CloseCurrentPopup();
@@ -1455,11 +1495,12 @@ void AppGUI::PopupModal_ProcessingOpenedFiles()
 		ImGui::SameLine();
 		if (ImGui::Button(u8"ȡ", ImVec2(60, 0)))
 		{
-			for (auto pair : m_importPathMapTypes)
+			for (auto it = m_importPathMapTypes.begin(); it != m_importPathMapTypes.end();)
 			{
-				std::wstring wpath = pair.first;
-				m_importPathMapTypes.erase(wpath);
-				break;				
+				if (it->second == SF_AssimpModel)
+					it = m_importPathMapTypes.erase(it);
+				else
+					++it;
 			}
 
 			ImGui::CloseCurrentPopup();
@@ -1533,6 +1574,40 @@ void AppGUI::PopupModal_ProcessingOpenedFiles()
 	}
 }
 
+void AppGUI::ImportProgressPanel()
+{
+	if (m_gWorld->m_imports.GetTasks().empty())
+		return;
+
+	if (!ImGui::Begin(u8"", nullptr, ImGuiWindowFlags_AlwaysAutoResize))
+	{
+		ImGui::End();
+		return;
+	}
+
+	SetBlockAreas();
+
+	for (size_t i = 0; i < m_gWorld->m_imports.GetTasks().size(); ++i)
+	{
+		auto& task = m_gWorld->m_imports.GetTasks()[i];
+
+		ImGui::PushID((int)i);
+		ImGui::ProgressBar(task->Progress.Progress.load(), ImVec2(240.0f, 0.0f), task->Desc.Name.c_str());
+		ImGui::SameLine();
+		if (task->Progress.bCancel)
+		{
+			ImGui::TextDisabled(u8"ȡ");
+		}
+		else if (ImGui::Button(u8"ȡ"))
+		{
+			task->Progress.bCancel = true;
+		}
+		ImGui::PopID();
+	}
+
+	ImGui::End();
+}
+
 void AppGUI::SetBlockAreas(bool bFullScreen)
 {
 	if (m_blockAreaId >= m_appData->BlockAreas.size())
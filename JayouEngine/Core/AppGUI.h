@@ -53,6 +53,9 @@ private:
 
 	void PopupModal_ProcessingOpenedFiles();
 
+	// Running model imports with a cancel button each, see GWorld::AddRenderItem(const ImportGeoDesc&).
+	void ImportProgressPanel();
+
 	void SetBlockAreas(bool bFullScreen = false);
 
 	void EditTransform(const float *cameraView, const float *cameraProjection, float* matrix, int id = 0, bool bNoScale = false);
@@ -3,95 +3,294 @@
 //
 
 #include "AssimpImporter.h"
+#include "ThreadManager.h"
+#include "VFSIOSystem.h"
 
 #include <assimp/Importer.hpp>  // C++ m_importer interface
 #include <assimp/scene.h>       // Output data structure
+#include <assimp/ProgressHandler.hpp>
 
-bool Core::AssimpImporter::Import(const ImportGeoDesc& InGeoDesc)
+using namespace Utility;
+
+namespace
+{
+	// Reading and post processing are the first half of ImportProgress::Progress, the conversion the second.
+	class ImportProgressHandler : public Assimp::ProgressHandler
+	{
+	public:
+
+		explicit ImportProgressHandler(Core::ImportProgress* InOutProgress) : m_progress(InOutProgress) {}
+
+		bool Update(float InPercentage = -1.0f) override
+		{
+			if (InPercentage >= 0.0f)
+			{
+				m_progress->Progress = 0.5f * std::min(InPercentage, 1.0f);
+			}
+			return !m_progress->bCancel.load();
+		}
+
+	private:
+
+		Core::ImportProgress* m_progress;
+	};
+
+	// One attribute at a time over the raw arrays. aiVector3D and XMFLOAT3 are both three packed floats, so each
+	// attribute is a plain 12 byte copy per vertex, without the per vertex branches and reloads through the scene.
+	void ConvertMesh(const aiMesh& InMesh, GeometryData<Vertex>& OutData)
+	{
+		static_assert(sizeof(aiVector3D) == sizeof(XMFLOAT3), "Assimp built with double precision");
+
+		const uint32 numVertices = InMesh.mNumVertices;
+		OutData.Vertices.resize(numVertices);
+		Vertex* vertices = OutData.Vertices.data();
+
+		const aiVector3D* positions = InMesh.mVertices;
+		for (uint32 j = 0; j < numVertices; ++j)
+		{
+			memcpy(&vertices[j].Position, &positions[j], sizeof(XMFLOAT3));
+		}
+
+		if (const aiVector3D* normals = InMesh.mNormals)
+		{
+			for (uint32 j = 0; j < numVertices; ++j)
+			{
+				memcpy(&vertices[j].Normal, &normals[j], sizeof(XMFLOAT3));
+			}
+		}
+
+		if (const aiVector3D* tangents = InMesh.mTangents)
+		{
+			for (uint32 j = 0; j < numVertices; ++j)
+			{
+				memcpy(&vertices[j].TangentU, &tangents[j], sizeof(XMFLOAT3));
+			}
+		}
+
+		if (const aiVector3D* texCoords = InMesh.mTextureCoords[0])
+		{
+			for (uint32 j = 0; j < numVertices; ++j)
+			{
+				memcpy(&vertices[j].TexC, &texCoords[j], sizeof(XMFLOAT2));
+			}
+		}
+
+		// Index Array, a triangulated face has three indices.
+		const uint32 numFaces = InMesh.mNumFaces;
+		OutData.Indices32.resize(numFaces * 3);
+		uint32* indices = OutData.Indices32.data();
+		for (uint32 m = 0; m < numFaces; ++m)
+		{
+			const aiFace& face = InMesh.mFaces[m];
+			for (uint32 n = 0; n < face.mNumIndices; ++n)
+			{
+				indices[n + m * 3] = face.mIndices[n];
+			}
+		}
+	}
+}
+
+bool Core::AssimpImporter::Import(const ImportGeoDesc& InGeoDesc, ImportProgress* InOutProgress /*= nullptr*/)
 {
 	FreeCachedData();
 
 	Assimp::Importer importer;
 
+	// Not owned by the importer, taken back before it goes away.
+	std::unique_ptr<ImportProgressHandler> progressHandler;
+	if (InOutProgress != nullptr)
+	{
+		progressHandler = std::make_unique<ImportProgressHandler>(InOutProgress);
+		importer.SetProgressHandler(progressHandler.get());
+	}
+
+	// Owned and deleted by the importer.
+	importer.SetIOHandler(new VFSIOSystem());
+
 	const aiScene* scene = importer.ReadFile(InGeoDesc.PathName.data(), InGeoDesc.PPSFlags);
 
 	if (!scene)
 	{
-		m_errorString.push(std::string(importer.GetErrorString()));
+		importer.SetProgressHandler(nullptr);
+		m_errorString.push(InOutProgress != nullptr && InOutProgress->bCancel ? std::string("Import cancelled") : std::string(importer.GetErrorString()));
 		return false;
 	}
 
-	int numMeshes = scene->mNumMeshes;
+	const uint32 numMeshes = scene->mNumMeshes;
 	std::vector<Geometry> geometries(numMeshes);
-	for (int i = 0; i < numMeshes; ++i)
+
+	// Named up front in mesh order, so the interned ids do not depend on the scheduling.
+	std::vector<uint32> triangleMeshes;
+	for (uint32 i = 0; i < numMeshes; ++i)
 	{
 		if (scene->mMeshes[i]->mPrimitiveTypes != aiPrimitiveType_TRIANGLE)
 			continue;
 
-		// Vertex Array.
-		int numVertices = scene->mMeshes[i]->mNumVertices;
-		std::vector<Vertex> vertices(numVertices);
-		for (int j = 0; j < numVertices; ++j)
+		geometries[i].Name = InGeoDesc.Name + "_" + std::to_string(i);
+		geometries[i].PathName = InGeoDesc.PathName;
+		triangleMeshes.push_back(i);
+	}
+
+	// Largest meshes first so one big mesh does not end up alone at the tail.
+	std::vector<uint32> order(triangleMeshes);
+	std::stable_sort(order.begin(), order.end(), [scene](uint32 a, uint32 b)
+	{
+		return scene->mMeshes[a]->mNumFaces > scene->mMeshes[b]->mNumFaces;
+	});
+
+	// Meshes are independent, a range only writes the geometry and stats of its own meshes.
+	std::vector<MeshOptimizeStats> stats(numMeshes);
+	std::atomic<uint32> numConverted(0);
+	std::atomic<bool> bCancelled(false);
+
+	auto convertMeshes = [&](uint32 InBegin, uint32 InEnd)
+	{
+		for (uint32 r = InBegin; r < InEnd; ++r)
 		{
-			vertices[j].Position.x = scene->mMeshes[i]->mVertices[j].x;
-			vertices[j].Position.y = scene->mMeshes[i]->mVertices[j].y;
-			vertices[j].Position.z = scene->mMeshes[i]->mVertices[j].z;
+			if (bCancelled || (InOutProgress != nullptr && InOutProgress->bCancel))
+			{
+				bCancelled = true;
+				return;
+			}
 
-			if (scene->mMeshes[i]->mNormals != nullptr)
+			const uint32 i = order[r];
+			Geometry& geo = geometries[i];
+
+			// Converted straight into the geometry, from there the vertices are moved along up to the render item.
+			ConvertMesh(*scene->mMeshes[i], geo.Data);
+
+			if (InGeoDesc.bOptimizeMesh)
 			{
-				vertices[j].Normal.x = scene->mMeshes[i]->mNormals[j].x;
-				vertices[j].Normal.y = scene->mMeshes[i]->mNormals[j].y;
-				vertices[j].Normal.z = scene->mMeshes[i]->mNormals[j].z;
+				stats[i] = MeshOptimizer::Optimize(geo.Data);
 			}
-	
-			if (scene->mMeshes[i]->mTangents != nullptr)
+
+			if (InGeoDesc.bBuildMeshlets)
 			{
-				vertices[j].TangentU.x = scene->mMeshes[i]->mTangents[j].x;
-				vertices[j].TangentU.y = scene->mMeshes[i]->mTangents[j].y;
-				vertices[j].TangentU.z = scene->mMeshes[i]->mTangents[j].z;
+				geo.Meshlets = MeshletBuilder::BuildMeshlets(geo.Data);
 			}
-			
-			if (scene->mMeshes[i]->mTextureCoords != nullptr)
+
+			geo.Bounds = geo.Data.CalcBounds();
+
+			if (InOutProgress != nullptr)
 			{
-				if (scene->mMeshes[i]->mTextureCoords[0] != nullptr)
-				{
-					vertices[j].TexC.x = scene->mMeshes[i]->mTextureCoords[0][j].x;
-					vertices[j].TexC.y = scene->mMeshes[i]->mTextureCoords[0][j].y;
-				}
-			}			
+				InOutProgress->Progress = 0.5f + 0.5f * (float)(++numConverted) / (float)numMeshes;
+			}
+		}
+	};
+
+	if (InGeoDesc.bParallel)
+	{
+		ThreadManager::JobSystem::Get().ParallelFor((uint32)order.size(), 1, convertMeshes);
+	}
+	else
+	{
+		convertMeshes(0, (uint32)order.size());
+	}
+
+	if (bCancelled)
+	{
+		importer.SetProgressHandler(nullptr);
+		m_errorString.push("Import cancelled");
+		return false;
+	}
+
+	if (InGeoDesc.bOptimizeMesh)
+	{
+		for (uint32 i : triangleMeshes)
+		{
+			const Geometry& geo = geometries[i];
+			m_optimizeStats[geo.Name.ToString()] = stats[i];
 		}
+	}
+
+	// Node tree, depth first so parents come first. aiMatrix4x4 transforms column vectors, ours rows.
+	std::vector<std::pair<const aiNode*, int32>> stack;
+	if (scene->mRootNode != nullptr)
+	{
+		stack.push_back({ scene->mRootNode, -1 });
+	}
+	while (!stack.empty())
+	{
+		const aiNode* node = stack.back().first;
+		const int32 parent = stack.back().second;
+		stack.pop_back();
+
+		const aiMatrix4x4& m = node->mTransformation;
 
-		// Index Array.
-		int numFaces = scene->mMeshes[i]->mNumFaces;
-		std::vector<uint32> indices(numFaces * 3);
-		for (int m = 0; m < numFaces; ++m)
+		ImportNode importNode;
+		importNode.Name = node->mName.C_Str();
+		importNode.Parent = parent;
+		importNode.LocalTransform = Matrix4(
+			Vector4(m.a1, m.b1, m.c1, m.d1),
+			Vector4(m.a2, m.b2, m.c2, m.d2),
+			Vector4(m.a3, m.b3, m.c3, m.d3),
+			Vector4(m.a4, m.b4, m.c4, m.d4));
+
+		for (uint32 i = 0; i < node->mNumMeshes; ++i)
 		{
-			int numIndices = scene->mMeshes[i]->mFaces[m].mNumIndices;
-			for (int n = 0; n < numIndices; ++n)
+			const Geometry& geo = geometries[node->mMeshes[i]];
+			if (!geo.Data.Vertices.empty() && !geo.Data.Indices32.empty())
 			{
-				indices[n + m * 3] = scene->mMeshes[i]->mFaces[m].mIndices[n];
+				importNode.Geometries.push_back(geo.Name.ToString());
 			}
 		}
 
-		geometries[i].Name = InGeoDesc.Name + "_" + std::to_string(i);
-		geometries[i].PathName = InGeoDesc.PathName;
-		geometries[i].Data.Vertices  = vertices;
-		geometries[i].Data.Indices32 = indices;
-		geometries[i].Bounds = geometries[i].Data.CalcBounds();
+		const int32 index = (int32)m_nodes.size();
+		m_nodes.push_back(importNode);
+
+		for (uint32 i = node->mNumChildren; i > 0; --i)
+		{
+			stack.push_back({ node->mChildren[i - 1], index });
+		}
+	}
+
+	// Everything needed is converted, the scene goes before the simplifier allocates its own copies.
+	importer.FreeScene();
+
+	if (InGeoDesc.NumLODs > 0)
+	{
+		std::vector<Geometry*> lodSources;
+		for (auto& geo : geometries)
+		{
+			if (!geo.Data.Indices32.empty())
+				lodSources.push_back(&geo);
+		}
+
+		SimplifyDesc simplifyDesc;
+		simplifyDesc.NumLODs = InGeoDesc.NumLODs;
+		simplifyDesc.bParallel = InGeoDesc.bParallel;
+		MeshSimplifier::GenerateLODs(lodSources, simplifyDesc);
 	}
 
-	for (auto geo : geometries)
+	for (auto& geo : geometries)
 	{
 		if (!geo.Data.Vertices.empty() && !geo.Data.Indices32.empty())
 		{
-			m_geometries[geo.Name] = geo;
+			m_geometries[geo.Name.ToString()] = std::move(geo);
 		}		
 	}
 
-	importer.FreeScene();
+	importer.SetProgressHandler(nullptr);
+
+	if (InOutProgress != nullptr)
+	{
+		InOutProgress->Progress = 1.0f;
+	}
 	return true;
 }
 
+std::string Core::AssimpImporter::GetLastError() const
+{
+	return m_errorString.empty() ? std::string() : m_errorString.back();
+}
+
+std::unordered_map<std::string, Geometry> Core::AssimpImporter::TakeGeometries()
+{
+	std::unordered_map<std::string, Geometry> geometries;
+	geometries.swap(m_geometries);
+	return geometries;
+}
+
 Geometry Core::AssimpImporter::GetGeometry(const std::string& InGeoName)
 {
 	if (m_geometries.find(InGeoName + "_0") != m_geometries.end())
@@ -106,7 +305,19 @@ const std::unordered_map<std::string, Geometry>& Core::AssimpImporter::GetAllGeo
 	return m_geometries;
 }
 
+const std::vector<ImportNode>& Core::AssimpImporter::GetNodes() const
+{
+	return m_nodes;
+}
+
+const std::unordered_map<std::string, MeshOptimizeStats>& Core::AssimpImporter::GetOptimizeStats() const
+{
+	return m_optimizeStats;
+}
+
 void Core::AssimpImporter::FreeCachedData()
 {
 	m_geometries.clear();
+	m_nodes.clear();
+	m_optimizeStats.clear();
 }
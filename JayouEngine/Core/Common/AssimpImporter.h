@@ -5,6 +5,9 @@
 #pragma once
 
 #include "Interface/IGeoImporter.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "MeshletBuilder.h"
 
 namespace Core
 {
@@ -14,12 +17,24 @@ namespace Core
 
 		AssimpImporter() = default;
 
-		bool Import(const ImportGeoDesc& InGeoDesc) override;
+		bool Import(const ImportGeoDesc& InGeoDesc, ImportProgress* InOutProgress = nullptr) override;
+
+		// Why the last Import failed.
+		std::string GetLastError() const;
 
 		Geometry GetGeometry(const std::string& InGeoName) override;
 
 		const std::unordered_map<std::string, Geometry>& GetAllGeometries() const;
 
+		// Moves the geometries of the last import out, the importer is left empty.
+		std::unordered_map<std::string, Geometry> TakeGeometries();
+
+		// Node tree of the last import, a geometry may appear under several nodes.
+		const std::vector<ImportNode>& GetNodes() const;
+
+		// ACMR/ATVR before and after optimization, keyed by geometry name (ImportGeoDesc::bOptimizeMesh).
+		const std::unordered_map<std::string, MeshOptimizeStats>& GetOptimizeStats() const;
+
 		void FreeCachedData() override;
 
 	protected:
@@ -27,5 +42,9 @@ namespace Core
 		std::queue<std::string> m_errorString;
 
 		std::unordered_map<std::string, Geometry> m_geometries;
+
+		std::vector<ImportNode> m_nodes;
+
+		std::unordered_map<std::string, MeshOptimizeStats> m_optimizeStats;
 	};
 }
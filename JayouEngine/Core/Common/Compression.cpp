@@ -0,0 +1,218 @@
+//
+// Compression.cpp
+//
+
+#include "Compression.h"
+
+using namespace Utility;
+
+namespace
+{
+	const uint32 kMinMatch = 4;
+	const uint32 kMaxOffset = 65535;
+	const uint64 kLastLiterals = 5;  // A block ends with at least this many literals,
+	const uint64 kMatchLimit = 12;   // and its last match starts at least this far from the end.
+	const uint32 kHashLog = 16;
+
+	uint32 Read32(const uint8* InData)
+	{
+		uint32 value;
+		memcpy(&value, InData, sizeof(value));
+		return value;
+	}
+
+	uint32 Hash4(uint32 InSequence)
+	{
+		return (InSequence * 2654435761u) >> (32 - kHashLog);
+	}
+
+	// 15 in the token, the rest in 255 steps.
+	uint64 LengthBytes(uint64 InLength)
+	{
+		return InLength < 15 ? 0 : (InLength - 15) / 255 + 1;
+	}
+
+	uint8* WriteLength(uint8* OutData, uint64 InLength)
+	{
+		for (InLength -= 15; InLength >= 255; InLength -= 255)
+		{
+			*OutData++ = 255;
+		}
+		*OutData++ = (uint8)InLength;
+		return OutData;
+	}
+
+	bool ReadLength(const uint8*& InOutData, const uint8* InEnd, uint64& InOutLength)
+	{
+		uint8 byte = 0;
+		do
+		{
+			if (InOutData == InEnd)
+				return false;
+			byte = *InOutData++;
+			InOutLength += byte;
+		} while (byte == 255);
+		return true;
+	}
+
+	// One sequence, the literals and then the match, InMatchLength 0 for the last one. nullptr if it does not fit.
+	uint8* WriteSequence(uint8* OutData, const uint8* InEnd, const uint8* InLiterals, uint64 InNumLiterals, uint32 InOffset, uint64 InMatchLength)
+	{
+		const uint64 matchLength = InMatchLength == 0 ? 0 : InMatchLength - kMinMatch;
+		const uint64 size = 1 + LengthBytes(InNumLiterals) + InNumLiterals + (InMatchLength == 0 ? 0 : 2 + LengthBytes(matchLength));
+		if (size > (uint64)(InEnd - OutData))
+			return nullptr;
+
+		uint8* token = OutData++;
+		*token = (uint8)(std::min<uint64>(InNumLiterals, 15) << 4);
+		if (InNumLiterals >= 15)
+		{
+			OutData = WriteLength(OutData, InNumLiterals);
+		}
+		if (InNumLiterals != 0)
+		{
+			memcpy(OutData, InLiterals, (size_t)InNumLiterals);
+			OutData += InNumLiterals;
+		}
+
+		if (InMatchLength == 0)
+			return OutData;
+
+		*OutData++ = (uint8)(InOffset & 0xff);
+		*OutData++ = (uint8)(InOffset >> 8);
+		*token |= (uint8)std::min<uint64>(matchLength, 15);
+		if (matchLength >= 15)
+		{
+			OutData = WriteLength(OutData, matchLength);
+		}
+		return OutData;
+	}
+}
+
+uint64 Compression::CompressBound(uint64 InSize)
+{
+	return InSize + InSize / 255 + 16;
+}
+
+uint64 Compression::Compress(const uint8* InData, uint64 InSize, uint8* OutData, uint64 InCapacity)
+{
+	if (InSize >= 0xffffffffull)
+		return 0;
+
+	uint8* out = OutData;
+	uint8* const outEnd = OutData + InCapacity;
+	uint64 anchor = 0;
+
+	if (InSize > kMatchLimit)
+	{
+		// Positions by the hash of the 4 bytes there, a candidate is checked before it is taken.
+		std::vector<uint32> table((size_t)1 << kHashLog, 0);
+		const uint64 limit = InSize - kMatchLimit;
+		const uint64 matchEnd = InSize - kLastLiterals;
+
+		uint64 pos = 0;
+		while (pos < limit)
+		{
+			const uint32 sequence = Read32(InData + pos);
+			const uint32 hash = Hash4(sequence);
+			uint64 candidate = table[hash];
+			table[hash] = (uint32)pos;
+
+			if (candidate >= pos || pos - candidate > kMaxOffset || Read32(InData + candidate) != sequence)
+			{
+				// Skip faster through data that does not compress.
+				pos += 1 + ((pos - anchor) >> 6);
+				continue;
+			}
+
+			while (pos > anchor && candidate > 0 && InData[pos - 1] == InData[candidate - 1])
+			{
+				--pos;
+				--candidate;
+			}
+
+			uint64 length = kMinMatch;
+			while (pos + length < matchEnd && InData[pos + length] == InData[candidate + length])
+			{
+				++length;
+			}
+
+			out = WriteSequence(out, outEnd, InData + anchor, pos - anchor, (uint32)(pos - candidate), length);
+			if (out == nullptr)
+				return 0;
+
+			pos += length;
+			anchor = pos;
+			if (pos < limit)
+			{
+				table[Hash4(Read32(InData + pos - 2))] = (uint32)(pos - 2);
+			}
+		}
+	}
+
+	out = WriteSequence(out, outEnd, InData + anchor, InSize - anchor, 0, 0);
+	return out == nullptr ? 0 : (uint64)(out - OutData);
+}
+
+bool Compression::Decompress(const uint8* InData, uint64 InSize, uint8* OutData, uint64 InDecompressedSize)
+{
+	const uint8* in = InData;
+	const uint8* const inEnd = InData + InSize;
+	uint8* out = OutData;
+	uint8* const outEnd = OutData + InDecompressedSize;
+
+	for (;;)
+	{
+		if (in == inEnd)
+			return false;
+		const uint8 token = *in++;
+
+		uint64 numLiterals = token >> 4;
+		if (numLiterals == 15 && !ReadLength(in, inEnd, numLiterals))
+			return false;
+		if (numLiterals > (uint64)(inEnd - in) || numLiterals > (uint64)(outEnd - out))
+			return false;
+
+		if (numLiterals != 0)
+		{
+			memcpy(out, in, (size_t)numLiterals);
+			in += numLiterals;
+			out += numLiterals;
+		}
+
+		// The last sequence has no match.
+		if (in == inEnd)
+			break;
+
+		if (inEnd - in < 2)
+			return false;
+		const uint64 offset = in[0] | (in[1] << 8);
+		in += 2;
+		if (offset == 0 || offset > (uint64)(out - OutData))
+			return false;
+
+		uint64 length = token & 15;
+		if (length == 15 && !ReadLength(in, inEnd, length))
+			return false;
+		length += kMinMatch;
+		if (length > (uint64)(outEnd - out))
+			return false;
+
+		// A match may overlap what it writes, a run of one byte is offset 1.
+		const uint8* match = out - offset;
+		if (offset >= length)
+		{
+			memcpy(out, match, (size_t)length);
+			out += length;
+		}
+		else
+		{
+			for (uint64 i = 0; i < length; ++i)
+			{
+				*out++ = *match++;
+			}
+		}
+	}
+
+	return out == outEnd;
+}
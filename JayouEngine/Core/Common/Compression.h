@@ -0,0 +1,32 @@
+//
+// Compression.h
+//
+
+#pragma once
+
+#include "TypeDef.h"
+
+namespace Utility
+{
+	///<summary>
+	/// LZ4 block format: literals and back references of at least 4 bytes within 64 KB, no entropy coding, so
+	/// decompression is little more than memcpy. The compressor is a greedy single hash probe, fast rather than tight.
+	/// Blocks carry no sizes, the caller keeps both.
+	///</summary>
+	namespace Compression
+	{
+		// Worst case compressed size of InSize bytes.
+		uint64 CompressBound(uint64 InSize);
+
+		///<summary>
+		/// Compressed size, 0 if it does not fit in InCapacity or InSize is 4 GB or more.
+		///</summary>
+		uint64 Compress(const uint8* InData, uint64 InSize, uint8* OutData, uint64 InCapacity);
+
+		///<summary>
+		/// False if InData is not a block that decompresses to exactly InDecompressedSize bytes. Never reads or writes
+		/// out of bounds, whatever InData holds.
+		///</summary>
+		bool Decompress(const uint8* InData, uint64 InSize, uint8* OutData, uint64 InDecompressedSize);
+	}
+}
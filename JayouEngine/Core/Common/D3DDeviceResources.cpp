@@ -1185,6 +1185,17 @@ void D3DDeviceResources::CreateDefaultBuffer(const void* pData, UINT64 byteSize,
 	// The caller can Release the uploadBuffer after it knows the copy has been executed.
 }
 
+void D3DDeviceResources::CreatePositionStream(RenderItem* InRenderItem, const std::vector<uint8>& InPositions, uint32 InByteStride)
+{
+	D3DRenderData* renderData = InRenderItem->RenderData.get();
+
+	CreateDefaultBuffer(InPositions.data(), InPositions.size(),
+		&renderData->PositionBufferGPU, &renderData->PositionBufferUploader);
+
+	renderData->PositionByteStride = InByteStride;
+	renderData->PositionBufferByteSize = (uint32)InPositions.size();
+}
+
 void D3DDeviceResources::CreateTexture2D(Texture* InTexture)
 {
 	// Create the actual default buffer resource.
@@ -49,6 +49,19 @@ namespace D3DCore
 		SS_Shadow
 	};
 
+	// Input assembler state of the last draw, so sorted draw streams skip redundant bindings.
+	struct DrawStreamState
+	{
+		const D3DRenderData*     RenderData = nullptr;
+		bool                     bPositionOnly = false;
+		D3D12_PRIMITIVE_TOPOLOGY PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_UNDEFINED;
+
+		// Statistics.
+		uint32                   NumDraws = 0;
+		uint32                   NumInstances = 0;
+		uint32                   NumBufferBindings = 0;
+	};
+
     // Controls all the DirectX device resources.
     class D3DDeviceResources
     {
@@ -118,8 +131,20 @@ namespace D3DCore
 		template<typename TVertex, typename TIndex>
 		// NOTE: NO Section.
 		void CreateCommonGeometry(RenderItem* InRenderItem, const std::vector<TVertex>& vertices, const std::vector<TIndex>& indices);
+		template<typename TVertex, typename TIndex>
+		// LOD indices are appended after the base indices, one Section per level in D3DRenderData::LODSections.
+		// Meshlets index into the base range.
+		void CreateCommonGeometry(RenderItem* InRenderItem, const std::vector<TVertex>& vertices, const std::vector<TIndex>& indices,
+			const std::vector<MeshLOD>& InLODs, const std::vector<Meshlet>& InMeshlets = std::vector<Meshlet>());
+		// InPositions as emitted by a position only VertexLayout, call after CreateCommonGeometry.
+		void CreatePositionStream(RenderItem* InRenderItem, const std::vector<uint8>& InPositions, uint32 InByteStride);
 		template<typename TLambda = PFVOID>
-		void DrawRenderItem(RenderItem* InRenderItem, const TLambda& lambda = defalut);
+		// bMeshletCulling: draw only RenderItem::VisibleMeshlets when the item was culled for this view.
+		// bPositionOnly: bind D3DRenderData::PositionBufferView, for depth only passes.
+		// InOutState: skip the vertex/index buffer and topology bindings already made by the previous draw.
+		// InNumInstances: instances per draw, replaces Section::InstanceCount.
+		void DrawRenderItem(RenderItem* InRenderItem, const TLambda& lambda = defalut, bool bMeshletCulling = false, bool bPositionOnly = false, DrawStreamState* InOutState = nullptr,
+			uint32 InNumInstances = 1);
 
 		void CreateRtvDescriptorHeaps_AutoUpdate(uint32 InNumRtvs = 0, PFVOID UpdateCallBack = nullptr);
 		void CreateDsvDescriptorHeaps_AutoUpdate(uint32 InNumDsvs = 0, PFVOID UpdateCallBack = nullptr);
@@ -314,13 +339,7 @@ namespace D3DCore
 		const UINT vbByteSize = (UINT)vertices.size() * sizeof(TVertex);
 		const UINT ibByteSize = (UINT)indices.size() * sizeof(TIndex);
 
-		InRenderItem->RenderData = std::make_unique<D3DRenderData>();
-
-		ThrowIfFailedV1(D3DCreateBlob(vbByteSize, &InRenderItem->RenderData->VertexBufferCPU));
-		CopyMemory(InRenderItem->RenderData->VertexBufferCPU->GetBufferPointer(), vertices.data(), vbByteSize);
-
-		ThrowIfFailedV1(D3DCreateBlob(ibByteSize, &InRenderItem->RenderData->IndexBufferCPU));
-		CopyMemory(InRenderItem->RenderData->IndexBufferCPU->GetBufferPointer(), indices.data(), ibByteSize);
+		InRenderItem->RenderData = std::make_shared<D3DRenderData>();
 
 		CreateDefaultBuffer(vertices.data(), vbByteSize,
 			&InRenderItem->RenderData->VertexBufferGPU, &InRenderItem->RenderData->VertexBufferUploader);
@@ -335,6 +354,8 @@ namespace D3DCore
 			InRenderItem->RenderData->VertexFormat = VF_Vertex;
 		else if ((std::is_same<TVertex, ColorVertex>::value))
 			InRenderItem->RenderData->VertexFormat = VF_ColorVertex;
+		else if ((std::is_same<TVertex, PackedVertex>::value))
+			InRenderItem->RenderData->VertexFormat = VF_PackedVertex;
 
 		// Index Buffer View Data.
 		if (std::is_same<TIndex, uint16>::value)
@@ -354,23 +375,118 @@ namespace D3DCore
 		InRenderItem->RenderData->Sections[InRenderItem->Name] = section;
 	}
 
+	template<typename TVertex, typename TIndex>
+	void D3DDeviceResources::CreateCommonGeometry(RenderItem* InRenderItem, const std::vector<TVertex>& vertices, const std::vector<TIndex>& indices,
+		const std::vector<MeshLOD>& InLODs, const std::vector<Meshlet>& InMeshlets)
+	{
+		size_t numIndices = indices.size();
+		for (const auto& lod : InLODs)
+			numIndices += lod.Indices32.size();
+
+		std::vector<TIndex> allIndices;
+		allIndices.reserve(numIndices);
+		allIndices.insert(allIndices.end(), indices.begin(), indices.end());
+		for (const auto& lod : InLODs)
+		{
+			for (uint32 index : lod.Indices32)
+				allIndices.push_back((TIndex)index);
+		}
+
+		CreateCommonGeometry(InRenderItem, vertices, allIndices);
+
+		Section& baseSection = InRenderItem->RenderData->Sections[InRenderItem->Name];
+		baseSection.IndexCountPerInstance = (UINT)indices.size();
+
+		uint32 startIndexLocation = (uint32)indices.size();
+		for (const auto& lod : InLODs)
+		{
+			Section section = baseSection;
+			section.IndexCountPerInstance = (UINT)lod.Indices32.size();
+			section.StartIndexLocation = startIndexLocation;
+			startIndexLocation += (uint32)lod.Indices32.size();
+
+			InRenderItem->RenderData->LODSections.push_back(section);
+		}
+
+		InRenderItem->RenderData->Meshlets = InMeshlets;
+	}
+
 	template<typename TLambda /*= PFVOID*/>
-	void D3DDeviceResources::DrawRenderItem(RenderItem* InRenderItem, const TLambda& lambda /*= defalut*/)
+	void D3DDeviceResources::DrawRenderItem(RenderItem* InRenderItem, const TLambda& lambda /*= defalut*/, bool bMeshletCulling /*= false*/, bool bPositionOnly /*= false*/, DrawStreamState* InOutState /*= nullptr*/,
+		uint32 InNumInstances /*= 1*/)
 	{
 		auto commandList = GetCommandList();
 
-		commandList->IASetVertexBuffers(0, 1, &InRenderItem->RenderData->VertexBufferView());
-		commandList->IASetIndexBuffer(&InRenderItem->RenderData->IndexBufferView());
-		commandList->IASetPrimitiveTopology(InRenderItem->PrimitiveType);
+		const D3DRenderData* renderData = InRenderItem->RenderData.get();
+		if (InOutState == nullptr || InOutState->RenderData != renderData || InOutState->bPositionOnly != bPositionOnly)
+		{
+			if (bPositionOnly && renderData->PositionBufferGPU != nullptr)
+				commandList->IASetVertexBuffers(0, 1, &renderData->PositionBufferView());
+			else
+				commandList->IASetVertexBuffers(0, 1, &renderData->VertexBufferView());
+			commandList->IASetIndexBuffer(&renderData->IndexBufferView());
+
+			if (InOutState != nullptr)
+			{
+				InOutState->RenderData = renderData;
+				InOutState->bPositionOnly = bPositionOnly;
+				InOutState->NumBufferBindings++;
+			}
+		}
+		if (InOutState == nullptr || InOutState->PrimitiveType != InRenderItem->PrimitiveType)
+		{
+			commandList->IASetPrimitiveTopology(InRenderItem->PrimitiveType);
+
+			if (InOutState != nullptr)
+				InOutState->PrimitiveType = InRenderItem->PrimitiveType;
+		}
+		if (InOutState != nullptr)
+		{
+			InOutState->NumDraws++;
+			InOutState->NumInstances += InNumInstances;
+		}
 
 		// Set/Bind Per Object Data.
 		lambda();
 
+		// A simplified level replaces the whole item.
+		const auto& lodSections = InRenderItem->RenderData->LODSections;
+		if (InRenderItem->LODIndex > 0 && InRenderItem->LODIndex <= lodSections.size())
+		{
+			const Section& section = lodSections[InRenderItem->LODIndex - 1];
+			commandList->DrawIndexedInstanced(section.IndexCountPerInstance,
+				InNumInstances,
+				section.StartIndexLocation,
+				section.BaseVertexLocation,
+				section.StartInstanceLocation);
+			return;
+		}
+
+		if (bMeshletCulling && InRenderItem->bMeshletCulled)
+		{
+			// Visible meshlets are sorted, neighbours in the index buffer go out as one draw.
+			const auto& meshlets = InRenderItem->RenderData->Meshlets;
+			const auto& visible = InRenderItem->VisibleMeshlets;
+			for (size_t i = 0; i < visible.size();)
+			{
+				const uint32 startIndexLocation = meshlets[visible[i]].StartIndexLocation;
+				uint32 indexCount = meshlets[visible[i]].IndexCount;
+
+				for (++i; i < visible.size() && visible[i] == visible[i - 1] + 1; ++i)
+				{
+					indexCount += meshlets[visible[i]].IndexCount;
+				}
+
+				commandList->DrawIndexedInstanced(indexCount, InNumInstances, startIndexLocation, 0, 0);
+			}
+			return;
+		}
+
 		for (auto& e : InRenderItem->RenderData->Sections)
 		{
 			Section& section = e.second;
 			commandList->DrawIndexedInstanced(section.IndexCountPerInstance,
-				section.InstanceCount,
+				InNumInstances,
 				section.StartIndexLocation,
 				section.BaseVertexLocation,
 				section.StartInstanceLocation);
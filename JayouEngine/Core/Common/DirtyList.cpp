@@ -0,0 +1,88 @@
+//
+// DirtyList.cpp
+//
+
+#include "DirtyList.h"
+
+using namespace Core;
+using namespace Utility;
+using namespace Utility::GeometryManager;
+
+void DirtyList::Reset(uint32 InNumFrameResources)
+{
+	for (IObject* object : m_objects)
+	{
+		object->DirtySlot = -1;
+	}
+	m_objects.clear();
+
+	m_generation = 0;
+	m_frameGenerations.assign(InNumFrameResources, 0);
+}
+
+void DirtyList::Add(IObject* InObject)
+{
+	assert(InObject->DirtyList == nullptr || InObject->DirtyList == this);
+
+	InObject->DirtyList = this;
+	OnMarkedDirty(InObject);
+}
+
+void DirtyList::Remove(IObject* InObject)
+{
+	if (InObject->DirtyList != this)
+		return;
+
+	if (InObject->DirtySlot >= 0)
+	{
+		IObject* last = m_objects.back();
+		last->DirtySlot = InObject->DirtySlot;
+		m_objects[InObject->DirtySlot] = last;
+		m_objects.pop_back();
+	}
+
+	InObject->DirtyList = nullptr;
+	InObject->DirtySlot = -1;
+}
+
+void DirtyList::OnMarkedDirty(IObject* InObject)
+{
+	// Stale in every frame resource updated before the next Update.
+	InObject->DirtyGeneration = m_generation + 1;
+
+	if (InObject->DirtySlot < 0)
+	{
+		Append(InObject);
+	}
+}
+
+void DirtyList::Append(IObject* InObject)
+{
+	InObject->DirtySlot = (int32)m_objects.size();
+	m_objects.push_back(InObject);
+}
+
+void DirtyList::Compact()
+{
+	uint64 oldestGeneration = m_generation;
+	for (uint64 generation : m_frameGenerations)
+	{
+		oldestGeneration = std::min(oldestGeneration, generation);
+	}
+
+	for (size_t i = 0; i < m_objects.size();)
+	{
+		IObject* object = m_objects[i];
+		if (object->DirtyGeneration <= oldestGeneration)
+		{
+			IObject* last = m_objects.back();
+			last->DirtySlot = (int32)i;
+			m_objects[i] = last;
+			m_objects.pop_back();
+
+			object->DirtySlot = -1;
+			continue;
+		}
+		++i;
+	}
+}
@@ -0,0 +1,96 @@
+//
+// DirtyList.h
+//
+
+#pragma once
+
+#include "Utility.h"
+#include "Interface/IObject.h"
+
+namespace Utility
+{
+	namespace GeometryManager
+	{
+		///<summary>
+		/// Objects whose GPU copy is stale in at least one frame resource, so the per frame updates
+		/// cost the changes instead of the scene. Every MarkAsDirty stamps the object with the next generation,
+		/// every Update of a frame resource records the generation it is up to date with.
+		/// An object leaves the list once all the frame resources have caught up with it.
+		///</summary>
+		class DirtyList : public Core::IDirtyList
+		{
+		public:
+
+			///<summary>
+			/// Empties the list for InNumFrameResources frame resources.
+			///</summary>
+			void Reset(uint32 InNumFrameResources);
+
+			///<summary>
+			/// Takes InObject in, it is dirty in every frame resource until updated.
+			///</summary>
+			void Add(Core::IObject* InObject);
+
+			///<summary>
+			/// Must be called before InObject is destroyed.
+			///</summary>
+			void Remove(Core::IObject* InObject);
+
+			void OnMarkedDirty(Core::IObject* InObject) override;
+
+			///<summary>
+			/// Calls InUpdate(Object) for every object that is stale in frame resource InFrameResourceIndex, returns their count.
+			///</summary>
+			template<typename TUpdate>
+			uint32 Update(uint32 InFrameResourceIndex, const TUpdate& InUpdate);
+
+			///<summary>
+			/// Calls InVisit(Object) for every object still stale in some frame resource.
+			///</summary>
+			template<typename TVisit>
+			void ForEach(const TVisit& InVisit) const
+			{
+				for (Core::IObject* object : m_objects)
+				{
+					InVisit(object);
+				}
+			}
+
+			uint32 GetNumDirty() const { return (uint32)m_objects.size(); }
+
+		private:
+
+			void Append(Core::IObject* InObject);
+
+			// Drops the objects every frame resource is up to date with.
+			void Compact();
+
+			std::vector<Core::IObject*> m_objects;
+			std::vector<uint64>         m_frameGenerations; // Last Update of each frame resource.
+			uint64                      m_generation = 0;
+		};
+
+		template<typename TUpdate>
+		uint32 DirtyList::Update(uint32 InFrameResourceIndex, const TUpdate& InUpdate)
+		{
+			assert(InFrameResourceIndex < m_frameGenerations.size());
+
+			const uint64 lastGeneration = m_frameGenerations[InFrameResourceIndex];
+
+			uint32 numUpdated = 0;
+			for (Core::IObject* object : m_objects)
+			{
+				if (object->DirtyGeneration > lastGeneration)
+				{
+					InUpdate(object);
+					numUpdated++;
+				}
+			}
+
+			m_frameGenerations[InFrameResourceIndex] = ++m_generation;
+			Compact();
+
+			return numUpdated;
+		}
+	}
+}
@@ -0,0 +1,128 @@
+//
+// DrawPacketSorter.cpp
+//
+
+#include "DrawPacketSorter.h"
+
+using namespace Utility;
+using namespace Utility::GeometryManager;
+
+namespace
+{
+	// Below this many keys std::sort beats clearing the histograms.
+	const size_t MinKeysForRadixSort = 256;
+}
+
+uint64 DrawPacketSorter::MakeOpaqueKey(uint32 InLayer, uint32 InPipeline, float InDepth, uint32 InGeometry, uint32 InMaterial, uint32 InPacket)
+{
+	assert(InPacket < MaxPackets);
+
+	return ((uint64)(InLayer & 0xf) << 60)
+		| ((uint64)(InPipeline & 0xf) << 56)
+		| ((uint64)QuantizeDepth(InDepth, 10) << 46)
+		| ((uint64)(InGeometry & 0x3fff) << 32)
+		| ((uint64)(InMaterial & 0xfff) << 20)
+		| (uint64)InPacket;
+}
+
+uint64 DrawPacketSorter::MakeTransparentKey(uint32 InLayer, uint32 InPipeline, float InDepth, uint32 InMaterial, uint32 InPacket)
+{
+	assert(InPacket < MaxPackets);
+
+	// Inverted, the farthest first.
+	const uint32 depth = ~QuantizeDepth(InDepth, 24) & 0xffffff;
+
+	return ((uint64)(InLayer & 0xf) << 60)
+		| ((uint64)(InPipeline & 0xf) << 56)
+		| ((uint64)depth << 32)
+		| ((uint64)(InMaterial & 0xfff) << 20)
+		| (uint64)InPacket;
+}
+
+float DrawPacketSorter::NormalizeDepth(float InViewDepth, float InNearZ, float InFarZ)
+{
+	if (InFarZ <= InNearZ)
+		return 0.0f;
+
+	float depth;
+	if (InNearZ > 0.0f)
+	{
+		depth = InViewDepth > InNearZ ? logf(InViewDepth / InNearZ) / logf(InFarZ / InNearZ) : 0.0f;
+	}
+	else
+	{
+		depth = (InViewDepth - InNearZ) / (InFarZ - InNearZ);
+	}
+
+	return depth < 0.0f ? 0.0f : (depth > 1.0f ? 1.0f : depth);
+}
+
+uint32 DrawPacketSorter::QuantizeDepth(float InDepth, uint32 InBits)
+{
+	// The negated test also catches NaN.
+	const float depth = !(InDepth > 0.0f) ? 0.0f : (InDepth < 1.0f ? InDepth : 1.0f);
+	const uint32 maxValue = (1u << InBits) - 1;
+
+	// Rounding may still land one past it for the widest field in float precision.
+	return std::min((uint32)(depth * (float)maxValue + 0.5f), maxValue);
+}
+
+void DrawPacketSorter::Sort(std::vector<uint64>& InOutKeys)
+{
+	const size_t numKeys = InOutKeys.size();
+	if (numKeys < MinKeysForRadixSort)
+	{
+		std::sort(InOutKeys.begin(), InOutKeys.end());
+		return;
+	}
+
+	m_scratch.resize(numKeys);
+	m_histograms.assign(NumPasses * RadixSize, 0);
+
+	uint32* histograms = m_histograms.data();
+	for (size_t i = 0; i < numKeys; ++i)
+	{
+		assert(i == 0 || GetPacket(InOutKeys[i]) > GetPacket(InOutKeys[i - 1]));
+
+		const uint64 key = InOutKeys[i] >> PacketBits;
+		for (uint32 pass = 0; pass < NumPasses; ++pass)
+		{
+			histograms[pass * RadixSize + ((key >> (pass * RadixBits)) & (RadixSize - 1))]++;
+		}
+	}
+
+	uint64* source = InOutKeys.data();
+	uint64* destination = m_scratch.data();
+
+	for (uint32 pass = 0; pass < NumPasses; ++pass)
+	{
+		const uint32 shift = PacketBits + pass * RadixBits;
+		uint32* histogram = &histograms[pass * RadixSize];
+
+		// Every key has the same digit, the order would not change.
+		if (histogram[(source[0] >> shift) & (RadixSize - 1)] == numKeys)
+			continue;
+
+		// Counts to start offsets.
+		uint32 offset = 0;
+		for (uint32 digit = 0; digit < RadixSize; ++digit)
+		{
+			const uint32 count = histogram[digit];
+			histogram[digit] = offset;
+			offset += count;
+		}
+
+		for (size_t i = 0; i < numKeys; ++i)
+		{
+			const uint64 key = source[i];
+			destination[histogram[(key >> shift) & (RadixSize - 1)]++] = key;
+		}
+
+		std::swap(source, destination);
+	}
+
+	if (source != InOutKeys.data())
+	{
+		memcpy(InOutKeys.data(), source, numKeys * sizeof(uint64));
+	}
+}
@@ -0,0 +1,62 @@
+//
+// DrawPacketSorter.h
+//
+
+#pragma once
+
+#include "Utility.h"
+
+namespace Utility
+{
+	namespace GeometryManager
+	{
+		///<summary>
+		/// 64 bits draw sort keys and a radix sort over them. From the top bit down a key holds
+		/// the render layer (4 bits), the pipeline (4 bits), 36 bits of layer dependent sort fields and the packet index (20 bits),
+		/// so sorted keys lead straight back to their draws and equal keys cannot exist.
+		///   Opaque:      view depth (10 bits, front to back), geometry (14 bits), material (12 bits).
+		///   Transparent: view depth (24 bits, back to front), material (12 bits).
+		/// Depths come in normalized (see NormalizeDepth) and use every value of their field.
+		/// Geometry and material ids are truncated, which only costs some grouping, never correctness.
+		///</summary>
+		class DrawPacketSorter
+		{
+		public:
+
+			static const uint32 PacketBits = 20;
+			static const uint32 MaxPackets = 1u << PacketBits;
+
+			static uint64 MakeOpaqueKey(uint32 InLayer, uint32 InPipeline, float InDepth, uint32 InGeometry, uint32 InMaterial, uint32 InPacket);
+			static uint64 MakeTransparentKey(uint32 InLayer, uint32 InPipeline, float InDepth, uint32 InMaterial, uint32 InPacket);
+
+			///<summary>
+			/// View depth to [0, 1] across the depth range of the sort camera, clamped. Logarithmic for a positive near plane,
+			/// so every field value covers the same relative depth step, linear otherwise (orthographic views).
+			///</summary>
+			static float NormalizeDepth(float InViewDepth, float InNearZ, float InFarZ);
+
+			static uint32 GetPacket(uint64 InKey) { return (uint32)InKey & (MaxPackets - 1); }
+			static uint32 GetPipeline(uint64 InKey) { return (uint32)(InKey >> 56) & 0xf; }
+			static uint32 GetLayer(uint64 InKey) { return (uint32)(InKey >> 60); }
+
+			///<summary>
+			/// Least significant digit radix sort, 8 bits per pass. InOutKeys must be in increasing packet order (as built),
+			/// the sort is stable so the packet bits are never sorted on. All histograms are built in one read
+			/// and the passes whose digit is the same for every key are skipped.
+			///</summary>
+			void Sort(std::vector<uint64>& InOutKeys);
+
+		private:
+
+			static const uint32 RadixBits = 8;
+			static const uint32 RadixSize = 1u << RadixBits;
+			static const uint32 NumPasses = (64 - PacketBits + RadixBits - 1) / RadixBits;
+
+			// A normalized depth rounded to InBits.
+			static uint32 QuantizeDepth(float InDepth, uint32 InBits);
+
+			std::vector<uint64> m_scratch;
+			std::vector<uint32> m_histograms;
+		};
+	}
+}
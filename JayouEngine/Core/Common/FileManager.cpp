@@ -6,7 +6,9 @@
 #include "FileManager.h"
 #include "StringManager.h"
 
+#ifdef _WINDOWS
 #include <io.h>
+#endif
 
 #define success_if(x) if (SUCCEEDED(x))
 
@@ -14,6 +16,8 @@ using namespace WinUtility;
 using namespace WinUtility::FileManager;
 using namespace Utility::StringManager;
 
+#ifdef _WINDOWS
+
 bool FileUtil::OpenDialogBox(HWND InOwner, std::vector<std::wstring>& OutPaths, DWORD InOptions, const std::vector<COMDLG_FILTERSPEC>& InFilters)
 {
 	////////////////////////////////
@@ -127,6 +131,8 @@ void FileUtil::WGetAllFilesUnder(std::wstring path, std::vector<std::wstring>& f
 	}
 }
 
+#endif // _WINDOWS
+
 void FileUtil::GetFileTypeFromPathW(const std::wstring& InPath, ESupportFileType& OutType)
 {
 	std::wstring name, exten;
@@ -9,7 +9,9 @@
 #include <fstream>
 // The Common Item Dialog implements an interface named IFileOpenDialog, 
 // which is declared in the header file Shobjidl.h.
+#ifdef _WINDOWS
 #include <shobjidl.h>
+#endif
 
 // Currently as WinUtility, some of them need to be moved into Utility (Cross Platform).
 namespace WinUtility
@@ -34,6 +36,7 @@ namespace WinUtility
 			{ SF_StdImage,    L"*.png;*.jpg;*.jpeg;*.tga;*.bmp;*.psd;*.gif;*.hdr;*.pic;*.pnm;*.ppm;*.pgm" },
 		};
 
+#ifdef _WINDOWS
 		const std::vector<COMDLG_FILTERSPEC> DefaultFilter =
 		{
 			{ L"JayouEngine", L"*.jayou;*.jscene" },
@@ -44,17 +47,20 @@ namespace WinUtility
 			{ L"Image", L"*.png;*.jpg;*.jpeg;*.tga;*.bmp;*.psd;*.gif;*.hdr;*.pic;*.pnm;*.ppm;*.pgm" },
 			{ L"All", L"*.*" }
 		};
+#endif // _WINDOWS
 
 		class FileUtil
 		{
 		public:
 	
+#ifdef _WINDOWS
 			// OpenDialog.
 			static bool OpenDialogBox(HWND InOwner, std::vector<std::wstring>& OutPaths, DWORD InOptions, const std::vector<COMDLG_FILTERSPEC>& InFilters = DefaultFilter);
 
 			static void GetAllFilesUnder(std::string path, std::vector<std::string>& files, std::string format = "");		
 
 			static void WGetAllFilesUnder(std::wstring path, std::vector<std::wstring>& files, std::wstring format = L"");			
+#endif // _WINDOWS
 			
 			static void GetFileTypeFromPathW(const std::wstring& InPath, ESupportFileType& OutType);
 
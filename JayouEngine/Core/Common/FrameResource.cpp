@@ -5,7 +5,3 @@
 #include "FrameResource.h"
 
 using namespace D3DCore;
-
-int32 Material::Count = 0;
-
-int32 Light::Count = 0;
\ No newline at end of file
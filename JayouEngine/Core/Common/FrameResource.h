@@ -9,6 +9,7 @@
 #include "../Math/Math.h"
 #include "Interface/IObject.h"
 #include "GeometryManager.h"
+#include "LightClusterBuilder.h"
 
 #include <type_traits>
 
@@ -74,13 +75,6 @@ namespace D3DCore
 
 		RenderItem* LightRItem = nullptr;
 
-		static int32 Count;
-
-		Light()
-		{
-			Index = Count++;
-		}
-
 		void SetTransFormMatrix(const Vector3& InTranslation, const Vector3& InRotation, const Vector3& InScale)
 		{
 			World = Matrix4(AffineTransform(InTranslation).Rotation(InRotation));
@@ -144,13 +138,6 @@ namespace D3DCore
 		int32 NormalMapComboIndex = -1;  // if -1, Vertex Normal.
 		int32 ORMMapComboIndex = -1;     // AO, Roughness, Metallicity.
 
-		static int32 Count;
-
-		Material()
-		{
-			Index = Count++;
-		}
-
 		void SetTransFormMatrix(const Vector3& InTranslation, const Vector3& InRotation, const Vector3& InScale)
 		{
 			MatTransform = Matrix4(AffineTransform(InTranslation).Rotation(InRotation).Scale(InScale));
@@ -194,9 +181,11 @@ namespace D3DCore
 		uint32 NumSpotLights;
 
 		int32 CubeMapIndex = -1;
+
+		// Light cluster slice of a view depth, see LightClusterBuilder.
+		float ClusterSliceScale = 0.0f;
+		float ClusterSliceBias = 0.0f;
 		int32 PassConstantPad0;
-		int32 PassConstantPad1;
-		int32 PassConstantPad2;
 	};
 
 	struct ObjectConstant
@@ -208,6 +197,25 @@ namespace D3DCore
 		int32 ObjectConstantPad0;
 		int32 ObjectConstantPad1;
 		int32 ObjectConstantPad2;
+
+		// VF_PackedVertex dequantization.
+		XMFLOAT3 PositionScale = { 1.0f, 1.0f, 1.0f };
+		float ObjectConstantPad3;
+		XMFLOAT3 PositionBias = { 0.0f, 0.0f, 0.0f };
+		float ObjectConstantPad4;
+	};
+
+	// Per RenderItem transforms of instanced draws, indexed by RenderItem::Index.
+	struct InstanceData
+	{
+		Matrix4 World = Matrix4(EIdentityTag::kIdentity);
+		Matrix4 InvTWorld = Matrix4(EIdentityTag::kIdentity);
+	};
+
+	// Instance list of the instanced draws of a frame, filled by InstanceBatcher.
+	struct InstanceIndexData
+	{
+		uint32 InstanceIndex;
 	};
 
 	struct ObjectConstantArray // Limited to 64KB.
@@ -252,6 +260,14 @@ namespace D3DCore
 		float SpotPower = 64.0f;                            // spot light only
 	};
 
+	// Clustered light lists, filled by LightClusterBuilder.
+	typedef LightCluster LightClusterData;
+
+	struct LightIndexData
+	{
+		uint32 LightIndex;
+	};
+
 	class FrameResource
 	{
 	public:
@@ -271,6 +287,10 @@ namespace D3DCore
 			else if (std::is_same<ObjectConstantArray, TConstantType>::value) m_objectArrayCBuffer = std::make_unique<UploadBuffer<ObjectConstantArray>>(m_d3dDevice, count, true);
 			else if (std::is_same<MaterialData, TConstantType>::value) m_matSBuffer = std::make_unique<UploadBuffer<MaterialData>>(m_d3dDevice, count, false);
 			else if (std::is_same<LightData, TConstantType>::value) m_litSBuffer = std::make_unique<UploadBuffer<LightData>>(m_d3dDevice, count, false);
+			else if (std::is_same<LightClusterData, TConstantType>::value) m_litClusterSBuffer = std::make_unique<UploadBuffer<LightClusterData>>(m_d3dDevice, count, false);
+			else if (std::is_same<LightIndexData, TConstantType>::value) m_litIndexSBuffer = std::make_unique<UploadBuffer<LightIndexData>>(m_d3dDevice, count, false);
+			else if (std::is_same<InstanceData, TConstantType>::value) m_instanceSBuffer = std::make_unique<UploadBuffer<InstanceData>>(m_d3dDevice, count, false);
+			else if (std::is_same<InstanceIndexData, TConstantType>::value) m_instanceIndexSBuffer = std::make_unique<UploadBuffer<InstanceIndexData>>(m_d3dDevice, count, false);
 		}
 
 		// Not Support For MaterialData & LightData.
@@ -300,6 +320,16 @@ namespace D3DCore
 			else if (std::is_same<ObjectConstantArray, TConstantType>::value) m_objectArrayCBuffer->CopyData<TConstantType>(elementIndex, data);
 			else if (std::is_same<MaterialData, TConstantType>::value) m_matSBuffer->CopyData<TConstantType>(elementIndex, data);
 			else if (std::is_same<LightData, TConstantType>::value) m_litSBuffer->CopyData<TConstantType>(elementIndex, data);
+			else if (std::is_same<InstanceData, TConstantType>::value) m_instanceSBuffer->CopyData<TConstantType>(elementIndex, data);
+		}
+
+		// Structure Buffer Only, copies count packed elements.
+		template<typename TConstantType>
+		void CopyData(int elementIndex, const TConstantType* data, uint32 count)
+		{
+			if (std::is_same<LightClusterData, TConstantType>::value) m_litClusterSBuffer->CopyData<TConstantType>(elementIndex, data, count);
+			else if (std::is_same<LightIndexData, TConstantType>::value) m_litIndexSBuffer->CopyData<TConstantType>(elementIndex, data, count);
+			else if (std::is_same<InstanceIndexData, TConstantType>::value) m_instanceIndexSBuffer->CopyData<TConstantType>(elementIndex, data, count);
 		}
 
 		template<typename TConstantType>
@@ -312,6 +342,10 @@ namespace D3DCore
 			else if (std::is_same<ObjectConstantArray, TConstantType>::value) cbAddress = m_objectArrayCBuffer->Resource()->GetGPUVirtualAddress();
 			else if (std::is_same<MaterialData, TConstantType>::value) cbAddress = m_matSBuffer->Resource()->GetGPUVirtualAddress();
 			else if (std::is_same<LightData, TConstantType>::value) cbAddress = m_litSBuffer->Resource()->GetGPUVirtualAddress();
+			else if (std::is_same<LightClusterData, TConstantType>::value) cbAddress = m_litClusterSBuffer->Resource()->GetGPUVirtualAddress();
+			else if (std::is_same<LightIndexData, TConstantType>::value) cbAddress = m_litIndexSBuffer->Resource()->GetGPUVirtualAddress();
+			else if (std::is_same<InstanceData, TConstantType>::value) cbAddress = m_instanceSBuffer->Resource()->GetGPUVirtualAddress();
+			else if (std::is_same<InstanceIndexData, TConstantType>::value) cbAddress = m_instanceIndexSBuffer->Resource()->GetGPUVirtualAddress();
 
 			return cbAddress;
 		}
@@ -323,6 +357,10 @@ namespace D3DCore
 		std::unique_ptr<UploadBuffer<ObjectConstantArray>> m_objectArrayCBuffer = nullptr;
 		std::unique_ptr<UploadBuffer<MaterialData>> m_matSBuffer = nullptr;
 		std::unique_ptr<UploadBuffer<LightData>> m_litSBuffer = nullptr;
+		std::unique_ptr<UploadBuffer<LightClusterData>> m_litClusterSBuffer = nullptr;
+		std::unique_ptr<UploadBuffer<LightIndexData>> m_litIndexSBuffer = nullptr;
+		std::unique_ptr<UploadBuffer<InstanceData>> m_instanceSBuffer = nullptr;
+		std::unique_ptr<UploadBuffer<InstanceIndexData>> m_instanceIndexSBuffer = nullptr;
 
 		ID3D12Device* m_d3dDevice = nullptr;
 	};
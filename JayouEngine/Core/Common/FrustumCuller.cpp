@@ -0,0 +1,301 @@
+//
+// FrustumCuller.cpp
+//
+
+#include "FrustumCuller.h"
+
+#if defined(_XM_SSE_INTRINSICS_)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#include <immintrin.h>
+#endif
+
+// MSVC emits AVX wherever it is asked to, GCC and Clang only in functions built for it.
+#if defined(_MSC_VER)
+#define TARGET_AVX
+#else
+#define TARGET_AVX __attribute__((target("avx")))
+#endif
+
+using namespace Utility;
+using namespace Utility::GeometryManager;
+
+namespace
+{
+	// Lanes past the last box of a partial block.
+	uint32 ValidLaneMask(uint32 InFirst, uint32 InNumBoxes, uint32 InNumLanes)
+	{
+		const uint32 numValid = std::min(InNumBoxes - InFirst, InNumLanes);
+		return numValid >= 32 ? ~0u : (1u << numValid) - 1;
+	}
+
+	// Appends the set bits of InMask as indices, without branching on the unpredictable visibility.
+	uint32 AppendVisible(uint32 InMask, uint32 InFirst, uint32 InNumLanes, uint32* OutVisible, uint32 InCount)
+	{
+		uint32 count = InCount;
+		for (uint32 lane = 0; lane < InNumLanes; ++lane)
+		{
+			OutVisible[count] = InFirst + lane;
+			count += (InMask >> lane) & 1;
+		}
+		return count;
+	}
+
+#if defined(_XM_SSE_INTRINSICS_)
+	bool IsAVXSupported()
+	{
+#if defined(_MSC_VER)
+		int cpuInfo[4];
+		__cpuid(cpuInfo, 1);
+#else
+		unsigned int cpuInfo[4] = {};
+		__get_cpuid(1, &cpuInfo[0], &cpuInfo[1], &cpuInfo[2], &cpuInfo[3]);
+#endif
+
+		// AVX needs the CPU feature and the OS saving the YMM registers.
+		const bool bOSXSave = (cpuInfo[2] & (1 << 27)) != 0;
+		const bool bAVX = (cpuInfo[2] & (1 << 28)) != 0;
+		if (!bOSXSave || !bAVX)
+			return false;
+
+#if defined(_MSC_VER)
+		return (_xgetbv(0) & 0x6) == 0x6;
+#else
+		uint32 xcr0, xcr0High;
+		__asm__("xgetbv" : "=a"(xcr0), "=d"(xcr0High) : "c"(0));
+		return (xcr0 & 0x6) == 0x6;
+#endif
+	}
+#endif
+}
+
+FrustumCuller::FrustumCuller()
+	: m_numBoxes(0)
+{
+}
+
+void FrustumCuller::Resize(uint32 InNumBoxes)
+{
+	m_numBoxes = InNumBoxes;
+
+	const size_t paddedSize = (InNumBoxes + BlockSize - 1) / BlockSize * BlockSize;
+	m_centerX.resize(paddedSize, 0.0f);
+	m_centerY.resize(paddedSize, 0.0f);
+	m_centerZ.resize(paddedSize, 0.0f);
+	m_extentX.resize(paddedSize, 0.0f);
+	m_extentY.resize(paddedSize, 0.0f);
+	m_extentZ.resize(paddedSize, 0.0f);
+}
+
+void FrustumCuller::SetBounds(uint32 InIndex, const BoundingBox& InBounds)
+{
+	assert(InIndex < m_numBoxes);
+
+	m_centerX[InIndex] = InBounds.Center.x;
+	m_centerY[InIndex] = InBounds.Center.y;
+	m_centerZ[InIndex] = InBounds.Center.z;
+	m_extentX[InIndex] = InBounds.Extents.x;
+	m_extentY[InIndex] = InBounds.Extents.y;
+	m_extentZ[InIndex] = InBounds.Extents.z;
+}
+
+void XM_CALLCONV FrustumCuller::ExtractPlanes(FXMMATRIX InViewProj, XMFLOAT4 OutPlanes[6])
+{
+	// Row vectors, the clip space coordinates are the dot products with the columns.
+	XMMATRIX columns = XMMatrixTranspose(InViewProj);
+
+	// -w <= x <= w, -w <= y <= w, 0 <= z <= w.
+	XMVECTOR planes[6] =
+	{
+		XMVectorAdd(columns.r[3], columns.r[0]),
+		XMVectorSubtract(columns.r[3], columns.r[0]),
+		XMVectorAdd(columns.r[3], columns.r[1]),
+		XMVectorSubtract(columns.r[3], columns.r[1]),
+		columns.r[2],
+		XMVectorSubtract(columns.r[3], columns.r[2])
+	};
+
+	for (uint32 i = 0; i < 6; ++i)
+	{
+		XMStoreFloat4(&OutPlanes[i], XMPlaneNormalize(planes[i]));
+	}
+}
+
+ECullInstructionSet FrustumCuller::GetBestInstructionSet()
+{
+#if defined(_XM_SSE_INTRINSICS_)
+	static const ECullInstructionSet bestInstructionSet = IsAVXSupported() ? CIS_AVX : CIS_SSE;
+	return bestInstructionSet;
+#else
+	return CIS_Scalar;
+#endif
+}
+
+uint32 FrustumCuller::Cull(const XMFLOAT4* InPlanes, uint32 InNumPlanes, std::vector<uint32>& OutVisible) const
+{
+	return Cull(InPlanes, InNumPlanes, OutVisible, GetBestInstructionSet());
+}
+
+uint32 FrustumCuller::Cull(const XMFLOAT4* InPlanes, uint32 InNumPlanes, std::vector<uint32>& OutVisible, ECullInstructionSet InInstructionSet) const
+{
+	assert(InNumPlanes <= MaxPlanes);
+
+	// Every lane of a block is written before the count tells which ones were visible.
+	OutVisible.resize(m_centerX.size());
+
+	uint32 numVisible = 0;
+	switch (InInstructionSet)
+	{
+#if defined(_XM_SSE_INTRINSICS_)
+	case CIS_AVX: numVisible = CullAVX(InPlanes, InNumPlanes, OutVisible.data()); break;
+	case CIS_SSE: numVisible = CullSSE(InPlanes, InNumPlanes, OutVisible.data()); break;
+#endif
+	default:      numVisible = CullScalar(InPlanes, InNumPlanes, OutVisible.data()); break;
+	}
+
+	OutVisible.resize(numVisible);
+	return numVisible;
+}
+
+uint32 FrustumCuller::CullShadowCasters(const XMFLOAT4 InLightPlanes[6], const XMFLOAT4 InCameraPlanes[6], const XMFLOAT3& InLightDirection,
+	float InSweepLength, std::vector<uint32>& OutCasters, ECullInstructionSet InInstructionSet /*= GetBestInstructionSet()*/) const
+{
+	XMFLOAT4 planes[11];
+	uint32 numPlanes = 0;
+
+	// Casters between the light and its near plane still throw shadows into the frustum, leave it open.
+	for (uint32 i = 0; i < 6; ++i)
+	{
+		if (i != 4)
+			planes[numPlanes++] = InLightPlanes[i];
+	}
+
+	// A swept box is behind a plane when both ends of the sweep are, so the sweep only
+	// moves the plane back by the part of the sweep going towards its inside.
+	for (uint32 i = 0; i < 6; ++i)
+	{
+		XMFLOAT4 plane = InCameraPlanes[i];
+		float towardsInside = InSweepLength * (plane.x * InLightDirection.x + plane.y * InLightDirection.y + plane.z * InLightDirection.z);
+		plane.w += std::max(towardsInside, 0.0f);
+		planes[numPlanes++] = plane;
+	}
+
+	return Cull(planes, numPlanes, OutCasters, InInstructionSet);
+}
+
+uint32 FrustumCuller::CullScalar(const XMFLOAT4* InPlanes, uint32 InNumPlanes, uint32* OutVisible) const
+{
+	uint32 count = 0;
+	for (uint32 i = 0; i < m_numBoxes; ++i)
+	{
+		// Outside when the box lies entirely behind one plane.
+		bool bVisible = true;
+		for (uint32 p = 0; p < InNumPlanes; ++p)
+		{
+			const XMFLOAT4& plane = InPlanes[p];
+			float distance = (m_centerX[i] * plane.x + m_centerY[i] * plane.y) + (m_centerZ[i] * plane.z + plane.w);
+			float radius = m_extentX[i] * fabsf(plane.x) + m_extentY[i] * fabsf(plane.y) + m_extentZ[i] * fabsf(plane.z);
+			bVisible &= distance + radius >= 0.0f;
+		}
+
+		OutVisible[count] = i;
+		count += bVisible ? 1 : 0;
+	}
+	return count;
+}
+
+#if defined(_XM_SSE_INTRINSICS_)
+
+uint32 FrustumCuller::CullSSE(const XMFLOAT4* InPlanes, uint32 InNumPlanes, uint32* OutVisible) const
+{
+	__m128 planeX[MaxPlanes], planeY[MaxPlanes], planeZ[MaxPlanes], planeW[MaxPlanes];
+	__m128 absPlaneX[MaxPlanes], absPlaneY[MaxPlanes], absPlaneZ[MaxPlanes];
+	for (uint32 p = 0; p < InNumPlanes; ++p)
+	{
+		planeX[p] = _mm_set1_ps(InPlanes[p].x);
+		planeY[p] = _mm_set1_ps(InPlanes[p].y);
+		planeZ[p] = _mm_set1_ps(InPlanes[p].z);
+		planeW[p] = _mm_set1_ps(InPlanes[p].w);
+		absPlaneX[p] = _mm_set1_ps(fabsf(InPlanes[p].x));
+		absPlaneY[p] = _mm_set1_ps(fabsf(InPlanes[p].y));
+		absPlaneZ[p] = _mm_set1_ps(fabsf(InPlanes[p].z));
+	}
+
+	uint32 count = 0;
+	for (uint32 i = 0; i < m_numBoxes; i += 4)
+	{
+		__m128 centerX = _mm_loadu_ps(&m_centerX[i]);
+		__m128 centerY = _mm_loadu_ps(&m_centerY[i]);
+		__m128 centerZ = _mm_loadu_ps(&m_centerZ[i]);
+		__m128 extentX = _mm_loadu_ps(&m_extentX[i]);
+		__m128 extentY = _mm_loadu_ps(&m_extentY[i]);
+		__m128 extentZ = _mm_loadu_ps(&m_extentZ[i]);
+
+		// Smallest signed distance of the box's most inward corner over all planes.
+		__m128 minDistance = _mm_set1_ps(std::numeric_limits<float>::max());
+		for (uint32 p = 0; p < InNumPlanes; ++p)
+		{
+			__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(centerX, planeX[p]), _mm_mul_ps(centerY, planeY[p])),
+				_mm_add_ps(_mm_mul_ps(centerZ, planeZ[p]), planeW[p]));
+			__m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(extentX, absPlaneX[p]), _mm_mul_ps(extentY, absPlaneY[p])),
+				_mm_mul_ps(extentZ, absPlaneZ[p]));
+			minDistance = _mm_min_ps(minDistance, _mm_add_ps(distance, radius));
+		}
+
+		uint32 mask = (uint32)_mm_movemask_ps(_mm_cmpge_ps(minDistance, _mm_setzero_ps()));
+		mask &= ValidLaneMask(i, m_numBoxes, 4);
+		count = AppendVisible(mask, i, 4, OutVisible, count);
+	}
+	return count;
+}
+
+TARGET_AVX uint32 FrustumCuller::CullAVX(const XMFLOAT4* InPlanes, uint32 InNumPlanes, uint32* OutVisible) const
+{
+	__m256 planeX[MaxPlanes], planeY[MaxPlanes], planeZ[MaxPlanes], planeW[MaxPlanes];
+	__m256 absPlaneX[MaxPlanes], absPlaneY[MaxPlanes], absPlaneZ[MaxPlanes];
+	for (uint32 p = 0; p < InNumPlanes; ++p)
+	{
+		planeX[p] = _mm256_set1_ps(InPlanes[p].x);
+		planeY[p] = _mm256_set1_ps(InPlanes[p].y);
+		planeZ[p] = _mm256_set1_ps(InPlanes[p].z);
+		planeW[p] = _mm256_set1_ps(InPlanes[p].w);
+		absPlaneX[p] = _mm256_set1_ps(fabsf(InPlanes[p].x));
+		absPlaneY[p] = _mm256_set1_ps(fabsf(InPlanes[p].y));
+		absPlaneZ[p] = _mm256_set1_ps(fabsf(InPlanes[p].z));
+	}
+
+	uint32 count = 0;
+	for (uint32 i = 0; i < m_numBoxes; i += 8)
+	{
+		__m256 centerX = _mm256_loadu_ps(&m_centerX[i]);
+		__m256 centerY = _mm256_loadu_ps(&m_centerY[i]);
+		__m256 centerZ = _mm256_loadu_ps(&m_centerZ[i]);
+		__m256 extentX = _mm256_loadu_ps(&m_extentX[i]);
+		__m256 extentY = _mm256_loadu_ps(&m_extentY[i]);
+		__m256 extentZ = _mm256_loadu_ps(&m_extentZ[i]);
+
+		__m256 minDistance = _mm256_set1_ps(std::numeric_limits<float>::max());
+		for (uint32 p = 0; p < InNumPlanes; ++p)
+		{
+			__m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(centerX, planeX[p]), _mm256_mul_ps(centerY, planeY[p])),
+				_mm256_add_ps(_mm256_mul_ps(centerZ, planeZ[p]), planeW[p]));
+			__m256 radius = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(extentX, absPlaneX[p]), _mm256_mul_ps(extentY, absPlaneY[p])),
+				_mm256_mul_ps(extentZ, absPlaneZ[p]));
+			minDistance = _mm256_min_ps(minDistance, _mm256_add_ps(distance, radius));
+		}
+
+		uint32 mask = (uint32)_mm256_movemask_ps(_mm256_cmp_ps(minDistance, _mm256_setzero_ps(), _CMP_GE_OQ));
+		mask &= ValidLaneMask(i, m_numBoxes, 8);
+		count = AppendVisible(mask, i, 8, OutVisible, count);
+	}
+
+	// The upper halves of the YMM registers are dirty, avoid the SSE transition penalty in the caller.
+	_mm256_zeroupper();
+
+	return count;
+}
+
+#endif
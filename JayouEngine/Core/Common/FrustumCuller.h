@@ -0,0 +1,82 @@
+//
+// FrustumCuller.h
+//
+
+#pragma once
+
+#include "Utility.h"
+
+using namespace DirectX;
+
+namespace Utility
+{
+	namespace GeometryManager
+	{
+		enum ECullInstructionSet
+		{
+			CIS_Scalar,
+			CIS_SSE,  // 4 boxes per instruction.
+			CIS_AVX   // 8 boxes per instruction.
+		};
+
+		///<summary>
+		/// Culls world space boxes against the six planes of a view frustum.
+		/// Boxes are kept as a structure of arrays (center and extents per axis), so the SIMD paths test
+		/// 4 or 8 boxes against one plane per instruction. The output is a compact list of visible indices.
+		///</summary>
+		class FrustumCuller
+		{
+		public:
+
+			// The arrays are padded to a whole number of blocks, the widest path reads BlockSize boxes at a time.
+			static const uint32 BlockSize = 8;
+
+			static const uint32 MaxPlanes = 12;
+
+			FrustumCuller();
+
+			void   Resize(uint32 InNumBoxes);
+			uint32 GetNumBoxes() const { return m_numBoxes; }
+
+			void   SetBounds(uint32 InIndex, const BoundingBox& InBounds);
+
+			///<summary>
+			/// Inward facing planes (left, right, bottom, top, near, far) of a view projection matrix,
+			/// works for perspective and orthographic projections alike.
+			///</summary>
+			static void XM_CALLCONV ExtractPlanes(FXMMATRIX InViewProj, XMFLOAT4 OutPlanes[6]);
+
+			///<summary>
+			/// Indices of the boxes not entirely behind any of the planes in increasing order, returns their count.
+			/// Uses the widest instruction set the CPU supports.
+			///</summary>
+			uint32 Cull(const XMFLOAT4* InPlanes, uint32 InNumPlanes, std::vector<uint32>& OutVisible) const;
+
+			uint32 Cull(const XMFLOAT4* InPlanes, uint32 InNumPlanes, std::vector<uint32>& OutVisible, ECullInstructionSet InInstructionSet) const;
+
+			///<summary>
+			/// Shadow casters of a directional light: boxes inside the light frustum, open towards the light,
+			/// whose shadow (the box swept InSweepLength along InLightDirection) can reach the camera frustum.
+			///</summary>
+			uint32 CullShadowCasters(const XMFLOAT4 InLightPlanes[6], const XMFLOAT4 InCameraPlanes[6], const XMFLOAT3& InLightDirection,
+				float InSweepLength, std::vector<uint32>& OutCasters, ECullInstructionSet InInstructionSet = GetBestInstructionSet()) const;
+
+			static ECullInstructionSet GetBestInstructionSet();
+
+		private:
+
+			uint32 CullScalar(const XMFLOAT4* InPlanes, uint32 InNumPlanes, uint32* OutVisible) const;
+			uint32 CullSSE(const XMFLOAT4* InPlanes, uint32 InNumPlanes, uint32* OutVisible) const;
+			uint32 CullAVX(const XMFLOAT4* InPlanes, uint32 InNumPlanes, uint32* OutVisible) const;
+
+			uint32             m_numBoxes;
+
+			std::vector<float> m_centerX;
+			std::vector<float> m_centerY;
+			std::vector<float> m_centerZ;
+			std::vector<float> m_extentX;
+			std::vector<float> m_extentY;
+			std::vector<float> m_extentZ;
+		};
+	}
+}
@@ -0,0 +1,130 @@
+//
+// GeometryCache.h
+//
+
+#pragma once
+
+#include "Utility.h"
+
+#include <memory>
+#include <unordered_map>
+
+namespace Utility
+{
+	namespace GeometryManager
+	{
+		///<summary>
+		/// Uploaded geometry by content hash, shared by every owner with the same content. An entry keeps its users, the
+		/// first one is the source new lookups compare their content against, and goes away with the last of them.
+		/// TOwner keeps where it is: uint64 GeometryHash and int32 GeometryUser (-1 when not in the cache), so that
+		/// Remove is a lookup and a swap.
+		///</summary>
+		template<typename TOwner, typename TData>
+		class GeometryCache
+		{
+		public:
+
+			///<summary>
+			/// The data of the entry of InHash when InIsSame(Source) holds, InOwner is then one of its users. nullptr otherwise.
+			///</summary>
+			template<typename TIsSame>
+			std::shared_ptr<TData> Share(uint64 InHash, TOwner* InOwner, const TIsSame& InIsSame);
+
+			///<summary>
+			/// InOwner uploaded InData itself and becomes the source of InHash. A hash collision leaves the entry to the
+			/// content it has, InOwner keeps its data to itself then.
+			///</summary>
+			void Add(uint64 InHash, TOwner* InOwner, const std::shared_ptr<TData>& InData);
+
+			///<summary>
+			/// Call before InOwner is destroyed or uploads other content. The next user takes over as the source.
+			///</summary>
+			void Remove(TOwner* InOwner);
+
+			const TOwner* GetSource(uint64 InHash) const
+			{
+				auto entry = m_entries.find(InHash);
+				return entry == m_entries.end() ? nullptr : entry->second.Users.front();
+			}
+
+			uint32 GetNumUsers(uint64 InHash) const
+			{
+				auto entry = m_entries.find(InHash);
+				return entry == m_entries.end() ? 0 : (uint32)entry->second.Users.size();
+			}
+
+			uint32 GetNumEntries() const { return (uint32)m_entries.size(); }
+
+		private:
+
+			struct Entry
+			{
+				std::weak_ptr<TData> Data;
+				std::vector<TOwner*> Users; // Never empty, the first one is the source.
+			};
+
+			void AddUser(Entry& InEntry, uint64 InHash, TOwner* InOwner)
+			{
+				InOwner->GeometryHash = InHash;
+				InOwner->GeometryUser = (int32)InEntry.Users.size();
+				InEntry.Users.push_back(InOwner);
+			}
+
+			std::unordered_map<uint64, Entry> m_entries;
+		};
+
+		template<typename TOwner, typename TData>
+		template<typename TIsSame>
+		std::shared_ptr<TData> GeometryCache<TOwner, TData>::Share(uint64 InHash, TOwner* InOwner, const TIsSame& InIsSame)
+		{
+			auto entry = m_entries.find(InHash);
+			if (entry == m_entries.end())
+				return nullptr;
+
+			std::shared_ptr<TData> data = entry->second.Data.lock();
+			if (data == nullptr || !InIsSame(*entry->second.Users.front()))
+				return nullptr;
+
+			AddUser(entry->second, InHash, InOwner);
+			return data;
+		}
+
+		template<typename TOwner, typename TData>
+		void GeometryCache<TOwner, TData>::Add(uint64 InHash, TOwner* InOwner, const std::shared_ptr<TData>& InData)
+		{
+			Entry& entry = m_entries[InHash];
+			if (!entry.Users.empty())
+				return;
+
+			entry.Data = InData;
+			AddUser(entry, InHash, InOwner);
+		}
+
+		template<typename TOwner, typename TData>
+		void GeometryCache<TOwner, TData>::Remove(TOwner* InOwner)
+		{
+			if (InOwner->GeometryUser < 0)
+				return;
+
+			auto entry = m_entries.find(InOwner->GeometryHash);
+			assert(entry != m_entries.end() && entry->second.Users[InOwner->GeometryUser] == InOwner);
+
+			std::vector<TOwner*>& users = entry->second.Users;
+			if (users.size() == 1)
+			{
+				m_entries.erase(entry);
+			}
+			else
+			{
+				// The last user takes the freed position, the first one if it was the source.
+				TOwner* last = users.back();
+				last->GeometryUser = InOwner->GeometryUser;
+				users[InOwner->GeometryUser] = last;
+				users.pop_back();
+			}
+
+			InOwner->GeometryHash = 0;
+			InOwner->GeometryUser = -1;
+		}
+	}
+}
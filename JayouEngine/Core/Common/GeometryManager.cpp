@@ -7,8 +7,6 @@
 using namespace Utility;
 using namespace WinUtility::GeometryManager;
 
-int32 RenderItem::Count = 0;
-
 GeometryData<ColorVertex> GeometryCreator::CreateLineGrid(
 	float width, float depth, uint32 m, uint32 n, 
 	const XMFLOAT4& InColorX, const XMFLOAT4& InColorZ, 
@@ -800,7 +798,7 @@ GeometryData<ColorVertex> GeometryCreator::CreateDirLightGeo()
 		meshData.Vertices.push_back(vertex);
 	}
 
-	for (uint32 i = 0; i < (UINT)meshData.Vertices.size(); i += 2)
+	for (uint32 i = 0; i < (uint32)meshData.Vertices.size(); i += 2)
 	{
 		meshData.Indices32.push_back(i);
 		meshData.Indices32.push_back(i + 1);
@@ -7,6 +7,9 @@
 #include "Utility.h"
 #include "../Math/Math.h"
 #include "Interface/IObject.h"
+#include "TriangleBVH.h"
+#include "SceneBVH.h"
+#include "TransformHierarchy.h"
 
 using namespace Math;
 using namespace Core;
@@ -39,10 +42,17 @@ namespace Utility
 			Count
 		};
 
+		// SceneBVH proxy mask bit of a layer.
+		inline uint32 GetRenderLayerMask(RenderLayer InLayer)
+		{
+			return 1u << (uint32)InLayer;
+		}
+
 		enum EVertexFormat
 		{
 			VF_ColorVertex,
-			VF_Vertex
+			VF_Vertex,
+			VF_PackedVertex
 		};
 
 		struct BuiltInGeoDesc
@@ -112,6 +122,26 @@ namespace Utility
 			XMFLOAT2 TexC;
 		};		
 
+		// 24 bytes version of Vertex, see VertexPacker. Positions are quantized to the mesh bounds,
+		// dequantized with D3DRenderData::PositionScale/PositionBias.
+		struct PackedVertex
+		{
+			uint16 Position[4];  // R16G16B16A16_UNORM, w unused.
+			int16  Normal[2];    // R16G16_SNORM, octahedral.
+			int16  TangentU[2];  // R16G16_SNORM, octahedral.
+			uint16 TexC[2];      // R16G16_FLOAT.
+			uint32 Color;        // R8G8B8A8_UNORM.
+		};
+
+		inline XMFLOAT3 GetVertexPosition(const ColorVertex& InVertex) { return InVertex.Position; }
+		inline XMFLOAT3 GetVertexPosition(const Vertex& InVertex) { return InVertex.Position; }
+
+		// Still quantized, [0, 1] over the mesh bounds.
+		inline XMFLOAT3 GetVertexPosition(const PackedVertex& InVertex)
+		{
+			return XMFLOAT3(InVertex.Position[0] / 65535.0f, InVertex.Position[1] / 65535.0f, InVertex.Position[2] / 65535.0f);
+		}
+
 		struct BoxSphereBounds
 		{
 		public:
@@ -154,6 +184,12 @@ namespace Utility
 			std::vector<TVertex> Vertices;
 			std::vector<uint32> Indices32;
 
+			// Every index fits in 16 bits, half the index buffer.
+			bool CanUse16BitIndices() const
+			{
+				return Vertices.size() < 65536;
+			}
+
 			std::vector<uint16>& GetIndices16()
 			{
 				if (mIndices16.empty())
@@ -173,7 +209,7 @@ namespace Utility
 				Vector3 vmin(+maxFloat);
 				Vector3 vmax(-maxFloat);
 
-				for (auto vertex : Vertices)
+				for (const auto& vertex : Vertices)
 				{
 					Vector3 pos = vertex.Position;
 					vmin = Math::Min(vmin, pos);
@@ -236,7 +272,7 @@ namespace Utility
 
 				for (uint32 i = BaseVertexLocation; i <= maxVertexId; ++i)
 				{
-					Vector3 pos = vertices[i].Position;
+					Vector3 pos = GetVertexPosition(vertices[i]);
 					vmin = Math::Min(vmin, pos);
 					vmax = Math::Max(vmax, pos);
 				}
@@ -254,11 +290,42 @@ namespace Utility
 			}
 		};	
 
+		// A simplified level of a Geometry. Shares the vertices of the base mesh, only the indices differ.
+		struct MeshLOD
+		{
+			std::vector<uint32> Indices32;
+
+			// Object space geometric error against the base mesh, see MeshSimplifier::ComputeScreenSpaceError.
+			float               Error = 0.0f;
+		};
+
+		// A cluster of at most MeshletBuilder::MaxVertices vertices / MaxTriangles triangles,
+		// its triangles are contiguous in the index buffer.
+		struct Meshlet
+		{
+			uint32          StartIndexLocation = 0;
+			uint32          IndexCount = 0;
+			uint32          VertexCount = 0;
+
+			BoxSphereBounds Bounds;
+
+			// Backface cone, the whole cluster faces away from an eye where
+			// dot(Center - Eye, ConeAxis) >= ConeCutoff * |Center - Eye| + Radius. A cutoff of 1 never culls.
+			XMFLOAT3        ConeAxis = { 0.0f, 0.0f, 0.0f };
+			float           ConeCutoff = 1.0f;
+		};
+
 		struct Geometry : public IObject
 		{
 			GeometryData<Vertex> Data;
 			BoxSphereBounds      Bounds;
 
+			// LOD1...LODn, LOD0 is Data itself.
+			std::vector<MeshLOD> LODs;
+
+			// Clusters of LOD0, index ranges into Data.Indices32.
+			std::vector<Meshlet> Meshlets;
+
 			void CalcBounds()
 			{
 				Bounds = Data.CalcBounds();
@@ -299,13 +366,10 @@ namespace WinUtility
 	{
 		using namespace Utility::GeometryManager;
 
+#ifdef _WINDOWS
 		struct D3DRenderData
 		{
-			// System memory copies.  Use Blobs because the vertex/index format can be generic.
-			// It is up to the client to cast appropriately.
-			// Using D3DCreateBlob(...), CopyMemory(...).
-			ComPtr<ID3DBlob> VertexBufferCPU = nullptr;
-			ComPtr<ID3DBlob> IndexBufferCPU = nullptr;
+			// No system memory copy, nothing reads one back. The CPU side of the mesh is RenderItem::CachedGeometryData.
 
 			// GPU Buffer.
 			ComPtr<ID3D12Resource> VertexBufferGPU = nullptr;
@@ -323,10 +387,27 @@ namespace WinUtility
 
 			EVertexFormat VertexFormat = VF_Vertex;
 
+			// Second copy of the positions only, so depth only passes fetch 8/12 bytes per vertex.
+			// See PositionStreamLayout/PackedPositionStreamLayout, optional.
+			ComPtr<ID3D12Resource> PositionBufferGPU = nullptr;
+			ComPtr<ID3D12Resource> PositionBufferUploader = nullptr;
+			uint32 PositionByteStride = 0;
+			uint32 PositionBufferByteSize = 0;
+
+			// VF_PackedVertex only, PosL = PackedPosL * PositionScale + PositionBias.
+			XMFLOAT3 PositionScale = { 1.0f, 1.0f, 1.0f };
+			XMFLOAT3 PositionBias = { 0.0f, 0.0f, 0.0f };
+
 			// A D3DRenderData may store multiple geometries in one vertex/index buffer.
 			// Use this container to define the Submesh geometries so we can draw
 			// the Submeshes individually.
-			std::unordered_map<std::string, Section> Sections;	
+			std::unordered_map<NameId, Section> Sections;	
+
+			// LOD1...LODn of a single section mesh, they share the vertex buffer with the base mesh.
+			std::vector<Section> LODSections;
+
+			// Clusters of the base mesh, drawn individually after per cluster culling.
+			std::vector<Meshlet> Meshlets;
 
 			D3D12_VERTEX_BUFFER_VIEW VertexBufferView() const
 			{
@@ -338,6 +419,16 @@ namespace WinUtility
 				return vbv;
 			}
 
+			D3D12_VERTEX_BUFFER_VIEW PositionBufferView() const
+			{
+				D3D12_VERTEX_BUFFER_VIEW vbv;
+				vbv.BufferLocation = PositionBufferGPU->GetGPUVirtualAddress();
+				vbv.StrideInBytes = PositionByteStride;
+				vbv.SizeInBytes = PositionBufferByteSize;
+
+				return vbv;
+			}
+
 			D3D12_INDEX_BUFFER_VIEW IndexBufferView() const
 			{
 				D3D12_INDEX_BUFFER_VIEW ibv;
@@ -353,6 +444,7 @@ namespace WinUtility
 			{
 				VertexBufferUploader = nullptr;
 				IndexBufferUploader = nullptr;
+				PositionBufferUploader = nullptr;
 			}
 		};
 
@@ -368,7 +460,7 @@ namespace WinUtility
 
 			XMFLOAT4 VertexColor = XMFLOAT4(Colors::Gray);
 
-			// Transform Matrix.
+			// World matrix. Translation, Rotation and Scale make the local one, relative to the parent node in Transforms.
 			Matrix4                        TransFormMatrix = Matrix4(kIdentity);
 			Vector3                        Translation = { 0.0f };
 			Vector3                        Rotation = { 0.0f };
@@ -379,29 +471,95 @@ namespace WinUtility
 			// Primitive topology.
 			D3D12_PRIMITIVE_TOPOLOGY       PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
 
-			std::unique_ptr<D3DRenderData> RenderData = nullptr;
+			// Shared by the render items whose geometry has the same content, see GWorld::CreateRenderItemGeometry.
+			std::shared_ptr<D3DRenderData> RenderData = nullptr;
+
+			// Where this item is in the owning GeometryCache, -1 when its RenderData is not shared through it.
+			uint64                         GeometryHash = 0;
+			int32                          GeometryUser = -1;
 
 			bool                           bIntersectBoundingOnly = false;
 			bool                           bCastShadow = true;
 
+			// Upload CachedGeometryData as VF_PackedVertex.
+			bool                           bPackVertices = false;
+
 			GeometryData<Vertex>           CachedGeometryData;
 			BuiltInGeoDesc                 CachedBuiltInGeoDesc;
+			std::vector<MeshLOD>           CachedLODs;
+			std::vector<Meshlet>           CachedMeshlets;
+
+			// Object space triangles of CachedGeometryData for picking, empty when bIntersectBoundingOnly.
+			TriangleBVH                    CachedBVH;
 
-			static int32 Count;
+			// 0 draws the full mesh, i draws RenderData->LODSections[i - 1].
+			uint32                         LODIndex = 0;
+
+			// Surviving RenderData->Meshlets of the main view, only used when bMeshletCulled.
+			std::vector<uint32>            VisibleMeshlets;
+			bool                           bMeshletCulled = false;
+
+			// Bounds.BoxBounds under TransFormMatrix, kept by UpdateWorldBounds.
+			BoundingBox                    WorldBounds;
+
+			// Proxy of the world bounds in the owning scene, see GWorld::GWorldCached.
+			SceneBVH*                      Scene = nullptr;
+			int32                          SceneProxy = SceneBVH::NullProxy;
+
+			// Node in the owning transform hierarchy, see GWorld::GWorldCached & GWorld::UpdateTransforms.
+			TransformHierarchy*            Transforms = nullptr;
+			int32                          TransformNode = TransformHierarchy::NullNode;
+
+			// Hot per frame copy of this item, see RenderEntityStore (-1 when none).
+			int32                          Entity = -1;
+
+			// Position in each GWorld::m_renderItemLayer holding this item, -1 elsewhere. Layers are unordered, see GWorld::RemoveFromLayers.
+			int32                          LayerPositions[RenderLayer::Count];
 
 			RenderItem()
 			{
-				Index = Count++;
+				std::fill(std::begin(LayerPositions), std::end(LayerPositions), -1);
 			}
 
 			void SetTransFormMatrix(const Vector3& InTranslation, const Vector3& InRotation, const Vector3& InScale)
 			{
-				TransFormMatrix = Matrix4(AffineTransform(InTranslation).Rotation(InRotation).Scale(InScale));
+				const Matrix4 local = Matrix4(AffineTransform(InTranslation).Rotation(InRotation).Scale(InScale));
 				Translation = InTranslation;
 				Rotation = InRotation;
 				Scale = InScale;
+
+				// The world matrix and bounds come back from the hierarchy update.
+				if (Transforms != nullptr && TransformNode != TransformHierarchy::NullNode)
+				{
+					Transforms->SetLocal(TransformNode, local);
+					return;
+				}
+
+				TransFormMatrix = local;
+				UpdateWorldBounds();
+			}
+
+			BoundingBox GetWorldBounds() const
+			{
+				BoundingBox worldBounds;
+				Bounds.BoxBounds.Transform(worldBounds, TransFormMatrix);
+				return worldBounds;
+			}
+
+			///<summary>
+			/// Call after TransFormMatrix or Bounds changed, refreshes WorldBounds and refits the scene proxy.
+			///</summary>
+			void UpdateWorldBounds()
+			{
+				WorldBounds = GetWorldBounds();
+
+				if (Scene != nullptr && SceneProxy != SceneBVH::NullProxy)
+				{
+					Scene->Move(SceneProxy, WorldBounds);
+				}
 			}
 		};
+#endif // _WINDOWS
 
 		class GeometryCreator
 		{
@@ -0,0 +1,88 @@
+//
+// ImportQueue.cpp
+//
+
+#include "ImportQueue.h"
+#include "MeshCache.h"
+
+using namespace Core;
+using namespace Utility;
+
+ImportTask* ImportQueue::Add(const ImportGeoDesc& InDesc)
+{
+	m_tasks.push_back(std::make_unique<ImportTask>());
+	ImportTask* task = m_tasks.back().get();
+	task->Desc = InDesc;
+
+	ThreadManager::JobSystem::Get().Run([this, task]()
+	{
+		Import(*task);
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_finished.push_back(task);
+	}, &m_jobs);
+
+	return task;
+}
+
+void ImportQueue::CancelAll()
+{
+	for (auto& task : m_tasks)
+	{
+		task->Progress.bCancel = true;
+	}
+
+	ThreadManager::JobSystem::Get().Wait(m_jobs);
+
+	m_finished.clear();
+	m_tasks.clear();
+}
+
+void ImportQueue::Import(ImportTask& InOutTask)
+{
+	// A cache of the same source and settings skips Assimp, the post processing and the BVH builds.
+	MeshCacheKey cacheKey;
+	const std::string cachePath = MeshCache::GetCachePath(InOutTask.Desc.PathName);
+	const bool bUseCache = InOutTask.Desc.bUseMeshCache && MeshCache::ComputeKey(InOutTask.Desc, cacheKey);
+	if (bUseCache && MeshCache::Load(cachePath, cacheKey, InOutTask.Geometries, InOutTask.Nodes, InOutTask.BVHs))
+	{
+		for (auto& pair : InOutTask.Geometries)
+		{
+			pair.second.PathName = InOutTask.Desc.PathName;
+		}
+
+		InOutTask.bSucceeded = true;
+		InOutTask.Progress.Progress = 1.0f;
+		return;
+	}
+
+	if (!InOutTask.Importer.Import(InOutTask.Desc, &InOutTask.Progress))
+		return;
+
+	InOutTask.Geometries = InOutTask.Importer.TakeGeometries();
+	InOutTask.Nodes = InOutTask.Importer.GetNodes();
+
+	std::vector<const Geometry*> geos;
+	std::vector<TriangleBVH*> bvhs;
+	for (const auto& pair : InOutTask.Geometries)
+	{
+		geos.push_back(&pair.second);
+		bvhs.push_back(&InOutTask.BVHs[pair.first]);
+	}
+
+	ThreadManager::JobSystem::Get().ParallelFor((uint32)geos.size(), 1, [&](uint32 InBegin, uint32 InEnd)
+	{
+		for (uint32 i = InBegin; i < InEnd; ++i)
+		{
+			bvhs[i]->Build(geos[i]->Data.Vertices, geos[i]->Data.Indices32);
+		}
+	});
+
+	// Not worth failing the import over, the next one simply goes through Assimp again.
+	if (bUseCache && !InOutTask.Progress.bCancel)
+	{
+		InOutTask.bCacheNotWritten = !MeshCache::Save(cachePath, cacheKey, InOutTask.Geometries, InOutTask.Nodes, InOutTask.BVHs);
+	}
+
+	InOutTask.bSucceeded = true;
+}
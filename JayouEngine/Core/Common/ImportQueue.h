@@ -0,0 +1,95 @@
+//
+// ImportQueue.h
+//
+
+#pragma once
+
+#include "AssimpImporter.h"
+#include "TriangleBVH.h"
+#include "ThreadManager.h"
+
+#include <algorithm>
+#include <mutex>
+
+namespace Core
+{
+	// One model imported on the job system, see ImportQueue.
+	struct ImportTask
+	{
+		ImportGeoDesc                                Desc;
+		ImportProgress                               Progress;
+		AssimpImporter                               Importer;
+
+		// Taken from the importer or loaded from the mesh cache, see MeshCache.
+		std::unordered_map<std::string, Geometry>    Geometries;
+		std::vector<ImportNode>                      Nodes;
+		std::unordered_map<std::string, TriangleBVH> BVHs; // By geometry name, picking structures built next to the import.
+		bool                                         bSucceeded = false;
+		bool                                         bCacheNotWritten = false; // Imported, the mesh cache could not be saved.
+	};
+
+	///<summary>
+	/// Imports running on the job system. Add returns at once, each task has its own importer so several files import
+	/// side by side. Nothing but the task is touched by its job, finished tasks wait on a mutex guarded list until the
+	/// thread that added them drains it, e.g. once a frame.
+	///</summary>
+	class ImportQueue
+	{
+	public:
+
+		ImportQueue() = default;
+		ImportQueue(const ImportQueue&) = delete;
+		ImportQueue& operator=(const ImportQueue&) = delete;
+
+		~ImportQueue() { CancelAll(); }
+
+		// The task stays valid until it is drained, its Progress can be read and cancelled meanwhile.
+		ImportTask* Add(const ImportGeoDesc& InDesc);
+
+		///<summary>
+		/// InOnFinished(ImportTask&) for every task finished since the last call, in the order they finished, failed and
+		/// cancelled ones included. The tasks are gone afterwards. Returns how many there were.
+		///</summary>
+		template<typename TOnFinished>
+		uint32 Drain(const TOnFinished& InOnFinished);
+
+		// Cancels the running imports and waits for them, nothing is handed out.
+		void CancelAll();
+
+		// Running ones and finished ones not drained yet, in the order they were added.
+		const std::vector<std::unique_ptr<ImportTask>>& GetTasks() const { return m_tasks; }
+
+	private:
+
+		// The job, on a worker.
+		static void Import(ImportTask& InOutTask);
+
+		std::vector<std::unique_ptr<ImportTask>> m_tasks;
+		std::vector<ImportTask*>                 m_finished;
+		std::mutex                               m_mutex;
+		Utility::ThreadManager::JobCounter       m_jobs;
+	};
+
+	template<typename TOnFinished>
+	uint32 ImportQueue::Drain(const TOnFinished& InOnFinished)
+	{
+		std::vector<ImportTask*> finished;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			finished.swap(m_finished);
+		}
+
+		for (ImportTask* task : finished)
+		{
+			InOnFinished(*task);
+
+			auto it = std::find_if(m_tasks.begin(), m_tasks.end(), [task](const std::unique_ptr<ImportTask>& InTask)
+			{
+				return InTask.get() == task;
+			});
+			m_tasks.erase(it);
+		}
+
+		return (uint32)finished.size();
+	}
+}
@@ -0,0 +1,41 @@
+//
+// InstanceBatcher.cpp
+//
+
+#include "InstanceBatcher.h"
+
+using namespace Utility;
+using namespace Utility::GeometryManager;
+
+void InstanceBatcher::Reset()
+{
+	m_batches.clear();
+	m_instanceIndices.clear();
+	m_passInstanceOffset = 0;
+}
+
+void InstanceBatcher::BeginPass()
+{
+	m_batches.clear();
+	m_passInstanceOffset = (uint32)m_instanceIndices.size();
+}
+
+void InstanceBatcher::Add(uint32 InPacket, const InstanceBatchKey& InKey, uint32 InInstanceIndex)
+{
+	if (!m_batches.empty() && InKey.CanJoin(m_lastKey))
+	{
+		m_batches.back().InstanceCount++;
+	}
+	else
+	{
+		InstanceBatch batch;
+		batch.Packet = InPacket;
+		batch.InstanceOffset = (uint32)m_instanceIndices.size();
+		batch.InstanceCount = 1;
+		m_batches.push_back(batch);
+
+		m_lastKey = InKey;
+	}
+
+	m_instanceIndices.push_back(InInstanceIndex);
+}
@@ -0,0 +1,81 @@
+//
+// InstanceBatcher.h
+//
+
+#pragma once
+
+#include "Utility.h"
+
+namespace Utility
+{
+	namespace GeometryManager
+	{
+		///<summary>
+		/// Draw packets with equal keys may share one instanced draw: same geometry, same material
+		/// and the same variant (LOD, topology...). A packet whose bCanBatch is false is always drawn alone.
+		///</summary>
+		struct InstanceBatchKey
+		{
+			uint64 Geometry = 0;
+			uint32 Material = 0;
+			uint32 Variant = 0;
+			bool   bCanBatch = true;
+
+			bool CanJoin(const InstanceBatchKey& InOther) const
+			{
+				return bCanBatch && InOther.bCanBatch &&
+					Geometry == InOther.Geometry && Material == InOther.Material && Variant == InOther.Variant;
+			}
+		};
+
+		///<summary>
+		/// One instanced draw. Its instances are GetInstanceIndices()[InstanceOffset, InstanceOffset + InstanceCount).
+		///</summary>
+		struct InstanceBatch
+		{
+			uint32 Packet = 0;         // First packet of the batch, as given to Add.
+			uint32 InstanceOffset = 0;
+			uint32 InstanceCount = 0;
+		};
+
+		///<summary>
+		/// Merges neighbouring draw packets into instanced draws and packs the instance indices of every draw
+		/// of a frame into one list, so a single structured buffer serves all the passes. No device involved,
+		/// the caller uploads the list and issues the batches.
+		///</summary>
+		class InstanceBatcher
+		{
+		public:
+
+			///<summary>
+			/// Starts a new frame, the instance index list is emptied.
+			///</summary>
+			void Reset();
+
+			///<summary>
+			/// Starts the batches of one pass. The instance indices of the previous passes are kept.
+			///</summary>
+			void BeginPass();
+
+			///<summary>
+			/// Adds packets in draw order, a packet joins the last batch of the pass when their keys allow it.
+			/// InInstanceIndex is stored in the instance index list, e.g. where the per instance data of the packet lives.
+			///</summary>
+			void Add(uint32 InPacket, const InstanceBatchKey& InKey, uint32 InInstanceIndex);
+
+			const std::vector<InstanceBatch>& GetBatches() const { return m_batches; }
+			const std::vector<uint32>&        GetInstanceIndices() const { return m_instanceIndices; }
+
+			// Range of the instance index list written by the current pass.
+			uint32 GetPassInstanceOffset() const { return m_passInstanceOffset; }
+			uint32 GetNumPassInstances() const { return (uint32)m_instanceIndices.size() - m_passInstanceOffset; }
+
+		private:
+
+			std::vector<InstanceBatch> m_batches;
+			InstanceBatchKey           m_lastKey;
+			std::vector<uint32>        m_instanceIndices;
+			uint32                     m_passInstanceOffset = 0;
+		};
+	}
+}
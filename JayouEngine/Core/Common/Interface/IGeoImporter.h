@@ -7,6 +7,8 @@
 #include "../TypeDef.h"
 #include "../GeometryManager.h"
 
+#include <atomic>
+
 using namespace Utility::GeometryManager;
 
 namespace Core
@@ -22,6 +24,25 @@ namespace Core
 
 		XMFLOAT4     Color = XMFLOAT4(Colors::Gray);
 
+		// Reorder triangles/vertices for post-transform cache and vertex fetch locality.
+		bool         bOptimizeMesh = true;
+
+		// Number of simplified levels generated on import, 0 disables LOD generation.
+		uint32       NumLODs = 3;
+
+		// Split LOD0 into clusters for per cluster frustum/backface culling.
+		bool         bBuildMeshlets = true;
+
+		// Upload as VF_PackedVertex (24 bytes instead of 60).
+		bool         bPackVertices = true;
+
+		// Reuse the .jmesh written by an earlier import of the same source and settings, see MeshCache.
+		bool         bUseMeshCache = true;
+
+		// Convert the meshes and build their LODs on the job system, false does it all on the calling thread.
+		// The result is the same byte for byte.
+		bool         bParallel = true;
+
 		// aiPostProcessSteps
 		uint32       PPSFlags =
 			aiProcess_CalcTangentSpace |
@@ -31,11 +52,28 @@ namespace Core
 			aiProcess_SortByPType;
 	};
 
+	// Shared with a running import, see GWorld::AddRenderItem(const ImportGeoDesc&).
+	struct ImportProgress
+	{
+		std::atomic<float> Progress{ 0.0f }; // 0...1.
+		std::atomic<bool>  bCancel{ false };  // Set by anyone, the import gives up at its next progress update.
+	};
+
+	// One node of an imported scene. Geometries are the names of the meshes the node instances.
+	struct ImportNode
+	{
+		std::string              Name;
+		int32                    Parent = -1; // Index in the node list, parents come first.
+		Matrix4                  LocalTransform = Matrix4(kIdentity);
+		std::vector<std::string> Geometries;
+	};
+
 	class IGeoImporter
 	{
 	public:
 
-		virtual bool Import(const ImportGeoDesc& InGeoDesc) = 0;
+		// InOutProgress, if any, is updated along the way and may cancel the import. May run on any thread.
+		virtual bool Import(const ImportGeoDesc& InGeoDesc, ImportProgress* InOutProgress = nullptr) = 0;
 
 		virtual Geometry GetGeometry(const std::string& InGeoName) = 0;
 
@@ -5,16 +5,39 @@
 #pragma once
 
 #include "../TypeDef.h"
+#include "../NameTable.h"
 
 namespace Core
 {
+	class IObject;
+
+	// Told about every MarkAsDirty of its objects, see Utility::GeometryManager::DirtyList.
+	class IDirtyList
+	{
+	public:
+
+		virtual void OnMarkedDirty(IObject* InObject) = 0;
+
+		virtual ~IDirtyList() {}
+	};
+
+	// Slot and generation of an object when the handle was taken, see Utility::GeometryManager::SlotMap.
+	struct SlotHandle
+	{
+		int32  Index = -1;
+		uint32 Generation = 0;
+	};
+
 	class IObject
 	{
 	public:
 
-		int32 Index;
+		// Slot in the GPU buffers of its kind, stable while the object lives. -1 until cached.
+		int32  Index = -1;
+		uint32 Generation = 0;
 
-		std::string  Name;
+		// Interned, see Utility::NameTable.
+		Utility::NameId Name;
 		std::string  PathName;
 		std::wstring WPathName;
 
@@ -28,19 +51,26 @@ namespace Core
 		bool bIsBuiltIn = false;
 		bool bIsVisible = true;
 
-		int NumFrameDirty = 3;
+		// Owned by the dirty list, if any.
+		IDirtyList* DirtyList = nullptr;
+		uint64      DirtyGeneration = 0;
+		int32       DirtySlot = -1;
 
 		void MarkAsDirty()
 		{
 			bIsDirty = true;
-			NumFrameDirty = 3;
+			if (DirtyList != nullptr)
+			{
+				DirtyList->OnMarkedDirty(this);
+			}
 		}
 
+		// The dirty list is where GWorld::GarbageCollection looks for deleted objects.
 		void MarkAsDeleted()
 		{
-			bIsDirty = true;
 			bIsVisible = false;
 			bMarkAsDeleted = true;
+			MarkAsDirty();
 		}
 
 		bool CanbeDeletedNow()
@@ -48,6 +78,14 @@ namespace Core
 			return bMarkAsDeleted && bCanBeDeleted;
 		}
 
+		SlotHandle GetHandle() const
+		{
+			SlotHandle handle;
+			handle.Index = Index;
+			handle.Generation = Generation;
+			return handle;
+		}
+
 		virtual ~IObject() {}
 	};
 }
\ No newline at end of file
@@ -12,7 +12,8 @@ namespace Core
 	{
 	public:
 
-		virtual void Add(IObject*) = 0;
+		// InParent must have been added before, nullptr adds a root.
+		virtual void Add(IObject* InObject, IObject* InParent = nullptr) = 0;
 
 		virtual ~IScene() {}
 	};
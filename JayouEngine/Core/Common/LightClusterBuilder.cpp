@@ -0,0 +1,398 @@
+//
+// LightClusterBuilder.cpp
+//
+
+#include "LightClusterBuilder.h"
+#include "ThreadManager.h"
+
+#include <cfloat>
+
+#if defined(_XM_SSE_INTRINSICS_) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+using namespace Utility;
+using namespace Utility::GeometryManager;
+
+namespace
+{
+	// Below this many lights the slices are built on the calling thread, handing them out costs more.
+	const uint32 MinLightsForThreads = 64;
+
+	uint32 CountTrailingZeros(uint32 InBits)
+	{
+#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanForward(&index, InBits);
+		return (uint32)index;
+#else
+		return (uint32)__builtin_ctz(InBits);
+#endif
+	}
+
+	// View space x (or y) of a point at InNDC on the screen and view depth InZ, for any D3D projection.
+	float UnprojectAxis(const XMFLOAT4X4& InProj, uint32 InAxis, float InNDC, float InZ)
+	{
+		const float w = InProj.m[2][3] * InZ + InProj.m[3][3];
+		return (InNDC * w - InProj.m[2][InAxis] * InZ - InProj.m[3][InAxis]) / InProj.m[InAxis][InAxis];
+	}
+}
+
+LightClusterBuilder::LightClusterBuilder()
+	: m_nearZ(0.0f)
+	, m_farZ(0.0f)
+	, m_sliceScale(0.0f)
+	, m_sliceBias(0.0f)
+	, m_numPointLights(0)
+	, m_maxLightsPerCluster(0)
+{
+	static_assert(NumClustersPerSlice % 4 == 0, "Slices are tested in blocks of 4 clusters.");
+
+	memset(&m_proj, 0, sizeof(m_proj));
+	m_slices.resize(NumClustersZ);
+	m_sliceDepths.resize(NumClustersZ + 1, 0.0f);
+	m_sliceIndices.resize(NumClustersZ);
+	m_clusters.resize(NumClusters, LightCluster{ 0, 0 });
+}
+
+void LightClusterBuilder::SetProjection(const XMFLOAT4X4& InProj, float InNearZ, float InFarZ)
+{
+	if (memcmp(&InProj, &m_proj, sizeof(m_proj)) == 0 && InNearZ == m_nearZ && InFarZ == m_farZ)
+		return;
+
+	assert(InNearZ > 0.0f && InFarZ > InNearZ);
+
+	m_proj = InProj;
+	m_nearZ = InNearZ;
+	m_farZ = InFarZ;
+
+	// z_k = Near * (Far / Near)^(k / NumClustersZ).
+	const float logDepthRange = log2f(InFarZ / InNearZ);
+	m_sliceScale = NumClustersZ / logDepthRange;
+	m_sliceBias = -(float)NumClustersZ * log2f(InNearZ) / logDepthRange;
+
+	for (uint32 k = 0; k <= NumClustersZ; ++k)
+	{
+		m_sliceDepths[k] = InNearZ * powf(InFarZ / InNearZ, (float)k / NumClustersZ);
+	}
+	m_sliceDepths[0] = InNearZ;
+	m_sliceDepths[NumClustersZ] = InFarZ;
+
+	for (uint32 k = 0; k < NumClustersZ; ++k)
+	{
+		SliceBounds& slice = m_slices[k];
+		const float depths[2] = { m_sliceDepths[k], m_sliceDepths[k + 1] };
+
+		for (uint32 j = 0; j < NumClustersY; ++j)
+		{
+			// Tile rows go down the screen, NDC y goes up.
+			const float ndcY[2] = { 1.0f - 2.0f * (j + 1) / NumClustersY, 1.0f - 2.0f * j / NumClustersY };
+
+			for (uint32 i = 0; i < NumClustersX; ++i)
+			{
+				const float ndcX[2] = { -1.0f + 2.0f * i / NumClustersX, -1.0f + 2.0f * (i + 1) / NumClustersX };
+
+				float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
+				for (float z : depths)
+				{
+					for (uint32 c = 0; c < 2; ++c)
+					{
+						const float x = UnprojectAxis(InProj, 0, ndcX[c], z);
+						const float y = UnprojectAxis(InProj, 1, ndcY[c], z);
+						minX = std::min(minX, x);
+						maxX = std::max(maxX, x);
+						minY = std::min(minY, y);
+						maxY = std::max(maxY, y);
+					}
+				}
+
+				const uint32 cluster = j * NumClustersX + i;
+				slice.MinX[cluster] = minX;
+				slice.MinY[cluster] = minY;
+				slice.MinZ[cluster] = depths[0];
+				slice.MaxX[cluster] = maxX;
+				slice.MaxY[cluster] = maxY;
+				slice.MaxZ[cluster] = depths[1];
+
+				const float extentX = 0.5f * (maxX - minX);
+				const float extentY = 0.5f * (maxY - minY);
+				const float extentZ = 0.5f * (depths[1] - depths[0]);
+				slice.CenterX[cluster] = minX + extentX;
+				slice.CenterY[cluster] = minY + extentY;
+				slice.CenterZ[cluster] = depths[0] + extentZ;
+				slice.Radius[cluster] = sqrtf(extentX * extentX + extentY * extentY + extentZ * extentZ);
+			}
+		}
+	}
+}
+
+uint32 LightClusterBuilder::Build(const XMFLOAT4X4& InView, const std::vector<ClusterLight>& InLights, const std::vector<uint32>& InGlobalLights,
+	ECullInstructionSet InInstructionSet /*= FrustumCuller::GetBestInstructionSet()*/)
+{
+	assert(m_nearZ > 0.0f && "SetProjection first.");
+	assert(InLights.size() < 0x10000);
+
+	// To view space, point lights first so each cluster lists its point lights before its spot lights.
+	m_viewLights.clear();
+	m_numPointLights = 0;
+	for (uint32 pass = 0; pass < 2; ++pass)
+	{
+		for (const ClusterLight& light : InLights)
+		{
+			if (light.bSpotLight != (pass == 1))
+				continue;
+
+			const XMFLOAT4X4& v = InView;
+			const XMFLOAT3& p = light.Position;
+			const XMFLOAT3& d = light.Direction;
+
+			ViewLight viewLight;
+			viewLight.X = p.x * v._11 + p.y * v._21 + p.z * v._31 + v._41;
+			viewLight.Y = p.x * v._12 + p.y * v._22 + p.z * v._32 + v._42;
+			viewLight.Z = p.x * v._13 + p.y * v._23 + p.z * v._33 + v._43;
+			viewLight.Range = light.Range;
+			viewLight.LightIndex = light.LightIndex;
+			viewLight.bSpotLight = light.bSpotLight && light.SpotPower > 0.0f;
+
+			// Behind the camera or past the far plane.
+			if (viewLight.Z + viewLight.Range < m_nearZ || viewLight.Z - viewLight.Range > m_farZ)
+				continue;
+
+			viewLight.DirX = viewLight.DirY = viewLight.DirZ = 0.0f;
+			viewLight.CosAngle = -1.0f;
+			viewLight.SinAngle = 0.0f;
+			if (viewLight.bSpotLight)
+			{
+				const float dirX = d.x * v._11 + d.y * v._21 + d.z * v._31;
+				const float dirY = d.x * v._12 + d.y * v._22 + d.z * v._32;
+				const float dirZ = d.x * v._13 + d.y * v._23 + d.z * v._33;
+				const float invLength = 1.0f / std::max(sqrtf(dirX * dirX + dirY * dirY + dirZ * dirZ), 1e-12f);
+				viewLight.DirX = dirX * invLength;
+				viewLight.DirY = dirY * invLength;
+				viewLight.DirZ = dirZ * invLength;
+
+				// pow(cos, SpotPower) = SpotCutoff.
+				viewLight.CosAngle = powf(SpotCutoff, 1.0f / light.SpotPower);
+				viewLight.SinAngle = sqrtf(std::max(1.0f - viewLight.CosAngle * viewLight.CosAngle, 0.0f));
+			}
+
+			m_viewLights.push_back(viewLight);
+			m_numPointLights += pass == 0 ? 1 : 0;
+		}
+	}
+
+	if (InInstructionSet == CIS_Scalar)
+	{
+		for (uint32 k = 0; k < NumClustersZ; ++k)
+		{
+			BuildSliceScalar(k, m_sliceIndices[k]);
+		}
+	}
+	else
+	{
+		auto buildSlices = [&](uint32 InBegin, uint32 InEnd)
+		{
+			SliceScratch scratch;
+			for (uint32 k = InBegin; k < InEnd; ++k)
+			{
+				BuildSliceSSE(k, m_sliceIndices[k], scratch);
+			}
+		};
+
+		if (m_viewLights.size() < MinLightsForThreads)
+		{
+			buildSlices(0, NumClustersZ);
+		}
+		else
+		{
+			ThreadManager::JobSystem::Get().ParallelFor(NumClustersZ, 1, buildSlices);
+		}
+	}
+
+	// Slices wrote offsets into their own lists, rebase them onto the shared list.
+	m_lightIndices.assign(InGlobalLights.begin(), InGlobalLights.end());
+	m_maxLightsPerCluster = 0;
+	for (uint32 k = 0; k < NumClustersZ; ++k)
+	{
+		const uint32 base = (uint32)m_lightIndices.size();
+		for (uint32 c = k * NumClustersPerSlice; c < (k + 1) * NumClustersPerSlice; ++c)
+		{
+			m_clusters[c].Offset += base;
+			m_maxLightsPerCluster = std::max(m_maxLightsPerCluster, m_clusters[c].GetPointCount() + m_clusters[c].GetSpotCount());
+		}
+		m_lightIndices.insert(m_lightIndices.end(), m_sliceIndices[k].begin(), m_sliceIndices[k].end());
+	}
+
+	return (uint32)m_lightIndices.size();
+}
+
+bool LightClusterBuilder::TestLightScalar(const ViewLight& InLight, const SliceBounds& InSlice, uint32 InCluster)
+{
+	const uint32 c = InCluster;
+
+	// Sphere of the light range vs the cluster box.
+	const float dx = std::max(std::max(InSlice.MinX[c] - InLight.X, InLight.X - InSlice.MaxX[c]), 0.0f);
+	const float dy = std::max(std::max(InSlice.MinY[c] - InLight.Y, InLight.Y - InSlice.MaxY[c]), 0.0f);
+	const float dz = std::max(std::max(InSlice.MinZ[c] - InLight.Z, InLight.Z - InSlice.MaxZ[c]), 0.0f);
+	if (dx * dx + dy * dy + dz * dz > InLight.Range * InLight.Range)
+		return false;
+
+	if (!InLight.bSpotLight)
+		return true;
+
+	// Cone vs the bounding sphere of the cluster.
+	const float vx = InSlice.CenterX[c] - InLight.X;
+	const float vy = InSlice.CenterY[c] - InLight.Y;
+	const float vz = InSlice.CenterZ[c] - InLight.Z;
+	const float lengthSq = vx * vx + vy * vy + vz * vz;
+	const float v1Length = vx * InLight.DirX + vy * InLight.DirY + vz * InLight.DirZ;
+	const float distanceClosest = InLight.CosAngle * sqrtf(std::max(lengthSq - v1Length * v1Length, 0.0f)) - v1Length * InLight.SinAngle;
+
+	const float radius = InSlice.Radius[c];
+	const bool bAngleCull = distanceClosest > radius;
+	const bool bFrontCull = v1Length > radius + InLight.Range;
+	const bool bBackCull = v1Length < -radius;
+
+	return !(bAngleCull || bFrontCull || bBackCull);
+}
+
+void LightClusterBuilder::BuildSliceScalar(uint32 InSlice, std::vector<uint32>& OutIndices)
+{
+	const SliceBounds& slice = m_slices[InSlice];
+	LightCluster* clusters = &m_clusters[InSlice * NumClustersPerSlice];
+
+	OutIndices.clear();
+	for (uint32 c = 0; c < NumClustersPerSlice; ++c)
+	{
+		const uint32 offset = (uint32)OutIndices.size();
+		uint32 numPointLights = 0;
+
+		for (uint32 l = 0; l < (uint32)m_viewLights.size(); ++l)
+		{
+			if (TestLightScalar(m_viewLights[l], slice, c))
+			{
+				OutIndices.push_back(m_viewLights[l].LightIndex);
+				numPointLights += l < m_numPointLights ? 1 : 0;
+			}
+		}
+
+		const uint32 numLights = (uint32)OutIndices.size() - offset;
+		clusters[c].Offset = offset;
+		clusters[c].Counts = numPointLights | ((numLights - numPointLights) << 16);
+	}
+}
+
+void LightClusterBuilder::BuildSliceSSE(uint32 InSlice, std::vector<uint32>& OutIndices, SliceScratch& InOutScratch)
+{
+#if defined(_XM_SSE_INTRINSICS_)
+	const SliceBounds& slice = m_slices[InSlice];
+	LightCluster* clusters = &m_clusters[InSlice * NumClustersPerSlice];
+
+	// Lights reaching the depth range of the slice, a little loose so no light the box test would keep is dropped.
+	const float sliceNear = m_sliceDepths[InSlice];
+	const float sliceFar = m_sliceDepths[InSlice + 1];
+	std::vector<uint32>& candidates = InOutScratch.Candidates;
+	candidates.clear();
+	uint32 numPointCandidates = 0;
+	for (uint32 l = 0; l < (uint32)m_viewLights.size(); ++l)
+	{
+		const ViewLight& light = m_viewLights[l];
+		const float range = light.Range * 1.001f + 1e-4f;
+		if (light.Z + range >= sliceNear && light.Z - range <= sliceFar)
+		{
+			candidates.push_back(l);
+			numPointCandidates += l < m_numPointLights ? 1 : 0;
+		}
+	}
+	const uint32 numCandidates = (uint32)candidates.size();
+
+	// One bit per candidate in every cluster.
+	const uint32 numWords = (numCandidates + 31) / 32;
+	InOutScratch.Bits.assign(NumClustersPerSlice * numWords, 0);
+	uint32* bits = InOutScratch.Bits.data();
+
+	const __m128 zero = _mm_setzero_ps();
+
+	for (uint32 i = 0; i < numCandidates; ++i)
+	{
+		const ViewLight& light = m_viewLights[candidates[i]];
+
+		const __m128 lightX = _mm_set1_ps(light.X);
+		const __m128 lightY = _mm_set1_ps(light.Y);
+		const __m128 lightZ = _mm_set1_ps(light.Z);
+		const __m128 rangeSq = _mm_set1_ps(light.Range * light.Range);
+
+		const __m128 dirX = _mm_set1_ps(light.DirX);
+		const __m128 dirY = _mm_set1_ps(light.DirY);
+		const __m128 dirZ = _mm_set1_ps(light.DirZ);
+		const __m128 cosAngle = _mm_set1_ps(light.CosAngle);
+		const __m128 sinAngle = _mm_set1_ps(light.SinAngle);
+		const __m128 range = _mm_set1_ps(light.Range);
+
+		const uint32 word = i / 32;
+		const uint32 bit = i % 32;
+
+		for (uint32 c = 0; c < NumClustersPerSlice; c += 4)
+		{
+			// Sphere of the light range vs the cluster boxes.
+			const __m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&slice.MinX[c]), lightX), _mm_sub_ps(lightX, _mm_loadu_ps(&slice.MaxX[c]))), zero);
+			const __m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&slice.MinY[c]), lightY), _mm_sub_ps(lightY, _mm_loadu_ps(&slice.MaxY[c]))), zero);
+			const __m128 dz = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&slice.MinZ[c]), lightZ), _mm_sub_ps(lightZ, _mm_loadu_ps(&slice.MaxZ[c]))), zero);
+			const __m128 distanceSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+			__m128 hit = _mm_cmple_ps(distanceSq, rangeSq);
+
+			if (light.bSpotLight)
+			{
+				// Cone vs the bounding spheres of the clusters.
+				const __m128 vx = _mm_sub_ps(_mm_loadu_ps(&slice.CenterX[c]), lightX);
+				const __m128 vy = _mm_sub_ps(_mm_loadu_ps(&slice.CenterY[c]), lightY);
+				const __m128 vz = _mm_sub_ps(_mm_loadu_ps(&slice.CenterZ[c]), lightZ);
+				const __m128 lengthSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz));
+				const __m128 v1Length = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, dirX), _mm_mul_ps(vy, dirY)), _mm_mul_ps(vz, dirZ));
+				const __m128 distanceClosest = _mm_sub_ps(
+					_mm_mul_ps(cosAngle, _mm_sqrt_ps(_mm_max_ps(_mm_sub_ps(lengthSq, _mm_mul_ps(v1Length, v1Length)), zero))),
+					_mm_mul_ps(v1Length, sinAngle));
+
+				const __m128 radius = _mm_loadu_ps(&slice.Radius[c]);
+				const __m128 angleCull = _mm_cmpgt_ps(distanceClosest, radius);
+				const __m128 frontCull = _mm_cmpgt_ps(v1Length, _mm_add_ps(radius, range));
+				const __m128 backCull = _mm_cmplt_ps(v1Length, _mm_sub_ps(zero, radius));
+
+				hit = _mm_andnot_ps(_mm_or_ps(angleCull, _mm_or_ps(frontCull, backCull)), hit);
+			}
+
+			const uint32 mask = (uint32)_mm_movemask_ps(hit);
+			bits[(c + 0) * numWords + word] |= ((mask >> 0) & 1) << bit;
+			bits[(c + 1) * numWords + word] |= ((mask >> 1) & 1) << bit;
+			bits[(c + 2) * numWords + word] |= ((mask >> 2) & 1) << bit;
+			bits[(c + 3) * numWords + word] |= ((mask >> 3) & 1) << bit;
+		}
+	}
+
+	// Candidates keep the light order, so the lists come out as in the brute force build.
+	OutIndices.clear();
+	for (uint32 c = 0; c < NumClustersPerSlice; ++c)
+	{
+		const uint32 offset = (uint32)OutIndices.size();
+		uint32 numPointLights = 0;
+
+		const uint32* clusterBits = &bits[c * numWords];
+		for (uint32 w = 0; w < numWords; ++w)
+		{
+			for (uint32 wordBits = clusterBits[w]; wordBits != 0; wordBits &= wordBits - 1)
+			{
+				const uint32 i = w * 32 + CountTrailingZeros(wordBits);
+				OutIndices.push_back(m_viewLights[candidates[i]].LightIndex);
+				numPointLights += i < numPointCandidates ? 1 : 0;
+			}
+		}
+
+		const uint32 numLights = (uint32)OutIndices.size() - offset;
+		clusters[c].Offset = offset;
+		clusters[c].Counts = numPointLights | ((numLights - numPointLights) << 16);
+	}
+#else
+	(void)InOutScratch;
+	BuildSliceScalar(InSlice, OutIndices);
+#endif
+}
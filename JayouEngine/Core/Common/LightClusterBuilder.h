@@ -0,0 +1,139 @@
+//
+// LightClusterBuilder.h
+//
+
+#pragma once
+
+#include "Utility.h"
+#include "FrustumCuller.h"
+
+using namespace DirectX;
+
+namespace Utility
+{
+	namespace GeometryManager
+	{
+		///<summary>
+		/// Point or spot light to bin, world space.
+		///</summary>
+		struct ClusterLight
+		{
+			XMFLOAT3 Position;
+			float    Range;      // FalloffEnd.
+			XMFLOAT3 Direction;  // Spot light only.
+			float    SpotPower;  // Spot light only.
+			uint32   LightIndex; // Stored in the index list.
+			bool     bSpotLight;
+		};
+
+		///<summary>
+		/// Offset into the light index list, followed by PointCount point lights and then SpotCount spot lights.
+		/// Matches the uint2 of gLightClusters, Counts = PointCount | SpotCount << 16.
+		///</summary>
+		struct LightCluster
+		{
+			uint32 Offset;
+			uint32 Counts;
+
+			uint32 GetPointCount() const { return Counts & 0xffff; }
+			uint32 GetSpotCount() const { return Counts >> 16; }
+		};
+
+		///<summary>
+		/// Bins point and spot lights into view space clusters (froxels): NumClustersX x NumClustersY screen tiles
+		/// times NumClustersZ exponential depth slices between the camera near and far planes.
+		/// Lights are tested against 4 clusters per instruction (sphere vs box, and cone vs the bounding sphere of the box
+		/// for spot lights), the depth slices are built in parallel. The scalar instruction set is a brute force reference
+		/// that tests every light against every cluster and gives the same output.
+		///</summary>
+		class LightClusterBuilder
+		{
+		public:
+
+			static const uint32 NumClustersX = 16;
+			static const uint32 NumClustersY = 9;
+			static const uint32 NumClustersZ = 24;
+			static const uint32 NumClustersPerSlice = NumClustersX * NumClustersY;
+			static const uint32 NumClusters = NumClustersPerSlice * NumClustersZ;
+
+			// Spot cones end where pow(cos, SpotPower) falls below this.
+			static constexpr float SpotCutoff = 1.0f / 256.0f;
+
+			LightClusterBuilder();
+
+			///<summary>
+			/// Rebuilds the view space cluster bounds when the projection changed. Works for perspective and
+			/// orthographic projections, the slices are exponential in view depth either way.
+			///</summary>
+			void SetProjection(const XMFLOAT4X4& InProj, float InNearZ, float InFarZ);
+
+			///<summary>
+			/// Bins InLights into the clusters, returns the size of the light index list.
+			/// InGlobalLights (directional lights) are stored once at the start of the index list.
+			///</summary>
+			uint32 Build(const XMFLOAT4X4& InView, const std::vector<ClusterLight>& InLights, const std::vector<uint32>& InGlobalLights,
+				ECullInstructionSet InInstructionSet = FrustumCuller::GetBestInstructionSet());
+
+			const std::vector<LightCluster>& GetClusters() const { return m_clusters; }
+			const std::vector<uint32>&       GetLightIndices() const { return m_lightIndices; }
+
+			// Slice of a view depth z is floor(log2(z) * Scale + Bias).
+			float  GetSliceScale() const { return m_sliceScale; }
+			float  GetSliceBias() const { return m_sliceBias; }
+
+			uint32 GetMaxLightsPerCluster() const { return m_maxLightsPerCluster; }
+
+		private:
+
+			// View space bounds of the clusters of one slice, in blocks of 4.
+			struct SliceBounds
+			{
+				float MinX[NumClustersPerSlice], MinY[NumClustersPerSlice], MinZ[NumClustersPerSlice];
+				float MaxX[NumClustersPerSlice], MaxY[NumClustersPerSlice], MaxZ[NumClustersPerSlice];
+
+				// Bounding spheres of the boxes, for the cone test.
+				float CenterX[NumClustersPerSlice], CenterY[NumClustersPerSlice], CenterZ[NumClustersPerSlice];
+				float Radius[NumClustersPerSlice];
+			};
+
+			// View space light, the cone is precomputed from SpotPower.
+			struct ViewLight
+			{
+				float  X, Y, Z, Range;
+				float  DirX, DirY, DirZ;
+				float  CosAngle, SinAngle;
+				uint32 LightIndex;
+				bool   bSpotLight;
+			};
+
+			// Buffers of BuildSliceSSE, one per range of slices.
+			struct SliceScratch
+			{
+				std::vector<uint32> Candidates; // Lights reaching the slice depth range.
+				std::vector<uint32> Bits;       // One bit per candidate in every cluster.
+			};
+
+			static bool TestLightScalar(const ViewLight& InLight, const SliceBounds& InSlice, uint32 InCluster);
+
+			void BuildSliceScalar(uint32 InSlice, std::vector<uint32>& OutIndices);
+			void BuildSliceSSE(uint32 InSlice, std::vector<uint32>& OutIndices, SliceScratch& InOutScratch);
+
+			XMFLOAT4X4                       m_proj;
+			float                            m_nearZ;
+			float                            m_farZ;
+			float                            m_sliceScale;
+			float                            m_sliceBias;
+
+			std::vector<SliceBounds>         m_slices;
+			std::vector<float>               m_sliceDepths; // NumClustersZ + 1 slice boundaries.
+
+			std::vector<ViewLight>           m_viewLights;  // Point lights first.
+			uint32                           m_numPointLights;
+
+			std::vector<std::vector<uint32>> m_sliceIndices;
+			std::vector<LightCluster>        m_clusters;
+			std::vector<uint32>              m_lightIndices;
+			uint32                           m_maxLightsPerCluster;
+		};
+	}
+}
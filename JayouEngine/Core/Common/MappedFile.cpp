@@ -0,0 +1,85 @@
+//
+// MappedFile.cpp
+//
+
+#include "MappedFile.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace Utility;
+
+bool MappedFile::Open(const std::string& InPath)
+{
+	Close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(InPath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize = {};
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	// The view keeps the mapping and the file alive, both handles can go right away.
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	CloseHandle(file);
+	if (mapping == nullptr)
+		return false;
+
+	void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+	if (data == nullptr)
+		return false;
+
+	const uint64 size = (uint64)fileSize.QuadPart;
+#else
+	const int file = open(InPath.c_str(), O_RDONLY);
+	if (file < 0)
+		return false;
+
+	struct stat info = {};
+	if (fstat(file, &info) != 0 || info.st_size == 0)
+	{
+		close(file);
+		return false;
+	}
+
+	const uint64 size = (uint64)info.st_size;
+
+	// The mapping keeps the file alive, the descriptor can go right away.
+	void* data = mmap(nullptr, (size_t)size, PROT_READ, MAP_PRIVATE, file, 0);
+	close(file);
+	if (data == MAP_FAILED)
+		return false;
+
+	madvise(data, (size_t)size, MADV_WILLNEED);
+#endif
+
+	m_data = static_cast<const uint8*>(data);
+	m_size = size;
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (m_data == nullptr)
+		return;
+
+#ifdef _WIN32
+	UnmapViewOfFile(m_data);
+#else
+	munmap(const_cast<uint8*>(m_data), (size_t)m_size);
+#endif
+
+	m_data = nullptr;
+	m_size = 0;
+}
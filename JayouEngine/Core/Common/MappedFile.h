@@ -0,0 +1,38 @@
+//
+// MappedFile.h
+//
+
+#pragma once
+
+#include "TypeDef.h"
+
+namespace Utility
+{
+	///<summary>
+	/// Read only mapping of a whole file. Pages are read in by the OS on first touch, nothing is copied up front.
+	/// Empty files can not be mapped, Open fails on them.
+	///</summary>
+	class MappedFile
+	{
+	public:
+
+		MappedFile() = default;
+		~MappedFile() { Close(); }
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		bool Open(const std::string& InPath);
+
+		void Close();
+
+		bool         IsOpen() const { return m_data != nullptr; }
+		const uint8* GetData() const { return m_data; }
+		uint64       GetSize() const { return m_size; }
+
+	private:
+
+		const uint8* m_data = nullptr;
+		uint64       m_size = 0;
+	};
+}
@@ -0,0 +1,419 @@
+//
+// MeshCache.cpp
+//
+
+#include "MeshCache.h"
+#include "VirtualFileSystem.h"
+#include "ThreadManager.h"
+
+#include <cstdio>
+#include <fstream>
+#include <type_traits>
+
+using namespace Core;
+using namespace Utility;
+
+const uint32 MeshCache::Magic;
+const uint32 MeshCache::Version;
+
+namespace
+{
+	const uint64 kAlignment = 16;
+
+	// Count elements at Offset from the start of the file.
+	struct Range
+	{
+		uint64 Offset;
+		uint64 Count;
+	};
+
+	struct FileHeader
+	{
+		uint32       Magic;
+		uint32       Version;
+		MeshCacheKey Key;
+		uint32       VertexSize;
+		uint32       MeshletSize;
+		uint32       BVHNodeSize;
+		uint32       Padding;
+		Range        Geometries; // GeometryRecord
+		Range        Nodes;      // NodeRecord
+	};
+
+	struct GeometryRecord
+	{
+		Range    Name;           // char, not terminated.
+		Range    Vertices;       // Vertex
+		Range    Indices;        // uint32
+		Range    LODs;           // LODRecord
+		Range    Meshlets;       // Meshlet
+		Range    BVHNodes;       // TriangleBVH::Node
+		Range    BVHPositions;   // XMFLOAT3
+		Range    BVHTriangles;   // uint32
+		Range    BVHTriangleIds; // uint32
+		XMFLOAT3 Origin;
+		XMFLOAT3 BoxExtent;
+		float    SphereRadius;
+		uint32   Padding;
+	};
+
+	struct LODRecord
+	{
+		Range  Indices; // uint32
+		float  Error;
+		uint32 Padding;
+	};
+
+	struct NodeRecord
+	{
+		Range       Name;       // char, not terminated.
+		Range       Geometries; // uint32, index of the GeometryRecord.
+		int32       Parent;
+		XMFLOAT4X4  LocalTransform;
+		uint32      Padding;
+	};
+
+	// Where the arrays of a cache go, one after the other and each aligned. Nothing is copied, the arrays
+	// have to stay put until Write.
+	class FileLayout
+	{
+	public:
+
+		template<typename T>
+		Range Add(const T* InData, size_t InCount)
+		{
+			static_assert(std::is_trivially_copyable<T>::value, "Written as it is in memory");
+
+			Range range = { 0, (uint64)InCount };
+			if (InCount == 0)
+				return range;
+
+			m_size = (m_size + kAlignment - 1) & ~(kAlignment - 1);
+			range.Offset = m_size;
+
+			m_blocks.push_back({ m_size, InData, (uint64)(InCount * sizeof(T)) });
+			m_size += InCount * sizeof(T);
+			return range;
+		}
+
+		template<typename T>
+		Range Add(const std::vector<T>& InArray)
+		{
+			return Add(InArray.data(), InArray.size());
+		}
+
+		bool Write(std::ofstream& InOutFile) const
+		{
+			const char zeros[kAlignment] = {};
+
+			uint64 offset = 0;
+			for (const auto& block : m_blocks)
+			{
+				InOutFile.write(zeros, (std::streamsize)(block.Offset - offset));
+				InOutFile.write(static_cast<const char*>(block.Data), (std::streamsize)block.Size);
+				offset = block.Offset + block.Size;
+			}
+			return InOutFile.good();
+		}
+
+	private:
+
+		struct Block
+		{
+			uint64      Offset;
+			const void* Data;
+			uint64      Size;
+		};
+
+		std::vector<Block> m_blocks;
+		uint64             m_size = 0;
+	};
+
+	// Range checked pointer into the file, nullptr for an empty range.
+	template<typename T>
+	bool GetArray(const VFSFile& InFile, const Range& InRange, const T*& OutData)
+	{
+		OutData = nullptr;
+		if (InRange.Count == 0)
+			return true;
+
+		if (InRange.Offset % alignof(T) != 0 || InRange.Offset > InFile.GetSize() ||
+			InRange.Count > (InFile.GetSize() - InRange.Offset) / sizeof(T))
+			return false;
+
+		OutData = reinterpret_cast<const T*>(InFile.GetData() + InRange.Offset);
+		return true;
+	}
+
+	// One copy of the whole array straight out of the file.
+	template<typename T>
+	bool CopyArray(const VFSFile& InFile, const Range& InRange, std::vector<T>& OutArray)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "Read as it is in the file");
+
+		const T* data = nullptr;
+		if (!GetArray(InFile, InRange, data))
+			return false;
+
+		OutArray.assign(data, data + InRange.Count);
+		return true;
+	}
+
+	bool GetString(const VFSFile& InFile, const Range& InRange, std::string& OutString)
+	{
+		const char* chars = nullptr;
+		if (!GetArray(InFile, InRange, chars))
+			return false;
+
+		OutString.assign(chars, (size_t)InRange.Count);
+		return true;
+	}
+
+	bool operator==(const MeshCacheKey& a, const MeshCacheKey& b)
+	{
+		return a.SourceHash == b.SourceHash && a.SourceSize == b.SourceSize && a.PPSFlags == b.PPSFlags && a.ImportFlags == b.ImportFlags;
+	}
+}
+
+std::string MeshCache::GetCachePath(const std::string& InSourcePath)
+{
+	return InSourcePath + ".jmesh";
+}
+
+bool MeshCache::ComputeKey(const ImportGeoDesc& InGeoDesc, MeshCacheKey& OutKey)
+{
+	uint64 sourceHash = 0;
+	uint64 sourceSize = 0;
+	if (!HashFile(InGeoDesc.PathName, sourceHash, sourceSize))
+		return false;
+
+	OutKey = MakeKey(InGeoDesc, sourceHash, sourceSize);
+	return true;
+}
+
+MeshCacheKey MeshCache::MakeKey(const ImportGeoDesc& InGeoDesc, uint64 InSourceHash, uint64 InSourceSize)
+{
+	MeshCacheKey key;
+	key.SourceHash = InSourceHash;
+	key.SourceSize = InSourceSize;
+	key.PPSFlags = InGeoDesc.PPSFlags;
+	key.ImportFlags = (InGeoDesc.bOptimizeMesh ? 1u : 0u) | (InGeoDesc.bBuildMeshlets ? 2u : 0u) | (InGeoDesc.NumLODs << 8);
+	return key;
+}
+
+bool MeshCache::Save(const std::string& InPath, const MeshCacheKey& InKey,
+	const std::unordered_map<std::string, Geometry>& InGeometries,
+	const std::vector<ImportNode>& InNodes,
+	const std::unordered_map<std::string, TriangleBVH>& InBVHs)
+{
+	FileHeader header = {};
+	header.Magic = Magic;
+	header.Version = Version;
+	header.Key = InKey;
+	header.VertexSize = sizeof(Vertex);
+	header.MeshletSize = sizeof(Meshlet);
+	header.BVHNodeSize = sizeof(TriangleBVH::Node);
+
+	std::vector<const std::string*> names;
+	std::vector<const Geometry*> geos;
+	std::unordered_map<std::string, uint32> geoIndices;
+	for (const auto& pair : InGeometries)
+	{
+		geoIndices[pair.first] = (uint32)geos.size();
+		names.push_back(&pair.first);
+		geos.push_back(&pair.second);
+	}
+
+	// The records are laid out first and filled in along with the arrays they point at.
+	FileLayout layout;
+	layout.Add(&header, 1);
+
+	std::vector<GeometryRecord> geoRecords(geos.size());
+	std::vector<NodeRecord> nodeRecords(InNodes.size());
+	header.Geometries = layout.Add(geoRecords);
+	header.Nodes = layout.Add(nodeRecords);
+
+	std::vector<std::vector<LODRecord>> lodRecords(geos.size());
+	for (size_t i = 0; i < geos.size(); ++i)
+	{
+		const Geometry& geo = *geos[i];
+		GeometryRecord& record = geoRecords[i];
+
+		record.Name = layout.Add(names[i]->data(), names[i]->size());
+		record.Vertices = layout.Add(geo.Data.Vertices);
+		record.Indices = layout.Add(geo.Data.Indices32);
+
+		lodRecords[i].resize(geo.LODs.size());
+		record.LODs = layout.Add(lodRecords[i]);
+		for (size_t l = 0; l < geo.LODs.size(); ++l)
+		{
+			lodRecords[i][l].Indices = layout.Add(geo.LODs[l].Indices32);
+			lodRecords[i][l].Error = geo.LODs[l].Error;
+		}
+
+		record.Meshlets = layout.Add(geo.Meshlets);
+
+		auto bvh = InBVHs.find(*names[i]);
+		if (bvh != InBVHs.end())
+		{
+			record.BVHNodes = layout.Add(bvh->second.m_nodes);
+			record.BVHPositions = layout.Add(bvh->second.m_positions);
+			record.BVHTriangles = layout.Add(bvh->second.m_triangles);
+			record.BVHTriangleIds = layout.Add(bvh->second.m_triangleIds);
+		}
+
+		record.Origin = geo.Bounds.Origin;
+		record.BoxExtent = geo.Bounds.BoxExtent;
+		record.SphereRadius = geo.Bounds.SphereRadius;
+	}
+
+	std::vector<std::vector<uint32>> nodeGeometries(InNodes.size());
+	for (size_t i = 0; i < InNodes.size(); ++i)
+	{
+		const ImportNode& node = InNodes[i];
+		NodeRecord& record = nodeRecords[i];
+
+		for (const auto& geoName : node.Geometries)
+		{
+			auto index = geoIndices.find(geoName);
+			if (index == geoIndices.end())
+				return false;
+			nodeGeometries[i].push_back(index->second);
+		}
+
+		record.Name = layout.Add(node.Name.data(), node.Name.size());
+		record.Geometries = layout.Add(nodeGeometries[i]);
+		record.Parent = node.Parent;
+		XMStoreFloat4x4(&record.LocalTransform, node.LocalTransform);
+	}
+
+	// Only ever renamed over the old cache once complete.
+	const std::string tempPath = InPath + ".tmp";
+	std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+	bool bSucceeded = file.is_open() && layout.Write(file);
+	file.close();
+	bSucceeded = bSucceeded && !file.fail();
+
+	if (bSucceeded)
+	{
+		std::remove(InPath.c_str());
+		bSucceeded = std::rename(tempPath.c_str(), InPath.c_str()) == 0;
+	}
+	if (!bSucceeded)
+	{
+		std::remove(tempPath.c_str());
+	}
+	return bSucceeded;
+}
+
+bool MeshCache::Load(const std::string& InPath, const MeshCacheKey& InKey,
+	std::unordered_map<std::string, Geometry>& OutGeometries,
+	std::vector<ImportNode>& OutNodes,
+	std::unordered_map<std::string, TriangleBVH>& OutBVHs)
+{
+	VFSFile file;
+	if (!VirtualFileSystem::Get().ReadFile(InPath, file))
+		return false;
+
+	const FileHeader* header = nullptr;
+	if (!GetArray(file, { 0, 1 }, header) || header == nullptr)
+		return false;
+
+	if (header->Magic != Magic || header->Version != Version || !(header->Key == InKey) ||
+		header->VertexSize != sizeof(Vertex) || header->MeshletSize != sizeof(Meshlet) || header->BVHNodeSize != sizeof(TriangleBVH::Node))
+		return false;
+
+	const GeometryRecord* geoRecords = nullptr;
+	const NodeRecord* nodeRecords = nullptr;
+	if (!GetArray(file, header->Geometries, geoRecords) || !GetArray(file, header->Nodes, nodeRecords))
+		return false;
+
+	const uint32 numGeos = (uint32)header->Geometries.Count;
+	std::vector<std::string> names(numGeos);
+	for (uint32 i = 0; i < numGeos; ++i)
+	{
+		if (!GetString(file, geoRecords[i].Name, names[i]))
+			return false;
+	}
+
+	std::vector<ImportNode> nodes(header->Nodes.Count);
+	for (size_t i = 0; i < nodes.size(); ++i)
+	{
+		const NodeRecord& record = nodeRecords[i];
+		ImportNode& node = nodes[i];
+
+		const uint32* geoIndices = nullptr;
+		if (!GetString(file, record.Name, node.Name) || !GetArray(file, record.Geometries, geoIndices))
+			return false;
+
+		// Parents come first.
+		if (record.Parent >= (int32)i)
+			return false;
+
+		node.Parent = record.Parent;
+		// Row by row, Matrix4 declares a copy constructor but no copy assignment.
+		const XMMATRIX localTransform = XMLoadFloat4x4(&record.LocalTransform);
+		node.LocalTransform.SetX(Vector4(localTransform.r[0]));
+		node.LocalTransform.SetY(Vector4(localTransform.r[1]));
+		node.LocalTransform.SetZ(Vector4(localTransform.r[2]));
+		node.LocalTransform.SetW(Vector4(localTransform.r[3]));
+		for (uint64 g = 0; g < record.Geometries.Count; ++g)
+		{
+			if (geoIndices[g] >= numGeos)
+				return false;
+			node.Geometries.push_back(names[geoIndices[g]]);
+		}
+	}
+
+	// The big arrays, a geometry per range.
+	std::vector<Geometry> geos(numGeos);
+	std::vector<TriangleBVH> bvhs(numGeos);
+	std::atomic<bool> bDamaged(false);
+
+	ThreadManager::JobSystem::Get().ParallelFor(numGeos, 1, [&](uint32 InBegin, uint32 InEnd)
+	{
+		for (uint32 i = InBegin; i < InEnd; ++i)
+		{
+			const GeometryRecord& record = geoRecords[i];
+			Geometry& geo = geos[i];
+			TriangleBVH& bvh = bvhs[i];
+
+			const LODRecord* lodRecords = nullptr;
+			bool bIsValid =
+				CopyArray(file, record.Vertices, geo.Data.Vertices) &&
+				CopyArray(file, record.Indices, geo.Data.Indices32) &&
+				CopyArray(file, record.Meshlets, geo.Meshlets) &&
+				CopyArray(file, record.BVHNodes, bvh.m_nodes) &&
+				CopyArray(file, record.BVHPositions, bvh.m_positions) &&
+				CopyArray(file, record.BVHTriangles, bvh.m_triangles) &&
+				CopyArray(file, record.BVHTriangleIds, bvh.m_triangleIds) &&
+				GetArray(file, record.LODs, lodRecords);
+
+			geo.LODs.resize(bIsValid ? (size_t)record.LODs.Count : 0);
+			for (size_t l = 0; l < geo.LODs.size() && bIsValid; ++l)
+			{
+				bIsValid = CopyArray(file, lodRecords[l].Indices, geo.LODs[l].Indices32);
+				geo.LODs[l].Error = lodRecords[l].Error;
+			}
+
+			geo.Bounds = BoxSphereBounds(record.Origin, record.BoxExtent, record.SphereRadius);
+
+			if (!bIsValid)
+			{
+				bDamaged = true;
+			}
+		}
+	});
+
+	if (bDamaged)
+		return false;
+
+	for (uint32 i = 0; i < numGeos; ++i)
+	{
+		geos[i].Name = names[i];
+		OutGeometries[names[i]] = std::move(geos[i]);
+		OutBVHs[names[i]] = std::move(bvhs[i]);
+	}
+	OutNodes = std::move(nodes);
+	return true;
+}
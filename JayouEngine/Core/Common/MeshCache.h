@@ -0,0 +1,61 @@
+//
+// MeshCache.h
+//
+
+#pragma once
+
+#include "Interface/IGeoImporter.h"
+#include "TriangleBVH.h"
+
+namespace Core
+{
+	// What a cached import was made from. A cache whose key differs is stale.
+	struct MeshCacheKey
+	{
+		uint64 SourceHash = 0;
+		uint64 SourceSize = 0;
+		uint32 PPSFlags = 0;
+		uint32 ImportFlags = 0; // bOptimizeMesh, bBuildMeshlets and NumLODs, they change what gets imported.
+	};
+
+	///<summary>
+	/// .jmesh, the result of an import as it is in memory: geometries with their LODs, meshlets and picking BVH, and the
+	/// node tree. Written next to the source file. Fixed size records point at 16 byte aligned arrays, so a load maps
+	/// the file, checks the header and the ranges and copies every array in one go, nothing is parsed.
+	/// The layout is that of the structs in GeometryManager.h and TriangleBVH.h, bump Version when they change.
+	///</summary>
+	class MeshCache
+	{
+	public:
+
+		static const uint32 Magic = 0x48534d4a; // "JMSH"
+		static const uint32 Version = 2; // 2: MeshLOD::Error is a bound, no longer a mean.
+
+		static std::string GetCachePath(const std::string& InSourcePath);
+
+		///<summary>
+		/// Hashes the source file of InGeoDesc, false if it can not be read.
+		///</summary>
+		static bool ComputeKey(const ImportGeoDesc& InGeoDesc, MeshCacheKey& OutKey);
+
+		// The key of a source already hashed.
+		static MeshCacheKey MakeKey(const ImportGeoDesc& InGeoDesc, uint64 InSourceHash, uint64 InSourceSize);
+
+		///<summary>
+		/// InBVHs by geometry name, as InGeometries. Written to a temporary file first, a failed save leaves no cache behind.
+		///</summary>
+		static bool Save(const std::string& InPath, const MeshCacheKey& InKey,
+			const std::unordered_map<std::string, Geometry>& InGeometries,
+			const std::vector<ImportNode>& InNodes,
+			const std::unordered_map<std::string, TriangleBVH>& InBVHs);
+
+		///<summary>
+		/// False if there is no cache at InPath, it is stale or it is damaged. The outputs are only touched on success.
+		/// PathName of the geometries is left to the caller.
+		///</summary>
+		static bool Load(const std::string& InPath, const MeshCacheKey& InKey,
+			std::unordered_map<std::string, Geometry>& OutGeometries,
+			std::vector<ImportNode>& OutNodes,
+			std::unordered_map<std::string, TriangleBVH>& OutBVHs);
+	};
+}
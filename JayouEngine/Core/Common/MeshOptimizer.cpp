@@ -0,0 +1,254 @@
+//
+// MeshOptimizer.cpp
+//
+
+#include "MeshOptimizer.h"
+
+using namespace Utility;
+using namespace Utility::GeometryManager;
+
+namespace
+{
+	// Forsyth scoring parameters, the LRU cache model is larger than the FIFO we analyze against on purpose.
+	const uint32 kCacheSize = 32;
+	const float  kCacheDecayPower = 1.5f;
+	const float  kLastTriScore = 0.75f;
+	const float  kValenceBoostScale = 2.0f;
+	const float  kValenceBoostPower = 0.5f;
+	const uint32 kMaxValence = 64;
+
+	float CacheScoreTable[kCacheSize];
+	float ValenceScoreTable[kMaxValence + 1];
+
+	void FillScoreTables()
+	{
+		for (uint32 i = 0; i < kCacheSize; ++i)
+		{
+			if (i < 3)
+			{
+				// The vertices of the last triangle get a fixed score, so we don't favor one of them.
+				CacheScoreTable[i] = kLastTriScore;
+			}
+			else
+			{
+				const float scaler = 1.0f / (kCacheSize - 3);
+				CacheScoreTable[i] = powf(1.0f - (i - 3) * scaler, kCacheDecayPower);
+			}
+		}
+
+		ValenceScoreTable[0] = 0.0f;
+		for (uint32 i = 1; i <= kMaxValence; ++i)
+		{
+			// Bonus points for having a low number of triangles left, so lone vertices get finished first.
+			ValenceScoreTable[i] = kValenceBoostScale * powf((float)i, -kValenceBoostPower);
+		}
+	}
+
+	// Meshes are optimized on several threads at once, a local static is initialized exactly once.
+	void InitScoreTables()
+	{
+		static const bool bHasBeInit = (FillScoreTables(), true);
+		(void)bHasBeInit;
+	}
+
+	float VertexScore(int32 cachePosition, uint32 numLiveTris)
+	{
+		if (numLiveTris == 0)
+		{
+			// No triangles left, never pick it.
+			return -1.0f;
+		}
+
+		float score = cachePosition >= 0 ? CacheScoreTable[cachePosition] : 0.0f;
+		score += ValenceScoreTable[Math::Min(numLiveTris, kMaxValence)];
+		return score;
+	}
+}
+
+VertexCacheStats MeshOptimizer::AnalyzeVertexCache(const std::vector<uint32>& indices, uint32 numVertices, uint32 cacheSize)
+{
+	VertexCacheStats stats;
+
+	if (indices.empty() || numVertices == 0)
+		return stats;
+
+	// Timestamp FIFO, a vertex is a hit if it was inserted less than cacheSize insertions ago.
+	std::vector<uint32> cacheTimestamps(numVertices, 0);
+	uint32 timestamp = cacheSize + 1;
+
+	for (auto index : indices)
+	{
+		if (timestamp - cacheTimestamps[index] > cacheSize)
+		{
+			cacheTimestamps[index] = timestamp++;
+			stats.NumTransformed++;
+		}
+	}
+
+	stats.ACMR = (float)stats.NumTransformed / (indices.size() / 3);
+	stats.ATVR = (float)stats.NumTransformed / numVertices;
+
+	return stats;
+}
+
+void MeshOptimizer::OptimizeVertexCache(std::vector<uint32>& indices, uint32 numVertices)
+{
+	const uint32 numTriangles = (uint32)indices.size() / 3;
+
+	if (numTriangles == 0 || numVertices == 0)
+		return;
+
+	InitScoreTables();
+
+	// Vertex -> triangle adjacency (CSR layout).
+	std::vector<uint32> numLiveTris(numVertices, 0);
+	for (auto index : indices)
+	{
+		numLiveTris[index]++;
+	}
+
+	std::vector<uint32> adjacencyOffsets(numVertices + 1, 0);
+	for (uint32 i = 0; i < numVertices; ++i)
+	{
+		adjacencyOffsets[i + 1] = adjacencyOffsets[i] + numLiveTris[i];
+	}
+
+	std::vector<uint32> adjacency(indices.size());
+	{
+		std::vector<uint32> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (uint32 i = 0; i < numTriangles; ++i)
+		{
+			adjacency[fill[indices[i * 3 + 0]]++] = i;
+			adjacency[fill[indices[i * 3 + 1]]++] = i;
+			adjacency[fill[indices[i * 3 + 2]]++] = i;
+		}
+	}
+
+	std::vector<int32> cachePositions(numVertices, -1);
+	std::vector<float> vertexScores(numVertices);
+	for (uint32 i = 0; i < numVertices; ++i)
+	{
+		vertexScores[i] = VertexScore(-1, numLiveTris[i]);
+	}
+
+	std::vector<float> triangleScores(numTriangles);
+	std::vector<bool>  triangleEmitted(numTriangles, false);
+	for (uint32 i = 0; i < numTriangles; ++i)
+	{
+		triangleScores[i] =
+			vertexScores[indices[i * 3 + 0]] +
+			vertexScores[indices[i * 3 + 1]] +
+			vertexScores[indices[i * 3 + 2]];
+	}
+
+	// LRU cache, +3 for the vertices of the triangle being pushed.
+	uint32 cache[kCacheSize + 3];
+	uint32 cacheCount = 0;
+
+	std::vector<uint32> result;
+	result.reserve(indices.size());
+
+	uint32 scanCursor = 0;
+	int32  bestTriangle = -1;
+
+	for (uint32 emitted = 0; emitted < numTriangles; ++emitted)
+	{
+		if (bestTriangle < 0)
+		{
+			// Cache ran dry, restart from the next triangle in input order (keeps the pass linear).
+			while (triangleEmitted[scanCursor])
+				scanCursor++;
+			bestTriangle = scanCursor;
+		}
+
+		const uint32 tri = (uint32)bestTriangle;
+		triangleEmitted[tri] = true;
+
+		uint32 newCache[kCacheSize + 3];
+		uint32 newCacheCount = 0;
+
+		for (uint32 k = 0; k < 3; ++k)
+		{
+			uint32 v = indices[tri * 3 + k];
+			result.push_back(v);
+			newCache[newCacheCount++] = v;
+
+			// Remove the triangle from the live adjacency of this vertex.
+			uint32 begin = adjacencyOffsets[v];
+			uint32 end = begin + numLiveTris[v];
+			for (uint32 a = begin; a < end; ++a)
+			{
+				if (adjacency[a] == tri)
+				{
+					std::swap(adjacency[a], adjacency[end - 1]);
+					break;
+				}
+			}
+			numLiveTris[v]--;
+		}
+
+		// Append the old cache entries that are not part of the new triangle.
+		for (uint32 i = 0; i < cacheCount; ++i)
+		{
+			uint32 v = cache[i];
+			if (v != newCache[0] && v != newCache[1] && v != newCache[2])
+				newCache[newCacheCount++] = v;
+		}
+
+		// Update scores of everything that was or is in the cache.
+		for (uint32 i = 0; i < newCacheCount; ++i)
+		{
+			uint32 v = newCache[i];
+			cachePositions[v] = i < kCacheSize ? (int32)i : -1;
+
+			float newScore = VertexScore(cachePositions[v], numLiveTris[v]);
+			float delta = newScore - vertexScores[v];
+			vertexScores[v] = newScore;
+
+			uint32 begin = adjacencyOffsets[v];
+			uint32 end = begin + numLiveTris[v];
+			for (uint32 a = begin; a < end; ++a)
+			{
+				triangleScores[adjacency[a]] += delta;
+			}
+		}
+
+		cacheCount = Math::Min(newCacheCount, kCacheSize);
+		std::copy(newCache, newCache + cacheCount, cache);
+
+		// Best candidate is always adjacent to a cached vertex.
+		bestTriangle = -1;
+		float bestScore = -1.0f;
+		for (uint32 i = 0; i < cacheCount; ++i)
+		{
+			uint32 v = cache[i];
+			uint32 begin = adjacencyOffsets[v];
+			uint32 end = begin + numLiveTris[v];
+			for (uint32 a = begin; a < end; ++a)
+			{
+				uint32 t = adjacency[a];
+				if (triangleScores[t] > bestScore)
+				{
+					bestScore = triangleScores[t];
+					bestTriangle = (int32)t;
+				}
+			}
+		}
+	}
+
+	indices.swap(result);
+}
+
+uint32 MeshOptimizer::BuildVertexFetchRemap(const std::vector<uint32>& indices, uint32 numVertices, std::vector<uint32>& OutRemap)
+{
+	OutRemap.assign(numVertices, ~0u);
+
+	uint32 next = 0;
+	for (auto index : indices)
+	{
+		if (OutRemap[index] == ~0u)
+			OutRemap[index] = next++;
+	}
+
+	return next;
+}
@@ -0,0 +1,106 @@
+//
+// MeshOptimizer.h
+//
+
+#pragma once
+
+#include "GeometryManager.h"
+
+namespace Utility
+{
+	namespace GeometryManager
+	{
+		// Post-transform vertex cache statistics of an indexed triangle list.
+		// ACMR: Average Cache Miss Ratio, transformed vertices per triangle (0.5 ~ 3.0, lower is better).
+		// ATVR: Average Transformed Vertex Ratio, transformed vertices per vertex (1.0 is optimal).
+		struct VertexCacheStats
+		{
+			uint32 NumTransformed = 0;
+			float  ACMR = 0.0f;
+			float  ATVR = 0.0f;
+		};
+
+		struct MeshOptimizeStats
+		{
+			uint32           NumVertices = 0;
+			uint32           NumTriangles = 0;
+
+			VertexCacheStats Before;
+			VertexCacheStats After;
+		};
+
+		class MeshOptimizer
+		{
+		public:
+
+			// Simulated FIFO cache size, close to what most GPUs expose for post-transform reuse.
+			static const uint32 DefaultCacheSize = 16;
+
+			///<summary>
+			/// Simulates a FIFO post-transform cache over the index buffer and reports ACMR/ATVR.
+			///</summary>
+			static VertexCacheStats AnalyzeVertexCache(const std::vector<uint32>& indices, uint32 numVertices, uint32 cacheSize = DefaultCacheSize);
+
+			///<summary>
+			/// Reorders triangles for post-transform cache locality (Tom Forsyth, "Linear-Speed Vertex Cache Optimisation").
+			/// Vertex data is untouched, only the triangle order changes.
+			///</summary>
+			static void OptimizeVertexCache(std::vector<uint32>& indices, uint32 numVertices);
+
+			///<summary>
+			/// Builds a remap table that puts vertices into first-use order of the index buffer.
+			/// Unreferenced vertices map to ~0u. Returns the number of referenced vertices.
+			///</summary>
+			static uint32 BuildVertexFetchRemap(const std::vector<uint32>& indices, uint32 numVertices, std::vector<uint32>& OutRemap);
+
+			///<summary>
+			/// Remaps vertices into first-use order so vertex fetch walks memory linearly.
+			/// Unreferenced vertices are dropped.
+			///</summary>
+			template<typename TVertex>
+			static void OptimizeVertexFetch(GeometryData<TVertex>& meshData);
+
+			///<summary>
+			/// Full pass: vertex cache then vertex fetch, returns the cache statistics before and after.
+			///</summary>
+			template<typename TVertex>
+			static MeshOptimizeStats Optimize(GeometryData<TVertex>& meshData);
+		};
+
+		template<typename TVertex>
+		void MeshOptimizer::OptimizeVertexFetch(GeometryData<TVertex>& meshData)
+		{
+			std::vector<uint32> remap;
+			uint32 numUnique = BuildVertexFetchRemap(meshData.Indices32, (uint32)meshData.Vertices.size(), remap);
+
+			std::vector<TVertex> vertices(numUnique);
+			for (size_t i = 0; i < remap.size(); ++i)
+			{
+				if (remap[i] != ~0u)
+					vertices[remap[i]] = meshData.Vertices[i];
+			}
+
+			for (auto& index : meshData.Indices32)
+			{
+				index = remap[index];
+			}
+
+			meshData.Vertices.swap(vertices);
+		}
+
+		template<typename TVertex>
+		MeshOptimizeStats MeshOptimizer::Optimize(GeometryData<TVertex>& meshData)
+		{
+			MeshOptimizeStats stats;
+			stats.NumVertices = (uint32)meshData.Vertices.size();
+			stats.NumTriangles = (uint32)meshData.Indices32.size() / 3;
+			stats.Before = AnalyzeVertexCache(meshData.Indices32, stats.NumVertices);
+
+			OptimizeVertexCache(meshData.Indices32, stats.NumVertices);
+			OptimizeVertexFetch(meshData);
+
+			stats.After = AnalyzeVertexCache(meshData.Indices32, (uint32)meshData.Vertices.size());
+			return stats;
+		}
+	}
+}
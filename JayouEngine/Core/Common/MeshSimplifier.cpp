@@ -0,0 +1,584 @@
+//
+// MeshSimplifier.cpp
+//
+
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+#include "ThreadManager.h"
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+
+using namespace Utility;
+using namespace Utility::GeometryManager;
+
+namespace
+{
+	// Symmetric 4x4 plane quadric, every plane weighted the same.
+	struct Quadric
+	{
+		double a2 = 0.0, b2 = 0.0, c2 = 0.0, d2 = 0.0;
+		double ab = 0.0, ac = 0.0, ad = 0.0;
+		double bc = 0.0, bd = 0.0, cd = 0.0;
+
+		void Add(const Quadric& q)
+		{
+			a2 += q.a2; b2 += q.b2; c2 += q.c2; d2 += q.d2;
+			ab += q.ab; ac += q.ac; ad += q.ad;
+			bc += q.bc; bd += q.bd; cd += q.cd;
+		}
+
+		// Sum of the squared distances of p to the accumulated planes, not less than the largest of them.
+		// Not divided by the area, a mean would hide a collapse that moves far off a small part of the surface.
+		double Error(const XMFLOAT3& p) const
+		{
+			const double x = p.x, y = p.y, z = p.z;
+
+			double r = 0.0;
+			r += x * (a2 * x + ab * y + ac * z + ad);
+			r += y * (ab * x + b2 * y + bc * z + bd);
+			r += z * (ac * x + bc * y + c2 * z + cd);
+			r += ad * x + bd * y + cd * z + d2;
+
+			return fabs(r);
+		}
+	};
+
+	Quadric TriangleQuadric(const XMFLOAT3& p0, const XMFLOAT3& p1, const XMFLOAT3& p2)
+	{
+		const double e0x = p1.x - p0.x, e0y = p1.y - p0.y, e0z = p1.z - p0.z;
+		const double e1x = p2.x - p0.x, e1y = p2.y - p0.y, e1z = p2.z - p0.z;
+
+		double nx = e0y * e1z - e0z * e1y;
+		double ny = e0z * e1x - e0x * e1z;
+		double nz = e0x * e1y - e0y * e1x;
+
+		Quadric q;
+
+		const double length = sqrt(nx * nx + ny * ny + nz * nz);
+		if (length <= 0.0)
+			return q;
+
+		nx /= length; ny /= length; nz /= length;
+		const double d = -(nx * p0.x + ny * p0.y + nz * p0.z);
+
+		q.a2 = nx * nx; q.b2 = ny * ny; q.c2 = nz * nz; q.d2 = d * d;
+		q.ab = nx * ny; q.ac = nx * nz; q.ad = nx * d;
+		q.bc = ny * nz; q.bd = ny * d; q.cd = nz * d;
+
+		return q;
+	}
+
+	XMFLOAT3 TriangleNormal(const XMFLOAT3& p0, const XMFLOAT3& p1, const XMFLOAT3& p2)
+	{
+		const float e0x = p1.x - p0.x, e0y = p1.y - p0.y, e0z = p1.z - p0.z;
+		const float e1x = p2.x - p0.x, e1y = p2.y - p0.y, e1z = p2.z - p0.z;
+
+		return XMFLOAT3(e0y * e1z - e0z * e1y, e0z * e1x - e0x * e1z, e0x * e1y - e0y * e1x);
+	}
+
+	enum EVertexKind : uint8
+	{
+		VK_Manifold,  // Single wedge, interior.
+		VK_Seam,      // Two attribute wedges sharing a position, interior.
+		VK_Locked     // Open border, more than two wedges or unreferenced.
+	};
+
+	struct Collapse
+	{
+		uint32 Source;
+		uint32 Target;
+		float  Error;
+
+		bool operator<(const Collapse& other) const
+		{
+			if (Error != other.Error)
+				return Error < other.Error;
+			if (Source != other.Source)
+				return Source < other.Source;
+			return Target < other.Target;
+		}
+	};
+
+	struct PositionHasher
+	{
+		size_t operator()(const XMFLOAT3& p) const
+		{
+			uint32 h[3];
+			memcpy(h, &p, sizeof(h));
+			return (size_t)(h[0] * 73856093u ^ h[1] * 19349663u ^ h[2] * 83492791u);
+		}
+	};
+
+	struct PositionEqual
+	{
+		bool operator()(const XMFLOAT3& a, const XMFLOAT3& b) const
+		{
+			return memcmp(&a, &b, sizeof(XMFLOAT3)) == 0;
+		}
+	};
+
+	// Simplification working set, everything indexed by the original vertex index.
+	class QuadricSimplifier
+	{
+	public:
+
+		QuadricSimplifier(const std::vector<XMFLOAT3>& positions, std::vector<uint32>& indices)
+			: m_positions(positions), m_indices(indices)
+		{
+			const uint32 numVertices = (uint32)positions.size();
+
+			// Vertices sharing a position are wedges of the same corner, linked in a ring.
+			m_posRemap.resize(numVertices);
+			m_wedge.resize(numVertices);
+
+			std::unordered_map<XMFLOAT3, uint32, PositionHasher, PositionEqual> firstVertex;
+			firstVertex.reserve(numVertices);
+
+			for (uint32 i = 0; i < numVertices; ++i)
+			{
+				auto it = firstVertex.emplace(positions[i], i).first;
+				uint32 r = it->second;
+
+				m_posRemap[i] = r;
+				m_wedge[i] = i;
+
+				if (r != i)
+				{
+					m_wedge[i] = m_wedge[r];
+					m_wedge[r] = i;
+				}
+			}
+
+			m_quadrics.resize(numVertices);
+			for (size_t i = 0; i + 2 < indices.size(); i += 3)
+			{
+				Quadric q = TriangleQuadric(positions[indices[i]], positions[indices[i + 1]], positions[indices[i + 2]]);
+				m_quadrics[m_posRemap[indices[i + 0]]].Add(q);
+				m_quadrics[m_posRemap[indices[i + 1]]].Add(q);
+				m_quadrics[m_posRemap[indices[i + 2]]].Add(q);
+			}
+		}
+
+		// One round of non overlapping collapses. Returns the number of collapses performed.
+		uint32 Pass(uint32 targetIndexCount, float targetError, float& InOutMaxError)
+		{
+			BuildAdjacency();
+			ClassifyVertices();
+
+			std::vector<Collapse> collapses;
+			PickCollapses(collapses);
+			std::sort(collapses.begin(), collapses.end());
+
+			const uint32 numTriangles = (uint32)m_indices.size() / 3;
+			const uint32 targetTriangles = targetIndexCount / 3;
+
+			// A manifold collapse removes two triangles, leave some room so the priorities get refreshed.
+			const uint32 maxCollapses = Math::Max((numTriangles - targetTriangles) / 2, 1u);
+
+			const uint32 numVertices = (uint32)m_positions.size();
+			m_remap.resize(numVertices);
+			for (uint32 i = 0; i < numVertices; ++i)
+			{
+				m_remap[i] = i;
+			}
+
+			std::vector<bool> collapseLocked(numVertices, false);
+			uint32 numCollapses = 0;
+
+			for (const auto& collapse : collapses)
+			{
+				if (numCollapses >= maxCollapses || collapse.Error > targetError)
+					break;
+
+				const uint32 rs = m_posRemap[collapse.Source];
+				const uint32 rt = m_posRemap[collapse.Target];
+
+				if (collapseLocked[rs] || collapseLocked[rt])
+					continue;
+
+				if (HasTriangleFlips(rs, rt, m_positions[collapse.Target]))
+					continue;
+
+				if (m_kinds[collapse.Source] == VK_Seam)
+				{
+					uint32 sourcePartner, targetPartner;
+					if (!FindSeamPartner(collapse.Source, collapse.Target, sourcePartner, targetPartner))
+						continue;
+
+					m_remap[sourcePartner] = targetPartner;
+				}
+
+				m_remap[collapse.Source] = collapse.Target;
+				m_quadrics[rt].Add(m_quadrics[rs]);
+
+				// Neighborhoods overlap after this, the next pass picks them up with fresh costs.
+				collapseLocked[rs] = true;
+				collapseLocked[rt] = true;
+
+				InOutMaxError = Math::Max(InOutMaxError, collapse.Error);
+				numCollapses++;
+			}
+
+			if (numCollapses > 0)
+				ApplyRemap();
+
+			return numCollapses;
+		}
+
+	private:
+
+		void BuildAdjacency()
+		{
+			const uint32 numVertices = (uint32)m_positions.size();
+
+			m_adjacencyOffsets.assign(numVertices + 1, 0);
+			for (auto index : m_indices)
+			{
+				m_adjacencyOffsets[index + 1]++;
+			}
+			for (uint32 i = 0; i < numVertices; ++i)
+			{
+				m_adjacencyOffsets[i + 1] += m_adjacencyOffsets[i];
+			}
+
+			m_adjacency.resize(m_indices.size());
+			std::vector<uint32> fill(m_adjacencyOffsets.begin(), m_adjacencyOffsets.end() - 1);
+			for (uint32 i = 0; i < (uint32)m_indices.size(); ++i)
+			{
+				m_adjacency[fill[m_indices[i]]++] = i / 3;
+			}
+		}
+
+		bool IsReferenced(uint32 v) const
+		{
+			return m_adjacencyOffsets[v + 1] > m_adjacencyOffsets[v];
+		}
+
+		void ClassifyVertices()
+		{
+			const uint32 numVertices = (uint32)m_positions.size();
+
+			// Directed edges in position space, an edge without its opposite is an open border.
+			std::unordered_set<uint64> edges;
+			edges.reserve(m_indices.size());
+
+			auto edgeKey = [](uint32 a, uint32 b) { return ((uint64)a << 32) | b; };
+
+			for (size_t i = 0; i < m_indices.size(); i += 3)
+			{
+				for (uint32 k = 0; k < 3; ++k)
+				{
+					uint32 a = m_posRemap[m_indices[i + k]];
+					uint32 b = m_posRemap[m_indices[i + (k + 1) % 3]];
+					edges.insert(edgeKey(a, b));
+				}
+			}
+
+			std::vector<bool> border(numVertices, false);
+			for (size_t i = 0; i < m_indices.size(); i += 3)
+			{
+				for (uint32 k = 0; k < 3; ++k)
+				{
+					uint32 a = m_posRemap[m_indices[i + k]];
+					uint32 b = m_posRemap[m_indices[i + (k + 1) % 3]];
+					if (edges.find(edgeKey(b, a)) == edges.end())
+					{
+						border[a] = true;
+						border[b] = true;
+					}
+				}
+			}
+
+			m_kinds.assign(numVertices, VK_Locked);
+			for (uint32 i = 0; i < numVertices; ++i)
+			{
+				if (!IsReferenced(i) || border[m_posRemap[i]])
+					continue;
+
+				uint32 numWedges = 0;
+				uint32 w = i;
+				do
+				{
+					numWedges += IsReferenced(w) ? 1 : 0;
+					w = m_wedge[w];
+				} while (w != i);
+
+				if (numWedges == 1)
+					m_kinds[i] = VK_Manifold;
+				else if (numWedges == 2)
+					m_kinds[i] = VK_Seam;
+			}
+		}
+
+		void PickCollapses(std::vector<Collapse>& OutCollapses)
+		{
+			OutCollapses.reserve(m_indices.size());
+
+			for (size_t i = 0; i < m_indices.size(); i += 3)
+			{
+				for (uint32 k = 0; k < 3; ++k)
+				{
+					uint32 a = m_indices[i + k];
+					uint32 b = m_indices[i + (k + 1) % 3];
+
+					if (m_posRemap[a] == m_posRemap[b])
+						continue;
+
+					// Both directions, the edge may only be seen from one triangle along a seam.
+					AddCollapse(a, b, OutCollapses);
+					AddCollapse(b, a, OutCollapses);
+				}
+			}
+
+			std::sort(OutCollapses.begin(), OutCollapses.end(), [](const Collapse& x, const Collapse& y)
+			{
+				return x.Source != y.Source ? x.Source < y.Source : x.Target < y.Target;
+			});
+			OutCollapses.erase(std::unique(OutCollapses.begin(), OutCollapses.end(), [](const Collapse& x, const Collapse& y)
+			{
+				return x.Source == y.Source && x.Target == y.Target;
+			}), OutCollapses.end());
+		}
+
+		void AddCollapse(uint32 source, uint32 target, std::vector<Collapse>& OutCollapses)
+		{
+			const uint8 sourceKind = m_kinds[source];
+
+			// Seams slide along themselves only, a manifold vertex can go anywhere.
+			if (sourceKind == VK_Locked)
+				return;
+			if (sourceKind == VK_Seam && m_kinds[target] != VK_Seam)
+				return;
+
+			Collapse collapse;
+			collapse.Source = source;
+			collapse.Target = target;
+			collapse.Error = (float)sqrt(m_quadrics[m_posRemap[source]].Error(m_positions[target]));
+
+			OutCollapses.push_back(collapse);
+		}
+
+		// Whether a and b share a triangle, in either winding.
+		bool HasEdge(uint32 a, uint32 b) const
+		{
+			for (uint32 j = m_adjacencyOffsets[a]; j < m_adjacencyOffsets[a + 1]; ++j)
+			{
+				const uint32 tri = m_adjacency[j];
+				for (uint32 k = 0; k < 3; ++k)
+				{
+					if (m_remap[m_indices[tri * 3 + k]] == b)
+						return true;
+				}
+			}
+			return false;
+		}
+
+		bool FindSeamPartner(uint32 source, uint32 target, uint32& OutSourcePartner, uint32& OutTargetPartner) const
+		{
+			OutSourcePartner = ~0u;
+			for (uint32 w = m_wedge[source]; w != source; w = m_wedge[w])
+			{
+				if (IsReferenced(w))
+					OutSourcePartner = w;
+			}
+
+			if (OutSourcePartner == ~0u)
+				return false;
+
+			// The other wedge of the source has to share an edge with the other wedge of the target,
+			// otherwise the two sides of the seam would tear.
+			for (uint32 w = m_wedge[target]; w != target; w = m_wedge[w])
+			{
+				if (IsReferenced(w) && m_remap[w] == w && HasEdge(OutSourcePartner, w))
+				{
+					OutTargetPartner = w;
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		bool HasTriangleFlips(uint32 rs, uint32 rt, const XMFLOAT3& targetPosition) const
+		{
+			uint32 w = rs;
+			do
+			{
+				for (uint32 j = m_adjacencyOffsets[w]; j < m_adjacencyOffsets[w + 1]; ++j)
+				{
+					const uint32 tri = m_adjacency[j];
+
+					XMFLOAT3 before[3];
+					XMFLOAT3 after[3];
+					bool bCollapses = false;
+
+					for (uint32 k = 0; k < 3; ++k)
+					{
+						const uint32 v = m_remap[m_indices[tri * 3 + k]];
+						const uint32 r = m_posRemap[v];
+
+						before[k] = m_positions[v];
+						after[k] = r == rs ? targetPosition : m_positions[v];
+						bCollapses |= r == rt;
+					}
+
+					// Triangles on the collapsing edge vanish.
+					if (bCollapses)
+						continue;
+
+					XMFLOAT3 n0 = TriangleNormal(before[0], before[1], before[2]);
+					XMFLOAT3 n1 = TriangleNormal(after[0], after[1], after[2]);
+
+					if (n0.x * n1.x + n0.y * n1.y + n0.z * n1.z <= 0.0f)
+						return true;
+				}
+
+				w = m_wedge[w];
+			} while (w != rs);
+
+			return false;
+		}
+
+		void ApplyRemap()
+		{
+			size_t write = 0;
+			for (size_t i = 0; i < m_indices.size(); i += 3)
+			{
+				const uint32 a = m_remap[m_indices[i + 0]];
+				const uint32 b = m_remap[m_indices[i + 1]];
+				const uint32 c = m_remap[m_indices[i + 2]];
+
+				const uint32 ra = m_posRemap[a];
+				const uint32 rb = m_posRemap[b];
+				const uint32 rc = m_posRemap[c];
+
+				if (ra == rb || rb == rc || ra == rc)
+					continue;
+
+				m_indices[write + 0] = a;
+				m_indices[write + 1] = b;
+				m_indices[write + 2] = c;
+				write += 3;
+			}
+
+			m_indices.resize(write);
+		}
+
+	private:
+
+		const std::vector<XMFLOAT3>& m_positions;
+		std::vector<uint32>&         m_indices;
+
+		std::vector<uint32>          m_posRemap;
+		std::vector<uint32>          m_wedge;
+		std::vector<Quadric>         m_quadrics;
+		std::vector<uint8>           m_kinds;
+		std::vector<uint32>          m_remap;
+
+		std::vector<uint32>          m_adjacencyOffsets;
+		std::vector<uint32>          m_adjacency;
+	};
+}
+
+float MeshSimplifier::SimplifyPositions(const std::vector<XMFLOAT3>& positions, const std::vector<uint32>& indices,
+	uint32 targetIndexCount, float targetError, std::vector<uint32>& OutIndices)
+{
+	OutIndices = indices;
+
+	if (indices.size() <= targetIndexCount || positions.empty())
+		return 0.0f;
+
+	QuadricSimplifier simplifier(positions, OutIndices);
+
+	float maxError = 0.0f;
+	while (OutIndices.size() > targetIndexCount)
+	{
+		if (simplifier.Pass(targetIndexCount, targetError, maxError) == 0)
+			break;
+	}
+
+	return maxError;
+}
+
+void MeshSimplifier::GenerateLODs(Geometry& InOutGeo, const SimplifyDesc& InDesc)
+{
+	InOutGeo.LODs.clear();
+
+	const auto& vertices = InOutGeo.Data.Vertices;
+	const uint32 numVertices = (uint32)vertices.size();
+
+	if (InOutGeo.Data.Indices32.empty() || numVertices == 0)
+		return;
+
+	const float radius = InOutGeo.Data.CalcBounds().SphereRadius;
+	const float errorLimit = InDesc.MaxError * radius;
+
+	float accumulatedError = 0.0f;
+
+	for (uint32 level = 0; level < InDesc.NumLODs; ++level)
+	{
+		const std::vector<uint32>& source = level == 0 ? InOutGeo.Data.Indices32 : InOutGeo.LODs.back().Indices32;
+
+		uint32 targetIndexCount = (uint32)(source.size() * InDesc.Reduction) / 3 * 3;
+		if (targetIndexCount / 3 < InDesc.MinTriangles)
+			break;
+
+		// Every level is built from the previous one, so the error against the base mesh accumulates. Each level only
+		// gets what the ones before left of the limit.
+		const float remainingError = errorLimit - accumulatedError;
+		if (remainingError <= 0.0f)
+			break;
+
+		MeshLOD lod;
+		float error = Simplify(vertices, source, targetIndexCount, remainingError, lod.Indices32);
+
+		// Locked borders or the error bound stopped it, further levels would only repeat this one.
+		if (lod.Indices32.empty() || lod.Indices32.size() > source.size() * 95 / 100)
+			break;
+
+		MeshOptimizer::OptimizeVertexCache(lod.Indices32, numVertices);
+
+		accumulatedError += error;
+		lod.Error = accumulatedError;
+
+		InOutGeo.LODs.push_back(std::move(lod));
+	}
+}
+
+void MeshSimplifier::GenerateLODs(const std::vector<Geometry*>& InOutGeos, const SimplifyDesc& InDesc)
+{
+	if (InOutGeos.empty())
+		return;
+
+	// Largest meshes first so one big mesh does not end up alone at the tail.
+	std::vector<Geometry*> order(InOutGeos);
+	std::stable_sort(order.begin(), order.end(), [](const Geometry* a, const Geometry* b)
+	{
+		return a->Data.Indices32.size() > b->Data.Indices32.size();
+	});
+
+	auto simplify = [&](uint32 InBegin, uint32 InEnd)
+	{
+		for (uint32 i = InBegin; i < InEnd; ++i)
+		{
+			GenerateLODs(*order[i], InDesc);
+		}
+	};
+
+	// One mesh per range, in that order.
+	if (InDesc.bParallel)
+	{
+		ThreadManager::JobSystem::Get().ParallelFor((uint32)order.size(), 1, simplify);
+	}
+	else
+	{
+		simplify(0, (uint32)order.size());
+	}
+}
+
+float MeshSimplifier::ComputeScreenSpaceError(float InError, float InDistance, float InFovY, float InViewportHeight)
+{
+	const float distance = Math::Max(InDistance, 1e-4f);
+	return InError * InViewportHeight / (2.0f * distance * tanf(0.5f * InFovY));
+}
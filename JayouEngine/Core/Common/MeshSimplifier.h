@@ -0,0 +1,79 @@
+//
+// MeshSimplifier.h
+//
+
+#pragma once
+
+#include "GeometryManager.h"
+
+namespace Utility
+{
+	namespace GeometryManager
+	{
+		struct SimplifyDesc
+		{
+			uint32 NumLODs = 3;
+
+			// Index count ratio between two consecutive levels.
+			float  Reduction = 0.5f;
+
+			// Upper bound of the error of the whole chain against the base mesh, relative to the bounding sphere radius.
+			float  MaxError = 0.25f;
+
+			// Stop the chain once a level would fall below this.
+			uint32 MinTriangles = 64;
+
+			// Many meshes are simplified on the job system, false keeps them on the calling thread. Same LODs either way.
+			bool   bParallel = true;
+		};
+
+		class MeshSimplifier
+		{
+		public:
+
+			///<summary>
+			/// Quadric error metric edge collapse (Garland & Heckbert). Vertices are never moved or created,
+			/// an edge collapses onto one of its existing endpoints, so UVs/normals stay exact. Open borders and
+			/// vertices where more than two attribute wedges meet are locked, two-wedge seams only collapse along the seam.
+			/// Returns the object space error of the result, a bound on how far a collapsed vertex moved off the planes of
+			/// the source triangles around it (distance, same units as the positions, scale by the world scale to compare).
+			///</summary>
+			template<typename TVertex>
+			static float Simplify(const std::vector<TVertex>& vertices, const std::vector<uint32>& indices,
+				uint32 targetIndexCount, float targetError, std::vector<uint32>& OutIndices);
+
+			///<summary>
+			/// Builds Geometry::LODs, each level simplified from the previous one. Deterministic.
+			///</summary>
+			static void GenerateLODs(Geometry& InOutGeo, const SimplifyDesc& InDesc);
+
+			///<summary>
+			/// Same as above across many meshes, largest first, spread over the job system unless InDesc.bParallel is false.
+			///</summary>
+			static void GenerateLODs(const std::vector<Geometry*>& InOutGeos, const SimplifyDesc& InDesc);
+
+			///<summary>
+			/// Projects an object space error to pixels for a perspective view at the given distance.
+			///</summary>
+			static float ComputeScreenSpaceError(float InError, float InDistance, float InFovY, float InViewportHeight);
+
+		private:
+
+			static float SimplifyPositions(const std::vector<XMFLOAT3>& positions, const std::vector<uint32>& indices,
+				uint32 targetIndexCount, float targetError, std::vector<uint32>& OutIndices);
+		};
+
+		template<typename TVertex>
+		float MeshSimplifier::Simplify(const std::vector<TVertex>& vertices, const std::vector<uint32>& indices,
+			uint32 targetIndexCount, float targetError, std::vector<uint32>& OutIndices)
+		{
+			std::vector<XMFLOAT3> positions(vertices.size());
+			for (size_t i = 0; i < vertices.size(); ++i)
+			{
+				positions[i] = vertices[i].Position;
+			}
+
+			return SimplifyPositions(positions, indices, targetIndexCount, targetError, OutIndices);
+		}
+	}
+}
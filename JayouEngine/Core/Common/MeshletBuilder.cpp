@@ -0,0 +1,364 @@
+//
+// MeshletBuilder.cpp
+//
+
+#include "MeshletBuilder.h"
+
+using namespace Utility;
+using namespace Utility::GeometryManager;
+
+namespace
+{
+	class MeshletContext
+	{
+	public:
+
+		MeshletContext(const std::vector<XMFLOAT3>& positions, const std::vector<uint32>& indices, std::vector<Meshlet>& OutMeshlets)
+			: m_positions(positions), m_indices(indices), m_meshlets(OutMeshlets)
+		{
+			m_bInMeshlet.assign(positions.size(), false);
+			m_result.reserve(indices.size());
+			ResetBox();
+		}
+
+		uint32 NumVertices() const { return (uint32)m_vertices.size(); }
+		uint32 NumTriangles() const { return (uint32)m_triangles.size(); }
+		const std::vector<uint32>& Vertices() const { return m_vertices; }
+
+		// Vertices of the triangle that are not in the current meshlet yet.
+		uint32 NumNewVertices(uint32 tri) const
+		{
+			uint32 count = 0;
+			for (uint32 k = 0; k < 3; ++k)
+			{
+				count += m_bInMeshlet[m_indices[tri * 3 + k]] ? 0 : 1;
+			}
+			return count;
+		}
+
+		// Squared distance from the triangle centroid to the centroid of the current meshlet.
+		float DistanceSq(uint32 tri) const
+		{
+			if (m_vertices.empty())
+				return 0.0f;
+
+			const float scale = 1.0f / m_vertices.size();
+			float dx = -m_centroidSum.x * scale;
+			float dy = -m_centroidSum.y * scale;
+			float dz = -m_centroidSum.z * scale;
+
+			for (uint32 k = 0; k < 3; ++k)
+			{
+				const XMFLOAT3& p = m_positions[m_indices[tri * 3 + k]];
+				dx += p.x / 3.0f;
+				dy += p.y / 3.0f;
+				dz += p.z / 3.0f;
+			}
+
+			return dx * dx + dy * dy + dz * dz;
+		}
+
+		// Whether the triangle lies within the current meshlet box grown by its largest extent.
+		bool IsNear(uint32 tri) const
+		{
+			if (m_vertices.empty())
+				return true;
+
+			const float margin = Math::Max(m_vmax.x - m_vmin.x, Math::Max(m_vmax.y - m_vmin.y, m_vmax.z - m_vmin.z));
+
+			for (uint32 k = 0; k < 3; ++k)
+			{
+				const XMFLOAT3& p = m_positions[m_indices[tri * 3 + k]];
+				if (p.x < m_vmin.x - margin || p.x > m_vmax.x + margin ||
+					p.y < m_vmin.y - margin || p.y > m_vmax.y + margin ||
+					p.z < m_vmin.z - margin || p.z > m_vmax.z + margin)
+					return false;
+			}
+			return true;
+		}
+
+		void Add(uint32 tri)
+		{
+			for (uint32 k = 0; k < 3; ++k)
+			{
+				uint32 v = m_indices[tri * 3 + k];
+				if (!m_bInMeshlet[v])
+				{
+					m_bInMeshlet[v] = true;
+					m_vertices.push_back(v);
+
+					const XMFLOAT3& p = m_positions[v];
+					m_centroidSum.x += p.x;
+					m_centroidSum.y += p.y;
+					m_centroidSum.z += p.z;
+
+					m_vmin.x = Math::Min(m_vmin.x, p.x); m_vmax.x = Math::Max(m_vmax.x, p.x);
+					m_vmin.y = Math::Min(m_vmin.y, p.y); m_vmax.y = Math::Max(m_vmax.y, p.y);
+					m_vmin.z = Math::Min(m_vmin.z, p.z); m_vmax.z = Math::Max(m_vmax.z, p.z);
+				}
+			}
+			m_triangles.push_back(tri);
+		}
+
+		void Flush()
+		{
+			if (m_triangles.empty())
+				return;
+
+			Meshlet meshlet;
+			meshlet.StartIndexLocation = (uint32)m_result.size();
+			meshlet.IndexCount = (uint32)m_triangles.size() * 3;
+			meshlet.VertexCount = (uint32)m_vertices.size();
+
+			for (auto tri : m_triangles)
+			{
+				m_result.push_back(m_indices[tri * 3 + 0]);
+				m_result.push_back(m_indices[tri * 3 + 1]);
+				m_result.push_back(m_indices[tri * 3 + 2]);
+			}
+
+			CalcBounds(meshlet);
+			CalcCone(meshlet);
+
+			m_meshlets.push_back(meshlet);
+
+			for (auto v : m_vertices)
+			{
+				m_bInMeshlet[v] = false;
+			}
+			m_vertices.clear();
+			m_triangles.clear();
+			m_centroidSum = XMFLOAT3(0.0f, 0.0f, 0.0f);
+			ResetBox();
+		}
+
+		std::vector<uint32>& Result() { return m_result; }
+
+	private:
+
+		void ResetBox()
+		{
+			const float maxFloat = std::numeric_limits<float>::max();
+			m_vmin = XMFLOAT3(+maxFloat, +maxFloat, +maxFloat);
+			m_vmax = XMFLOAT3(-maxFloat, -maxFloat, -maxFloat);
+		}
+
+		void CalcBounds(Meshlet& OutMeshlet) const
+		{
+			const float maxFloat = std::numeric_limits<float>::max();
+
+			XMFLOAT3 vmin(+maxFloat, +maxFloat, +maxFloat);
+			XMFLOAT3 vmax(-maxFloat, -maxFloat, -maxFloat);
+
+			for (auto v : m_vertices)
+			{
+				const XMFLOAT3& p = m_positions[v];
+				vmin.x = Math::Min(vmin.x, p.x); vmax.x = Math::Max(vmax.x, p.x);
+				vmin.y = Math::Min(vmin.y, p.y); vmax.y = Math::Max(vmax.y, p.y);
+				vmin.z = Math::Min(vmin.z, p.z); vmax.z = Math::Max(vmax.z, p.z);
+			}
+
+			XMFLOAT3 origin(0.5f * (vmin.x + vmax.x), 0.5f * (vmin.y + vmax.y), 0.5f * (vmin.z + vmax.z));
+			XMFLOAT3 boxExtent(0.5f * (vmax.x - vmin.x), 0.5f * (vmax.y - vmin.y), 0.5f * (vmax.z - vmin.z));
+			float sphereRadius = sqrtf(boxExtent.x * boxExtent.x + boxExtent.y * boxExtent.y + boxExtent.z * boxExtent.z);
+
+			OutMeshlet.Bounds = BoxSphereBounds(origin, boxExtent, sphereRadius);
+		}
+
+		void CalcCone(Meshlet& OutMeshlet) const
+		{
+			std::vector<XMFLOAT3> normals;
+			normals.reserve(m_triangles.size());
+
+			XMFLOAT3 axis(0.0f, 0.0f, 0.0f);
+			for (auto tri : m_triangles)
+			{
+				const XMFLOAT3& p0 = m_positions[m_indices[tri * 3 + 0]];
+				const XMFLOAT3& p1 = m_positions[m_indices[tri * 3 + 1]];
+				const XMFLOAT3& p2 = m_positions[m_indices[tri * 3 + 2]];
+
+				const float e0x = p1.x - p0.x, e0y = p1.y - p0.y, e0z = p1.z - p0.z;
+				const float e1x = p2.x - p0.x, e1y = p2.y - p0.y, e1z = p2.z - p0.z;
+
+				XMFLOAT3 n(e0y * e1z - e0z * e1y, e0z * e1x - e0x * e1z, e0x * e1y - e0y * e1x);
+				const float length = sqrtf(n.x * n.x + n.y * n.y + n.z * n.z);
+
+				// Degenerate triangles are never rasterized, they don't constrain the cone.
+				if (length <= 0.0f)
+					continue;
+
+				n.x /= length; n.y /= length; n.z /= length;
+				normals.push_back(n);
+
+				axis.x += n.x; axis.y += n.y; axis.z += n.z;
+			}
+
+			const float axisLength = sqrtf(axis.x * axis.x + axis.y * axis.y + axis.z * axis.z);
+			if (normals.empty() || axisLength <= 0.0f)
+				return;
+
+			axis.x /= axisLength; axis.y /= axisLength; axis.z /= axisLength;
+
+			float minDot = 1.0f;
+			for (const auto& n : normals)
+			{
+				minDot = Math::Min(minDot, n.x * axis.x + n.y * axis.y + n.z * axis.z);
+			}
+
+			OutMeshlet.ConeAxis = axis;
+
+			// Wider than ~84 degrees almost never culls, keep the test trivially false.
+			if (minDot <= 0.1f)
+				OutMeshlet.ConeCutoff = 1.0f;
+			else
+				OutMeshlet.ConeCutoff = sqrtf(1.0f - minDot * minDot);
+		}
+
+	private:
+
+		const std::vector<XMFLOAT3>& m_positions;
+		const std::vector<uint32>&   m_indices;
+		std::vector<Meshlet>&        m_meshlets;
+
+		std::vector<bool>            m_bInMeshlet;
+		std::vector<uint32>          m_vertices;
+		std::vector<uint32>          m_triangles;
+		std::vector<uint32>          m_result;
+
+		XMFLOAT3                     m_centroidSum = { 0.0f, 0.0f, 0.0f };
+		XMFLOAT3                     m_vmin;
+		XMFLOAT3                     m_vmax;
+	};
+}
+
+std::vector<Meshlet> MeshletBuilder::BuildMeshletsPositions(const std::vector<XMFLOAT3>& positions,
+	std::vector<uint32>& indices, uint32 maxVertices, uint32 maxTriangles)
+{
+	std::vector<Meshlet> meshlets;
+
+	const uint32 numVertices = (uint32)positions.size();
+	const uint32 numTriangles = (uint32)indices.size() / 3;
+
+	if (numTriangles == 0 || numVertices == 0 || maxVertices < 3 || maxTriangles < 1)
+		return meshlets;
+
+	// Vertex -> triangle adjacency (CSR layout).
+	std::vector<uint32> adjacencyOffsets(numVertices + 1, 0);
+	for (uint32 i = 0; i < numTriangles * 3; ++i)
+	{
+		adjacencyOffsets[indices[i] + 1]++;
+	}
+	for (uint32 i = 0; i < numVertices; ++i)
+	{
+		adjacencyOffsets[i + 1] += adjacencyOffsets[i];
+	}
+
+	std::vector<uint32> adjacency(numTriangles * 3);
+	{
+		std::vector<uint32> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (uint32 i = 0; i < numTriangles * 3; ++i)
+		{
+			adjacency[fill[indices[i]]++] = i / 3;
+		}
+	}
+
+	std::vector<bool> emitted(numTriangles, false);
+	MeshletContext context(positions, indices, meshlets);
+
+	// Best unemitted triangle around the given vertices: fewest new vertices, then closest to the
+	// cluster so it stays round, then input order which is already cache friendly after MeshOptimizer.
+	auto pickAround = [&](const uint32* verts, uint32 count, uint32& OutNewVertices)
+	{
+		uint32 best = ~0u;
+		float  bestDistance = std::numeric_limits<float>::max();
+		OutNewVertices = 4;
+
+		for (uint32 i = 0; i < count; ++i)
+		{
+			for (uint32 a = adjacencyOffsets[verts[i]]; a < adjacencyOffsets[verts[i] + 1]; ++a)
+			{
+				const uint32 tri = adjacency[a];
+				if (emitted[tri])
+					continue;
+
+				const uint32 numNew = context.NumNewVertices(tri);
+				if (numNew > OutNewVertices)
+					continue;
+
+				const float distance = context.DistanceSq(tri);
+				if (numNew < OutNewVertices || distance < bestDistance || (distance == bestDistance && tri < best))
+				{
+					best = tri;
+					bestDistance = distance;
+					OutNewVertices = numNew;
+				}
+			}
+		}
+
+		return best;
+	};
+
+	uint32 scanCursor = 0;
+
+	for (uint32 numEmitted = 0; numEmitted < numTriangles; ++numEmitted)
+	{
+		uint32 numNew = 4;
+		uint32 tri = pickAround(context.Vertices().data(), context.NumVertices(), numNew);
+
+		if (tri == ~0u)
+		{
+			// Disconnected from the cluster, continue with the next triangle in input order.
+			while (emitted[scanCursor])
+				scanCursor++;
+
+			tri = scanCursor;
+			numNew = context.NumNewVertices(tri);
+
+			// Small nearby islands may share a cluster, a far one would only blow up the bounds.
+			if (!context.IsNear(tri))
+				context.Flush();
+		}
+
+		if (context.NumVertices() + numNew > maxVertices || context.NumTriangles() + 1 > maxTriangles)
+			context.Flush();
+
+		context.Add(tri);
+		emitted[tri] = true;
+	}
+
+	context.Flush();
+
+	indices.swap(context.Result());
+	return meshlets;
+}
+
+bool MeshletBuilder::IsBackfacing(const Meshlet& InMeshlet, const XMFLOAT3& InEyePos)
+{
+	const XMFLOAT3& center = InMeshlet.Bounds.Origin;
+
+	const float dx = center.x - InEyePos.x;
+	const float dy = center.y - InEyePos.y;
+	const float dz = center.z - InEyePos.z;
+	const float distance = sqrtf(dx * dx + dy * dy + dz * dz);
+
+	const float d = dx * InMeshlet.ConeAxis.x + dy * InMeshlet.ConeAxis.y + dz * InMeshlet.ConeAxis.z;
+
+	return d >= InMeshlet.ConeCutoff * distance + InMeshlet.Bounds.SphereRadius;
+}
+
+bool MeshletBuilder::HasUniformScale(const XMMATRIX& InWorld)
+{
+	// The rows are the world axes, orthogonal and of one length. Equal lengths alone still let a shear through.
+	const XMVECTOR x = InWorld.r[0];
+	const XMVECTOR y = InWorld.r[1];
+	const XMVECTOR z = InWorld.r[2];
+	const float xx = XMVectorGetX(XMVector3LengthSq(x));
+	const float yy = XMVectorGetX(XMVector3LengthSq(y));
+	const float zz = XMVectorGetX(XMVector3LengthSq(z));
+	const float tolerance = 2e-4f * std::max(xx, std::max(yy, zz));
+
+	return fabsf(xx - yy) <= tolerance && fabsf(xx - zz) <= tolerance &&
+		fabsf(XMVectorGetX(XMVector3Dot(x, y))) <= tolerance &&
+		fabsf(XMVectorGetX(XMVector3Dot(x, z))) <= tolerance &&
+		fabsf(XMVectorGetX(XMVector3Dot(y, z))) <= tolerance;
+}
@@ -0,0 +1,58 @@
+//
+// MeshletBuilder.h
+//
+
+#pragma once
+
+#include "GeometryManager.h"
+
+namespace Utility
+{
+	namespace GeometryManager
+	{
+		class MeshletBuilder
+		{
+		public:
+
+			// Same limits as the common mesh shader setups, 124 keeps the primitive indices in 128 bytes rows.
+			static const uint32 MaxVertices = 64;
+			static const uint32 MaxTriangles = 124;
+
+			///<summary>
+			/// Greedily grows clusters over shared vertices and reorders the index buffer so every cluster is
+			/// one contiguous range. Vertices are untouched. Only depends on the mesh data, no device needed.
+			///</summary>
+			template<typename TVertex>
+			static std::vector<Meshlet> BuildMeshlets(GeometryData<TVertex>& meshData,
+				uint32 maxVertices = MaxVertices, uint32 maxTriangles = MaxTriangles);
+
+			///<summary>
+			/// Normal cone test, true if every triangle of the cluster faces away from the eye (object space).
+			///</summary>
+			static bool IsBackfacing(const Meshlet& InMeshlet, const XMFLOAT3& InEyePos);
+
+			///<summary>
+			/// Whether the bounds and cones can be culled in object space under InWorld: rotation, translation and a single
+			/// scale. Takes the world matrix, a rotated child of a non uniformly scaled parent is sheared whatever its own scale.
+			///</summary>
+			static bool HasUniformScale(const XMMATRIX& InWorld);
+
+		private:
+
+			static std::vector<Meshlet> BuildMeshletsPositions(const std::vector<XMFLOAT3>& positions,
+				std::vector<uint32>& indices, uint32 maxVertices, uint32 maxTriangles);
+		};
+
+		template<typename TVertex>
+		std::vector<Meshlet> MeshletBuilder::BuildMeshlets(GeometryData<TVertex>& meshData, uint32 maxVertices, uint32 maxTriangles)
+		{
+			std::vector<XMFLOAT3> positions(meshData.Vertices.size());
+			for (size_t i = 0; i < meshData.Vertices.size(); ++i)
+			{
+				positions[i] = meshData.Vertices[i].Position;
+			}
+
+			return BuildMeshletsPositions(positions, meshData.Indices32, maxVertices, maxTriangles);
+		}
+	}
+}
@@ -0,0 +1,129 @@
+//
+// NameTable.cpp
+//
+
+#include "NameTable.h"
+
+using namespace Utility;
+
+const uint32 NameTable::EntriesPerPage;
+const uint32 NameTable::MaxPages;
+const uint32 NameTable::CharsPerChunk;
+
+NameTable& NameTable::Get()
+{
+	static NameTable table;
+	return table;
+}
+
+NameTable::NameTable()
+{
+	m_pages[0].reset(new Entry[EntriesPerPage]);
+	m_pages[0][0] = { "", 0, 0 };
+	m_numNames = 1;
+
+	m_buckets.resize(1024, 0);
+}
+
+uint32 NameTable::Intern(const char* InChars, size_t InLength)
+{
+	if (InLength == 0)
+		return 0;
+
+	const uint32 hash = (uint32)HashMemory(InChars, InLength, 0);
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	uint32 bucket = FindBucket(InChars, InLength, hash);
+	if (m_buckets[bucket] != 0)
+		return m_buckets[bucket];
+
+	const uint32 index = m_numNames;
+	const uint32 page = index / EntriesPerPage;
+	assert(page < MaxPages);
+	if (!m_pages[page])
+		m_pages[page].reset(new Entry[EntriesPerPage]);
+
+	m_pages[page][index % EntriesPerPage] = { StoreChars(InChars, InLength), (uint32)InLength, hash };
+	m_numNames = index + 1;
+
+	// Keep the load under one half, the probe runs stay short.
+	if (m_numNames * 2 > m_buckets.size())
+	{
+		Rehash((uint32)m_buckets.size() * 2);
+		bucket = FindBucket(InChars, InLength, hash);
+	}
+	m_buckets[bucket] = index;
+
+	return index;
+}
+
+uint32 NameTable::Find(const char* InChars, size_t InLength) const
+{
+	if (InLength == 0)
+		return 0;
+
+	const uint32 hash = (uint32)HashMemory(InChars, InLength, 0);
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_buckets[FindBucket(InChars, InLength, hash)];
+}
+
+uint32 NameTable::FindBucket(const char* InChars, size_t InLength, uint32 InHash) const
+{
+	const uint32 mask = (uint32)m_buckets.size() - 1;
+
+	for (uint32 bucket = InHash & mask; ; bucket = (bucket + 1) & mask)
+	{
+		const uint32 index = m_buckets[bucket];
+		if (index == 0)
+			return bucket;
+
+		const Entry& entry = GetEntry(index);
+		if (entry.Hash == InHash && entry.Length == InLength && memcmp(entry.Chars, InChars, InLength) == 0)
+			return bucket;
+	}
+}
+
+const char* NameTable::StoreChars(const char* InChars, size_t InLength)
+{
+	// Long strings get a chunk of their own, in front so the last chunk stays the one being filled.
+	if (InLength + 1 > CharsPerChunk)
+	{
+		char* chars = new char[InLength + 1];
+		memcpy(chars, InChars, InLength);
+		chars[InLength] = '\0';
+
+		m_chunks.emplace(m_chunks.begin(), chars);
+		return chars;
+	}
+
+	if (m_chunkUsed + InLength + 1 > CharsPerChunk)
+	{
+		m_chunks.emplace_back(new char[CharsPerChunk]);
+		m_chunkUsed = 0;
+	}
+
+	char* chars = m_chunks.back().get() + m_chunkUsed;
+	memcpy(chars, InChars, InLength);
+	chars[InLength] = '\0';
+	m_chunkUsed += InLength + 1;
+
+	return chars;
+}
+
+void NameTable::Rehash(uint32 InNumBuckets)
+{
+	std::vector<uint32> buckets(InNumBuckets, 0);
+	const uint32 mask = InNumBuckets - 1;
+
+	for (uint32 index = 1; index < m_numNames; ++index)
+	{
+		uint32 bucket = GetEntry(index).Hash & mask;
+		while (buckets[bucket] != 0)
+			bucket = (bucket + 1) & mask;
+		buckets[bucket] = index;
+	}
+
+	m_buckets.swap(buckets);
+}
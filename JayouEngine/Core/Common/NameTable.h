@@ -0,0 +1,129 @@
+//
+// NameTable.h
+//
+
+#pragma once
+
+#include "Utility.h"
+
+#include <memory>
+#include <mutex>
+
+namespace Utility
+{
+	///<summary>
+	/// Every distinct string once, in arena chunks that never move, so a name is a 32 bits index and compares,
+	/// hashes and copies as one. Index 0 is the empty string. Thread safe, interning takes a lock, reading does not.
+	///</summary>
+	class NameTable
+	{
+	public:
+
+		static NameTable& Get();
+
+		uint32 Intern(const char* InChars, size_t InLength);
+
+		// 0 when InChars was never interned, the table is left as is.
+		uint32 Find(const char* InChars, size_t InLength) const;
+
+		const char* GetChars(uint32 InIndex) const { return GetEntry(InIndex).Chars; }
+		uint32      GetLength(uint32 InIndex) const { return GetEntry(InIndex).Length; }
+		uint32      GetNumNames() const { return m_numNames; }
+
+	private:
+
+		NameTable();
+		NameTable(const NameTable&) = delete;
+		NameTable& operator=(const NameTable&) = delete;
+
+		struct Entry
+		{
+			const char* Chars;
+			uint32      Length;
+			uint32      Hash;
+		};
+
+		static const uint32 EntriesPerPage = 4096;
+		static const uint32 MaxPages = 4096;
+		static const uint32 CharsPerChunk = 64 * 1024;
+
+		const Entry& GetEntry(uint32 InIndex) const { return m_pages[InIndex / EntriesPerPage][InIndex % EntriesPerPage]; }
+
+		// Slot of InChars in m_buckets, the empty one it would go to when absent.
+		uint32 FindBucket(const char* InChars, size_t InLength, uint32 InHash) const;
+
+		const char* StoreChars(const char* InChars, size_t InLength);
+		void Rehash(uint32 InNumBuckets);
+
+		// Entries by index, pages are allocated once and never move.
+		std::unique_ptr<Entry[]>              m_pages[MaxPages];
+		uint32                                m_numNames = 0;
+
+		// Open addressing, linear probing, 0 is an empty bucket (the empty string is never looked up there).
+		std::vector<uint32>                   m_buckets;
+
+		std::vector<std::unique_ptr<char[]>>  m_chunks;
+		size_t                                m_chunkUsed = CharsPerChunk;
+
+		mutable std::mutex                    m_mutex;
+	};
+
+	///<summary>
+	/// An interned string, see NameTable. Built from a string it interns it, the other operations are index work.
+	///</summary>
+	class NameId
+	{
+	public:
+
+		NameId() = default;
+		NameId(const char* InString) : m_index(NameTable::Get().Intern(InString, strlen(InString))) {}
+		NameId(const std::string& InString) : m_index(NameTable::Get().Intern(InString.data(), InString.size())) {}
+
+		uint32      GetIndex() const { return m_index; }
+		const char* c_str() const { return NameTable::Get().GetChars(m_index); }
+		size_t      size() const { return NameTable::Get().GetLength(m_index); }
+		bool        empty() const { return m_index == 0; }
+		std::string ToString() const { return std::string(c_str(), size()); }
+
+		bool operator==(const NameId& InOther) const { return m_index == InOther.m_index; }
+		bool operator!=(const NameId& InOther) const { return m_index != InOther.m_index; }
+
+	private:
+
+		uint32 m_index = 0;
+	};
+}
+
+namespace std
+{
+	template<>
+	struct hash<Utility::NameId>
+	{
+		size_t operator()(const Utility::NameId& InName) const { return InName.GetIndex(); }
+	};
+}
+
+namespace Utility
+{
+	///<summary>
+	/// InName, or InName_N with the first N that is free in InRegistry. N keeps counting up from the last one given for
+	/// InName in InOutSuffixes, adding many objects of one name stays linear.
+	///</summary>
+	template<typename T>
+	NameId MakeUniqueName(const NameId& InName, const std::unordered_map<NameId, T>& InRegistry, std::unordered_map<NameId, uint32>& InOutSuffixes)
+	{
+		if (InRegistry.find(InName) == InRegistry.end())
+			return InName;
+
+		uint32& suffix = InOutSuffixes[InName];
+		const std::string prefix = InName.ToString() + "_";
+
+		NameId name;
+		do
+		{
+			name = NameId(prefix + std::to_string(++suffix));
+		} while (InRegistry.find(name) != InRegistry.end());
+
+		return name;
+	}
+}
@@ -69,4 +69,40 @@ typedef unsigned int     size_type;
 #pragma comment(lib, "dxguid.lib")
 #pragma comment(lib, "runtimeobject.lib")
 
+#else // _WINDOWS
+
+// The portable part of Common (see CMakeLists.txt), built with GCC or Clang against the headers in Core/Portable.
+#include <cstdint>
+
+#include <dxgiformat.h>
+
+typedef uint64_t size_type;
+
+#define __forceinline inline __attribute__((always_inline))
+#define __cdecl
+#define __declspec(x)
+
+// SAL annotations.
+#define _In_
+#define _In_opt_
+#define _Out_
+#define _Out_opt_
+#define _Inout_
+
+inline unsigned char _BitScanForward64(unsigned long* Index, uint64_t Mask)
+{
+	if (Mask == 0)
+		return 0;
+	*Index = (unsigned long)__builtin_ctzll(Mask);
+	return 1;
+}
+
+inline unsigned char _BitScanReverse64(unsigned long* Index, uint64_t Mask)
+{
+	if (Mask == 0)
+		return 0;
+	*Index = (unsigned long)(63 - __builtin_clzll(Mask));
+	return 1;
+}
+
 #endif // _WINDOWS
@@ -0,0 +1,112 @@
+//
+// RenderEntityStore.cpp
+//
+
+#include "RenderEntityStore.h"
+
+using namespace Utility;
+using namespace Utility::GeometryManager;
+
+namespace
+{
+	template<typename T>
+	void SwapRemove(std::vector<T>& InOutComponents, uint32 InIndex)
+	{
+		InOutComponents[InIndex] = InOutComponents.back();
+		InOutComponents.pop_back();
+	}
+}
+
+const int32 RenderEntityStore::NullEntity;
+
+int32 RenderEntityStore::Create(RenderItem* InOwner, bool bOpaque)
+{
+	assert(InOwner->Entity == NullEntity);
+
+	int32 entity;
+	if (!m_freeEntities.empty())
+	{
+		entity = m_freeEntities.back();
+		m_freeEntities.pop_back();
+	}
+	else
+	{
+		entity = (int32)m_indices.size();
+		m_indices.push_back(0);
+	}
+
+	m_indices[entity] = (uint32)m_entities.size();
+
+	m_entities.push_back(entity);
+	m_owners.push_back(InOwner);
+	m_flags.push_back(bOpaque ? EF_Opaque : 0);
+	m_worldBounds.push_back(BoundingBox());
+	m_worldSpheres.push_back(BoundingSphere());
+	m_worldScales.push_back(1.0f);
+	m_renderData.push_back(nullptr);
+	m_objectIndices.push_back(0);
+	m_materialIndices.push_back(0);
+	m_lods.push_back(nullptr);
+	m_numLODs.push_back(0);
+	m_lodIndices.push_back(InOwner->LODIndex);
+
+	InOwner->Entity = entity;
+	Sync(entity);
+
+	return entity;
+}
+
+void RenderEntityStore::Destroy(int32 InEntity)
+{
+	const uint32 index = m_indices[InEntity];
+
+	m_owners[index]->Entity = NullEntity;
+
+	// The last entity takes the freed index, its culling slot has to be refreshed.
+	const int32 last = m_entities.back();
+	m_indices[last] = index;
+	m_flags.back() |= EF_BoundsChanged;
+
+	SwapRemove(m_entities, index);
+	SwapRemove(m_owners, index);
+	SwapRemove(m_flags, index);
+	SwapRemove(m_worldBounds, index);
+	SwapRemove(m_worldSpheres, index);
+	SwapRemove(m_worldScales, index);
+	SwapRemove(m_renderData, index);
+	SwapRemove(m_objectIndices, index);
+	SwapRemove(m_materialIndices, index);
+	SwapRemove(m_lods, index);
+	SwapRemove(m_numLODs, index);
+	SwapRemove(m_lodIndices, index);
+
+	m_freeEntities.push_back(InEntity);
+}
+
+void RenderEntityStore::Sync(int32 InEntity)
+{
+	const uint32 index = m_indices[InEntity];
+	const RenderItem* ri = m_owners[index];
+
+	uint8 flags = (m_flags[index] & EF_Opaque) | EF_BoundsChanged;
+	if (ri->bIsVisible)
+		flags |= EF_Visible;
+	if (ri->bCastShadow)
+		flags |= EF_CastShadow;
+	if (ri->RenderData != nullptr && ri->RenderData->VertexFormat == VF_PackedVertex)
+		flags |= EF_PackedVertices;
+	m_flags[index] = flags;
+
+	m_worldBounds[index] = ri->WorldBounds;
+
+	ri->Bounds.SphereBounds.Transform(m_worldSpheres[index], ri->TransFormMatrix);
+	const float localRadius = ri->Bounds.SphereRadius;
+	m_worldScales[index] = localRadius > 0.0f ? m_worldSpheres[index].Radius / localRadius : 1.0f;
+
+	m_renderData[index] = ri->RenderData.get();
+	m_objectIndices[index] = (uint32)ri->Index;
+	m_materialIndices[index] = (uint32)ri->MaterialIndex;
+	m_lods[index] = ri->CachedLODs.empty() ? nullptr : ri->CachedLODs.data();
+	m_numLODs[index] = (uint32)ri->CachedLODs.size();
+	m_lodIndices[index] = ri->LODIndex;
+}
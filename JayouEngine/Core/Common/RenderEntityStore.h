@@ -0,0 +1,100 @@
+//
+// RenderEntityStore.h
+//
+
+#pragma once
+
+#include "GeometryManager.h"
+
+namespace Utility
+{
+	namespace GeometryManager
+	{
+		///<summary>
+		/// The per frame data of the render items in dense component arrays, so culling, LOD selection and draw sorting
+		/// stream through a few small arrays instead of visiting every RenderItem with its cached geometry.
+		/// Entities are stable ids, the components of an entity live at its index, which changes when another entity is destroyed.
+		/// The RenderItem stays the owner of the data, Sync copies it over after a change.
+		///</summary>
+		class RenderEntityStore
+		{
+		public:
+
+			static const int32 NullEntity = -1;
+
+			enum EFlags : uint8
+			{
+				EF_Visible         = 1 << 0,
+				EF_Opaque          = 1 << 1, // Culled and LOD selected, RenderLayer::Opaque.
+				EF_CastShadow      = 1 << 2,
+				EF_PackedVertices  = 1 << 3, // RenderData is VF_PackedVertex.
+				EF_BoundsChanged   = 1 << 4, // WorldBounds written since the last ClearFlag, or moved to another index.
+			};
+
+			///<summary>
+			/// Adds an entity for InOwner and syncs it. InOwner->Entity is set.
+			///</summary>
+			int32 Create(RenderItem* InOwner, bool bOpaque);
+
+			///<summary>
+			/// The last entity moves into the freed index. InOwner->Entity is reset.
+			///</summary>
+			void Destroy(int32 InEntity);
+
+			///<summary>
+			/// Copies the hot data of the owner into the components, call after the owner changed.
+			///</summary>
+			void Sync(int32 InEntity);
+
+			uint32 GetIndex(int32 InEntity) const { return m_indices[InEntity]; }
+			uint32 GetNumEntities() const { return (uint32)m_entities.size(); }
+
+			// Components, by index.
+			const std::vector<RenderItem*>&     GetOwners() const { return m_owners; }
+			const std::vector<uint8>&           GetFlags() const { return m_flags; }
+			const std::vector<BoundingBox>&     GetWorldBounds() const { return m_worldBounds; }
+			const std::vector<BoundingSphere>&  GetWorldSpheres() const { return m_worldSpheres; }
+			const std::vector<float>&           GetWorldScales() const { return m_worldScales; }
+			const std::vector<D3DRenderData*>&  GetRenderData() const { return m_renderData; }
+			const std::vector<uint32>&          GetObjectIndices() const { return m_objectIndices; }
+			const std::vector<uint32>&          GetMaterialIndices() const { return m_materialIndices; }
+			const std::vector<const MeshLOD*>&  GetLODs() const { return m_lods; }
+			const std::vector<uint32>&          GetNumLODs() const { return m_numLODs; }
+			const std::vector<uint32>&          GetLODIndices() const { return m_lodIndices; }
+
+			void ClearFlag(uint32 InIndex, uint8 InFlag) { m_flags[InIndex] &= ~InFlag; }
+
+			///<summary>
+			/// Also written to the owner, which the draw calls read.
+			///</summary>
+			void SetLODIndex(uint32 InIndex, uint32 InLODIndex)
+			{
+				if (m_lodIndices[InIndex] != InLODIndex)
+				{
+					m_lodIndices[InIndex] = InLODIndex;
+					m_owners[InIndex]->LODIndex = InLODIndex;
+				}
+			}
+
+		private:
+
+			// By index.
+			std::vector<int32>           m_entities;
+			std::vector<RenderItem*>     m_owners;
+			std::vector<uint8>           m_flags;
+			std::vector<BoundingBox>     m_worldBounds;
+			std::vector<BoundingSphere>  m_worldSpheres;
+			std::vector<float>           m_worldScales;     // World over local sphere radius.
+			std::vector<D3DRenderData*>  m_renderData;
+			std::vector<uint32>          m_objectIndices;   // RenderItem::Index.
+			std::vector<uint32>          m_materialIndices;
+			std::vector<const MeshLOD*>  m_lods;            // RenderItem::CachedLODs.
+			std::vector<uint32>          m_numLODs;
+			std::vector<uint32>          m_lodIndices;
+
+			// By entity.
+			std::vector<uint32>          m_indices;
+			std::vector<int32>           m_freeEntities;
+		};
+	}
+}
@@ -9,13 +9,28 @@
 #include <iostream>
 
 using namespace Core;
+using namespace Utility::GeometryManager;
 
 Scene_Impl::Scene_Impl()
 {
 
 }
 
-void Scene_Impl::Add(IObject* InObject)
+void Scene_Impl::Add(IObject* InObject, IObject* InParent)
 {
-	std::cout << "Scene Add Object [" << InObject->Name << "]" << std::endl;
+	int32 parentNode = TransformHierarchy::NullNode;
+	if (InParent != nullptr)
+	{
+		auto parent = m_transformNodes.find(InParent);
+		assert(parent != m_transformNodes.end() && "Add the parent first.");
+		parentNode = parent->second;
+
+		std::cout << "Scene Add Object [" << InObject->Name.c_str() << "] To [" << InParent->Name.c_str() << "]" << std::endl;
+	}
+	else
+	{
+		std::cout << "Scene Add Object [" << InObject->Name.c_str() << "]" << std::endl;
+	}
+
+	m_transformNodes[InObject] = m_transforms.Insert(parentNode, Matrix4(kIdentity), InObject);
 }
@@ -5,6 +5,7 @@
 #pragma once
 
 #include "Interface/IScene.h"
+#include "TransformHierarchy.h"
 
 namespace Core
 {
@@ -14,6 +15,11 @@ namespace Core
 
 		Scene_Impl();
 
-		virtual void Add(IObject*) override;
+		virtual void Add(IObject* InObject, IObject* InParent = nullptr) override;
+
+	protected:
+
+		Utility::GeometryManager::TransformHierarchy m_transforms;
+		std::unordered_map<IObject*, int32>          m_transformNodes;
 	};
 }
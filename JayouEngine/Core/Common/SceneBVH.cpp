@@ -0,0 +1,319 @@
+//
+// SceneBVH.cpp
+//
+
+#include "SceneBVH.h"
+
+using namespace Utility;
+using namespace Utility::GeometryManager;
+
+namespace
+{
+	BoundingBox Merge(const BoundingBox& a, const BoundingBox& b)
+	{
+		BoundingBox merged;
+		BoundingBox::CreateMerged(merged, a, b);
+		return merged;
+	}
+}
+
+SceneBVH::SceneBVH()
+	: m_root(NullProxy)
+	, m_freeList(NullProxy)
+	, m_numProxies(0)
+{
+}
+
+int32 SceneBVH::Insert(const BoundingBox& InBounds, Core::IObject* InObject, uint32 InMask /*= ~0u*/)
+{
+	int32 proxy = AllocateNode();
+
+	Node& leaf = m_nodes[proxy];
+	leaf.Bounds = Fatten(InBounds);
+	leaf.Height = 0;
+	leaf.Mask = InMask;
+	leaf.Object = InObject;
+
+	InsertLeaf(proxy);
+	m_numProxies++;
+
+	return proxy;
+}
+
+void SceneBVH::Remove(int32 InProxy)
+{
+	assert(InProxy >= 0 && InProxy < (int32)m_nodes.size() && m_nodes[InProxy].IsLeaf());
+
+	RemoveLeaf(InProxy);
+	FreeNode(InProxy);
+	m_numProxies--;
+}
+
+bool SceneBVH::Move(int32 InProxy, const BoundingBox& InBounds)
+{
+	assert(InProxy >= 0 && InProxy < (int32)m_nodes.size() && m_nodes[InProxy].IsLeaf());
+
+	const BoundingBox& fatBounds = m_nodes[InProxy].Bounds;
+
+	// Still inside, and the fat bounds did not become loose after a shrink.
+	if (fatBounds.Contains(InBounds) == CONTAINS)
+	{
+		BoundingBox looseBounds = InBounds;
+		XMStoreFloat3(&looseBounds.Extents, XMVectorScale(XMLoadFloat3(&InBounds.Extents), 1.0f + 4.0f * FatRatio));
+		if (looseBounds.Contains(fatBounds) == CONTAINS)
+			return false;
+	}
+
+	RemoveLeaf(InProxy);
+	m_nodes[InProxy].Bounds = Fatten(InBounds);
+	InsertLeaf(InProxy);
+
+	return true;
+}
+
+void SceneBVH::Clear()
+{
+	m_nodes.clear();
+	m_root = NullProxy;
+	m_freeList = NullProxy;
+	m_numProxies = 0;
+}
+
+int32 SceneBVH::AllocateNode()
+{
+	if (m_freeList == NullProxy)
+	{
+		m_nodes.push_back(Node());
+		return (int32)m_nodes.size() - 1;
+	}
+
+	int32 node = m_freeList;
+	m_freeList = m_nodes[node].Parent;
+	m_nodes[node] = Node();
+	return node;
+}
+
+void SceneBVH::FreeNode(int32 InNode)
+{
+	m_nodes[InNode] = Node();
+	m_nodes[InNode].Parent = m_freeList;
+	m_freeList = InNode;
+}
+
+void SceneBVH::InsertLeaf(int32 InLeaf)
+{
+	if (m_root == NullProxy)
+	{
+		m_root = InLeaf;
+		m_nodes[m_root].Parent = NullProxy;
+		return;
+	}
+
+	// Find the best sibling, descending along the cheapest growth of surface area.
+	const BoundingBox leafBounds = m_nodes[InLeaf].Bounds;
+	int32 index = m_root;
+	while (!m_nodes[index].IsLeaf())
+	{
+		const Node& node = m_nodes[index];
+
+		float area = Area(node.Bounds);
+		float combinedArea = Area(Merge(node.Bounds, leafBounds));
+
+		// Cost of pairing the leaf with this node.
+		float cost = 2.0f * combinedArea;
+
+		// Every ancestor below this node grows at least by this.
+		float inheritanceCost = 2.0f * (combinedArea - area);
+
+		auto descendCost = [&](int32 InChild)
+		{
+			const BoundingBox& childBounds = m_nodes[InChild].Bounds;
+			float childArea = Area(Merge(childBounds, leafBounds));
+			if (m_nodes[InChild].IsLeaf())
+				return childArea + inheritanceCost;
+			return childArea - Area(childBounds) + inheritanceCost;
+		};
+
+		float cost1 = descendCost(node.Child1);
+		float cost2 = descendCost(node.Child2);
+
+		if (cost < cost1 && cost < cost2)
+			break;
+
+		index = cost1 < cost2 ? node.Child1 : node.Child2;
+	}
+
+	const int32 sibling = index;
+
+	// New parent takes the place of the sibling.
+	const int32 oldParent = m_nodes[sibling].Parent;
+	const int32 newParent = AllocateNode();
+	m_nodes[newParent].Parent = oldParent;
+	m_nodes[newParent].Bounds = Merge(leafBounds, m_nodes[sibling].Bounds);
+	m_nodes[newParent].Height = m_nodes[sibling].Height + 1;
+	m_nodes[newParent].Mask = m_nodes[sibling].Mask | m_nodes[InLeaf].Mask;
+	m_nodes[newParent].Child1 = sibling;
+	m_nodes[newParent].Child2 = InLeaf;
+	m_nodes[sibling].Parent = newParent;
+	m_nodes[InLeaf].Parent = newParent;
+
+	if (oldParent != NullProxy)
+	{
+		if (m_nodes[oldParent].Child1 == sibling)
+			m_nodes[oldParent].Child1 = newParent;
+		else
+			m_nodes[oldParent].Child2 = newParent;
+	}
+	else
+	{
+		m_root = newParent;
+	}
+
+	Refit(m_nodes[InLeaf].Parent);
+}
+
+void SceneBVH::RemoveLeaf(int32 InLeaf)
+{
+	if (InLeaf == m_root)
+	{
+		m_root = NullProxy;
+		return;
+	}
+
+	const int32 parent = m_nodes[InLeaf].Parent;
+	const int32 grandParent = m_nodes[parent].Parent;
+	const int32 sibling = m_nodes[parent].Child1 == InLeaf ? m_nodes[parent].Child2 : m_nodes[parent].Child1;
+
+	// The sibling takes the place of the parent.
+	if (grandParent != NullProxy)
+	{
+		if (m_nodes[grandParent].Child1 == parent)
+			m_nodes[grandParent].Child1 = sibling;
+		else
+			m_nodes[grandParent].Child2 = sibling;
+		m_nodes[sibling].Parent = grandParent;
+		FreeNode(parent);
+
+		Refit(grandParent);
+	}
+	else
+	{
+		m_root = sibling;
+		m_nodes[sibling].Parent = NullProxy;
+		FreeNode(parent);
+	}
+
+	m_nodes[InLeaf].Parent = NullProxy;
+}
+
+void SceneBVH::Refit(int32 InNode)
+{
+	int32 index = InNode;
+	while (index != NullProxy)
+	{
+		index = Balance(index);
+
+		Node& node = m_nodes[index];
+		const Node& child1 = m_nodes[node.Child1];
+		const Node& child2 = m_nodes[node.Child2];
+
+		node.Bounds = Merge(child1.Bounds, child2.Bounds);
+		node.Height = 1 + std::max(child1.Height, child2.Height);
+		node.Mask = child1.Mask | child2.Mask;
+
+		index = node.Parent;
+	}
+}
+
+int32 SceneBVH::Balance(int32 InNode)
+{
+	const int32 a = InNode;
+	if (m_nodes[a].IsLeaf())
+		return a;
+
+	// Height of A itself may be stale here, only its children are up to date.
+	const int32 b = m_nodes[a].Child1;
+	const int32 c = m_nodes[a].Child2;
+	const int32 balance = m_nodes[c].Height - m_nodes[b].Height;
+
+	// Rotates the taller child up, its shorter child goes down to A.
+	auto rotateUp = [&](int32 InUp, int32 InOther)
+	{
+		const int32 f = m_nodes[InUp].Child1;
+		const int32 g = m_nodes[InUp].Child2;
+
+		// A and InUp swap places.
+		m_nodes[InUp].Child1 = a;
+		m_nodes[InUp].Parent = m_nodes[a].Parent;
+		m_nodes[a].Parent = InUp;
+
+		if (m_nodes[InUp].Parent != NullProxy)
+		{
+			Node& parent = m_nodes[m_nodes[InUp].Parent];
+			if (parent.Child1 == a)
+				parent.Child1 = InUp;
+			else
+				parent.Child2 = InUp;
+		}
+		else
+		{
+			m_root = InUp;
+		}
+
+		// The taller grandchild stays with InUp.
+		const int32 keep = m_nodes[f].Height > m_nodes[g].Height ? f : g;
+		const int32 drop = keep == f ? g : f;
+
+		m_nodes[InUp].Child2 = keep;
+		if (m_nodes[a].Child1 == InUp)
+			m_nodes[a].Child1 = drop;
+		else
+			m_nodes[a].Child2 = drop;
+		m_nodes[drop].Parent = a;
+
+		Node& nodeA = m_nodes[a];
+		nodeA.Bounds = Merge(m_nodes[InOther].Bounds, m_nodes[drop].Bounds);
+		nodeA.Height = 1 + std::max(m_nodes[InOther].Height, m_nodes[drop].Height);
+		nodeA.Mask = m_nodes[InOther].Mask | m_nodes[drop].Mask;
+
+		Node& nodeUp = m_nodes[InUp];
+		nodeUp.Bounds = Merge(nodeA.Bounds, m_nodes[keep].Bounds);
+		nodeUp.Height = 1 + std::max(nodeA.Height, m_nodes[keep].Height);
+		nodeUp.Mask = nodeA.Mask | m_nodes[keep].Mask;
+
+		return InUp;
+	};
+
+	if (balance > 1)
+		return rotateUp(c, b);
+
+	if (balance < -1)
+		return rotateUp(b, c);
+
+	return a;
+}
+
+BoundingBox SceneBVH::Fatten(const BoundingBox& InBounds)
+{
+	BoundingBox fatBounds = InBounds;
+	XMStoreFloat3(&fatBounds.Extents, XMVectorScale(XMLoadFloat3(&InBounds.Extents), 1.0f + FatRatio));
+	return fatBounds;
+}
+
+float SceneBVH::IntersectRay(const BoundingBox& InBounds, const XMFLOAT3& InOrigin, const XMFLOAT3& InInvDirection, float InMaxDistance)
+{
+	const XMFLOAT3& c = InBounds.Center;
+	const XMFLOAT3& e = InBounds.Extents;
+
+	float tx0 = (c.x - e.x - InOrigin.x) * InInvDirection.x;
+	float tx1 = (c.x + e.x - InOrigin.x) * InInvDirection.x;
+	float ty0 = (c.y - e.y - InOrigin.y) * InInvDirection.y;
+	float ty1 = (c.y + e.y - InOrigin.y) * InInvDirection.y;
+	float tz0 = (c.z - e.z - InOrigin.z) * InInvDirection.z;
+	float tz1 = (c.z + e.z - InOrigin.z) * InInvDirection.z;
+
+	float tmin = std::max(std::max(std::min(tx0, tx1), std::min(ty0, ty1)), std::max(std::min(tz0, tz1), 0.0f));
+	float tmax = std::min(std::min(std::max(tx0, tx1), std::max(ty0, ty1)), std::min(std::max(tz0, tz1), InMaxDistance));
+
+	return tmin <= tmax ? tmin : std::numeric_limits<float>::infinity();
+}
@@ -0,0 +1,214 @@
+//
+// SceneBVH.h
+//
+
+#pragma once
+
+#include "Utility.h"
+#include "Interface/IObject.h"
+
+using namespace DirectX;
+
+namespace Utility
+{
+	namespace GeometryManager
+	{
+		///<summary>
+		/// Dynamic AABB tree over world space object bounds, balanced with tree rotations on insert and remove.
+		/// Leaves store fattened bounds so small moves do not touch the tree, see Move.
+		/// Every proxy carries a mask, queries only report proxies whose mask overlaps the query mask.
+		///</summary>
+		class SceneBVH
+		{
+		public:
+
+			static const int32 NullProxy = -1;
+
+			// Leaves are enlarged by this fraction of their extents.
+			static constexpr float FatRatio = 0.1f;
+
+			SceneBVH();
+
+			int32 Insert(const BoundingBox& InBounds, Core::IObject* InObject, uint32 InMask = ~0u);
+
+			void Remove(int32 InProxy);
+
+			///<summary>
+			/// Refits the proxy to the new bounds, returns true when it had to be reinserted.
+			///</summary>
+			bool Move(int32 InProxy, const BoundingBox& InBounds);
+
+			void Clear();
+
+			Core::IObject*     GetObject(int32 InProxy) const { return m_nodes[InProxy].Object; }
+			const BoundingBox& GetFatBounds(int32 InProxy) const { return m_nodes[InProxy].Bounds; }
+
+			uint32 GetNumProxies() const { return m_numProxies; }
+			int32  GetHeight() const { return m_root == NullProxy ? 0 : m_nodes[m_root].Height; }
+
+			///<summary>
+			/// Visits the proxies whose fat bounds the ray enters before InMaxDistance, roughly front to back.
+			/// InCallback(IObject*, float InEntryDistance) returns the new max distance, so nearest hit queries
+			/// can clip the ray as they go. InDirection does not need to be unit length.
+			///</summary>
+			template<typename TCallback>
+			void QueryRay(const XMFLOAT3& InOrigin, const XMFLOAT3& InDirection, float InMaxDistance, uint32 InMask, TCallback&& InCallback) const;
+
+			///<summary>
+			/// Visits the proxies overlapping InShape (BoundingBox, BoundingSphere, BoundingFrustum, ...) with InCallback(IObject*).
+			/// Subtrees fully contained in InShape are reported without further tests.
+			///</summary>
+			template<typename TShape, typename TCallback>
+			void Query(const TShape& InShape, uint32 InMask, TCallback&& InCallback) const;
+
+			template<typename TCallback>
+			void QueryFrustum(const BoundingFrustum& InFrustum, uint32 InMask, TCallback&& InCallback) const { Query(InFrustum, InMask, InCallback); }
+
+			template<typename TCallback>
+			void QuerySphere(const BoundingSphere& InSphere, uint32 InMask, TCallback&& InCallback) const { Query(InSphere, InMask, InCallback); }
+
+			template<typename TCallback>
+			void QueryBox(const BoundingBox& InBox, uint32 InMask, TCallback&& InCallback) const { Query(InBox, InMask, InCallback); }
+
+		private:
+
+			struct Node
+			{
+				BoundingBox    Bounds;
+
+				// Next free node when on the free list.
+				int32          Parent = NullProxy;
+				int32          Child1 = NullProxy;
+				int32          Child2 = NullProxy;
+
+				// Leaf 0, free -1.
+				int32          Height = -1;
+
+				// Union of the leaf masks below.
+				uint32         Mask = 0;
+
+				Core::IObject* Object = nullptr;
+
+				bool IsLeaf() const { return Child1 == NullProxy; }
+			};
+
+			int32 AllocateNode();
+			void  FreeNode(int32 InNode);
+
+			void  InsertLeaf(int32 InLeaf);
+			void  RemoveLeaf(int32 InLeaf);
+
+			// Rotates the subtree at InNode when its children heights differ by more than one, returns the new subtree root.
+			int32 Balance(int32 InNode);
+
+			// Walks from InNode to the root refreshing bounds, masks and heights.
+			void  Refit(int32 InNode);
+
+			static BoundingBox Fatten(const BoundingBox& InBounds);
+
+			// Entry distance of the ray into the box, +infinity on a miss.
+			static float IntersectRay(const BoundingBox& InBounds, const XMFLOAT3& InOrigin, const XMFLOAT3& InInvDirection, float InMaxDistance);
+
+			// Half of the surface area, the SAH cost of a node.
+			static float Area(const BoundingBox& InBounds)
+			{
+				const XMFLOAT3& e = InBounds.Extents;
+				return e.x * e.y + e.y * e.z + e.z * e.x;
+			}
+
+			int32             m_root;
+			int32             m_freeList;
+			uint32            m_numProxies;
+			std::vector<Node> m_nodes;
+		};
+
+		template<typename TCallback>
+		void SceneBVH::QueryRay(const XMFLOAT3& InOrigin, const XMFLOAT3& InDirection, float InMaxDistance, uint32 InMask, TCallback&& InCallback) const
+		{
+			if (m_root == NullProxy)
+				return;
+
+			const XMFLOAT3 invDirection(1.0f / InDirection.x, 1.0f / InDirection.y, 1.0f / InDirection.z);
+			float maxDistance = InMaxDistance;
+
+			std::vector<std::pair<int32, float>> stack;
+			stack.reserve(64);
+			stack.push_back({ m_root, IntersectRay(m_nodes[m_root].Bounds, InOrigin, invDirection, maxDistance) });
+
+			while (!stack.empty())
+			{
+				std::pair<int32, float> entry = stack.back();
+				stack.pop_back();
+
+				// The ray may have been clipped since the node was pushed.
+				if (entry.second > maxDistance)
+					continue;
+
+				const Node& node = m_nodes[entry.first];
+				if ((node.Mask & InMask) == 0)
+					continue;
+
+				if (node.IsLeaf())
+				{
+					maxDistance = std::min(maxDistance, (float)InCallback(node.Object, entry.second));
+					continue;
+				}
+
+				float distance1 = IntersectRay(m_nodes[node.Child1].Bounds, InOrigin, invDirection, maxDistance);
+				float distance2 = IntersectRay(m_nodes[node.Child2].Bounds, InOrigin, invDirection, maxDistance);
+
+				// Push the far child first so the near one is visited first.
+				if (distance1 > distance2)
+				{
+					if (distance1 <= maxDistance) stack.push_back({ node.Child1, distance1 });
+					if (distance2 <= maxDistance) stack.push_back({ node.Child2, distance2 });
+				}
+				else
+				{
+					if (distance2 <= maxDistance) stack.push_back({ node.Child2, distance2 });
+					if (distance1 <= maxDistance) stack.push_back({ node.Child1, distance1 });
+				}
+			}
+		}
+
+		template<typename TShape, typename TCallback>
+		void SceneBVH::Query(const TShape& InShape, uint32 InMask, TCallback&& InCallback) const
+		{
+			if (m_root == NullProxy)
+				return;
+
+			// Second is true when the subtree is known to be inside the shape.
+			std::vector<std::pair<int32, bool>> stack;
+			stack.reserve(64);
+			stack.push_back({ m_root, false });
+
+			while (!stack.empty())
+			{
+				std::pair<int32, bool> entry = stack.back();
+				stack.pop_back();
+
+				const Node& node = m_nodes[entry.first];
+				if ((node.Mask & InMask) == 0)
+					continue;
+
+				bool bContained = entry.second;
+				if (!bContained)
+				{
+					ContainmentType containment = InShape.Contains(node.Bounds);
+					if (containment == DISJOINT)
+						continue;
+					bContained = containment == CONTAINS;
+				}
+
+				if (node.IsLeaf())
+				{
+					InCallback(node.Object);
+					continue;
+				}
+
+				stack.push_back({ node.Child2, bContained });
+				stack.push_back({ node.Child1, bContained });
+			}
+		}
+	}
+}
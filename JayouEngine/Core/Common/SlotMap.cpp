@@ -0,0 +1,53 @@
+//
+// SlotMap.cpp
+//
+
+#include "SlotMap.h"
+
+using namespace Core;
+using namespace Utility;
+using namespace Utility::GeometryManager;
+
+const int32 SlotMap::NullSlot;
+
+void SlotMap::Insert(IObject* InObject)
+{
+	assert(InObject->Index == NullSlot);
+
+	int32 slot;
+	if (!m_freeSlots.empty())
+	{
+		slot = m_freeSlots.back();
+		m_freeSlots.pop_back();
+	}
+	else
+	{
+		slot = (int32)m_objects.size();
+		m_objects.push_back(nullptr);
+		m_generations.push_back(0);
+	}
+
+	m_objects[slot] = InObject;
+	InObject->Index = slot;
+	InObject->Generation = m_generations[slot];
+}
+
+void SlotMap::Remove(IObject* InObject)
+{
+	const int32 slot = InObject->Index;
+	assert(slot != NullSlot && m_objects[slot] == InObject);
+
+	m_objects[slot] = nullptr;
+	m_generations[slot]++;
+	m_freeSlots.push_back(slot);
+
+	InObject->Index = NullSlot;
+}
+
+IObject* SlotMap::Get(const SlotHandle& InHandle) const
+{
+	if (InHandle.Index < 0 || InHandle.Index >= (int32)m_objects.size())
+		return nullptr;
+
+	return m_generations[InHandle.Index] == InHandle.Generation ? m_objects[InHandle.Index] : nullptr;
+}
@@ -0,0 +1,53 @@
+//
+// SlotMap.h
+//
+
+#pragma once
+
+#include "Utility.h"
+#include "Interface/IObject.h"
+
+namespace Utility
+{
+	namespace GeometryManager
+	{
+		///<summary>
+		/// Stable slots for the objects of one kind. The slot is the Index of the object and so its element in the GPU buffers,
+		/// it does not change while the object lives. Freed slots are reused, the most recently freed first, and every free
+		/// bumps the generation of the slot, so a SlotHandle kept past the deletion of its object resolves to nullptr.
+		///</summary>
+		class SlotMap
+		{
+		public:
+
+			static const int32 NullSlot = -1;
+
+			///<summary>
+			/// Sets InObject->Index and InObject->Generation.
+			///</summary>
+			void Insert(Core::IObject* InObject);
+
+			///<summary>
+			/// The slot of InObject goes to the free list, InObject->Index is reset.
+			///</summary>
+			void Remove(Core::IObject* InObject);
+
+			///<summary>
+			/// nullptr when the object of InHandle was removed, even if its slot is in use again.
+			///</summary>
+			Core::IObject* Get(const Core::SlotHandle& InHandle) const;
+
+			// Highest slot ever used + 1, the GPU buffers of the kind need that many elements.
+			uint32 GetCapacity() const { return (uint32)m_objects.size(); }
+			uint32 GetNumObjects() const { return (uint32)(m_objects.size() - m_freeSlots.size()); }
+
+		private:
+
+			// By slot.
+			std::vector<Core::IObject*> m_objects;
+			std::vector<uint32>         m_generations;
+
+			std::vector<int32>          m_freeSlots;
+		};
+	}
+}
@@ -8,6 +8,8 @@
 using namespace Utility;
 using namespace Utility::StringManager;
 
+#ifdef _WINDOWS
+
 std::wstring StringUtil::StringToWString(const std::string& str)
 {
 	int bufferlen = MultiByteToWideChar(CP_UTF8, 0, str.c_str(), -1, NULL, 0);
@@ -38,6 +40,26 @@ std::wstring StringUtil::AnsiToWString(const std::string& str)
 	return wstr;
 }
 
+#else // _WINDOWS
+
+std::wstring StringUtil::StringToWString(const std::string& str)
+{
+	return to_wstring(str);
+}
+
+std::string StringUtil::WStringToString(const std::wstring& wstr)
+{
+	return to_string(wstr);
+}
+
+// The narrow encoding is UTF-8 there.
+std::wstring StringUtil::AnsiToWString(const std::string& str)
+{
+	return to_wstring(str);
+}
+
+#endif // _WINDOWS
+
 std::string StringUtil::WStringToStringV2(const std::wstring& wstr)
 {
 	std::setlocale(LC_ALL, "");
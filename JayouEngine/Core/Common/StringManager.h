@@ -6,6 +6,7 @@
 
 #include <sstream>
 #include <codecvt>
+#include <locale>
 #include "TypeDef.h"
 
 namespace Utility
@@ -88,7 +89,7 @@ namespace Utility
 		}
 
 		template<typename T>
-		static std::vector<T>
+		std::vector<T>
 			StringUtil::WStringToArray(const std::wstring& wstr, const wchar_t& separator)
 		{
 			std::wistringstream wstr_stream(wstr);
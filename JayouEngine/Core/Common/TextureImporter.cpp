@@ -4,7 +4,11 @@
 
 #include "TextureImporter.h"
 #include "StringManager.h"
+#include "VirtualFileSystem.h"
 #include <cassert>
+#include <climits>
+#include <cstdio>
+#include <fstream>
 
 using namespace Utility;
 using namespace Utility::StringManager;
@@ -14,7 +18,28 @@ using namespace Utility::StringManager;
 #define STBI_WINDOWS_UTF8
 #include "../StdImage/stb_image.h"
 
-int32 Texture::Count = 0;
+const uint32 TextureImporter::CookedVersion;
+
+namespace
+{
+	const uint32 kCookedMagic = 0x5845544a; // "JTEX"
+
+	// The pixels follow, NumBytes of them.
+	struct CookedHeader
+	{
+		uint32 Magic;
+		uint32 Version;
+		uint64 SourceHash;
+		uint64 SourceSize;
+		uint32 bIsHDR;     // As asked for, an HDR source is decoded as such either way.
+		uint32 Format;     // DXGI_FORMAT
+		uint64 Width;
+		uint32 Height;
+		uint32 Padding;
+		uint64 NumBytes;
+		uint64 Reserved;
+	};
+}
 
 //--------------------------------------------------------------------------------------
 // Return the BPP for a particular format
@@ -238,6 +263,9 @@ static void GetSurfaceInfo(_In_ size_t width,
 		planar = true;
 		bpe = 4;
 		break;
+
+	default:
+		break;
 	}
 
 	if (bc)
@@ -296,32 +324,46 @@ static void GetSurfaceInfo(_In_ size_t width,
 	}
 }
 
-void Utility::TextureImporter::LoadTexture(Texture* OutTexture)
+bool Utility::TextureImporter::LoadTexture(Texture* OutTexture)
 {
 	int width, height, channels_in_file;
 	std::string filename = OutTexture->PathName;
 
-	int is_hdr = stbi_is_hdr(filename.data());
+	// Packed or loose, decoded from memory either way.
+	VFSFile source;
+	if (!VirtualFileSystem::Get().ReadFile(filename, source) || source.GetSize() > INT_MAX)
+	{
+		m_errorString.push("Can not read " + filename);
+		return false;
+	}
+
+	if (LoadCooked(GetCookedPath(filename), HashFile(source), source.GetSize(), OutTexture))
+		return true;
+
+	const stbi_uc* sourceData = source.GetData();
+	const int sourceSize = (int)source.GetSize();
+
+	int is_hdr = stbi_is_hdr_from_memory(sourceData, sourceSize);
 	/// assert(!is_hdr && "Currently not support HDR image!");
 
 	if (is_hdr || OutTexture->bIsHDR)
 	{
-		float* data = stbi_loadf(filename.data(), &width, &height, &channels_in_file, 4);
+		float* data = stbi_loadf_from_memory(sourceData, sourceSize, &width, &height, &channels_in_file, 4);
 		if (data == nullptr)
 		{
 			m_errorString.push(stbi_failure_reason());
-			return;
+			return false;
 		}
 		OutTexture->Data = (void*)data;
 		OutTexture->Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
 	}
 	else
 	{
-		byte* data = stbi_load (filename.data(), &width, &height, &channels_in_file, 4);
+		byte* data = stbi_load_from_memory(sourceData, sourceSize, &width, &height, &channels_in_file, 4);
 		if (data == nullptr)
 		{
 			m_errorString.push(stbi_failure_reason());
-			return;
+			return false;
 		}
 		OutTexture->Data = (void*)data;
 		OutTexture->Format = DXGI_FORMAT_R8G8B8A8_UNORM;
@@ -331,6 +373,7 @@ void Utility::TextureImporter::LoadTexture(Texture* OutTexture)
 	OutTexture->Height = height;
 	
 	GetSurfaceInfo(width, height, OutTexture->Format, &OutTexture->NumBytes, &OutTexture->RowBytes, &OutTexture->NumRows);
+	return true;
 }
 
 void Utility::TextureImporter::CreateDefaultTexture(Texture* OutTexture, uint64 InWidth, uint32 InHeight)
@@ -339,7 +382,7 @@ void Utility::TextureImporter::CreateDefaultTexture(Texture* OutTexture, uint64
 	OutTexture->Height = InHeight;
 	OutTexture->Format = DXGI_FORMAT_R8G8B8A8_UNORM;
 
-	byte* data = new byte[InWidth * InHeight * 4];
+	byte* data = (byte*)malloc(InWidth * InHeight * 4);
 	// Create Data.
 	for (uint32 i = 0; i < InHeight; ++i)
 	{
@@ -364,3 +407,89 @@ void Utility::TextureImporter::CreateDefaultTexture(Texture* OutTexture, uint64
 
 	GetSurfaceInfo(InWidth, InHeight, OutTexture->Format, &OutTexture->NumBytes, &OutTexture->RowBytes, &OutTexture->NumRows);
 }
+
+std::string Utility::TextureImporter::GetLastError() const
+{
+	return m_errorString.empty() ? std::string() : m_errorString.back();
+}
+
+std::string Utility::TextureImporter::GetCookedPath(const std::string& InSourcePath)
+{
+	return InSourcePath + ".jtex";
+}
+
+bool Utility::TextureImporter::SaveCooked(const std::string& InPath, uint64 InSourceHash, uint64 InSourceSize, const Texture& InTexture)
+{
+	if (InTexture.Data == nullptr)
+		return false;
+
+	CookedHeader header = {};
+	header.Magic = kCookedMagic;
+	header.Version = CookedVersion;
+	header.SourceHash = InSourceHash;
+	header.SourceSize = InSourceSize;
+	header.bIsHDR = InTexture.bIsHDR ? 1 : 0;
+	header.Format = (uint32)InTexture.Format;
+	header.Width = InTexture.Width;
+	header.Height = InTexture.Height;
+	header.NumBytes = InTexture.NumBytes;
+
+	// Only ever renamed over the old one once complete.
+	const std::string tempPath = InPath + ".tmp";
+	std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(static_cast<const char*>(InTexture.Data), (std::streamsize)InTexture.NumBytes);
+	file.close();
+
+	bool bSucceeded = !file.fail();
+	if (bSucceeded)
+	{
+		std::remove(InPath.c_str());
+		bSucceeded = std::rename(tempPath.c_str(), InPath.c_str()) == 0;
+	}
+	if (!bSucceeded)
+	{
+		std::remove(tempPath.c_str());
+	}
+	return bSucceeded;
+}
+
+bool Utility::TextureImporter::LoadCooked(const std::string& InPath, uint64 InSourceHash, uint64 InSourceSize, Texture* OutTexture)
+{
+	VFSFile file;
+	if (!VirtualFileSystem::Get().ReadFile(InPath, file) || file.GetSize() < sizeof(CookedHeader))
+		return false;
+
+	CookedHeader header;
+	memcpy(&header, file.GetData(), sizeof(header));
+
+	if (header.Magic != kCookedMagic || header.Version != CookedVersion ||
+		header.SourceHash != InSourceHash || header.SourceSize != InSourceSize || header.bIsHDR != (OutTexture->bIsHDR ? 1u : 0u))
+		return false;
+
+	const DXGI_FORMAT format = (DXGI_FORMAT)header.Format;
+	if (format != DXGI_FORMAT_R8G8B8A8_UNORM && format != DXGI_FORMAT_R32G32B32A32_FLOAT)
+		return false;
+
+	size_t numBytes = 0;
+	size_t rowBytes = 0;
+	size_t numRows = 0;
+	GetSurfaceInfo((size_t)header.Width, header.Height, format, &numBytes, &rowBytes, &numRows);
+	if (numBytes != header.NumBytes || file.GetSize() - sizeof(CookedHeader) != numBytes)
+		return false;
+
+	// Allocated as stb_image does, Texture::Free does not know where its pixels came from.
+	void* data = malloc(numBytes);
+	if (data == nullptr)
+		return false;
+	memcpy(data, file.GetData() + sizeof(CookedHeader), numBytes);
+
+	OutTexture->Data = data;
+	OutTexture->Format = format;
+	OutTexture->Width = header.Width;
+	OutTexture->Height = header.Height;
+	OutTexture->NumBytes = numBytes;
+	OutTexture->RowBytes = rowBytes;
+	OutTexture->NumRows = numRows;
+	return true;
+}
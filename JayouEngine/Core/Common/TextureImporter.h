@@ -6,6 +6,7 @@
 
 #include "Utility.h"
 #include "Interface/IObject.h"
+#include <cstdlib>
 
 using namespace Core;
 
@@ -24,7 +25,8 @@ namespace Utility
 
 		bool  bIsHDR = false;
 
-		const void* Data;
+		// malloc'd, as stb_image and LoadCooked allocate it.
+		const void* Data = nullptr;
 
 		DXGI_FORMAT Format;
 		uint64 Width;
@@ -34,22 +36,17 @@ namespace Utility
 		uint64 RowBytes;
 		uint64 NumRows;
 
+#ifdef _WINDOWS
 		ComPtr<ID3D12Resource> Resource = nullptr;
 		ComPtr<ID3D12Resource> UploadHeap = nullptr;
 
 		CD3DX12_CPU_DESCRIPTOR_HANDLE HCPUDescriptor;
 		CD3DX12_GPU_DESCRIPTOR_HANDLE HGPUDescriptor;
-
-		static int32 Count;
-
-		Texture()
-		{
-			Index = Count++;
-		}
+#endif // _WINDOWS
 
 		void Free()
 		{
-			delete Data;
+			free((void*)Data);
 			Data = nullptr;
 		}
 
@@ -66,9 +63,29 @@ namespace Utility
 	{
 	public:
 
-		void LoadTexture(Texture* OutTexture);
+		// Takes the cooked texture of the source when there is a current one, decodes the source otherwise. Both are read
+		// through the VirtualFileSystem.
+		bool LoadTexture(Texture* OutTexture);
 		void CreateDefaultTexture(Texture* OutTexture, uint64 InWidth, uint32 InHeight);
 
+		// Why the last LoadTexture failed.
+		std::string GetLastError() const;
+
+		///<summary>
+		/// .jtex, the pixels of a loaded texture as they are uploaded, written next to the source by the asset cooker.
+		/// Keyed by the hash and size of the source and by Texture::bIsHDR, it is stale as soon as one of them differs.
+		///</summary>
+		static const uint32 CookedVersion = 1;
+
+		static std::string GetCookedPath(const std::string& InSourcePath);
+
+		static bool SaveCooked(const std::string& InPath, uint64 InSourceHash, uint64 InSourceSize, const Texture& InTexture);
+
+		///<summary>
+		/// False if there is no current .jtex at InPath, OutTexture is only touched on success.
+		///</summary>
+		static bool LoadCooked(const std::string& InPath, uint64 InSourceHash, uint64 InSourceSize, Texture* OutTexture);
+
 	protected:
 
 		std::queue<std::string> m_errorString;
@@ -2,4 +2,223 @@
 // ThreadManager.cpp
 //
 
-#include "ThreadManager.h"
\ No newline at end of file
+#include "ThreadManager.h"
+
+using namespace Utility;
+using namespace Utility::ThreadManager;
+
+namespace
+{
+	// Queue of the calling thread, see JobSystem::m_queues.
+	thread_local uint32 t_queue = 0;
+
+	// Failed rounds over the queues before a worker goes to sleep.
+	const uint32 SpinsBeforeSleep = 64;
+}
+
+JobSystem& JobSystem::Get()
+{
+	static JobSystem jobSystem;
+	return jobSystem;
+}
+
+JobSystem::JobSystem()
+{
+	SetNumThreads(0);
+}
+
+JobSystem::~JobSystem()
+{
+	StopWorkers();
+}
+
+void JobSystem::SetNumThreads(uint32 InNumThreads)
+{
+	assert(t_queue == 0 && m_numQueued.load() == 0);
+
+	// At least one worker, jobs nobody waits for still have to run. hardware_concurrency may be 0 when it is not known.
+	const uint32 numThreads = InNumThreads > 0 ? InNumThreads : std::thread::hardware_concurrency();
+	const uint32 numWorkers = std::max(2u, numThreads) - 1;
+	if (numWorkers == m_workers.size())
+		return;
+
+	StopWorkers();
+	StartWorkers(numWorkers);
+}
+
+void JobSystem::StartWorkers(uint32 InNumWorkers)
+{
+	m_queues.clear();
+	for (uint32 i = 0; i <= InNumWorkers; ++i)
+	{
+		m_queues.push_back(std::make_unique<WorkQueue>());
+	}
+
+	m_bStop = false;
+	for (uint32 i = 0; i < InNumWorkers; ++i)
+	{
+		m_workers.emplace_back(&JobSystem::WorkerMain, this, i + 1);
+	}
+}
+
+void JobSystem::StopWorkers()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_bStop = true;
+	}
+	m_wake.notify_all();
+
+	for (auto& worker : m_workers)
+	{
+		worker.join();
+	}
+	m_workers.clear();
+}
+
+void JobSystem::Run(std::function<void()> InJob, JobCounter* InCounter /*= nullptr*/, JobCounter* InDependency /*= nullptr*/)
+{
+	Job job;
+	job.Function = std::move(InJob);
+	job.Counter = InCounter;
+
+	if (InCounter != nullptr)
+	{
+		InCounter->m_count++;
+	}
+
+	if (InDependency != nullptr)
+	{
+		std::lock_guard<std::mutex> lock(InDependency->m_mutex);
+		if (InDependency->m_count.load() > 0)
+		{
+			InDependency->m_continuations.push_back(std::move(job));
+			return;
+		}
+	}
+
+	Push(std::move(job));
+}
+
+void JobSystem::Wait(JobCounter& InCounter)
+{
+	while (InCounter.m_count.load() > 0)
+	{
+		if (!TryRunJob())
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	// The last Finish may still hold the lock, the counter must not go away under it.
+	std::lock_guard<std::mutex> lock(InCounter.m_mutex);
+}
+
+void JobSystem::Push(Job&& InJob)
+{
+	WorkQueue& queue = *m_queues[t_queue];
+	{
+		std::lock_guard<std::mutex> lock(queue.Mutex);
+		queue.Jobs.push_back(std::move(InJob));
+	}
+	m_numQueued++;
+
+	// Workers count themselves as sleeping before they look at m_numQueued a last time, one of the two sees the other.
+	if (m_numSleeping.load() > 0)
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_wake.notify_one();
+	}
+}
+
+bool JobSystem::TryRunJob()
+{
+	if (m_numQueued.load() == 0)
+		return false;
+
+	const uint32 numQueues = (uint32)m_queues.size();
+
+	Job job;
+	bool bFound = false;
+
+	// Own queue newest first, it is the warmest in cache. Then the oldest job of the others, the largest piece of work left.
+	{
+		WorkQueue& queue = *m_queues[t_queue];
+		std::lock_guard<std::mutex> lock(queue.Mutex);
+		if (!queue.Jobs.empty())
+		{
+			job = std::move(queue.Jobs.back());
+			queue.Jobs.pop_back();
+			bFound = true;
+		}
+	}
+
+	for (uint32 i = 1; i < numQueues && !bFound; ++i)
+	{
+		WorkQueue& queue = *m_queues[(t_queue + i) % numQueues];
+		std::lock_guard<std::mutex> lock(queue.Mutex);
+		if (!queue.Jobs.empty())
+		{
+			job = std::move(queue.Jobs.front());
+			queue.Jobs.pop_front();
+			bFound = true;
+		}
+	}
+
+	if (!bFound)
+		return false;
+
+	m_numQueued--;
+
+	job.Function();
+	if (job.Counter != nullptr)
+	{
+		Finish(*job.Counter);
+	}
+
+	return true;
+}
+
+void JobSystem::Finish(JobCounter& InCounter)
+{
+	std::vector<Job> continuations;
+	{
+		std::lock_guard<std::mutex> lock(InCounter.m_mutex);
+		if (--InCounter.m_count == 0)
+		{
+			continuations.swap(InCounter.m_continuations);
+		}
+	}
+
+	for (auto& job : continuations)
+	{
+		Push(std::move(job));
+	}
+}
+
+void JobSystem::WorkerMain(uint32 InQueue)
+{
+	t_queue = InQueue;
+
+	uint32 spins = 0;
+	while (!m_bStop.load())
+	{
+		if (TryRunJob())
+		{
+			spins = 0;
+			continue;
+		}
+
+		if (++spins < SpinsBeforeSleep)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(m_sleepMutex);
+		m_numSleeping++;
+		m_wake.wait(lock, [this]() { return m_numQueued.load() > 0 || m_bStop.load(); });
+		m_numSleeping--;
+		spins = 0;
+	}
+}
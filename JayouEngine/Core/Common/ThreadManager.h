@@ -7,27 +7,183 @@
 #include <thread>
 #include <atomic>
 #include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <functional>
 #include "TypeDef.h"
 
 namespace Utility
 {
 	namespace ThreadManager
 	{
-		class Thread
+		class JobSystem;
+		class JobCounter;
+
+		struct Job
+		{
+			std::function<void()> Function;
+			JobCounter*           Counter = nullptr;
+		};
+
+		///<summary>
+		/// Number of jobs of a group still to finish. Jobs started with JobSystem::Run after it is zero again start a new group,
+		/// the jobs given to it as a dependency run once it is zero. Must outlive its jobs, JobSystem::Wait on it before it goes.
+		///</summary>
+		class JobCounter
 		{
 		public:
 
-			template<typename TLambda>
-			void CreateThreadDetach(const TLambda& lambda)
-			{
-				m_threads.push_back(std::thread(lambda));
-				m_threads.back().detach();
-			}
+			JobCounter() = default;
+			JobCounter(const JobCounter&) = delete;
+			JobCounter& operator=(const JobCounter&) = delete;
+
+			bool IsDone() const { return m_count.load() == 0; }
 
 		private:
 
-			std::vector<std::thread> m_threads;
-			
+			friend class JobSystem;
+
+			std::atomic<int32> m_count{ 0 };
+
+			// Guards m_continuations and the last decrement, so a dependent job is never left behind.
+			std::mutex         m_mutex;
+			std::vector<Job>   m_continuations;
 		};
+
+		///<summary>
+		/// Work stealing scheduler over one worker per hardware thread but the calling one. Each worker has its own deque,
+		/// takes its newest job first and steals the oldest of the others when out of work. Threads that are not workers
+		/// share one more deque. Wait runs jobs while the counter is not done, so the caller helps instead of blocking
+		/// and jobs may start and wait for jobs of their own.
+		///</summary>
+		class JobSystem
+		{
+		public:
+
+			static JobSystem& Get();
+
+			~JobSystem();
+
+			// Workers + the calling thread.
+			uint32 GetNumThreads() const { return (uint32)m_workers.size() + 1; }
+
+			///<summary>
+			/// Restarts the workers as InNumThreads - 1 of them, at least one. 0 goes back to one per hardware thread. Only
+			/// while no job is queued or running and from a thread that is not a worker, e.g. to measure scaling.
+			///</summary>
+			void SetNumThreads(uint32 InNumThreads);
+
+			///<summary>
+			/// InCounter, if any, counts the job until it returned. With InDependency the job is queued once InDependency is done.
+			///</summary>
+			void Run(std::function<void()> InJob, JobCounter* InCounter = nullptr, JobCounter* InDependency = nullptr);
+
+			///<summary>
+			/// Runs queued jobs, of any group, until InCounter is done.
+			///</summary>
+			void Wait(JobCounter& InCounter);
+
+			///<summary>
+			/// Calls InFunc(Begin, End) over [0, InCount) in ranges of InGrainSize, on the calling thread and as many workers.
+			/// Ranges are handed out in increasing order, one at a time. Returns once every range is done.
+			///</summary>
+			template<typename TFunc>
+			void ParallelFor(uint32 InCount, uint32 InGrainSize, const TFunc& InFunc);
+
+			///<summary>
+			/// InMap(Begin, End) for every range as in ParallelFor, the results folded with InCombine in range order
+			/// starting from InIdentity, so the result does not depend on the scheduling.
+			///</summary>
+			template<typename T, typename TMap, typename TCombine>
+			T ParallelReduce(uint32 InCount, uint32 InGrainSize, const T& InIdentity, const TMap& InMap, const TCombine& InCombine);
+
+		private:
+
+			JobSystem();
+			JobSystem(const JobSystem&) = delete;
+			JobSystem& operator=(const JobSystem&) = delete;
+
+			struct WorkQueue
+			{
+				std::mutex      Mutex;
+				std::deque<Job> Jobs;
+			};
+
+			void Push(Job&& InJob);
+			bool TryRunJob();
+			void Finish(JobCounter& InCounter);
+			void WorkerMain(uint32 InQueue);
+			void StartWorkers(uint32 InNumWorkers);
+			void StopWorkers();
+
+			// 0 is shared by the threads that are not workers, worker i owns i + 1.
+			std::vector<std::unique_ptr<WorkQueue>> m_queues;
+			std::vector<std::thread>                m_workers;
+
+			std::atomic<uint32>                     m_numQueued{ 0 };
+			std::atomic<uint32>                     m_numSleeping{ 0 };
+			std::atomic<bool>                       m_bStop{ false };
+			std::mutex                              m_sleepMutex;
+			std::condition_variable                 m_wake;
+		};
+
+		template<typename TFunc>
+		void JobSystem::ParallelFor(uint32 InCount, uint32 InGrainSize, const TFunc& InFunc)
+		{
+			if (InCount == 0)
+				return;
+
+			const uint32 grainSize = InGrainSize > 0 ? InGrainSize : 1;
+			const uint32 numRanges = (InCount - 1) / grainSize + 1;
+			if (numRanges == 1)
+			{
+				InFunc(0u, InCount);
+				return;
+			}
+
+			std::atomic<uint32> next(0);
+			auto body = [&]()
+			{
+				for (uint32 r = next++; r < numRanges; r = next++)
+				{
+					const uint32 begin = r * grainSize;
+					InFunc(begin, std::min(begin + grainSize, InCount));
+				}
+			};
+
+			JobCounter counter;
+			const uint32 numJobs = std::min(numRanges, GetNumThreads()) - 1;
+			for (uint32 i = 0; i < numJobs; ++i)
+			{
+				Run(body, &counter);
+			}
+
+			body();
+			Wait(counter);
+		}
+
+		template<typename T, typename TMap, typename TCombine>
+		T JobSystem::ParallelReduce(uint32 InCount, uint32 InGrainSize, const T& InIdentity, const TMap& InMap, const TCombine& InCombine)
+		{
+			const uint32 grainSize = InGrainSize > 0 ? InGrainSize : 1;
+			const uint32 numRanges = InCount == 0 ? 0 : (InCount - 1) / grainSize + 1;
+
+			std::vector<T> results(numRanges, InIdentity);
+			ParallelFor(numRanges, 1, [&](uint32 InBegin, uint32 InEnd)
+			{
+				for (uint32 r = InBegin; r < InEnd; ++r)
+				{
+					const uint32 begin = r * grainSize;
+					results[r] = InMap(begin, std::min(begin + grainSize, InCount));
+				}
+			});
+
+			T result = InIdentity;
+			for (const T& value : results)
+			{
+				result = InCombine(result, value);
+			}
+			return result;
+		}
 	}
 }
\ No newline at end of file
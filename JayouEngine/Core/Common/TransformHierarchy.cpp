@@ -0,0 +1,353 @@
+//
+// TransformHierarchy.cpp
+//
+
+#include "TransformHierarchy.h"
+#include "ThreadManager.h"
+
+using namespace Core;
+using namespace Utility;
+using namespace Utility::GeometryManager;
+using namespace Utility::ThreadManager;
+
+namespace
+{
+	// Slots per unit of work, a level is split into chunks of this size.
+	const uint32 ChunkSize = 1024;
+
+	// Removed slots are left in place until they are this share of all slots, then Update compacts.
+	const uint32 MaxRemovedSlotsPercent = 25;
+
+	// Below this many nodes everything runs on the calling thread, handing out the chunks costs more.
+	const uint32 MinNodesForThreads = 16384;
+
+	struct Chunk
+	{
+		uint32 Begin;
+		uint32 End;
+		uint32 WaitFor; // First chunk of the level, see Update.
+	};
+}
+
+const int32 TransformHierarchy::NullNode;
+
+int32 TransformHierarchy::Insert(int32 InParent, const Matrix4& InLocal, IObject* InObject)
+{
+	assert(InParent == NullNode || m_nodeSlots[InParent] != NullNode);
+
+	int32 node;
+	if (!m_freeNodes.empty())
+	{
+		node = m_freeNodes.back();
+		m_freeNodes.pop_back();
+	}
+	else
+	{
+		node = (int32)m_nodeSlots.size();
+		m_nodeSlots.push_back(NullNode);
+		m_nodeParents.push_back(NullNode);
+		m_nodeNumChildren.push_back(0);
+		m_nodeObjects.push_back(nullptr);
+	}
+
+	m_nodeParents[node] = InParent;
+	m_nodeNumChildren[node] = 0;
+	m_nodeObjects[node] = InObject;
+	if (InParent != NullNode)
+	{
+		m_nodeNumChildren[InParent]++;
+	}
+
+	// Appended as is, Reorder moves it to its level before the next Update.
+	const uint32 slot = (uint32)m_slotNodes.size();
+	m_slotNodes.push_back(node);
+	m_slotParents.push_back(InParent == NullNode ? NullNode : m_nodeSlots[InParent]);
+	m_slotLocals.push_back(InLocal);
+	m_slotWorlds.push_back(InLocal);
+	m_slotDirty.push_back(0);
+	m_nodeSlots[node] = (int32)slot;
+
+	MarkDirty(slot);
+	m_bOrderDirty = true;
+
+	return node;
+}
+
+void TransformHierarchy::Remove(int32 InNode, bool bRemoveEmptyGroups)
+{
+	assert(m_nodeSlots[InNode] != NullNode);
+
+	const int32 parent = m_nodeParents[InNode];
+
+	const uint32 removedSlot = m_nodeSlots[InNode];
+
+	if (m_nodeNumChildren[InNode] > 0)
+	{
+		// Children are found by a scan, removing inner nodes is rare. A parent before its children keeps the levels
+		// in order, so they stay in their slots.
+		const Matrix4 local = GetLocal(InNode);
+		const int32 parentSlot = parent == NullNode ? NullNode : m_nodeSlots[parent];
+		for (uint32 slot = 0; slot < (uint32)m_slotNodes.size(); ++slot)
+		{
+			const int32 child = m_slotNodes[slot];
+			if (child == NullNode || m_nodeParents[child] != InNode)
+				continue;
+
+			m_nodeParents[child] = parent;
+			m_slotParents[slot] = parentSlot;
+			m_slotLocals[slot] = m_slotLocals[slot] * local;
+			MarkDirty(slot);
+			if (parent != NullNode)
+			{
+				m_nodeNumChildren[parent]++;
+			}
+		}
+	}
+
+	// Left in place, Update skips it until enough of them are compacted by Reorder.
+	m_slotNodes[removedSlot] = NullNode;
+	m_slotParents[removedSlot] = NullNode;
+	if (m_slotDirty[removedSlot])
+	{
+		m_slotDirty[removedSlot] = 0;
+		m_numDirty--;
+	}
+	m_numRemovedSlots++;
+
+	m_nodeSlots[InNode] = NullNode;
+	m_nodeParents[InNode] = NullNode;
+	m_nodeNumChildren[InNode] = 0;
+	m_nodeObjects[InNode] = nullptr;
+	m_freeNodes.push_back(InNode);
+
+	if (parent != NullNode)
+	{
+		m_nodeNumChildren[parent]--;
+		if (bRemoveEmptyGroups && m_nodeNumChildren[parent] == 0 && m_nodeObjects[parent] == nullptr)
+		{
+			Remove(parent, true);
+		}
+	}
+}
+
+void TransformHierarchy::SetParent(int32 InNode, int32 InParent, bool bKeepWorld)
+{
+	const int32 oldParent = m_nodeParents[InNode];
+	if (oldParent == InParent)
+		return;
+
+#if defined(_DEBUG)
+	for (int32 node = InParent; node != NullNode; node = m_nodeParents[node])
+	{
+		assert(node != InNode && "A node cannot become its own descendant.");
+	}
+#endif
+
+	if (oldParent != NullNode)
+	{
+		m_nodeNumChildren[oldParent]--;
+	}
+	if (InParent != NullNode)
+	{
+		m_nodeNumChildren[InParent]++;
+	}
+	m_nodeParents[InNode] = InParent;
+
+	// World = Local * parent World, so Local = World * inverse(parent World).
+	if (bKeepWorld)
+	{
+		const uint32 slot = m_nodeSlots[InNode];
+		m_slotLocals[slot] = InParent == NullNode ? GetWorld(InNode) : Matrix4(XMMatrixMultiply(GetWorld(InNode), XMMatrixInverse(nullptr, GetWorld(InParent))));
+	}
+
+	MarkDirty(m_nodeSlots[InNode]);
+	m_bOrderDirty = true;
+}
+
+void TransformHierarchy::SetLocal(int32 InNode, const Matrix4& InLocal)
+{
+	const uint32 slot = m_nodeSlots[InNode];
+	m_slotLocals[slot] = InLocal;
+	MarkDirty(slot);
+}
+
+void TransformHierarchy::MarkDirty(uint32 InSlot)
+{
+	if (m_slotDirty[InSlot] == 0)
+	{
+		m_slotDirty[InSlot] = 1;
+		m_numDirty++;
+	}
+}
+
+void TransformHierarchy::Reorder()
+{
+	// Depth of every node, walking up to the first node whose depth is known.
+	std::vector<int32> depths(m_nodeSlots.size(), NullNode);
+	std::vector<int32> path;
+	uint32 numLevels = 0;
+	for (int32 node : m_slotNodes)
+	{
+		if (node == NullNode)
+			continue;
+
+		int32 ancestor = node;
+		while (ancestor != NullNode && depths[ancestor] == NullNode)
+		{
+			path.push_back(ancestor);
+			ancestor = m_nodeParents[ancestor];
+		}
+
+		int32 depth = ancestor == NullNode ? -1 : depths[ancestor];
+		while (!path.empty())
+		{
+			depths[path.back()] = ++depth;
+			path.pop_back();
+		}
+
+		numLevels = std::max(numLevels, (uint32)depths[node] + 1);
+	}
+
+	// Counting sort by depth, stable so an unchanged hierarchy keeps its order.
+	m_levelStarts.assign(numLevels + 1, 0);
+	for (int32 node : m_slotNodes)
+	{
+		if (node != NullNode)
+		{
+			m_levelStarts[depths[node] + 1]++;
+		}
+	}
+	for (uint32 level = 0; level < numLevels; ++level)
+	{
+		m_levelStarts[level + 1] += m_levelStarts[level];
+	}
+
+	const uint32 numSlots = m_levelStarts.back();
+	std::vector<uint32> nextSlots(m_levelStarts.begin(), m_levelStarts.end() - 1);
+
+	std::vector<int32>   slotNodes(numSlots);
+	std::vector<Matrix4> slotLocals(numSlots);
+	std::vector<Matrix4> slotWorlds(numSlots);
+	std::vector<uint8>   slotDirty(numSlots);
+	for (uint32 oldSlot = 0; oldSlot < (uint32)m_slotNodes.size(); ++oldSlot)
+	{
+		const int32 node = m_slotNodes[oldSlot];
+		if (node == NullNode)
+			continue;
+
+		const uint32 slot = nextSlots[depths[node]]++;
+		slotNodes[slot] = node;
+		slotLocals[slot] = m_slotLocals[oldSlot];
+		slotWorlds[slot] = m_slotWorlds[oldSlot];
+		slotDirty[slot] = m_slotDirty[oldSlot];
+		m_nodeSlots[node] = (int32)slot;
+	}
+
+	std::vector<int32> slotParents(numSlots);
+	for (uint32 slot = 0; slot < numSlots; ++slot)
+	{
+		const int32 parent = m_nodeParents[slotNodes[slot]];
+		slotParents[slot] = parent == NullNode ? NullNode : m_nodeSlots[parent];
+	}
+
+	m_slotNodes.swap(slotNodes);
+	m_slotParents.swap(slotParents);
+	m_slotLocals.swap(slotLocals);
+	m_slotWorlds.swap(slotWorlds);
+	m_slotDirty.swap(slotDirty);
+
+	m_numRemovedSlots = 0;
+	m_bOrderDirty = false;
+}
+
+uint32 TransformHierarchy::Update()
+{
+	if (m_bOrderDirty || m_numRemovedSlots * 100 > (uint32)m_slotNodes.size() * MaxRemovedSlotsPercent)
+	{
+		Reorder();
+	}
+
+	m_changedNodes.clear();
+	if (m_numDirty == 0)
+		return 0;
+
+	// Chunks in level order. A chunk may start once every chunk of the previous levels is done, which is the case
+	// as soon as that many chunks are done: chunks are handed out in order and none finishes before its parents.
+	std::vector<Chunk> chunks;
+	for (uint32 level = 0; level < GetNumLevels(); ++level)
+	{
+		const uint32 waitFor = (uint32)chunks.size();
+		for (uint32 begin = m_levelStarts[level]; begin < m_levelStarts[level + 1]; begin += ChunkSize)
+		{
+			chunks.push_back({ begin, std::min(begin + ChunkSize, m_levelStarts[level + 1]), waitFor });
+		}
+	}
+
+	const uint32 numChunks = (uint32)chunks.size();
+
+	std::vector<std::vector<uint32>> changedSlots(numChunks);
+
+	std::atomic<uint32> done(0);
+	auto updateChunk = [&](uint32 InChunk)
+	{
+		const Chunk& chunk = chunks[InChunk];
+		while (done.load() < chunk.WaitFor)
+		{
+			std::this_thread::yield();
+		}
+
+		std::vector<uint32>& changed = changedSlots[InChunk];
+		for (uint32 slot = chunk.Begin; slot < chunk.End; ++slot)
+		{
+			const int32 parent = m_slotParents[slot];
+			if (parent == NullNode)
+			{
+				// Roots, and removed slots which are never dirty.
+				if (m_slotDirty[slot])
+				{
+					m_slotWorlds[slot] = m_slotLocals[slot];
+					changed.push_back(slot);
+				}
+			}
+			else if (m_slotDirty[slot] | m_slotDirty[parent])
+			{
+				m_slotWorlds[slot] = m_slotLocals[slot] * m_slotWorlds[parent];
+				m_slotDirty[slot] = 1;
+				changed.push_back(slot);
+			}
+		}
+
+		done++;
+	};
+
+	if (m_slotNodes.size() < MinNodesForThreads)
+	{
+		for (uint32 c = 0; c < numChunks; ++c)
+		{
+			updateChunk(c);
+		}
+	}
+	else
+	{
+		// One chunk per range, ranges are handed out in order so the chunks being waited for are always in progress.
+		JobSystem::Get().ParallelFor(numChunks, 1, [&](uint32 InBegin, uint32 InEnd)
+		{
+			for (uint32 c = InBegin; c < InEnd; ++c)
+			{
+				updateChunk(c);
+			}
+		});
+	}
+
+	for (const auto& changed : changedSlots)
+	{
+		for (uint32 slot : changed)
+		{
+			m_slotDirty[slot] = 0;
+			m_changedNodes.push_back(m_slotNodes[slot]);
+		}
+	}
+	m_numDirty = 0;
+
+	return (uint32)m_changedNodes.size();
+}
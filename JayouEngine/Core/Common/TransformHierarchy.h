@@ -0,0 +1,93 @@
+//
+// TransformHierarchy.h
+//
+
+#pragma once
+
+#include "Utility.h"
+#include "../Math/Math.h"
+#include "Interface/IObject.h"
+
+using namespace Math;
+
+namespace Utility
+{
+	namespace GeometryManager
+	{
+		///<summary>
+		/// Parent links with local and world matrices. Nodes are stored structure of arrays and sorted by depth,
+		/// so the parents of a level are all done before the level starts and one level can be split across threads.
+		/// Node handles are stable, slots change when a node is inserted or reparented. A removal only empties its slot.
+		/// World = Local * parent World, only the subtrees under changed locals are recomputed.
+		///</summary>
+		class TransformHierarchy
+		{
+		public:
+
+			static const int32 NullNode = -1;
+
+			///<summary>
+			/// InParent may be NullNode for a root. InObject is the owner reported back by GetObject, may be nullptr for a group.
+			///</summary>
+			int32 Insert(int32 InParent, const Matrix4& InLocal, Core::IObject* InObject = nullptr);
+
+			///<summary>
+			/// The children of InNode move up to its parent, its local folded into theirs so their world does not change.
+			/// Groups (no object) left without children are removed as well when bRemoveEmptyGroups.
+			///</summary>
+			void Remove(int32 InNode, bool bRemoveEmptyGroups = true);
+
+			///<summary>
+			/// bKeepWorld changes the local of InNode so its world stays where it is, the worlds as of the last Update.
+			/// Otherwise the local is kept and the node moves along with its new parent.
+			///</summary>
+			void SetParent(int32 InNode, int32 InParent, bool bKeepWorld = false);
+			void SetLocal(int32 InNode, const Matrix4& InLocal);
+
+			///<summary>
+			/// Recomputes the world matrices of the changed subtrees, over the job system for large hierarchies.
+			/// Returns the number of nodes whose world changed, see GetChangedNodes.
+			///</summary>
+			uint32 Update();
+
+			// Nodes whose world changed in the last Update.
+			const std::vector<int32>& GetChangedNodes() const { return m_changedNodes; }
+
+			const Matrix4& GetLocal(int32 InNode) const { return m_slotLocals[m_nodeSlots[InNode]]; }
+			const Matrix4& GetWorld(int32 InNode) const { return m_slotWorlds[m_nodeSlots[InNode]]; }
+			int32          GetParent(int32 InNode) const { return m_nodeParents[InNode]; }
+			Core::IObject* GetObject(int32 InNode) const { return m_nodeObjects[InNode]; }
+
+			uint32 GetNumNodes() const { return (uint32)(m_nodeSlots.size() - m_freeNodes.size()); }
+			uint32 GetNumLevels() const { return m_levelStarts.empty() ? 0 : (uint32)m_levelStarts.size() - 1; }
+
+		private:
+
+			// Sorts the slots by depth, stable, and drops the removed ones. Only for a new or moved node or once the removed
+			// slots pile up, a removal leaves the order as it is.
+			void Reorder();
+
+			void MarkDirty(uint32 InSlot);
+
+			// By slot, depth sorted.
+			std::vector<int32>         m_slotParents;   // Parent slot.
+			std::vector<Matrix4>       m_slotLocals;
+			std::vector<Matrix4>       m_slotWorlds;
+			std::vector<uint8>         m_slotDirty;     // Local changed, or world changed during Update.
+			std::vector<int32>         m_slotNodes;
+			std::vector<uint32>        m_levelStarts;   // Slot range of each depth, valid when !m_bOrderDirty.
+
+			// By node.
+			std::vector<int32>         m_nodeSlots;
+			std::vector<int32>         m_nodeParents;
+			std::vector<uint32>        m_nodeNumChildren;
+			std::vector<Core::IObject*> m_nodeObjects;
+			std::vector<int32>         m_freeNodes;
+
+			std::vector<int32>         m_changedNodes;
+			uint32                     m_numDirty = 0;
+			uint32                     m_numRemovedSlots = 0;
+			bool                       m_bOrderDirty = false;
+		};
+	}
+}
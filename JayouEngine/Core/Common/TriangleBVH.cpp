@@ -0,0 +1,453 @@
+//
+// TriangleBVH.cpp
+//
+
+#include "TriangleBVH.h"
+
+using namespace Utility;
+using namespace Utility::GeometryManager;
+
+namespace
+{
+	struct Box
+	{
+		XMFLOAT3 Min = { +std::numeric_limits<float>::max(), +std::numeric_limits<float>::max(), +std::numeric_limits<float>::max() };
+		XMFLOAT3 Max = { -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max() };
+
+		void Grow(const XMFLOAT3& p)
+		{
+			Min = XMFLOAT3(std::min(Min.x, p.x), std::min(Min.y, p.y), std::min(Min.z, p.z));
+			Max = XMFLOAT3(std::max(Max.x, p.x), std::max(Max.y, p.y), std::max(Max.z, p.z));
+		}
+
+		void Grow(const Box& b)
+		{
+			Min = XMFLOAT3(std::min(Min.x, b.Min.x), std::min(Min.y, b.Min.y), std::min(Min.z, b.Min.z));
+			Max = XMFLOAT3(std::max(Max.x, b.Max.x), std::max(Max.y, b.Max.y), std::max(Max.z, b.Max.z));
+		}
+
+		bool IsValid() const { return Min.x <= Max.x; }
+
+		float HalfArea() const
+		{
+			if (!IsValid())
+				return 0.0f;
+
+			float dx = Max.x - Min.x;
+			float dy = Max.y - Min.y;
+			float dz = Max.z - Min.z;
+			return dx * dy + dy * dz + dz * dx;
+		}
+	};
+
+	float Axis(const XMFLOAT3& v, uint32 axis)
+	{
+		return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+	}
+
+	XMFLOAT3 Sub(const XMFLOAT3& a, const XMFLOAT3& b) { return XMFLOAT3(a.x - b.x, a.y - b.y, a.z - b.z); }
+	XMFLOAT3 Cross(const XMFLOAT3& a, const XMFLOAT3& b) { return XMFLOAT3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x); }
+	float    Dot(const XMFLOAT3& a, const XMFLOAT3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+	// Slab test, returns the entry distance or +max on a miss.
+	float IntersectBox(const XMFLOAT3& InMin, const XMFLOAT3& InMax, const XMFLOAT3& InOrigin, const XMFLOAT3& InInvDirection, float InMaxDistance)
+	{
+		float tx0 = (InMin.x - InOrigin.x) * InInvDirection.x;
+		float tx1 = (InMax.x - InOrigin.x) * InInvDirection.x;
+		float ty0 = (InMin.y - InOrigin.y) * InInvDirection.y;
+		float ty1 = (InMax.y - InOrigin.y) * InInvDirection.y;
+		float tz0 = (InMin.z - InOrigin.z) * InInvDirection.z;
+		float tz1 = (InMax.z - InOrigin.z) * InInvDirection.z;
+
+		float tmin = std::max(std::max(std::min(tx0, tx1), std::min(ty0, ty1)), std::max(std::min(tz0, tz1), 0.0f));
+		float tmax = std::min(std::min(std::max(tx0, tx1), std::max(ty0, ty1)), std::min(std::max(tz0, tz1), InMaxDistance));
+
+		return tmin <= tmax ? tmin : std::numeric_limits<float>::max();
+	}
+
+	class BVHBuilder
+	{
+	public:
+
+		BVHBuilder(const std::vector<XMFLOAT3>& positions, const std::vector<uint32>& indices)
+		{
+			const uint32 numTriangles = (uint32)(indices.size() / 3);
+			m_primitives.resize(numTriangles);
+
+			for (uint32 i = 0; i < numTriangles; ++i)
+			{
+				Primitive& primitive = m_primitives[i];
+				for (uint32 k = 0; k < 3; ++k)
+				{
+					primitive.Bounds.Grow(positions[indices[i * 3 + k]]);
+				}
+				const Box& box = primitive.Bounds;
+				primitive.Centroid = XMFLOAT3((box.Min.x + box.Max.x) * 0.5f, (box.Min.y + box.Max.y) * 0.5f, (box.Min.z + box.Max.z) * 0.5f);
+				primitive.Triangle = i;
+			}
+		}
+
+		uint32 GetTriangle(uint32 i) const { return m_primitives[i].Triangle; }
+
+		Box CalcBounds(uint32 first, uint32 count, Box* OutCentroidBounds) const
+		{
+			Box box;
+			for (uint32 i = first; i < first + count; ++i)
+			{
+				box.Grow(m_primitives[i].Bounds);
+				OutCentroidBounds->Grow(m_primitives[i].Centroid);
+			}
+			return box;
+		}
+
+		// Returns the number of triangles that go left, 0 if the range should stay a leaf.
+		uint32 Split(uint32 first, uint32 count, const Box& nodeBounds, const Box& centroidBounds)
+		{
+			if (count <= TriangleBVH::MaxLeafTriangles)
+				return 0;
+
+			struct Bin
+			{
+				Box    Bounds;
+				uint32 Count = 0;
+			};
+
+			float  bestCost = std::numeric_limits<float>::max();
+			uint32 bestAxis = 0;
+			uint32 bestBin = 0;
+
+			// Large ranges only try the longest axis, it is nearly always the winner and a third of the cost.
+			XMFLOAT3 extent = Sub(centroidBounds.Max, centroidBounds.Min);
+			uint32 longestAxis = (extent.x >= extent.y && extent.x >= extent.z) ? 0 : (extent.y >= extent.z ? 1 : 2);
+			const bool bAllAxes = count <= LargeRange;
+
+			for (uint32 axis = 0; axis < 3; ++axis)
+			{
+				if (!bAllAxes && axis != longestAxis)
+					continue;
+
+				const float cmin = Axis(centroidBounds.Min, axis);
+				const float cmax = Axis(centroidBounds.Max, axis);
+				if (cmax <= cmin)
+					continue;
+
+				Bin bins[TriangleBVH::NumBins];
+				const float scale = TriangleBVH::NumBins / (cmax - cmin);
+				for (uint32 i = first; i < first + count; ++i)
+				{
+					uint32 b = BinIndex(Axis(m_primitives[i].Centroid, axis), cmin, scale);
+					bins[b].Bounds.Grow(m_primitives[i].Bounds);
+					bins[b].Count++;
+				}
+
+				// Sweep from the right to get the cost of every plane between bins.
+				float  rightArea[TriangleBVH::NumBins];
+				uint32 rightCount[TriangleBVH::NumBins];
+				Box    rightBox;
+				uint32 rightSum = 0;
+				for (uint32 b = TriangleBVH::NumBins - 1; b > 0; --b)
+				{
+					rightBox.Grow(bins[b].Bounds);
+					rightSum += bins[b].Count;
+					rightArea[b] = rightBox.HalfArea();
+					rightCount[b] = rightSum;
+				}
+
+				Box    leftBox;
+				uint32 leftSum = 0;
+				for (uint32 b = 0; b < TriangleBVH::NumBins - 1; ++b)
+				{
+					leftBox.Grow(bins[b].Bounds);
+					leftSum += bins[b].Count;
+
+					float cost = leftSum * leftBox.HalfArea() + rightCount[b + 1] * rightArea[b + 1];
+					if (leftSum > 0 && rightCount[b + 1] > 0 && cost < bestCost)
+					{
+						bestCost = cost;
+						bestAxis = axis;
+						bestBin = b;
+					}
+				}
+			}
+
+			// Every centroid in the same spot, no plane separates them.
+			if (bestCost == std::numeric_limits<float>::max())
+				return SplitMedian(first, count, centroidBounds);
+
+			// Traversal is about as expensive as one triangle test, small ranges may be cheaper as a leaf.
+			const float leafCost = count * nodeBounds.HalfArea();
+			const float splitCost = nodeBounds.HalfArea() + bestCost;
+			if (leafCost <= splitCost && count <= TriangleBVH::MaxLeafTriangles * 4)
+				return 0;
+
+			const float cmin = Axis(centroidBounds.Min, bestAxis);
+			const float scale = TriangleBVH::NumBins / (Axis(centroidBounds.Max, bestAxis) - cmin);
+			auto middle = std::partition(m_primitives.begin() + first, m_primitives.begin() + first + count, [&](const Primitive& primitive)
+			{
+				return BinIndex(Axis(primitive.Centroid, bestAxis), cmin, scale) <= bestBin;
+			});
+
+			return (uint32)(middle - (m_primitives.begin() + first));
+		}
+
+		// Object median on the longest centroid axis, always halves the range.
+		uint32 SplitMedian(uint32 first, uint32 count, const Box& centroidBounds)
+		{
+			XMFLOAT3 extent = Sub(centroidBounds.Max, centroidBounds.Min);
+			uint32 axis = (extent.x >= extent.y && extent.x >= extent.z) ? 0 : (extent.y >= extent.z ? 1 : 2);
+
+			auto begin = m_primitives.begin() + first;
+			std::nth_element(begin, begin + count / 2, begin + count, [&](const Primitive& a, const Primitive& b)
+			{
+				return Axis(a.Centroid, axis) < Axis(b.Centroid, axis);
+			});
+
+			return count / 2;
+		}
+
+	private:
+
+		static const uint32 LargeRange = 4096;
+
+		static uint32 BinIndex(float value, float cmin, float scale)
+		{
+			int32 b = (int32)((value - cmin) * scale);
+			return (uint32)std::min(std::max(b, 0), (int32)TriangleBVH::NumBins - 1);
+		}
+
+		// Partitioned in place, ranges stay contiguous in memory.
+		struct Primitive
+		{
+			Box      Bounds;
+			XMFLOAT3 Centroid;
+			uint32   Triangle;
+		};
+
+		std::vector<Primitive> m_primitives;
+	};
+}
+
+void TriangleBVH::Build(const std::vector<XMFLOAT3>& InPositions, const std::vector<uint32>& InIndices)
+{
+	Clear();
+
+	const uint32 numTriangles = (uint32)(InIndices.size() / 3);
+	if (numTriangles == 0)
+		return;
+
+	BVHBuilder builder(InPositions, InIndices);
+
+	struct Range
+	{
+		uint32 Node;
+		uint32 First;
+		uint32 Count;
+		uint32 Depth;
+	};
+
+	m_nodes.reserve(2 * numTriangles / MaxLeafTriangles + 1);
+	m_nodes.push_back(Node());
+
+	std::vector<Range> stack;
+	stack.push_back({ 0, 0, numTriangles, 0 });
+
+	while (!stack.empty())
+	{
+		Range range = stack.back();
+		stack.pop_back();
+
+		Box centroidBounds;
+		Box bounds = builder.CalcBounds(range.First, range.Count, &centroidBounds);
+
+		m_nodes[range.Node].BoundsMin = bounds.Min;
+		m_nodes[range.Node].BoundsMax = bounds.Max;
+
+		// Past MaxSAHDepth only halve, so the depth stays below MaxDepth for the traversal stack.
+		uint32 numLeft = 0;
+		if (range.Depth < MaxSAHDepth)
+			numLeft = builder.Split(range.First, range.Count, bounds, centroidBounds);
+		else if (range.Count > MaxLeafTriangles)
+			numLeft = builder.SplitMedian(range.First, range.Count, centroidBounds);
+
+		if (numLeft == 0)
+		{
+			m_nodes[range.Node].FirstOrLeft = range.First;
+			m_nodes[range.Node].NumTriangles = range.Count;
+			continue;
+		}
+
+		uint32 left = (uint32)m_nodes.size();
+		m_nodes.push_back(Node());
+		m_nodes.push_back(Node());
+
+		m_nodes[range.Node].FirstOrLeft = left;
+		m_nodes[range.Node].NumTriangles = 0;
+
+		stack.push_back({ left, range.First, numLeft, range.Depth + 1 });
+		stack.push_back({ left + 1, range.First + numLeft, range.Count - numLeft, range.Depth + 1 });
+	}
+
+	m_positions = InPositions;
+	m_triangleIds.resize(numTriangles);
+	m_triangles.resize(numTriangles * 3);
+	for (uint32 i = 0; i < numTriangles; ++i)
+	{
+		m_triangleIds[i] = builder.GetTriangle(i);
+		for (uint32 k = 0; k < 3; ++k)
+		{
+			m_triangles[i * 3 + k] = InIndices[m_triangleIds[i] * 3 + k];
+		}
+	}
+}
+
+void TriangleBVH::Clear()
+{
+	m_nodes.clear();
+	m_positions.clear();
+	m_triangles.clear();
+	m_triangleIds.clear();
+}
+
+bool TriangleBVH::IntersectNearest(const XMFLOAT3& InOrigin, const XMFLOAT3& InDirection, TriangleHit& OutHit, float InMaxDistance) const
+{
+	return Intersect(InOrigin, InDirection, InMaxDistance, QM_Nearest, &OutHit, nullptr) > 0;
+}
+
+bool TriangleBVH::IntersectAny(const XMFLOAT3& InOrigin, const XMFLOAT3& InDirection, float InMaxDistance) const
+{
+	return Intersect(InOrigin, InDirection, InMaxDistance, QM_Any, nullptr, nullptr) > 0;
+}
+
+uint32 TriangleBVH::IntersectAll(const XMFLOAT3& InOrigin, const XMFLOAT3& InDirection, std::vector<TriangleHit>& OutHits, float InMaxDistance) const
+{
+	OutHits.clear();
+	Intersect(InOrigin, InDirection, InMaxDistance, QM_All, nullptr, &OutHits);
+
+	std::sort(OutHits.begin(), OutHits.end(), [](const TriangleHit& a, const TriangleHit& b) { return a.Distance < b.Distance; });
+	return (uint32)OutHits.size();
+}
+
+uint32 TriangleBVH::Intersect(const XMFLOAT3& InOrigin, const XMFLOAT3& InDirection, float InMaxDistance, EQueryMode InMode,
+	TriangleHit* OutNearest, std::vector<TriangleHit>* OutAll) const
+{
+	if (m_nodes.empty())
+		return 0;
+
+	// Zero components give infinities, the slab test handles them.
+	const XMFLOAT3 invDirection(1.0f / InDirection.x, 1.0f / InDirection.y, 1.0f / InDirection.z);
+
+	uint32 numHits = 0;
+	float maxDistance = InMaxDistance;
+
+	// Node and its entry distance.
+	uint32 stack[MaxDepth];
+	float  stackDistance[MaxDepth];
+	uint32 stackSize = 0;
+
+	float troot = IntersectBox(m_nodes[0].BoundsMin, m_nodes[0].BoundsMax, InOrigin, invDirection, maxDistance);
+	if (troot == std::numeric_limits<float>::max())
+		return 0;
+	stack[stackSize] = 0;
+	stackDistance[stackSize++] = troot;
+
+	while (stackSize > 0)
+	{
+		--stackSize;
+
+		// maxDistance may have shrunk since the node was pushed.
+		if (stackDistance[stackSize] > maxDistance)
+			continue;
+
+		const Node& node = m_nodes[stack[stackSize]];
+
+		if (node.NumTriangles > 0)
+		{
+			for (uint32 i = node.FirstOrLeft; i < node.FirstOrLeft + node.NumTriangles; ++i)
+			{
+				TriangleHit hit;
+				if (!IntersectTriangle(i, InOrigin, InDirection, maxDistance, hit))
+					continue;
+
+				numHits++;
+				if (InMode == QM_Any)
+					return numHits;
+
+				if (InMode == QM_Nearest)
+				{
+					// Only closer hits matter from now on.
+					maxDistance = hit.Distance;
+					*OutNearest = hit;
+				}
+				else
+				{
+					OutAll->push_back(hit);
+				}
+			}
+			continue;
+		}
+
+		const uint32 left = node.FirstOrLeft;
+		const uint32 right = node.FirstOrLeft + 1;
+		float tleft = IntersectBox(m_nodes[left].BoundsMin, m_nodes[left].BoundsMax, InOrigin, invDirection, maxDistance);
+		float tright = IntersectBox(m_nodes[right].BoundsMin, m_nodes[right].BoundsMax, InOrigin, invDirection, maxDistance);
+
+		// Push the far child first so the near one is visited first and shrinks maxDistance.
+		const bool bLeftFirst = tleft <= tright;
+		const uint32 nearChild = bLeftFirst ? left : right;
+		const uint32 farChild = bLeftFirst ? right : left;
+		const float tnear = bLeftFirst ? tleft : tright;
+		const float tfar = bLeftFirst ? tright : tleft;
+
+		// At most one entry per level stays on the stack, Build keeps the depth below MaxDepth.
+		if (tfar != std::numeric_limits<float>::max())
+		{
+			stack[stackSize] = farChild;
+			stackDistance[stackSize++] = tfar;
+		}
+		if (tnear != std::numeric_limits<float>::max())
+		{
+			stack[stackSize] = nearChild;
+			stackDistance[stackSize++] = tnear;
+		}
+	}
+
+	return numHits;
+}
+
+bool TriangleBVH::IntersectTriangle(uint32 InTriangle, const XMFLOAT3& InOrigin, const XMFLOAT3& InDirection, float InMaxDistance, TriangleHit& OutHit) const
+{
+	// Moller-Trumbore.
+	const XMFLOAT3& p0 = m_positions[m_triangles[InTriangle * 3 + 0]];
+	const XMFLOAT3& p1 = m_positions[m_triangles[InTriangle * 3 + 1]];
+	const XMFLOAT3& p2 = m_positions[m_triangles[InTriangle * 3 + 2]];
+
+	XMFLOAT3 e1 = Sub(p1, p0);
+	XMFLOAT3 e2 = Sub(p2, p0);
+	XMFLOAT3 p = Cross(InDirection, e2);
+
+	float det = Dot(e1, p);
+	if (std::abs(det) < 1e-12f)
+		return false;
+
+	float invDet = 1.0f / det;
+	XMFLOAT3 s = Sub(InOrigin, p0);
+
+	float u = Dot(s, p) * invDet;
+	if (u < 0.0f || u > 1.0f)
+		return false;
+
+	XMFLOAT3 q = Cross(s, e1);
+	float v = Dot(InDirection, q) * invDet;
+	if (v < 0.0f || u + v > 1.0f)
+		return false;
+
+	float t = Dot(e2, q) * invDet;
+	if (t < 0.0f || t >= InMaxDistance)
+		return false;
+
+	OutHit.Distance = t;
+	OutHit.Triangle = m_triangleIds[InTriangle];
+	OutHit.U = u;
+	OutHit.V = v;
+	return true;
+}
@@ -0,0 +1,120 @@
+//
+// TriangleBVH.h
+//
+
+#pragma once
+
+#include "Utility.h"
+
+using namespace DirectX;
+
+namespace Core
+{
+	class MeshCache;
+}
+
+namespace Utility
+{
+	namespace GeometryManager
+	{
+		struct TriangleHit
+		{
+			// In units of the ray direction.
+			float  Distance = 0.0f;
+
+			// Index of the triangle in the source index buffer (first index / 3).
+			uint32 Triangle = 0;
+
+			// Barycentrics of the second and third vertex.
+			float  U = 0.0f;
+			float  V = 0.0f;
+		};
+
+		///<summary>
+		/// Binned SAH bounding volume hierarchy over the triangles of one mesh, in object space.
+		/// Keeps its own compact copy of the positions, so it does not depend on the source buffers.
+		///</summary>
+		class TriangleBVH
+		{
+		public:
+
+			static const uint32 MaxLeafTriangles = 4;
+			static const uint32 NumBins = 16;
+
+			// SAH splits stop at MaxSAHDepth, median splits finish the job within MaxDepth.
+			static const uint32 MaxSAHDepth = 64;
+			static const uint32 MaxDepth = 128;
+
+			template<typename TVertex>
+			void Build(const std::vector<TVertex>& InVertices, const std::vector<uint32>& InIndices);
+
+			void Build(const std::vector<XMFLOAT3>& InPositions, const std::vector<uint32>& InIndices);
+
+			void Clear();
+
+			bool   IsEmpty() const { return m_nodes.empty(); }
+			uint32 GetNumNodes() const { return (uint32)m_nodes.size(); }
+			uint32 GetNumTriangles() const { return (uint32)m_triangleIds.size(); }
+
+			///<summary>
+			/// Nearest hit closer than InMaxDistance. Triangles are double sided, InDirection does not need to be unit length.
+			///</summary>
+			bool IntersectNearest(const XMFLOAT3& InOrigin, const XMFLOAT3& InDirection, TriangleHit& OutHit,
+				float InMaxDistance = std::numeric_limits<float>::max()) const;
+
+			///<summary>
+			/// Any hit closer than InMaxDistance, stops at the first one found (occlusion queries).
+			///</summary>
+			bool IntersectAny(const XMFLOAT3& InOrigin, const XMFLOAT3& InDirection,
+				float InMaxDistance = std::numeric_limits<float>::max()) const;
+
+			///<summary>
+			/// Every hit closer than InMaxDistance, sorted front to back. Returns the number of hits.
+			///</summary>
+			uint32 IntersectAll(const XMFLOAT3& InOrigin, const XMFLOAT3& InDirection, std::vector<TriangleHit>& OutHits,
+				float InMaxDistance = std::numeric_limits<float>::max()) const;
+
+		private:
+
+			// Stores the arrays below as they are, see MeshCache.
+			friend class Core::MeshCache;
+
+			struct Node
+			{
+				XMFLOAT3 BoundsMin;
+				uint32   FirstOrLeft;  // Leaf: first triangle, inner: left child, the right child follows it.
+				XMFLOAT3 BoundsMax;
+				uint32   NumTriangles; // 0 for inner nodes.
+			};
+
+			enum EQueryMode
+			{
+				QM_Nearest,
+				QM_Any,
+				QM_All
+			};
+
+			uint32 Intersect(const XMFLOAT3& InOrigin, const XMFLOAT3& InDirection, float InMaxDistance, EQueryMode InMode,
+				TriangleHit* OutNearest, std::vector<TriangleHit>* OutAll) const;
+
+			bool IntersectTriangle(uint32 InTriangle, const XMFLOAT3& InOrigin, const XMFLOAT3& InDirection, float InMaxDistance, TriangleHit& OutHit) const;
+
+			std::vector<Node>     m_nodes;
+			std::vector<XMFLOAT3> m_positions;
+			std::vector<uint32>   m_triangles;   // 3 indices per triangle, in leaf order.
+			std::vector<uint32>   m_triangleIds; // Leaf order to source triangle.
+		};
+
+		template<typename TVertex>
+		void TriangleBVH::Build(const std::vector<TVertex>& InVertices, const std::vector<uint32>& InIndices)
+		{
+			std::vector<XMFLOAT3> positions(InVertices.size());
+			for (size_t i = 0; i < InVertices.size(); ++i)
+			{
+				positions[i] = InVertices[i].Position;
+			}
+
+			Build(positions, InIndices);
+		}
+	}
+}
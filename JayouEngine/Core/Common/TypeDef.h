@@ -5,10 +5,15 @@
 #pragma once
 
 #include "Platform.h"
+#ifdef _WINDOWS
 #include <comdef.h>
+#endif
 #include <cstdint>
+#include <cassert>
+#include <cstring>
 
 #include <string>
+#include <memory>
 
 #include <unordered_map>
 #include <map>
@@ -23,7 +28,9 @@
 #include <DirectXColors.h>
 #include <DirectXCollision.h>
 
-#ifdef ENGINE_EXPORTS
+#if !defined(_WINDOWS)
+#define ENGINE_API
+#elif defined(ENGINE_EXPORTS)
 #define ENGINE_API __declspec(dllexport)
 #else
 #define ENGINE_API __declspec(dllimport)
@@ -33,7 +40,9 @@
 #undef max
 
 #define NameOf(x)         #x
+#ifndef MAX_PATH
 #define MAX_PATH          260
+#endif
 
 using int8 = std::int8_t;
 using int16 = std::int16_t;
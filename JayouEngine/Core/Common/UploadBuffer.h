@@ -70,6 +70,14 @@ namespace D3DCore
 			memcpy(&mMappedData[elementIndex*mElementByteSize], &data, sizeof(TDataType));
 		}
 
+		// Structure buffer only, the elements are packed.
+		template<typename TDataType>
+		void CopyData(int elementIndex, const TDataType* data, UINT count)
+		{
+			assert(!mIsConstantBuffer && mElementByteSize == sizeof(TDataType));
+			memcpy(&mMappedData[elementIndex*mElementByteSize], data, sizeof(TDataType)*count);
+		}
+
 	private:
 
 		Microsoft::WRL::ComPtr<ID3D12Resource> mUploadBuffer;
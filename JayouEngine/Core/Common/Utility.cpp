@@ -5,7 +5,9 @@
 #include "Utility.h"
 
 #include <fstream>
+#ifdef _WINDOWS
 #include <strsafe.h> // StringCchPrintf
+#endif
 
 uint32 Utility::CalcConstantBufferByteSize(uint32 byteSize)
 {
@@ -23,6 +25,40 @@ uint32 Utility::CalcConstantBufferByteSize(uint32 byteSize)
 	return (byteSize + 255) & ~255;
 }
 
+uint64 Utility::HashMemory(const void* InData, size_t InSize, uint64 InSeed /*= 0*/)
+{
+	const uint64 prime1 = 0x9e3779b185ebca87ull;
+	const uint64 prime2 = 0xc2b2ae3d27d4eb4full;
+
+	// One multiply-rotate round per 8 bytes, the tail byte by byte.
+	const uint8* bytes = static_cast<const uint8*>(InData);
+	uint64 hash = InSeed ^ (InSize * prime1);
+
+	size_t i = 0;
+	for (; i + 8 <= InSize; i += 8)
+	{
+		uint64 word;
+		memcpy(&word, bytes + i, sizeof(word));
+		hash ^= word * prime2;
+		hash = ((hash << 31) | (hash >> 33)) * prime1;
+	}
+	for (; i < InSize; ++i)
+	{
+		hash ^= bytes[i] * prime1;
+		hash = ((hash << 11) | (hash >> 53)) * prime2;
+	}
+
+	// Final avalanche.
+	hash ^= hash >> 33;
+	hash *= prime2;
+	hash ^= hash >> 29;
+	hash *= prime1;
+	hash ^= hash >> 32;
+	return hash;
+}
+
+#ifdef _WINDOWS
+
 ComPtr<ID3DBlob> WinUtility::LoadBinary(const std::wstring& filename)
 {
 	std::ifstream fin(filename, std::ios::binary);
@@ -94,3 +130,5 @@ void WinUtility::ErrorExit(LPTSTR lpszFunction)
 	LocalFree(lpDisplayBuf);
 	ExitProcess(dw);
 }
+
+#endif // _WINDOWS
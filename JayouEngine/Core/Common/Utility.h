@@ -10,6 +10,10 @@ namespace Utility
 {
 	uint32 CalcConstantBufferByteSize(uint32 byteSize);
 
+	// 64 bits hash of InSize bytes, chain calls through InSeed to hash several ranges.
+	uint64 HashMemory(const void* InData, size_t InSize, uint64 InSeed = 0);
+
+#ifdef _WINDOWS
 	struct CD3DX12_INPUT_LAYOUT_DESC : public D3D12_INPUT_LAYOUT_DESC
 	{
 		CD3DX12_INPUT_LAYOUT_DESC() = default;
@@ -27,8 +31,10 @@ namespace Utility
 			this->NumElements = InNumElems;
 		}
 	};
+#endif // _WINDOWS
 }
 
+#ifdef _WINDOWS
 namespace WinUtility
 {
 	ComPtr<ID3DBlob> LoadBinary(const std::wstring& filename);
@@ -123,4 +129,5 @@ namespace WinUtility
 #define ReleaseCom(x) { if(x){ x->Release(); x = 0; } }
 #endif
 
-}
\ No newline at end of file
+}
+#endif // _WINDOWS
\ No newline at end of file
@@ -0,0 +1,77 @@
+//
+// VFSIOSystem.cpp
+//
+
+#include "VFSIOSystem.h"
+
+#include <cstring>
+
+using namespace Core;
+using namespace Utility;
+
+size_t VFSIOStream::Read(void* OutBuffer, size_t InSize, size_t InCount)
+{
+	if (InSize == 0)
+		return 0;
+
+	// As fread, a partial element at the end is read but not counted.
+	const size_t numBytes = (size_t)std::min<uint64>((uint64)InSize * InCount, m_file.GetSize() - m_position);
+	memcpy(OutBuffer, m_file.GetData() + m_position, numBytes);
+	m_position += numBytes;
+	return numBytes / InSize;
+}
+
+aiReturn VFSIOStream::Seek(size_t InOffset, aiOrigin InOrigin)
+{
+	// A negative offset, as from the end, wraps around to below the base.
+	size_t position = InOffset;
+	if (InOrigin == aiOrigin_CUR)
+	{
+		position += (size_t)m_position;
+	}
+	else if (InOrigin == aiOrigin_END)
+	{
+		position += (size_t)m_file.GetSize();
+	}
+
+	if (position > m_file.GetSize())
+		return aiReturn_FAILURE;
+
+	m_position = position;
+	return aiReturn_SUCCESS;
+}
+
+bool VFSIOSystem::Exists(const char* InFile) const
+{
+	return VirtualFileSystem::Get().Exists(InFile);
+}
+
+char VFSIOSystem::getOsSeparator() const
+{
+#ifdef _WIN32
+	return '\\';
+#else
+	return '/';
+#endif
+}
+
+Assimp::IOStream* VFSIOSystem::Open(const char* InFile, const char* InMode)
+{
+	if (strchr(InMode, 'w') != nullptr || strchr(InMode, 'a') != nullptr)
+		return nullptr;
+
+	VFSFile file;
+	if (!VirtualFileSystem::Get().ReadFile(InFile, file))
+		return nullptr;
+	return new VFSIOStream(std::move(file));
+}
+
+void VFSIOSystem::Close(Assimp::IOStream* InFile)
+{
+	delete InFile;
+}
+
+bool VFSIOSystem::ComparePaths(const char* InFirst, const char* InSecond) const
+{
+	return PakArchive::NormalizePath(InFirst) == PakArchive::NormalizePath(InSecond);
+}
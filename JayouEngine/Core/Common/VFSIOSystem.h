@@ -0,0 +1,58 @@
+//
+// VFSIOSystem.h
+//
+
+#pragma once
+
+#include "VirtualFileSystem.h"
+
+#include <assimp/IOSystem.hpp>
+#include <assimp/IOStream.hpp>
+
+namespace Core
+{
+	// A whole file read through the VirtualFileSystem, Read is a memcpy out of the mapping.
+	class VFSIOStream : public Assimp::IOStream
+	{
+	public:
+
+		explicit VFSIOStream(Utility::VFSFile&& InFile) : m_file(std::move(InFile)) {}
+
+		size_t Read(void* OutBuffer, size_t InSize, size_t InCount) override;
+		size_t Write(const void* InBuffer, size_t InSize, size_t InCount) override { return 0; }
+
+		///<summary>
+		/// Fails past the end of the file and before its start, the position is then left where it was.
+		///</summary>
+		aiReturn Seek(size_t InOffset, aiOrigin InOrigin) override;
+
+		size_t Tell() const override { return (size_t)m_position; }
+		size_t FileSize() const override { return (size_t)m_file.GetSize(); }
+		void Flush() override {}
+
+	private:
+
+		Utility::VFSFile m_file;
+		uint64           m_position = 0;
+	};
+
+	///<summary>
+	/// What Assimp opens, the model and everything it references next to it (.mtl, .bin, textures), comes from the
+	/// VirtualFileSystem, so a packed model imports as a loose one and a loose one is mapped instead of read through
+	/// small fread buffers. Read only, an import never writes.
+	///</summary>
+	class VFSIOSystem : public Assimp::IOSystem
+	{
+	public:
+
+		bool Exists(const char* InFile) const override;
+		char getOsSeparator() const override;
+
+		// Null for a missing file and for any write mode.
+		Assimp::IOStream* Open(const char* InFile, const char* InMode = "rb") override;
+		void Close(Assimp::IOStream* InFile) override;
+
+		// However the importer spelled them, as the VirtualFileSystem looks them up.
+		bool ComparePaths(const char* InFirst, const char* InSecond) const override;
+	};
+}
@@ -0,0 +1,233 @@
+//
+// VertexLayout.cpp
+//
+
+#include "VertexLayout.h"
+#include <DirectXPackedVector.h>
+
+using namespace Utility;
+using namespace Utility::GeometryManager;
+using namespace DirectX::PackedVector;
+
+VertexQuantization VertexCodec::CalcQuantization(const std::vector<Vertex>& InVertices)
+{
+	VertexQuantization quantization;
+
+	XMVECTOR vmin = XMVectorReplicate(+std::numeric_limits<float>::max());
+	XMVECTOR vmax = XMVectorReplicate(-std::numeric_limits<float>::max());
+	for (const auto& vertex : InVertices)
+	{
+		XMVECTOR pos = XMLoadFloat3(&vertex.Position);
+		vmin = XMVectorMin(vmin, pos);
+		vmax = XMVectorMax(vmax, pos);
+	}
+
+	if (InVertices.empty())
+	{
+		vmin = XMVectorZero();
+		vmax = XMVectorZero();
+	}
+
+	// Flat meshes keep a tiny extent on the flat axis so the divide stays finite.
+	XMStoreFloat3(&quantization.PositionScale, XMVectorMax(XMVectorSubtract(vmax, vmin), XMVectorReplicate(1e-6f)));
+	XMStoreFloat3(&quantization.PositionBias, vmin);
+
+	return quantization;
+}
+
+XMVECTOR XM_CALLCONV VertexCodec::Fetch(const Vertex& InVertex, EVertexSemantic InSemantic)
+{
+	switch (InSemantic)
+	{
+	case VS_Color:    return XMLoadFloat4(&InVertex.Color);
+	case VS_Position: return XMLoadFloat3(&InVertex.Position);
+	case VS_Normal:   return XMLoadFloat3(&InVertex.Normal);
+	case VS_Tangent:  return XMLoadFloat3(&InVertex.TangentU);
+	case VS_TexCoord: return XMLoadFloat2(&InVertex.TexC);
+	default:          return XMVectorZero();
+	}
+}
+
+void XM_CALLCONV VertexCodec::Store(FXMVECTOR InValue, EVertexSemantic InSemantic, Vertex& OutVertex)
+{
+	switch (InSemantic)
+	{
+	case VS_Color:    XMStoreFloat4(&OutVertex.Color, InValue); break;
+	case VS_Position: XMStoreFloat3(&OutVertex.Position, InValue); break;
+	case VS_Normal:   XMStoreFloat3(&OutVertex.Normal, InValue); break;
+	case VS_Tangent:  XMStoreFloat3(&OutVertex.TangentU, InValue); break;
+	case VS_TexCoord: XMStoreFloat2(&OutVertex.TexC, InValue); break;
+	default:          break;
+	}
+}
+
+void XM_CALLCONV VertexCodec::Encode(FXMVECTOR InValue, EVertexEncoding InEncoding, const VertexQuantization& InQuantization, uint8* OutData)
+{
+	// Packed vector types are not guaranteed to be aligned in the stream, go through memcpy.
+	switch (InEncoding)
+	{
+	case VE_Float2:
+	{
+		XMFLOAT2 value;
+		XMStoreFloat2(&value, InValue);
+		memcpy(OutData, &value, sizeof(value));
+		break;
+	}
+	case VE_Float3:
+	{
+		XMFLOAT3 value;
+		XMStoreFloat3(&value, InValue);
+		memcpy(OutData, &value, sizeof(value));
+		break;
+	}
+	case VE_Float4:
+	{
+		XMFLOAT4 value;
+		XMStoreFloat4(&value, InValue);
+		memcpy(OutData, &value, sizeof(value));
+		break;
+	}
+	case VE_UNorm16x4:
+	{
+		XMVECTOR scale = XMLoadFloat3(&InQuantization.PositionScale);
+		XMVECTOR bias = XMLoadFloat3(&InQuantization.PositionBias);
+
+		XMUSHORTN4 value;
+		XMStoreUShortN4(&value, XMVectorSetW(XMVectorDivide(XMVectorSubtract(InValue, bias), scale), 1.0f));
+		memcpy(OutData, &value, sizeof(value));
+		break;
+	}
+	case VE_Oct16:
+	{
+		XMSHORTN2 value;
+		XMStoreShortN2(&value, EncodeOctahedral(XMVector3Normalize(InValue)));
+		memcpy(OutData, &value, sizeof(value));
+		break;
+	}
+	case VE_Half2:
+	{
+		XMHALF2 value;
+		XMStoreHalf2(&value, InValue);
+		memcpy(OutData, &value, sizeof(value));
+		break;
+	}
+	case VE_UNorm8x4:
+	{
+		XMUBYTEN4 value;
+		XMStoreUByteN4(&value, InValue);
+		memcpy(OutData, &value, sizeof(value));
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+XMVECTOR VertexCodec::Decode(const uint8* InData, EVertexEncoding InEncoding, const VertexQuantization& InQuantization)
+{
+	switch (InEncoding)
+	{
+	case VE_Float2:
+	{
+		XMFLOAT2 value;
+		memcpy(&value, InData, sizeof(value));
+		return XMLoadFloat2(&value);
+	}
+	case VE_Float3:
+	{
+		XMFLOAT3 value;
+		memcpy(&value, InData, sizeof(value));
+		return XMLoadFloat3(&value);
+	}
+	case VE_Float4:
+	{
+		XMFLOAT4 value;
+		memcpy(&value, InData, sizeof(value));
+		return XMLoadFloat4(&value);
+	}
+	case VE_UNorm16x4:
+	{
+		XMUSHORTN4 value;
+		memcpy(&value, InData, sizeof(value));
+		return XMVectorMultiplyAdd(XMLoadUShortN4(&value), XMLoadFloat3(&InQuantization.PositionScale), XMLoadFloat3(&InQuantization.PositionBias));
+	}
+	case VE_Oct16:
+	{
+		XMSHORTN2 value;
+		memcpy(&value, InData, sizeof(value));
+		return DecodeOctahedral(XMLoadShortN2(&value));
+	}
+	case VE_Half2:
+	{
+		XMHALF2 value;
+		memcpy(&value, InData, sizeof(value));
+		return XMLoadHalf2(&value);
+	}
+	case VE_UNorm8x4:
+	{
+		XMUBYTEN4 value;
+		memcpy(&value, InData, sizeof(value));
+		return XMLoadUByteN4(&value);
+	}
+	default:
+		return XMVectorZero();
+	}
+}
+
+const char* VertexCodec::GetSemanticName(EVertexSemantic InSemantic)
+{
+	switch (InSemantic)
+	{
+	case VS_Color:    return "COLOR";
+	case VS_Position: return "POSITION";
+	case VS_Normal:   return "NORMAL";
+	case VS_Tangent:  return "TANGENT";
+	case VS_TexCoord: return "TEXCOORD";
+	default:          return "";
+	}
+}
+
+DXGI_FORMAT VertexCodec::GetFormat(EVertexEncoding InEncoding)
+{
+	switch (InEncoding)
+	{
+	case VE_Float2:    return DXGI_FORMAT_R32G32_FLOAT;
+	case VE_Float3:    return DXGI_FORMAT_R32G32B32_FLOAT;
+	case VE_Float4:    return DXGI_FORMAT_R32G32B32A32_FLOAT;
+	case VE_UNorm16x4: return DXGI_FORMAT_R16G16B16A16_UNORM;
+	case VE_Oct16:     return DXGI_FORMAT_R16G16_SNORM;
+	case VE_Half2:     return DXGI_FORMAT_R16G16_FLOAT;
+	case VE_UNorm8x4:  return DXGI_FORMAT_R8G8B8A8_UNORM;
+	default:           return DXGI_FORMAT_UNKNOWN;
+	}
+}
+
+XMVECTOR XM_CALLCONV VertexCodec::EncodeOctahedral(FXMVECTOR InNormal)
+{
+	// Project onto the octahedron |x| + |y| + |z| = 1.
+	XMVECTOR l1 = XMVector3Dot(XMVectorAbs(InNormal), g_XMOne);
+	XMVECTOR p = XMVectorDivide(InNormal, XMVectorMax(l1, g_XMEpsilon));
+
+	// The lower half folds over the diagonals onto the outer triangles of the square.
+	XMVECTOR signs = XMVectorSelect(g_XMNegativeOne, g_XMOne, XMVectorGreaterOrEqual(p, XMVectorZero()));
+	XMVECTOR folded = XMVectorMultiply(XMVectorSubtract(g_XMOne, XMVectorAbs(XMVectorSwizzle<1, 0, 2, 3>(p))), signs);
+
+	XMVECTOR bLowerHalf = XMVectorLess(XMVectorSplatZ(p), XMVectorZero());
+	return XMVectorAndInt(XMVectorSelect(p, folded, bLowerHalf), g_XMSelect1100);
+}
+
+XMVECTOR XM_CALLCONV VertexCodec::DecodeOctahedral(FXMVECTOR InEncoded)
+{
+	XMVECTOR e = XMVectorAndInt(InEncoded, g_XMSelect1100);
+	XMVECTOR absE = XMVectorAbs(e);
+
+	// z = 1 - |x| - |y|, negative on the folded half.
+	XMVECTOR z = XMVectorSubtract(XMVectorSubtract(g_XMOne, XMVectorSplatX(absE)), XMVectorSplatY(absE));
+	XMVECTOR t = XMVectorSaturate(XMVectorNegate(z));
+
+	XMVECTOR offset = XMVectorSelect(t, XMVectorNegate(t), XMVectorGreaterOrEqual(e, XMVectorZero()));
+	XMVECTOR n = XMVectorAdd(e, XMVectorAndInt(offset, g_XMSelect1100));
+	n = XMVectorSelect(n, z, g_XMSelect0010);
+
+	return XMVector3Normalize(n);
+}
@@ -0,0 +1,246 @@
+//
+// VertexLayout.h
+//
+
+#pragma once
+
+#include "GeometryManager.h"
+#include <utility>
+
+namespace Utility
+{
+	namespace GeometryManager
+	{
+		enum EVertexSemantic
+		{
+			VS_Color,
+			VS_Position,
+			VS_Normal,
+			VS_Tangent,
+			VS_TexCoord
+		};
+
+		enum EVertexEncoding
+		{
+			VE_Float2,
+			VE_Float3,
+			VE_Float4,
+			VE_UNorm16x4, // Positions quantized to the mesh bounds, see VertexQuantization.
+			VE_Oct16,     // Octahedral unit vectors.
+			VE_Half2,
+			VE_UNorm8x4
+		};
+
+		constexpr uint32 GetEncodingSize(EVertexEncoding InEncoding)
+		{
+			switch (InEncoding)
+			{
+			case VE_Float2:    return 8;
+			case VE_Float3:    return 12;
+			case VE_Float4:    return 16;
+			case VE_UNorm16x4: return 8;
+			case VE_Oct16:     return 4;
+			case VE_Half2:     return 4;
+			case VE_UNorm8x4:  return 4;
+			default:           return 0;
+			}
+		}
+
+		struct VertexAttributeDesc
+		{
+			EVertexSemantic Semantic;
+			EVertexEncoding Encoding;
+			uint32          Stream;
+		};
+
+		template<EVertexSemantic TSemantic, EVertexEncoding TEncoding, uint32 TStream = 0>
+		struct VertexAttribute
+		{
+			static constexpr VertexAttributeDesc Desc() { return { TSemantic, TEncoding, TStream }; }
+		};
+
+		// Dequantization of VE_UNorm16x4 positions, PosL = Packed * PositionScale + PositionBias.
+		struct VertexQuantization
+		{
+			XMFLOAT3 PositionScale = { 1.0f, 1.0f, 1.0f };
+			XMFLOAT3 PositionBias = { 0.0f, 0.0f, 0.0f };
+		};
+
+		class VertexCodec
+		{
+		public:
+
+			///<summary>
+			/// Scale/bias mapping the bounds of the vertices to [0, 1].
+			///</summary>
+			static VertexQuantization CalcQuantization(const std::vector<Vertex>& InVertices);
+
+			static XMVECTOR XM_CALLCONV Fetch(const Vertex& InVertex, EVertexSemantic InSemantic);
+			static void XM_CALLCONV Store(FXMVECTOR InValue, EVertexSemantic InSemantic, Vertex& OutVertex);
+
+			static void XM_CALLCONV Encode(FXMVECTOR InValue, EVertexEncoding InEncoding, const VertexQuantization& InQuantization, uint8* OutData);
+			static XMVECTOR Decode(const uint8* InData, EVertexEncoding InEncoding, const VertexQuantization& InQuantization);
+
+			static const char* GetSemanticName(EVertexSemantic InSemantic);
+			static DXGI_FORMAT GetFormat(EVertexEncoding InEncoding);
+
+			///<summary>
+			/// Unit vector to the [-1, 1]^2 octahedron parameterization (xy of the result).
+			///</summary>
+			static XMVECTOR XM_CALLCONV EncodeOctahedral(FXMVECTOR InNormal);
+
+			static XMVECTOR XM_CALLCONV DecodeOctahedral(FXMVECTOR InEncoded);
+		};
+
+		///<summary>
+		/// Describes a vertex once as a list of VertexAttribute, offsets and strides are computed at compile time.
+		/// Attributes can be spread over several streams (input slots), each stream is emitted as its own buffer.
+		///</summary>
+		template<typename... TAttributes>
+		class VertexLayout
+		{
+		public:
+
+			static constexpr uint32 NumAttributes = sizeof...(TAttributes);
+
+			static constexpr VertexAttributeDesc GetAttribute(uint32 InIndex)
+			{
+				const VertexAttributeDesc attributes[] = { TAttributes::Desc()... };
+				return attributes[InIndex];
+			}
+
+			static constexpr uint32 GetNumStreams()
+			{
+				uint32 numStreams = 0;
+				for (uint32 i = 0; i < NumAttributes; ++i)
+				{
+					if (GetAttribute(i).Stream >= numStreams)
+						numStreams = GetAttribute(i).Stream + 1;
+				}
+				return numStreams;
+			}
+
+			static constexpr uint32 GetOffset(uint32 InIndex)
+			{
+				uint32 offset = 0;
+				for (uint32 i = 0; i < InIndex; ++i)
+				{
+					if (GetAttribute(i).Stream == GetAttribute(InIndex).Stream)
+						offset += GetEncodingSize(GetAttribute(i).Encoding);
+				}
+				return offset;
+			}
+
+			static constexpr uint32 GetStride(uint32 InStream)
+			{
+				uint32 stride = 0;
+				for (uint32 i = 0; i < NumAttributes; ++i)
+				{
+					if (GetAttribute(i).Stream == InStream)
+						stride += GetEncodingSize(GetAttribute(i).Encoding);
+				}
+				return stride;
+			}
+
+#ifdef _WINDOWS
+			static std::vector<D3D12_INPUT_ELEMENT_DESC> GetInputLayout()
+			{
+				std::vector<D3D12_INPUT_ELEMENT_DESC> inputLayout;
+				for (uint32 i = 0; i < NumAttributes; ++i)
+				{
+					VertexAttributeDesc attribute = GetAttribute(i);
+					inputLayout.push_back({ VertexCodec::GetSemanticName(attribute.Semantic), 0, VertexCodec::GetFormat(attribute.Encoding),
+						attribute.Stream, GetOffset(i), D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 });
+				}
+				return inputLayout;
+			}
+#endif // _WINDOWS
+
+			///<summary>
+			/// Encodes the vertices into one tightly packed byte array per stream.
+			///</summary>
+			static void EmitStreams(const std::vector<Vertex>& InVertices, const VertexQuantization& InQuantization,
+				std::vector<std::vector<uint8>>& OutStreams)
+			{
+				OutStreams.resize(GetNumStreams());
+				for (uint32 i = 0; i < GetNumStreams(); ++i)
+				{
+					OutStreams[i].resize(InVertices.size() * GetStride(i));
+				}
+
+				for (size_t i = 0; i < InVertices.size(); ++i)
+				{
+					EncodeVertex(InVertices[i], InQuantization, OutStreams, i, std::make_index_sequence<NumAttributes>());
+				}
+			}
+
+			///<summary>
+			/// Inverse of EmitStreams, semantics missing from the layout keep their Vertex defaults.
+			///</summary>
+			static void ReadStreams(const std::vector<std::vector<uint8>>& InStreams, const VertexQuantization& InQuantization,
+				std::vector<Vertex>& OutVertices)
+			{
+				const size_t numVertices = InStreams.empty() ? 0 : InStreams[0].size() / GetStride(0);
+				OutVertices.resize(numVertices);
+
+				for (size_t i = 0; i < numVertices; ++i)
+				{
+					for (uint32 a = 0; a < NumAttributes; ++a)
+					{
+						VertexAttributeDesc attribute = GetAttribute(a);
+						const uint8* data = InStreams[attribute.Stream].data() + i * GetStride(attribute.Stream) + GetOffset(a);
+						VertexCodec::Store(VertexCodec::Decode(data, attribute.Encoding, InQuantization), attribute.Semantic, OutVertices[i]);
+					}
+				}
+			}
+
+		private:
+
+			template<size_t... TIndices>
+			static void EncodeVertex(const Vertex& InVertex, const VertexQuantization& InQuantization,
+				std::vector<std::vector<uint8>>& OutStreams, size_t InVertexIndex, std::index_sequence<TIndices...>)
+			{
+				int expand[] = { 0, (EncodeAttribute<(uint32)TIndices>(InVertex, InQuantization, OutStreams, InVertexIndex), 0)... };
+				(void)expand;
+			}
+
+			template<uint32 TIndex>
+			static void EncodeAttribute(const Vertex& InVertex, const VertexQuantization& InQuantization,
+				std::vector<std::vector<uint8>>& OutStreams, size_t InVertexIndex)
+			{
+				constexpr VertexAttributeDesc attribute = GetAttribute(TIndex);
+				constexpr uint32 stride = GetStride(attribute.Stream);
+				constexpr uint32 offset = GetOffset(TIndex);
+
+				uint8* data = OutStreams[attribute.Stream].data() + InVertexIndex * stride + offset;
+				VertexCodec::Encode(VertexCodec::Fetch(InVertex, attribute.Semantic), attribute.Encoding, InQuantization, data);
+			}
+		};
+
+		// Vertex, as uploaded by default.
+		using DefaultVertexLayout = VertexLayout<
+			VertexAttribute<VS_Color, VE_Float4>,
+			VertexAttribute<VS_Position, VE_Float3>,
+			VertexAttribute<VS_Normal, VE_Float3>,
+			VertexAttribute<VS_Tangent, VE_Float3>,
+			VertexAttribute<VS_TexCoord, VE_Float2>>;
+
+		// PackedVertex, see VertexPacker.
+		using PackedVertexLayout = VertexLayout<
+			VertexAttribute<VS_Position, VE_UNorm16x4>,
+			VertexAttribute<VS_Normal, VE_Oct16>,
+			VertexAttribute<VS_Tangent, VE_Oct16>,
+			VertexAttribute<VS_TexCoord, VE_Half2>,
+			VertexAttribute<VS_Color, VE_UNorm8x4>>;
+
+		// Position only streams for depth only passes, see D3DRenderData::PositionBufferGPU.
+		using PositionStreamLayout = VertexLayout<VertexAttribute<VS_Position, VE_Float3>>;
+		using PackedPositionStreamLayout = VertexLayout<VertexAttribute<VS_Position, VE_UNorm16x4>>;
+
+		static_assert(DefaultVertexLayout::GetStride(0) == sizeof(Vertex), "DefaultVertexLayout must match Vertex.");
+		static_assert(DefaultVertexLayout::GetOffset(1) == offsetof(Vertex, Position), "DefaultVertexLayout must match Vertex.");
+		static_assert(DefaultVertexLayout::GetOffset(4) == offsetof(Vertex, TexC), "DefaultVertexLayout must match Vertex.");
+		static_assert(PackedVertexLayout::GetStride(0) == sizeof(PackedVertex), "PackedVertexLayout must match PackedVertex.");
+		static_assert(PackedVertexLayout::GetOffset(4) == offsetof(PackedVertex, Color), "PackedVertexLayout must match PackedVertex.");
+	}
+}
@@ -0,0 +1,84 @@
+//
+// VertexPacker.cpp
+//
+
+#include "VertexPacker.h"
+#include "VertexLayout.h"
+
+using namespace Utility;
+using namespace Utility::GeometryManager;
+
+void VertexPacker::PackVertices(const std::vector<Vertex>& InVertices, std::vector<PackedVertex>& OutVertices,
+	XMFLOAT3& OutPositionScale, XMFLOAT3& OutPositionBias)
+{
+	VertexQuantization quantization = VertexCodec::CalcQuantization(InVertices);
+	OutPositionScale = quantization.PositionScale;
+	OutPositionBias = quantization.PositionBias;
+
+	std::vector<std::vector<uint8>> streams;
+	PackedVertexLayout::EmitStreams(InVertices, quantization, streams);
+
+	OutVertices.resize(InVertices.size());
+	memcpy(OutVertices.data(), streams[0].data(), streams[0].size());
+}
+
+void VertexPacker::UnpackVertices(const std::vector<PackedVertex>& InVertices, const XMFLOAT3& InPositionScale,
+	const XMFLOAT3& InPositionBias, std::vector<Vertex>& OutVertices)
+{
+	VertexQuantization quantization;
+	quantization.PositionScale = InPositionScale;
+	quantization.PositionBias = InPositionBias;
+
+	std::vector<std::vector<uint8>> streams(1);
+	streams[0].resize(InVertices.size() * sizeof(PackedVertex));
+	memcpy(streams[0].data(), InVertices.data(), streams[0].size());
+
+	PackedVertexLayout::ReadStreams(streams, quantization, OutVertices);
+}
+
+PackedVertexError VertexPacker::MeasureError(const std::vector<Vertex>& InVertices, const std::vector<PackedVertex>& InPackedVertices,
+	const XMFLOAT3& InPositionScale, const XMFLOAT3& InPositionBias)
+{
+	PackedVertexError error;
+
+	std::vector<Vertex> unpacked;
+	UnpackVertices(InPackedVertices, InPositionScale, InPositionBias, unpacked);
+
+	auto angleBetween = [](const XMFLOAT3& a, const XMFLOAT3& b)
+	{
+		XMVECTOR va = XMLoadFloat3(&a);
+
+		// Zero vectors have no direction to preserve.
+		if (XMVector3Equal(va, XMVectorZero()))
+			return 0.0f;
+
+		// atan2 of sine and cosine, acos of a float cosine can not tell angles under about 0.02 degrees apart.
+		XMVECTOR na = XMVector3Normalize(va);
+		XMVECTOR vb = XMLoadFloat3(&b);
+		float sinAngle = XMVectorGetX(XMVector3Length(XMVector3Cross(na, vb)));
+		float cosAngle = XMVectorGetX(XMVector3Dot(na, vb));
+		return XMConvertToDegrees(atan2f(sinAngle, cosAngle));
+	};
+
+	const size_t count = std::min(InVertices.size(), unpacked.size());
+	for (size_t i = 0; i < count; ++i)
+	{
+		const Vertex& source = InVertices[i];
+		const Vertex& result = unpacked[i];
+
+		error.Position = Math::Max(error.Position,
+			XMVectorGetX(XMVector3Length(XMVectorSubtract(XMLoadFloat3(&source.Position), XMLoadFloat3(&result.Position)))));
+
+		error.NormalAngle = Math::Max(error.NormalAngle, angleBetween(source.Normal, result.Normal));
+		error.TangentAngle = Math::Max(error.TangentAngle, angleBetween(source.TangentU, result.TangentU));
+
+		XMVECTOR texCDiff = XMVectorAbs(XMVectorSubtract(XMLoadFloat2(&source.TexC), XMLoadFloat2(&result.TexC)));
+		error.TexC = Math::Max(error.TexC, Math::Max(XMVectorGetX(texCDiff), XMVectorGetY(texCDiff)));
+
+		XMVECTOR colorDiff = XMVectorAbs(XMVectorSubtract(XMVectorSaturate(XMLoadFloat4(&source.Color)), XMLoadFloat4(&result.Color)));
+		colorDiff = XMVectorMax(XMVectorMax(XMVectorSplatX(colorDiff), XMVectorSplatY(colorDiff)), XMVectorMax(XMVectorSplatZ(colorDiff), XMVectorSplatW(colorDiff)));
+		error.Color = Math::Max(error.Color, XMVectorGetX(colorDiff));
+	}
+
+	return error;
+}
@@ -0,0 +1,44 @@
+//
+// VertexPacker.h
+//
+
+#pragma once
+
+#include "GeometryManager.h"
+
+namespace Utility
+{
+	namespace GeometryManager
+	{
+		// Worst case deviation of a packed mesh from its source.
+		struct PackedVertexError
+		{
+			float Position = 0.0f;    // Object space distance.
+			float NormalAngle = 0.0f; // Degrees.
+			float TangentAngle = 0.0f;
+			float TexC = 0.0f;
+			float Color = 0.0f;
+		};
+
+		class VertexPacker
+		{
+		public:
+
+			///<summary>
+			/// Quantizes positions to the bounds of the mesh (16 bits per axis), octahedral encodes normal and tangent,
+			/// halves the UVs and packs the color to RGBA8, see PackedVertexLayout. Returns the dequantization PosL = Packed * Scale + Bias.
+			///</summary>
+			static void PackVertices(const std::vector<Vertex>& InVertices, std::vector<PackedVertex>& OutVertices,
+				XMFLOAT3& OutPositionScale, XMFLOAT3& OutPositionBias);
+
+			static void UnpackVertices(const std::vector<PackedVertex>& InVertices, const XMFLOAT3& InPositionScale,
+				const XMFLOAT3& InPositionBias, std::vector<Vertex>& OutVertices);
+
+			///<summary>
+			/// Unpacks and compares against the source, for import reports and validation.
+			///</summary>
+			static PackedVertexError MeasureError(const std::vector<Vertex>& InVertices, const std::vector<PackedVertex>& InPackedVertices,
+				const XMFLOAT3& InPositionScale, const XMFLOAT3& InPositionBias);
+		};
+	}
+}
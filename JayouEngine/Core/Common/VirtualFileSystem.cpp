@@ -0,0 +1,563 @@
+//
+// VirtualFileSystem.cpp
+//
+
+#include "VirtualFileSystem.h"
+#include "Compression.h"
+#include "ThreadManager.h"
+#include "Utility.h"
+
+#include <cstdio>
+#include <fstream>
+#include <set>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+using namespace Utility;
+
+const uint32 PakArchive::Magic;
+const uint32 PakArchive::Version;
+const uint64 PakArchive::Alignment;
+
+namespace
+{
+	const uint32 kEmptyBucket = 0xffffffff;
+
+	// Chunks of a file hashed in parallel by HashFile.
+	const uint64 kHashChunkSize = 4 << 20;
+
+	enum EEntryCompression : uint32
+	{
+		EC_None,
+		EC_LZ4
+	};
+
+	uint64 AlignUp(uint64 InValue, uint64 InAlignment)
+	{
+		return (InValue + InAlignment - 1) / InAlignment * InAlignment;
+	}
+
+	bool StartsWith(const std::string& InString, const std::string& InPrefix)
+	{
+		return InString.size() >= InPrefix.size() && InString.compare(0, InPrefix.size(), InPrefix) == 0;
+	}
+
+	bool EndsWith(const std::string& InString, const std::string& InSuffix)
+	{
+		return InString.size() >= InSuffix.size() && InString.compare(InString.size() - InSuffix.size(), InSuffix.size(), InSuffix) == 0;
+	}
+}
+
+struct PakArchive::Header
+{
+	uint32 Magic;
+	uint32 Version;
+	uint32 NumEntries;
+	uint32 NumBuckets;    // A power of two above NumEntries, so a probe always ends on an empty bucket.
+	uint64 EntriesOffset; // Entry, by name.
+	uint64 BucketsOffset; // uint32 index of an entry or kEmptyBucket, probed linearly from NameHash.
+	uint64 NamesOffset;   // char, not terminated.
+	uint64 NamesSize;
+	uint64 DataOffset;
+	uint64 Reserved;
+};
+
+struct PakArchive::Entry
+{
+	uint64 NameHash;
+	uint64 Offset;     // From the start of the archive, a multiple of Alignment.
+	uint64 StoredSize;
+	uint64 Size;
+	uint32 NameOffset;
+	uint32 NameLength;
+	uint32 Compression; // EEntryCompression
+	uint32 Padding;
+};
+
+void VFSFile::Close()
+{
+	m_archive.reset();
+	m_loose.reset();
+	m_buffer.clear();
+	m_buffer.shrink_to_fit();
+	m_data = nullptr;
+	m_size = 0;
+}
+
+std::string PakArchive::NormalizePath(const std::string& InPath)
+{
+	std::string path;
+	path.reserve(InPath.size());
+
+	// Part by part, "." and empty ones dropped.
+	size_t begin = 0;
+	while (begin <= InPath.size())
+	{
+		size_t end = InPath.find_first_of("/\\", begin);
+		if (end == std::string::npos)
+		{
+			end = InPath.size();
+		}
+
+		const size_t length = end - begin;
+		if (length == 0 && begin == 0 && end < InPath.size())
+		{
+			// Rooted, "/usr/..." stays so.
+			path.push_back('/');
+		}
+		else if (length != 0 && !(length == 1 && InPath[begin] == '.'))
+		{
+			if (!path.empty() && path.back() != '/')
+			{
+				path.push_back('/');
+			}
+			for (size_t i = begin; i < end; ++i)
+			{
+				const char c = InPath[i];
+				path.push_back(c >= 'A' && c <= 'Z' ? (char)(c - 'A' + 'a') : c);
+			}
+		}
+		begin = end + 1;
+	}
+	return path;
+}
+
+bool PakArchive::Build(const std::string& InPakPath, const std::string& InRootDir, const std::vector<std::string>& InFiles,
+	bool bInCompress, std::string& OutError)
+{
+	struct Source
+	{
+		std::string Name;
+		std::string Path;
+	};
+
+	std::vector<Source> sources;
+	for (const auto& file : InFiles)
+	{
+		sources.push_back({ NormalizePath(file), InRootDir + "/" + file });
+	}
+	std::sort(sources.begin(), sources.end(), [](const Source& a, const Source& b) { return a.Name < b.Name; });
+	for (size_t i = 1; i < sources.size(); ++i)
+	{
+		if (sources[i].Name == sources[i - 1].Name)
+		{
+			OutError = "Two files named " + sources[i].Name;
+			return false;
+		}
+	}
+	if (sources.size() >= kEmptyBucket / 2)
+	{
+		OutError = "Too many files";
+		return false;
+	}
+
+	const uint32 numEntries = (uint32)sources.size();
+	uint32 numBuckets = 1;
+	while (numBuckets < numEntries * 2)
+	{
+		numBuckets *= 2;
+	}
+
+	std::vector<Entry> entries(numEntries);
+	std::vector<uint32> buckets(numBuckets, kEmptyBucket);
+	std::string names;
+	for (uint32 i = 0; i < numEntries; ++i)
+	{
+		const std::string& name = sources[i].Name;
+		Entry& entry = entries[i];
+		entry = {};
+		entry.NameHash = HashMemory(name.data(), name.size());
+		entry.NameOffset = (uint32)names.size();
+		entry.NameLength = (uint32)name.size();
+		names += name;
+
+		uint32 bucket = (uint32)entry.NameHash & (numBuckets - 1);
+		while (buckets[bucket] != kEmptyBucket)
+		{
+			bucket = (bucket + 1) & (numBuckets - 1);
+		}
+		buckets[bucket] = i;
+	}
+
+	Header header = {};
+	header.Magic = Magic;
+	header.Version = Version;
+	header.NumEntries = numEntries;
+	header.NumBuckets = numBuckets;
+	header.EntriesOffset = AlignUp(sizeof(Header), alignof(Entry));
+	header.BucketsOffset = header.EntriesOffset + entries.size() * sizeof(Entry);
+	header.NamesOffset = header.BucketsOffset + buckets.size() * sizeof(uint32);
+	header.NamesSize = names.size();
+	header.DataOffset = AlignUp(header.NamesOffset + header.NamesSize, Alignment);
+
+	const std::string tempPath = InPakPath + ".tmp";
+	std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+	const std::vector<char> padding((size_t)std::max<uint64>(header.DataOffset, Alignment), 0);
+	file.write(padding.data(), (std::streamsize)header.DataOffset);
+
+	// Read and compressed in parallel a batch at a time, written in name order.
+	struct Packed
+	{
+		MappedFile         Source;
+		std::vector<uint8> Compressed;
+		bool               bFailed = false;
+	};
+
+	const uint32 batchSize = ThreadManager::JobSystem::Get().GetNumThreads() * 4;
+	uint64 offset = header.DataOffset;
+	for (uint32 first = 0; first < numEntries && file.good() && OutError.empty(); first += batchSize)
+	{
+		const uint32 count = std::min(batchSize, numEntries - first);
+		std::vector<Packed> batch(count);
+
+		ThreadManager::JobSystem::Get().ParallelFor(count, 1, [&](uint32 InBegin, uint32 InEnd)
+		{
+			for (uint32 i = InBegin; i < InEnd; ++i)
+			{
+				Packed& packed = batch[i];
+				if (!packed.Source.Open(sources[first + i].Path))
+				{
+					// An empty file can not be mapped, it is an empty entry.
+					std::ifstream source(sources[first + i].Path, std::ios::binary | std::ios::ate);
+					packed.bFailed = !source || source.tellg() != 0;
+					continue;
+				}
+
+				if (!bInCompress)
+					continue;
+
+				const uint64 size = packed.Source.GetSize();
+				packed.Compressed.resize((size_t)Compression::CompressBound(size));
+				const uint64 compressedSize = Compression::Compress(packed.Source.GetData(), size, packed.Compressed.data(), packed.Compressed.size());
+				packed.Compressed.resize(compressedSize != 0 && compressedSize <= size - size / 8 ? (size_t)compressedSize : 0);
+				packed.Compressed.shrink_to_fit();
+			}
+		});
+
+		for (uint32 i = 0; i < count; ++i)
+		{
+			const Packed& packed = batch[i];
+			if (packed.bFailed)
+			{
+				OutError = "Can not read " + sources[first + i].Path;
+				break;
+			}
+
+			Entry& entry = entries[first + i];
+			entry.Offset = offset;
+			entry.Size = packed.Source.GetSize();
+			entry.Compression = packed.Compressed.empty() ? EC_None : EC_LZ4;
+			entry.StoredSize = packed.Compressed.empty() ? entry.Size : packed.Compressed.size();
+
+			const uint8* data = packed.Compressed.empty() ? packed.Source.GetData() : packed.Compressed.data();
+			file.write(reinterpret_cast<const char*>(data), (std::streamsize)entry.StoredSize);
+
+			const uint64 end = AlignUp(offset + entry.StoredSize, Alignment);
+			file.write(padding.data(), (std::streamsize)(end - offset - entry.StoredSize));
+			offset = end;
+		}
+	}
+
+	// The table of contents once every offset is known.
+	file.seekp(0);
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.seekp((std::streamoff)header.EntriesOffset);
+	file.write(reinterpret_cast<const char*>(entries.data()), (std::streamsize)(entries.size() * sizeof(Entry)));
+	file.write(reinterpret_cast<const char*>(buckets.data()), (std::streamsize)(buckets.size() * sizeof(uint32)));
+	file.write(names.data(), (std::streamsize)names.size());
+	file.close();
+
+	bool bSucceeded = OutError.empty() && !file.fail();
+	if (bSucceeded)
+	{
+		std::remove(InPakPath.c_str());
+		bSucceeded = std::rename(tempPath.c_str(), InPakPath.c_str()) == 0;
+	}
+	if (!bSucceeded)
+	{
+		std::remove(tempPath.c_str());
+		if (OutError.empty())
+		{
+			OutError = "Can not write " + InPakPath;
+		}
+	}
+	return bSucceeded;
+}
+
+bool PakArchive::Open(const std::string& InPath)
+{
+	m_header = nullptr;
+	if (!m_file.Open(InPath) || m_file.GetSize() < sizeof(Header))
+		return false;
+
+	const uint64 fileSize = m_file.GetSize();
+	const Header* header = reinterpret_cast<const Header*>(m_file.GetData());
+	const uint32 numBuckets = header->NumBuckets;
+	const bool bHeaderValid = header->Magic == Magic && header->Version == Version &&
+		numBuckets != 0 && (numBuckets & (numBuckets - 1)) == 0 && numBuckets > header->NumEntries &&
+		header->EntriesOffset % alignof(Entry) == 0 && header->EntriesOffset <= fileSize &&
+		header->NumEntries <= (fileSize - header->EntriesOffset) / sizeof(Entry) &&
+		header->BucketsOffset == header->EntriesOffset + header->NumEntries * sizeof(Entry) &&
+		numBuckets <= (fileSize - header->BucketsOffset) / sizeof(uint32) &&
+		header->NamesOffset == header->BucketsOffset + numBuckets * sizeof(uint32) &&
+		header->NamesSize <= fileSize - header->NamesOffset;
+	if (!bHeaderValid)
+	{
+		m_file.Close();
+		return false;
+	}
+
+	const Entry* entries = reinterpret_cast<const Entry*>(m_file.GetData() + header->EntriesOffset);
+	const uint32* buckets = reinterpret_cast<const uint32*>(m_file.GetData() + header->BucketsOffset);
+
+	// Everything a lookup or a read trusts is checked here once.
+	bool bValid = true;
+	for (uint32 i = 0; i < header->NumEntries && bValid; ++i)
+	{
+		const Entry& entry = entries[i];
+		bValid = (uint64)entry.NameOffset + entry.NameLength <= header->NamesSize &&
+			entry.Offset <= fileSize && entry.StoredSize <= fileSize - entry.Offset &&
+			(entry.Compression == EC_LZ4 || (entry.Compression == EC_None && entry.StoredSize == entry.Size));
+	}
+	for (uint32 i = 0; i < numBuckets && bValid; ++i)
+	{
+		bValid = buckets[i] == kEmptyBucket || buckets[i] < header->NumEntries;
+	}
+	if (!bValid)
+	{
+		m_file.Close();
+		return false;
+	}
+
+	m_header = header;
+	m_entries = entries;
+	m_buckets = buckets;
+	m_names = reinterpret_cast<const char*>(m_file.GetData() + header->NamesOffset);
+	return true;
+}
+
+const PakArchive::Entry* PakArchive::Find(const std::string& InNormalizedName) const
+{
+	if (m_header == nullptr)
+		return nullptr;
+
+	const uint64 hash = HashMemory(InNormalizedName.data(), InNormalizedName.size());
+	const uint32 mask = m_header->NumBuckets - 1;
+	for (uint32 i = 0, bucket = (uint32)hash & mask; i < m_header->NumBuckets; ++i, bucket = (bucket + 1) & mask)
+	{
+		const uint32 index = m_buckets[bucket];
+		if (index == kEmptyBucket)
+			return nullptr;
+
+		const Entry& entry = m_entries[index];
+		if (entry.NameHash == hash && entry.NameLength == InNormalizedName.size() &&
+			memcmp(m_names + entry.NameOffset, InNormalizedName.data(), entry.NameLength) == 0)
+			return &entry;
+	}
+	return nullptr;
+}
+
+bool PakArchive::Read(const std::string& InName, VFSFile& OutFile) const
+{
+	OutFile.Close();
+
+	const Entry* entry = Find(NormalizePath(InName));
+	if (entry == nullptr)
+		return false;
+
+	const uint8* stored = m_file.GetData() + entry->Offset;
+	if (entry->Compression == EC_None)
+	{
+		OutFile.m_data = stored;
+		OutFile.m_size = entry->Size;
+		return true;
+	}
+
+	std::vector<uint8> buffer((size_t)entry->Size);
+	if (!Compression::Decompress(stored, entry->StoredSize, buffer.data(), entry->Size))
+		return false;
+
+	OutFile.m_buffer = std::move(buffer);
+	OutFile.m_data = OutFile.m_buffer.data();
+	OutFile.m_size = entry->Size;
+	return true;
+}
+
+void PakArchive::ListFiles(const std::string& InDir, std::vector<std::string>& OutNames) const
+{
+	if (m_header == nullptr)
+		return;
+
+	std::string prefix = NormalizePath(InDir);
+	if (!prefix.empty() && prefix.back() != '/')
+	{
+		prefix.push_back('/');
+	}
+
+	for (uint32 i = 0; i < m_header->NumEntries; ++i)
+	{
+		const Entry& entry = m_entries[i];
+		if (entry.NameLength >= prefix.size() && memcmp(m_names + entry.NameOffset, prefix.data(), prefix.size()) == 0)
+		{
+			OutNames.emplace_back(m_names + entry.NameOffset, entry.NameLength);
+		}
+	}
+}
+
+uint32 PakArchive::GetNumEntries() const
+{
+	return m_header == nullptr ? 0 : m_header->NumEntries;
+}
+
+VirtualFileSystem& VirtualFileSystem::Get()
+{
+	static VirtualFileSystem instance;
+	return instance;
+}
+
+bool VirtualFileSystem::Mount(const std::string& InPakPath, const std::string& InMountPoint /*= ""*/)
+{
+	auto archive = std::make_shared<PakArchive>();
+	if (!archive->Open(InPakPath))
+		return false;
+
+	std::string mountPoint = InMountPoint;
+	if (mountPoint.empty())
+	{
+		const size_t separator = InPakPath.find_last_of("/\\");
+		const size_t dot = InPakPath.find_last_of('.');
+		mountPoint = InPakPath.substr(0, dot != std::string::npos && (separator == std::string::npos || dot > separator) ? dot : std::string::npos);
+	}
+	mountPoint = PakArchive::NormalizePath(mountPoint);
+	if (!mountPoint.empty() && mountPoint.back() != '/')
+	{
+		mountPoint.push_back('/');
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_mounts.insert(m_mounts.begin(), { mountPoint, archive });
+	return true;
+}
+
+void VirtualFileSystem::UnmountAll()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_mounts.clear();
+}
+
+std::vector<VirtualFileSystem::Mounted> VirtualFileSystem::GetMounts() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_mounts;
+}
+
+bool VirtualFileSystem::ReadFile(const std::string& InPath, VFSFile& OutFile) const
+{
+	OutFile.Close();
+
+	const std::vector<Mounted> mounts = GetMounts();
+	if (!mounts.empty())
+	{
+		const std::string path = PakArchive::NormalizePath(InPath);
+		for (const auto& mounted : mounts)
+		{
+			if (StartsWith(path, mounted.MountPoint) && mounted.Archive->Read(path.substr(mounted.MountPoint.size()), OutFile))
+			{
+				OutFile.m_archive = mounted.Archive;
+				return true;
+			}
+		}
+	}
+
+	auto loose = std::make_unique<MappedFile>();
+	if (!loose->Open(InPath))
+		return false;
+
+	OutFile.m_data = loose->GetData();
+	OutFile.m_size = loose->GetSize();
+	OutFile.m_loose = std::move(loose);
+	return true;
+}
+
+bool VirtualFileSystem::IsPacked(const std::string& InPath) const
+{
+	const std::string path = PakArchive::NormalizePath(InPath);
+	for (const auto& mounted : GetMounts())
+	{
+		if (StartsWith(path, mounted.MountPoint) && mounted.Archive->Contains(path.substr(mounted.MountPoint.size())))
+			return true;
+	}
+	return false;
+}
+
+bool VirtualFileSystem::Exists(const std::string& InPath) const
+{
+	if (IsPacked(InPath))
+		return true;
+
+	struct stat info = {};
+	return stat(InPath.c_str(), &info) == 0 && (info.st_mode & S_IFMT) == S_IFREG;
+}
+
+void VirtualFileSystem::GetAllFilesUnder(const std::string& InDir, std::vector<std::string>& OutFiles, const std::string& InExtension /*= ""*/) const
+{
+	std::string dir = PakArchive::NormalizePath(InDir);
+	if (!dir.empty() && dir.back() != '/')
+	{
+		dir.push_back('/');
+	}
+	const std::string extension = PakArchive::NormalizePath(InExtension);
+
+	// A file packed twice is listed once.
+	std::set<std::string> files;
+	for (const auto& mounted : GetMounts())
+	{
+		std::vector<std::string> names;
+		if (StartsWith(dir, mounted.MountPoint))
+		{
+			mounted.Archive->ListFiles(dir.substr(mounted.MountPoint.size()), names);
+		}
+		else if (StartsWith(mounted.MountPoint, dir))
+		{
+			mounted.Archive->ListFiles("", names);
+		}
+
+		for (const auto& name : names)
+		{
+			if (EndsWith(name, extension))
+			{
+				files.insert(mounted.MountPoint + name);
+			}
+		}
+	}
+	OutFiles.insert(OutFiles.end(), files.begin(), files.end());
+}
+
+uint64 Utility::HashFile(const VFSFile& InFile)
+{
+	// Chunk hashes folded in order.
+	const uint64 size = InFile.GetSize();
+	const uint32 numChunks = (uint32)((size + kHashChunkSize - 1) / kHashChunkSize);
+	return ThreadManager::JobSystem::Get().ParallelReduce<uint64>(numChunks, 1, 0,
+		[&](uint32 InBegin, uint32 InEnd)
+		{
+			const uint64 begin = InBegin * kHashChunkSize;
+			const uint64 end = std::min(InEnd * kHashChunkSize, size);
+			return HashMemory(InFile.GetData() + begin, (size_t)(end - begin));
+		},
+		[](uint64 InHash, uint64 InChunkHash)
+		{
+			return HashMemory(&InChunkHash, sizeof(InChunkHash), InHash);
+		});
+}
+
+bool Utility::HashFile(const std::string& InPath, uint64& OutHash, uint64& OutSize)
+{
+	VFSFile file;
+	if (!VirtualFileSystem::Get().ReadFile(InPath, file) || file.GetSize() == 0)
+		return false;
+
+	OutHash = HashFile(file);
+	OutSize = file.GetSize();
+	return true;
+}
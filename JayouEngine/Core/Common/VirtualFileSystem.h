@@ -0,0 +1,175 @@
+//
+// VirtualFileSystem.h
+//
+
+#pragma once
+
+#include "MappedFile.h"
+
+#include <memory>
+#include <mutex>
+
+namespace Utility
+{
+	class PakArchive;
+
+	///<summary>
+	/// A whole file read through the VirtualFileSystem. Points straight into the mapping of a loose file or of an archive
+	/// entry stored as is, owns the bytes of an entry it had to decompress. Keeps what it points into alive.
+	///</summary>
+	class VFSFile
+	{
+	public:
+
+		VFSFile() = default;
+		VFSFile(VFSFile&&) = default;
+		VFSFile& operator=(VFSFile&&) = default;
+
+		void Close();
+
+		bool         IsOpen() const { return m_data != nullptr; }
+		const uint8* GetData() const { return m_data; }
+		uint64       GetSize() const { return m_size; }
+
+		// No copy was made, the data is the mapping.
+		bool IsMapped() const { return m_data != nullptr && m_buffer.empty(); }
+
+	private:
+
+		friend class PakArchive;
+		friend class VirtualFileSystem;
+
+		std::shared_ptr<const PakArchive> m_archive;
+		std::unique_ptr<MappedFile>       m_loose;
+		std::vector<uint8>                m_buffer;
+		const uint8*                      m_data = nullptr;
+		uint64                            m_size = 0;
+	};
+
+	///<summary>
+	/// .pak, many files in one: a header, the entries, a hash table of their names, the names and then the data, every
+	/// entry aligned to Alignment. Opening maps the archive and checks the table of contents, nothing is built, a lookup
+	/// is a hash and a probe or two. Entries are stored as they are or LZ4 compressed (see Compression.h), whichever
+	/// Build found worth it. Names are relative to the packed directory, see NormalizePath.
+	///</summary>
+	class PakArchive
+	{
+	public:
+
+		static const uint32 Magic = 0x4b41504a; // "JPAK"
+		static const uint32 Version = 1;
+		static const uint64 Alignment = 64;
+
+		///<summary>
+		/// '/' separated and lower case, without "." parts or repeated separators, so a path names one entry however
+		/// it is spelled. Names are case insensitive as the files on Windows.
+		///</summary>
+		static std::string NormalizePath(const std::string& InPath);
+
+		///<summary>
+		/// Packs InFiles, relative to InRootDir, into InPakPath. bInCompress tries every entry and keeps the compressed
+		/// one where it saves at least an eighth. Written to a temporary file first, a failed build leaves no archive.
+		///</summary>
+		static bool Build(const std::string& InPakPath, const std::string& InRootDir, const std::vector<std::string>& InFiles,
+			bool bInCompress, std::string& OutError);
+
+		PakArchive() = default;
+		PakArchive(const PakArchive&) = delete;
+		PakArchive& operator=(const PakArchive&) = delete;
+
+		// False if InPath is not an archive of this Version or its table of contents is damaged.
+		bool Open(const std::string& InPath);
+
+		bool Contains(const std::string& InName) const { return Find(NormalizePath(InName)) != nullptr; }
+
+		///<summary>
+		/// False if there is no such entry or it does not decompress. OutFile points into the archive when the entry is
+		/// stored as is, the archive must outlive it (the VirtualFileSystem makes sure of that).
+		///</summary>
+		bool Read(const std::string& InName, VFSFile& OutFile) const;
+
+		// The names of the entries under InDir, all of them for an empty one.
+		void ListFiles(const std::string& InDir, std::vector<std::string>& OutNames) const;
+
+		uint32 GetNumEntries() const;
+
+		// The mapped archive, what files of entries stored as is point into.
+		const uint8* GetData() const { return m_file.GetData(); }
+		uint64       GetSize() const { return m_file.GetSize(); }
+
+	private:
+
+		struct Header;
+		struct Entry;
+
+		const Entry* Find(const std::string& InNormalizedName) const;
+
+		MappedFile    m_file;
+		const Header* m_header = nullptr;
+		const Entry*  m_entries = nullptr;
+		const uint32* m_buckets = nullptr;
+		const char*   m_names = nullptr;
+	};
+
+	///<summary>
+	/// Where the importers read their files from. A path under the mount point of an archive is looked up in it,
+	/// archives mounted later first, anything not found there is a loose file mapped from disk. Mount before the first
+	/// read, reads are thread safe and do not block each other.
+	///</summary>
+	class VirtualFileSystem
+	{
+	public:
+
+		static VirtualFileSystem& Get();
+
+		///<summary>
+		/// The files of InPakPath stand in for those under InMountPoint, by default the archive path without its
+		/// extension, so Assets.pak next to the editor is what was packed from Assets there.
+		///</summary>
+		bool Mount(const std::string& InPakPath, const std::string& InMountPoint = "");
+
+		// Reads already made keep their archives until they are closed.
+		void UnmountAll();
+
+		bool ReadFile(const std::string& InPath, VFSFile& OutFile) const;
+
+		// Whether InPath is in a mounted archive, loose files are not looked for.
+		bool IsPacked(const std::string& InPath) const;
+
+		// Packed or a loose regular file.
+		bool Exists(const std::string& InPath) const;
+
+		///<summary>
+		/// The packed files under InDir with InExtension (".png", any for an empty one), as paths under their mount
+		/// point. Read from the tables of contents in memory, loose files are not listed.
+		///</summary>
+		void GetAllFilesUnder(const std::string& InDir, std::vector<std::string>& OutFiles, const std::string& InExtension = "") const;
+
+	private:
+
+		VirtualFileSystem() = default;
+		VirtualFileSystem(const VirtualFileSystem&) = delete;
+		VirtualFileSystem& operator=(const VirtualFileSystem&) = delete;
+
+		struct Mounted
+		{
+			std::string                       MountPoint; // Normalized, with a trailing '/'.
+			std::shared_ptr<const PakArchive> Archive;
+		};
+
+		// Later mounts first. Copied under the lock, a read holds it only that long.
+		std::vector<Mounted> GetMounts() const;
+
+		mutable std::mutex   m_mutex;
+		std::vector<Mounted> m_mounts;
+	};
+
+	///<summary>
+	/// HashMemory of a whole file, hashed in chunks on the job system. The hash does not depend on the number of threads,
+	/// nor on whether the file is packed.
+	///</summary>
+	uint64 HashFile(const VFSFile& InFile);
+
+	// Read through the VirtualFileSystem, false if the file can not be read or is empty.
+	bool HashFile(const std::string& InPath, uint64& OutHash, uint64& OutSize);
+}
@@ -130,4 +130,23 @@ namespace Math
         return Matrix4( basis, translate );
     }
 
+    // Transpose(Invert(xform)) of an affine xform (W column 0, 0, 0, 1), e.g. for normals. The rows of the inverse
+    // transpose are the cross products of the basis rows over the determinant, no general 4x4 inverse needed.
+    INLINE Matrix4 AffineInverseTranspose( const Matrix4& xform )
+    {
+        Vector3 x = Vector3(xform.GetX());
+        Vector3 y = Vector3(xform.GetY());
+        Vector3 z = Vector3(xform.GetZ());
+        Vector3 t = Vector3(xform.GetW());
+
+        Vector3 yz = Cross(y, z);
+        Scalar invDet = Recip(Dot(x, yz));
+
+        Vector3 cx = yz * invDet;
+        Vector3 cy = Cross(z, x) * invDet;
+        Vector3 cz = Cross(x, y) * invDet;
+
+        return Matrix4( Vector4(cx, -Dot(cx, t)), Vector4(cy, -Dot(cy, t)), Vector4(cz, -Dot(cz, t)), Vector4(kWUnitVector) );
+    }
+
 }
\ No newline at end of file
@@ -28,7 +28,7 @@ namespace Math
 
         INLINE Vector3() {}
         INLINE Vector3( float x, float y, float z ) { m_vec = XMVectorSet(x, y, z, 1.0f); } // w = z. make it 1.0f
-		INLINE Vector3(const XMFLOAT3& v) { m_vec = XMLoadFloat3(&v); m_vec.m128_f32[3] = 1.0f; } // w = 0. make it 1.0f
+		INLINE Vector3(const XMFLOAT3& v) { m_vec = XMVectorSetW(XMLoadFloat3(&v), 1.0f); } // w = 0. make it 1.0f
         INLINE Vector3( const Vector3& v ) { m_vec = v; }
         INLINE Vector3( Scalar s ) { m_vec = s; }
         INLINE explicit Vector3( Vector4 v );
@@ -44,11 +44,7 @@ namespace Math
 
 		void RightHandToLeft()
 		{
-			float temp; 
-			m_vec.m128_f32[0] = -m_vec.m128_f32[0];
-			temp = m_vec.m128_f32[1]; 
-			m_vec.m128_f32[1] = m_vec.m128_f32[2]; 
-			m_vec.m128_f32[2] = temp;
+			m_vec = XMVectorSet(-XMVectorGetX(m_vec), XMVectorGetZ(m_vec), XMVectorGetY(m_vec), XMVectorGetW(m_vec));
 		} // Added.
 
         INLINE Scalar GetX() const { return Scalar(XMVectorSplatX(m_vec)); }
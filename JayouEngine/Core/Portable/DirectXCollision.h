@@ -0,0 +1,233 @@
+//
+// DirectXCollision.h
+// Non Windows builds only, the bounding volumes of DirectXCollision.h the portable sources use. The frustum only
+// knows boxes, tested against its six planes: conservative where the SDK also tries the box axes and edges, a box
+// found DISJOINT is outside either way.
+
+#pragma once
+
+#include "DirectXMath.h"
+
+#include <algorithm>
+
+namespace DirectX
+{
+	enum ContainmentType
+	{
+		DISJOINT = 0,
+		INTERSECTS = 1,
+		CONTAINS = 2,
+	};
+
+	struct BoundingBox;
+
+	struct BoundingSphere
+	{
+		XMFLOAT3 Center;
+		float    Radius;
+
+		BoundingSphere() : Center(0.0f, 0.0f, 0.0f), Radius(1.0f) {}
+		BoundingSphere(const XMFLOAT3& center, float radius) : Center(center), Radius(radius) {}
+
+		// Radius scaled by the largest axis scale of M.
+		void XM_CALLCONV Transform(BoundingSphere& Out, FXMMATRIX M) const
+		{
+			XMStoreFloat3(&Out.Center, XMVector3Transform(XMLoadFloat3(&Center), M));
+
+			float scale = 0.0f;
+			for (int i = 0; i < 3; ++i)
+			{
+				scale = std::max(scale, XMVectorGetX(XMVector3LengthSq(M.r[i])));
+			}
+			Out.Radius = Radius * sqrtf(scale);
+		}
+
+		ContainmentType XM_CALLCONV Contains(FXMVECTOR Point) const
+		{
+			const float distanceSq = XMVectorGetX(XMVector3LengthSq(XMVectorSubtract(Point, XMLoadFloat3(&Center))));
+			return distanceSq <= Radius * Radius ? CONTAINS : DISJOINT;
+		}
+
+		ContainmentType Contains(const BoundingSphere& sh) const
+		{
+			const float distance = XMVectorGetX(XMVector3Length(XMVectorSubtract(XMLoadFloat3(&sh.Center), XMLoadFloat3(&Center))));
+			if (Radius + sh.Radius < distance)
+				return DISJOINT;
+			return Radius - sh.Radius < distance ? INTERSECTS : CONTAINS;
+		}
+
+		bool Intersects(const BoundingSphere& sh) const { return Contains(sh) != DISJOINT; }
+
+		// Below BoundingBox.
+		ContainmentType Contains(const BoundingBox& box) const;
+		bool Intersects(const BoundingBox& box) const { return Contains(box) != DISJOINT; }
+	};
+
+	struct BoundingBox
+	{
+		static const size_t CORNER_COUNT = 8;
+
+		XMFLOAT3 Center;
+		XMFLOAT3 Extents;
+
+		BoundingBox() : Center(0.0f, 0.0f, 0.0f), Extents(1.0f, 1.0f, 1.0f) {}
+		BoundingBox(const XMFLOAT3& center, const XMFLOAT3& extents) : Center(center), Extents(extents) {}
+
+		void GetCorners(XMFLOAT3* Corners) const
+		{
+			for (size_t i = 0; i < CORNER_COUNT; ++i)
+			{
+				Corners[i] = XMFLOAT3(
+					Center.x + ((i & 1) ? Extents.x : -Extents.x),
+					Center.y + ((i & 2) ? Extents.y : -Extents.y),
+					Center.z + ((i & 4) ? Extents.z : -Extents.z));
+			}
+		}
+
+		// The box around the transformed corners.
+		void XM_CALLCONV Transform(BoundingBox& Out, FXMMATRIX M) const
+		{
+			XMFLOAT3 corners[CORNER_COUNT];
+			GetCorners(corners);
+
+			XMVECTOR vMin = XMVector3Transform(XMLoadFloat3(&corners[0]), M);
+			XMVECTOR vMax = vMin;
+			for (size_t i = 1; i < CORNER_COUNT; ++i)
+			{
+				const XMVECTOR corner = XMVector3Transform(XMLoadFloat3(&corners[i]), M);
+				vMin = XMVectorMin(vMin, corner);
+				vMax = XMVectorMax(vMax, corner);
+			}
+
+			XMStoreFloat3(&Out.Center, XMVectorScale(XMVectorAdd(vMin, vMax), 0.5f));
+			XMStoreFloat3(&Out.Extents, XMVectorScale(XMVectorSubtract(vMax, vMin), 0.5f));
+		}
+
+		ContainmentType XM_CALLCONV Contains(FXMVECTOR Point) const
+		{
+			float p[4];
+			Internal::Store(p, Point);
+			return fabsf(p[0] - Center.x) <= Extents.x && fabsf(p[1] - Center.y) <= Extents.y && fabsf(p[2] - Center.z) <= Extents.z ? CONTAINS : DISJOINT;
+		}
+
+		ContainmentType Contains(const BoundingBox& box) const
+		{
+			if (!Intersects(box))
+				return DISJOINT;
+
+			const bool bContains =
+				box.Center.x - box.Extents.x >= Center.x - Extents.x && box.Center.x + box.Extents.x <= Center.x + Extents.x &&
+				box.Center.y - box.Extents.y >= Center.y - Extents.y && box.Center.y + box.Extents.y <= Center.y + Extents.y &&
+				box.Center.z - box.Extents.z >= Center.z - Extents.z && box.Center.z + box.Extents.z <= Center.z + Extents.z;
+			return bContains ? CONTAINS : INTERSECTS;
+		}
+
+		bool Intersects(const BoundingBox& box) const
+		{
+			return fabsf(box.Center.x - Center.x) <= box.Extents.x + Extents.x &&
+				fabsf(box.Center.y - Center.y) <= box.Extents.y + Extents.y &&
+				fabsf(box.Center.z - Center.z) <= box.Extents.z + Extents.z;
+		}
+
+		static void CreateMerged(BoundingBox& Out, const BoundingBox& b1, const BoundingBox& b2)
+		{
+			const XMVECTOR c1 = XMLoadFloat3(&b1.Center), e1 = XMLoadFloat3(&b1.Extents);
+			const XMVECTOR c2 = XMLoadFloat3(&b2.Center), e2 = XMLoadFloat3(&b2.Extents);
+			const XMVECTOR vMin = XMVectorMin(XMVectorSubtract(c1, e1), XMVectorSubtract(c2, e2));
+			const XMVECTOR vMax = XMVectorMax(XMVectorAdd(c1, e1), XMVectorAdd(c2, e2));
+
+			XMStoreFloat3(&Out.Center, XMVectorScale(XMVectorAdd(vMin, vMax), 0.5f));
+			XMStoreFloat3(&Out.Extents, XMVectorScale(XMVectorSubtract(vMax, vMin), 0.5f));
+		}
+
+		static void CreateFromPoints(BoundingBox& Out, size_t Count, const XMFLOAT3* pPoints, size_t Stride)
+		{
+			const uint8_t* point = reinterpret_cast<const uint8_t*>(pPoints);
+			XMVECTOR vMin = XMLoadFloat3(pPoints);
+			XMVECTOR vMax = vMin;
+			for (size_t i = 1; i < Count; ++i)
+			{
+				const XMVECTOR p = XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(point + i * Stride));
+				vMin = XMVectorMin(vMin, p);
+				vMax = XMVectorMax(vMax, p);
+			}
+
+			XMStoreFloat3(&Out.Center, XMVectorScale(XMVectorAdd(vMin, vMax), 0.5f));
+			XMStoreFloat3(&Out.Extents, XMVectorScale(XMVectorSubtract(vMax, vMin), 0.5f));
+		}
+	};
+
+	// Disjoint when the nearest point of the box is outside, contained when the farthest one is inside.
+	inline ContainmentType BoundingSphere::Contains(const BoundingBox& box) const
+	{
+		const float d[3] = { fabsf(box.Center.x - Center.x), fabsf(box.Center.y - Center.y), fabsf(box.Center.z - Center.z) };
+		const float e[3] = { box.Extents.x, box.Extents.y, box.Extents.z };
+
+		float nearSq = 0.0f, farSq = 0.0f;
+		for (int i = 0; i < 3; ++i)
+		{
+			const float nearest = std::max(d[i] - e[i], 0.0f);
+			nearSq += nearest * nearest;
+			farSq += (d[i] + e[i]) * (d[i] + e[i]);
+		}
+
+		if (nearSq > Radius * Radius)
+			return DISJOINT;
+		return farSq <= Radius * Radius ? CONTAINS : INTERSECTS;
+	}
+
+	// Looks down +z from Origin, turned by Orientation. Slopes are x / z and y / z of the side planes.
+	struct BoundingFrustum
+	{
+		static const size_t CORNER_COUNT = 8;
+
+		XMFLOAT3 Origin;
+		XMFLOAT4 Orientation;
+
+		float    RightSlope;
+		float    LeftSlope;
+		float    TopSlope;
+		float    BottomSlope;
+		float    Near, Far;
+
+		BoundingFrustum() : Origin(0.0f, 0.0f, 0.0f), Orientation(0.0f, 0.0f, 0.0f, 1.0f),
+			RightSlope(1.0f), LeftSlope(-1.0f), TopSlope(1.0f), BottomSlope(-1.0f), Near(0.0f), Far(1.0f) {}
+		BoundingFrustum(const XMFLOAT3& origin, const XMFLOAT4& orientation, float rightSlope, float leftSlope,
+			float topSlope, float bottomSlope, float nearPlane, float farPlane) :
+			Origin(origin), Orientation(orientation), RightSlope(rightSlope), LeftSlope(leftSlope),
+			TopSlope(topSlope), BottomSlope(bottomSlope), Near(nearPlane), Far(farPlane) {}
+
+		ContainmentType Contains(const BoundingBox& box) const
+		{
+			// Outward planes in the frustum's frame, n.p + d <= 0 inside.
+			const XMFLOAT4 planes[6] =
+			{
+				XMFLOAT4(0.0f, 0.0f, -1.0f, Near),
+				XMFLOAT4(0.0f, 0.0f, 1.0f, -Far),
+				XMFLOAT4(1.0f, 0.0f, -RightSlope, 0.0f),
+				XMFLOAT4(-1.0f, 0.0f, LeftSlope, 0.0f),
+				XMFLOAT4(0.0f, 1.0f, -TopSlope, 0.0f),
+				XMFLOAT4(0.0f, -1.0f, BottomSlope, 0.0f),
+			};
+
+			const XMVECTOR orientation = XMLoadFloat4(&Orientation);
+			const XMFLOAT3 center(box.Center.x - Origin.x, box.Center.y - Origin.y, box.Center.z - Origin.z);
+
+			bool bInside = true;
+			for (const XMFLOAT4& plane : planes)
+			{
+				XMFLOAT3 n;
+				XMStoreFloat3(&n, XMVector3Rotate(XMVectorSet(plane.x, plane.y, plane.z, 0.0f), orientation));
+
+				const float distance = n.x * center.x + n.y * center.y + n.z * center.z + plane.w;
+				const float radius = fabsf(n.x) * box.Extents.x + fabsf(n.y) * box.Extents.y + fabsf(n.z) * box.Extents.z;
+				if (distance - radius > 0.0f)
+					return DISJOINT;
+				bInside &= distance + radius <= 0.0f;
+			}
+			return bInside ? CONTAINS : INTERSECTS;
+		}
+
+		bool Intersects(const BoundingBox& box) const { return Contains(box) != DISJOINT; }
+	};
+}
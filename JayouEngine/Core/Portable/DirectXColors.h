@@ -0,0 +1,26 @@
+//
+// DirectXColors.h
+// Non Windows builds only, the colors of DirectXColors.h the portable sources use.
+
+#pragma once
+
+#include "DirectXMath.h"
+
+namespace DirectX
+{
+	namespace Colors
+	{
+		static const XMVECTORF32 Black = { { 0.000000000f, 0.000000000f, 0.000000000f, 1.000000000f } };
+		static const XMVECTORF32 White = { { 1.000000000f, 1.000000000f, 1.000000000f, 1.000000000f } };
+		static const XMVECTORF32 Red = { { 1.000000000f, 0.000000000f, 0.000000000f, 1.000000000f } };
+		static const XMVECTORF32 Lime = { { 0.000000000f, 1.000000000f, 0.000000000f, 1.000000000f } };
+		static const XMVECTORF32 Green = { { 0.000000000f, 0.501960814f, 0.000000000f, 1.000000000f } };
+		static const XMVECTORF32 Blue = { { 0.000000000f, 0.000000000f, 1.000000000f, 1.000000000f } };
+		static const XMVECTORF32 Yellow = { { 1.000000000f, 1.000000000f, 0.000000000f, 1.000000000f } };
+		static const XMVECTORF32 Cyan = { { 0.000000000f, 1.000000000f, 1.000000000f, 1.000000000f } };
+		static const XMVECTORF32 Magenta = { { 1.000000000f, 0.000000000f, 1.000000000f, 1.000000000f } };
+		static const XMVECTORF32 Gray = { { 0.501960814f, 0.501960814f, 0.501960814f, 1.000000000f } };
+		static const XMVECTORF32 LightGray = { { 0.827451050f, 0.827451050f, 0.827451050f, 1.000000000f } };
+		static const XMVECTORF32 DarkGray = { { 0.662745118f, 0.662745118f, 0.662745118f, 1.000000000f } };
+	}
+}
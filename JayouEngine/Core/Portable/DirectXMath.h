@@ -0,0 +1,845 @@
+//
+// DirectXMath.h
+// Non Windows builds only (see CMakeLists.txt), the part of DirectXMath the portable sources use. Same names, same
+// conventions (row vectors, XMQuaternionMultiply(Q1, Q2) is Q2 * Q1, XMVectorExp/Log are base 2), written plainly
+// over four floats. Windows builds use the real header from the SDK.
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#if !defined(_XM_NO_INTRINSICS_) && (defined(__SSE2__) || defined(__x86_64__))
+#define _XM_SSE_INTRINSICS_
+#include <emmintrin.h>
+#if defined(__SSE4_1__)
+#define _XM_SSE4_INTRINSICS_
+#include <smmintrin.h>
+#endif
+#endif
+
+#define XM_CALLCONV
+
+namespace DirectX
+{
+	const float XM_PI = 3.141592654f;
+	const float XM_2PI = 6.283185307f;
+	const float XM_1DIVPI = 0.318309886f;
+	const float XM_1DIV2PI = 0.159154943f;
+	const float XM_PIDIV2 = 1.570796327f;
+	const float XM_PIDIV4 = 0.785398163f;
+
+	const uint32_t XM_SELECT_0 = 0x00000000;
+	const uint32_t XM_SELECT_1 = 0xFFFFFFFF;
+
+	inline float XMConvertToRadians(float fDegrees) { return fDegrees * (XM_PI / 180.0f); }
+	inline float XMConvertToDegrees(float fRadians) { return fRadians * (180.0f / XM_PI); }
+
+#if defined(_XM_SSE_INTRINSICS_)
+	typedef __m128 XMVECTOR;
+#else
+	struct XMVECTOR
+	{
+		float vector4_f32[4];
+	};
+#endif
+
+	typedef const XMVECTOR  FXMVECTOR;
+	typedef const XMVECTOR  GXMVECTOR;
+	typedef const XMVECTOR  HXMVECTOR;
+	typedef const XMVECTOR& CXMVECTOR;
+
+	struct XMVECTORF32
+	{
+		union
+		{
+			float    f[4];
+			XMVECTOR v;
+		};
+
+		operator XMVECTOR() const { return v; }
+		operator const float*() const { return f; }
+	};
+
+	struct XMVECTORU32
+	{
+		union
+		{
+			uint32_t u[4];
+			XMVECTOR v;
+		};
+
+		operator XMVECTOR() const { return v; }
+	};
+
+	struct XMVECTORI32
+	{
+		union
+		{
+			int32_t  i[4];
+			XMVECTOR v;
+		};
+
+		operator XMVECTOR() const { return v; }
+	};
+
+	static const XMVECTORF32 g_XMOne = { { 1.0f, 1.0f, 1.0f, 1.0f } };
+	static const XMVECTORF32 g_XMNegativeOne = { { -1.0f, -1.0f, -1.0f, -1.0f } };
+	static const XMVECTORF32 g_XMZero = { { 0.0f, 0.0f, 0.0f, 0.0f } };
+	static const XMVECTORF32 g_XMEpsilon = { { 1.192092896e-7f, 1.192092896e-7f, 1.192092896e-7f, 1.192092896e-7f } };
+	static const XMVECTORF32 g_XMIdentityR0 = { { 1.0f, 0.0f, 0.0f, 0.0f } };
+	static const XMVECTORF32 g_XMIdentityR1 = { { 0.0f, 1.0f, 0.0f, 0.0f } };
+	static const XMVECTORF32 g_XMIdentityR2 = { { 0.0f, 0.0f, 1.0f, 0.0f } };
+	static const XMVECTORF32 g_XMIdentityR3 = { { 0.0f, 0.0f, 0.0f, 1.0f } };
+	static const XMVECTORU32 g_XMMask3 = { { 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0x00000000 } };
+	static const XMVECTORU32 g_XMSelect1000 = { { XM_SELECT_1, XM_SELECT_0, XM_SELECT_0, XM_SELECT_0 } };
+	static const XMVECTORU32 g_XMSelect1100 = { { XM_SELECT_1, XM_SELECT_1, XM_SELECT_0, XM_SELECT_0 } };
+	static const XMVECTORU32 g_XMSelect1110 = { { XM_SELECT_1, XM_SELECT_1, XM_SELECT_1, XM_SELECT_0 } };
+	static const XMVECTORU32 g_XMSelect0010 = { { XM_SELECT_0, XM_SELECT_0, XM_SELECT_1, XM_SELECT_0 } };
+
+	struct XMMATRIX
+	{
+		XMVECTOR r[4];
+
+		XMMATRIX() = default;
+		XMMATRIX(FXMVECTOR R0, FXMVECTOR R1, FXMVECTOR R2, CXMVECTOR R3) { r[0] = R0; r[1] = R1; r[2] = R2; r[3] = R3; }
+		XMMATRIX(float m00, float m01, float m02, float m03,
+			float m10, float m11, float m12, float m13,
+			float m20, float m21, float m22, float m23,
+			float m30, float m31, float m32, float m33);
+	};
+
+	typedef const XMMATRIX& FXMMATRIX;
+	typedef const XMMATRIX& CXMMATRIX;
+
+	struct XMINT2
+	{
+		int32_t x;
+		int32_t y;
+
+		XMINT2() = default;
+		XMINT2(int32_t _x, int32_t _y) : x(_x), y(_y) {}
+	};
+
+	struct XMFLOAT2
+	{
+		float x;
+		float y;
+
+		XMFLOAT2() = default;
+		XMFLOAT2(float _x, float _y) : x(_x), y(_y) {}
+		explicit XMFLOAT2(const float* pArray) : x(pArray[0]), y(pArray[1]) {}
+	};
+
+	struct XMFLOAT3
+	{
+		float x;
+		float y;
+		float z;
+
+		XMFLOAT3() = default;
+		XMFLOAT3(float _x, float _y, float _z) : x(_x), y(_y), z(_z) {}
+		explicit XMFLOAT3(const float* pArray) : x(pArray[0]), y(pArray[1]), z(pArray[2]) {}
+	};
+
+	struct XMFLOAT4
+	{
+		float x;
+		float y;
+		float z;
+		float w;
+
+		XMFLOAT4() = default;
+		XMFLOAT4(float _x, float _y, float _z, float _w) : x(_x), y(_y), z(_z), w(_w) {}
+		explicit XMFLOAT4(const float* pArray) : x(pArray[0]), y(pArray[1]), z(pArray[2]), w(pArray[3]) {}
+	};
+
+	struct XMFLOAT4X4
+	{
+		union
+		{
+			struct
+			{
+				float _11, _12, _13, _14;
+				float _21, _22, _23, _24;
+				float _31, _32, _33, _34;
+				float _41, _42, _43, _44;
+			};
+			float m[4][4];
+		};
+
+		XMFLOAT4X4() = default;
+		XMFLOAT4X4(float m00, float m01, float m02, float m03,
+			float m10, float m11, float m12, float m13,
+			float m20, float m21, float m22, float m23,
+			float m30, float m31, float m32, float m33) :
+			_11(m00), _12(m01), _13(m02), _14(m03),
+			_21(m10), _22(m11), _23(m12), _24(m13),
+			_31(m20), _32(m21), _33(m22), _34(m23),
+			_41(m30), _42(m31), _43(m32), _44(m33) {}
+		explicit XMFLOAT4X4(const float* pArray) { memcpy(m, pArray, sizeof(m)); }
+
+		float  operator() (size_t Row, size_t Column) const { return m[Row][Column]; }
+		float& operator() (size_t Row, size_t Column) { return m[Row][Column]; }
+	};
+
+	namespace Internal
+	{
+		inline XMVECTOR Load(const float* InValues)
+		{
+#if defined(_XM_SSE_INTRINSICS_)
+			return _mm_loadu_ps(InValues);
+#else
+			XMVECTOR v;
+			memcpy(v.vector4_f32, InValues, sizeof(v.vector4_f32));
+			return v;
+#endif
+		}
+
+		inline void Store(float* OutValues, FXMVECTOR V)
+		{
+#if defined(_XM_SSE_INTRINSICS_)
+			_mm_storeu_ps(OutValues, V);
+#else
+			memcpy(OutValues, V.vector4_f32, sizeof(V.vector4_f32));
+#endif
+		}
+
+		inline XMVECTOR LoadBits(const uint32_t* InBits)
+		{
+			float values[4];
+			memcpy(values, InBits, sizeof(values));
+			return Load(values);
+		}
+
+		inline void StoreBits(uint32_t* OutBits, FXMVECTOR V)
+		{
+			float values[4];
+			Store(values, V);
+			memcpy(OutBits, values, sizeof(values));
+		}
+
+		// Component wise f(x) and f(a, b).
+		template<typename TFunction>
+		inline XMVECTOR Map(FXMVECTOR V, TFunction InFunction)
+		{
+			float v[4];
+			Store(v, V);
+			for (int i = 0; i < 4; ++i)
+			{
+				v[i] = InFunction(v[i]);
+			}
+			return Load(v);
+		}
+
+		template<typename TFunction>
+		inline XMVECTOR Map(FXMVECTOR V1, FXMVECTOR V2, TFunction InFunction)
+		{
+			float a[4], b[4];
+			Store(a, V1);
+			Store(b, V2);
+			for (int i = 0; i < 4; ++i)
+			{
+				a[i] = InFunction(a[i], b[i]);
+			}
+			return Load(a);
+		}
+
+		template<typename TFunction>
+		inline XMVECTOR MapBits(FXMVECTOR V1, FXMVECTOR V2, TFunction InFunction)
+		{
+			uint32_t a[4], b[4];
+			StoreBits(a, V1);
+			StoreBits(b, V2);
+			for (int i = 0; i < 4; ++i)
+			{
+				a[i] = InFunction(a[i], b[i]);
+			}
+			return LoadBits(a);
+		}
+
+		template<typename TFunction>
+		inline XMVECTOR Compare(FXMVECTOR V1, FXMVECTOR V2, TFunction InFunction)
+		{
+			float a[4], b[4];
+			uint32_t r[4];
+			Store(a, V1);
+			Store(b, V2);
+			for (int i = 0; i < 4; ++i)
+			{
+				r[i] = InFunction(a[i], b[i]) ? XM_SELECT_1 : XM_SELECT_0;
+			}
+			return LoadBits(r);
+		}
+	}
+
+	//
+	// Load & store.
+	//
+
+	inline XMVECTOR XM_CALLCONV XMVectorSet(float x, float y, float z, float w)
+	{
+		const float v[4] = { x, y, z, w };
+		return Internal::Load(v);
+	}
+
+	inline XMVECTOR XM_CALLCONV XMLoadFloat2(const XMFLOAT2* pSource) { return XMVectorSet(pSource->x, pSource->y, 0.0f, 0.0f); }
+	inline XMVECTOR XM_CALLCONV XMLoadFloat3(const XMFLOAT3* pSource) { return XMVectorSet(pSource->x, pSource->y, pSource->z, 0.0f); }
+	inline XMVECTOR XM_CALLCONV XMLoadFloat4(const XMFLOAT4* pSource) { return XMVectorSet(pSource->x, pSource->y, pSource->z, pSource->w); }
+
+	inline XMMATRIX XM_CALLCONV XMLoadFloat4x4(const XMFLOAT4X4* pSource)
+	{
+		XMMATRIX M;
+		for (int i = 0; i < 4; ++i)
+		{
+			M.r[i] = Internal::Load(pSource->m[i]);
+		}
+		return M;
+	}
+
+	inline void XM_CALLCONV XMStoreFloat2(XMFLOAT2* pDestination, FXMVECTOR V)
+	{
+		float v[4];
+		Internal::Store(v, V);
+		pDestination->x = v[0];
+		pDestination->y = v[1];
+	}
+
+	inline void XM_CALLCONV XMStoreFloat3(XMFLOAT3* pDestination, FXMVECTOR V)
+	{
+		float v[4];
+		Internal::Store(v, V);
+		pDestination->x = v[0];
+		pDestination->y = v[1];
+		pDestination->z = v[2];
+	}
+
+	inline void XM_CALLCONV XMStoreFloat4(XMFLOAT4* pDestination, FXMVECTOR V)
+	{
+		float v[4];
+		Internal::Store(v, V);
+		*pDestination = XMFLOAT4(v);
+	}
+
+	inline void XM_CALLCONV XMStoreFloat4x4(XMFLOAT4X4* pDestination, FXMMATRIX M)
+	{
+		for (int i = 0; i < 4; ++i)
+		{
+			Internal::Store(pDestination->m[i], M.r[i]);
+		}
+	}
+
+	inline XMMATRIX::XMMATRIX(float m00, float m01, float m02, float m03,
+		float m10, float m11, float m12, float m13,
+		float m20, float m21, float m22, float m23,
+		float m30, float m31, float m32, float m33)
+	{
+		r[0] = XMVectorSet(m00, m01, m02, m03);
+		r[1] = XMVectorSet(m10, m11, m12, m13);
+		r[2] = XMVectorSet(m20, m21, m22, m23);
+		r[3] = XMVectorSet(m30, m31, m32, m33);
+	}
+
+	//
+	// General vector.
+	//
+
+	inline XMVECTOR XM_CALLCONV XMVectorZero() { return XMVectorSet(0.0f, 0.0f, 0.0f, 0.0f); }
+	inline XMVECTOR XM_CALLCONV XMVectorReplicate(float Value) { return XMVectorSet(Value, Value, Value, Value); }
+	inline XMVECTOR XM_CALLCONV XMVectorSplatOne() { return XMVectorReplicate(1.0f); }
+
+	inline float XM_CALLCONV XMVectorGetByIndex(FXMVECTOR V, size_t i)
+	{
+		float v[4];
+		Internal::Store(v, V);
+		return v[i];
+	}
+
+	inline float XM_CALLCONV XMVectorGetX(FXMVECTOR V) { return XMVectorGetByIndex(V, 0); }
+	inline float XM_CALLCONV XMVectorGetY(FXMVECTOR V) { return XMVectorGetByIndex(V, 1); }
+	inline float XM_CALLCONV XMVectorGetZ(FXMVECTOR V) { return XMVectorGetByIndex(V, 2); }
+	inline float XM_CALLCONV XMVectorGetW(FXMVECTOR V) { return XMVectorGetByIndex(V, 3); }
+
+	inline XMVECTOR XM_CALLCONV XMVectorSetByIndex(FXMVECTOR V, float f, size_t i)
+	{
+		float v[4];
+		Internal::Store(v, V);
+		v[i] = f;
+		return Internal::Load(v);
+	}
+
+	inline XMVECTOR XM_CALLCONV XMVectorSetX(FXMVECTOR V, float x) { return XMVectorSetByIndex(V, x, 0); }
+	inline XMVECTOR XM_CALLCONV XMVectorSetY(FXMVECTOR V, float y) { return XMVectorSetByIndex(V, y, 1); }
+	inline XMVECTOR XM_CALLCONV XMVectorSetZ(FXMVECTOR V, float z) { return XMVectorSetByIndex(V, z, 2); }
+	inline XMVECTOR XM_CALLCONV XMVectorSetW(FXMVECTOR V, float w) { return XMVectorSetByIndex(V, w, 3); }
+
+	inline XMVECTOR XM_CALLCONV XMVectorSplatX(FXMVECTOR V) { return XMVectorReplicate(XMVectorGetX(V)); }
+	inline XMVECTOR XM_CALLCONV XMVectorSplatY(FXMVECTOR V) { return XMVectorReplicate(XMVectorGetY(V)); }
+	inline XMVECTOR XM_CALLCONV XMVectorSplatZ(FXMVECTOR V) { return XMVectorReplicate(XMVectorGetZ(V)); }
+	inline XMVECTOR XM_CALLCONV XMVectorSplatW(FXMVECTOR V) { return XMVectorReplicate(XMVectorGetW(V)); }
+
+	// Elements 0-3 of V1 and 4-7 of V2.
+	template<uint32_t PermuteX, uint32_t PermuteY, uint32_t PermuteZ, uint32_t PermuteW>
+	inline XMVECTOR XM_CALLCONV XMVectorPermute(FXMVECTOR V1, FXMVECTOR V2)
+	{
+		static_assert(PermuteX <= 7 && PermuteY <= 7 && PermuteZ <= 7 && PermuteW <= 7, "Permute template parameter out of range");
+
+		float v[8];
+		Internal::Store(v, V1);
+		Internal::Store(v + 4, V2);
+		return XMVectorSet(v[PermuteX], v[PermuteY], v[PermuteZ], v[PermuteW]);
+	}
+
+	template<uint32_t SwizzleX, uint32_t SwizzleY, uint32_t SwizzleZ, uint32_t SwizzleW>
+	inline XMVECTOR XM_CALLCONV XMVectorSwizzle(FXMVECTOR V)
+	{
+		static_assert(SwizzleX <= 3 && SwizzleY <= 3 && SwizzleZ <= 3 && SwizzleW <= 3, "Swizzle template parameter out of range");
+
+		float v[4];
+		Internal::Store(v, V);
+		return XMVectorSet(v[SwizzleX], v[SwizzleY], v[SwizzleZ], v[SwizzleW]);
+	}
+
+	// V1 where the Control bits are clear, V2 where they are set.
+	inline XMVECTOR XM_CALLCONV XMVectorSelect(FXMVECTOR V1, FXMVECTOR V2, FXMVECTOR Control)
+	{
+		uint32_t a[4], b[4], c[4];
+		Internal::StoreBits(a, V1);
+		Internal::StoreBits(b, V2);
+		Internal::StoreBits(c, Control);
+		for (int i = 0; i < 4; ++i)
+		{
+			a[i] = (a[i] & ~c[i]) | (b[i] & c[i]);
+		}
+		return Internal::LoadBits(a);
+	}
+
+	inline XMVECTOR XM_CALLCONV XMVectorAndInt(FXMVECTOR V1, FXMVECTOR V2) { return Internal::MapBits(V1, V2, [](uint32_t a, uint32_t b) { return a & b; }); }
+	inline XMVECTOR XM_CALLCONV XMVectorOrInt(FXMVECTOR V1, FXMVECTOR V2) { return Internal::MapBits(V1, V2, [](uint32_t a, uint32_t b) { return a | b; }); }
+
+	inline XMVECTOR XM_CALLCONV XMVectorEqual(FXMVECTOR V1, FXMVECTOR V2) { return Internal::Compare(V1, V2, [](float a, float b) { return a == b; }); }
+	inline XMVECTOR XM_CALLCONV XMVectorLess(FXMVECTOR V1, FXMVECTOR V2) { return Internal::Compare(V1, V2, [](float a, float b) { return a < b; }); }
+	inline XMVECTOR XM_CALLCONV XMVectorLessOrEqual(FXMVECTOR V1, FXMVECTOR V2) { return Internal::Compare(V1, V2, [](float a, float b) { return a <= b; }); }
+	inline XMVECTOR XM_CALLCONV XMVectorGreater(FXMVECTOR V1, FXMVECTOR V2) { return Internal::Compare(V1, V2, [](float a, float b) { return a > b; }); }
+	inline XMVECTOR XM_CALLCONV XMVectorGreaterOrEqual(FXMVECTOR V1, FXMVECTOR V2) { return Internal::Compare(V1, V2, [](float a, float b) { return a >= b; }); }
+
+	inline XMVECTOR XM_CALLCONV XMVectorNegate(FXMVECTOR V) { return Internal::Map(V, [](float x) { return -x; }); }
+	inline XMVECTOR XM_CALLCONV XMVectorAdd(FXMVECTOR V1, FXMVECTOR V2) { return Internal::Map(V1, V2, [](float a, float b) { return a + b; }); }
+	inline XMVECTOR XM_CALLCONV XMVectorSubtract(FXMVECTOR V1, FXMVECTOR V2) { return Internal::Map(V1, V2, [](float a, float b) { return a - b; }); }
+	inline XMVECTOR XM_CALLCONV XMVectorMultiply(FXMVECTOR V1, FXMVECTOR V2) { return Internal::Map(V1, V2, [](float a, float b) { return a * b; }); }
+	inline XMVECTOR XM_CALLCONV XMVectorDivide(FXMVECTOR V1, FXMVECTOR V2) { return Internal::Map(V1, V2, [](float a, float b) { return a / b; }); }
+	inline XMVECTOR XM_CALLCONV XMVectorMultiplyAdd(FXMVECTOR V1, FXMVECTOR V2, FXMVECTOR V3) { return XMVectorAdd(XMVectorMultiply(V1, V2), V3); }
+	inline XMVECTOR XM_CALLCONV XMVectorScale(FXMVECTOR V, float ScaleFactor) { return Internal::Map(V, [ScaleFactor](float x) { return x * ScaleFactor; }); }
+	inline XMVECTOR XM_CALLCONV XMVectorMin(FXMVECTOR V1, FXMVECTOR V2) { return Internal::Map(V1, V2, [](float a, float b) { return a < b ? a : b; }); }
+	inline XMVECTOR XM_CALLCONV XMVectorMax(FXMVECTOR V1, FXMVECTOR V2) { return Internal::Map(V1, V2, [](float a, float b) { return a > b ? a : b; }); }
+	inline XMVECTOR XM_CALLCONV XMVectorAbs(FXMVECTOR V) { return Internal::Map(V, [](float x) { return fabsf(x); }); }
+	inline XMVECTOR XM_CALLCONV XMVectorClamp(FXMVECTOR V, FXMVECTOR Min, FXMVECTOR Max) { return XMVectorMin(XMVectorMax(V, Min), Max); }
+	inline XMVECTOR XM_CALLCONV XMVectorSaturate(FXMVECTOR V) { return Internal::Map(V, [](float x) { return x < 0.0f ? 0.0f : (x > 1.0f ? 1.0f : x); }); }
+	inline XMVECTOR XM_CALLCONV XMVectorSqrt(FXMVECTOR V) { return Internal::Map(V, [](float x) { return sqrtf(x); }); }
+	inline XMVECTOR XM_CALLCONV XMVectorReciprocal(FXMVECTOR V) { return Internal::Map(V, [](float x) { return 1.0f / x; }); }
+	inline XMVECTOR XM_CALLCONV XMVectorReciprocalSqrt(FXMVECTOR V) { return Internal::Map(V, [](float x) { return 1.0f / sqrtf(x); }); }
+	// Halfway cases to even, as DirectXMath.
+	inline XMVECTOR XM_CALLCONV XMVectorRound(FXMVECTOR V) { return Internal::Map(V, [](float x) { return nearbyintf(x); }); }
+	inline XMVECTOR XM_CALLCONV XMVectorFloor(FXMVECTOR V) { return Internal::Map(V, [](float x) { return floorf(x); }); }
+	inline XMVECTOR XM_CALLCONV XMVectorCeiling(FXMVECTOR V) { return Internal::Map(V, [](float x) { return ceilf(x); }); }
+	inline XMVECTOR XM_CALLCONV XMVectorSin(FXMVECTOR V) { return Internal::Map(V, [](float x) { return sinf(x); }); }
+	inline XMVECTOR XM_CALLCONV XMVectorCos(FXMVECTOR V) { return Internal::Map(V, [](float x) { return cosf(x); }); }
+	inline XMVECTOR XM_CALLCONV XMVectorTan(FXMVECTOR V) { return Internal::Map(V, [](float x) { return tanf(x); }); }
+	inline XMVECTOR XM_CALLCONV XMVectorASin(FXMVECTOR V) { return Internal::Map(V, [](float x) { return asinf(x); }); }
+	inline XMVECTOR XM_CALLCONV XMVectorACos(FXMVECTOR V) { return Internal::Map(V, [](float x) { return acosf(x); }); }
+	inline XMVECTOR XM_CALLCONV XMVectorATan(FXMVECTOR V) { return Internal::Map(V, [](float x) { return atanf(x); }); }
+	inline XMVECTOR XM_CALLCONV XMVectorATan2(FXMVECTOR Y, FXMVECTOR X) { return Internal::Map(Y, X, [](float y, float x) { return atan2f(y, x); }); }
+	inline XMVECTOR XM_CALLCONV XMVectorExp(FXMVECTOR V) { return Internal::Map(V, [](float x) { return exp2f(x); }); }
+	inline XMVECTOR XM_CALLCONV XMVectorLog(FXMVECTOR V) { return Internal::Map(V, [](float x) { return log2f(x); }); }
+	inline XMVECTOR XM_CALLCONV XMVectorPow(FXMVECTOR V1, FXMVECTOR V2) { return Internal::Map(V1, V2, [](float a, float b) { return powf(a, b); }); }
+
+	inline XMVECTOR XM_CALLCONV XMVectorLerpV(FXMVECTOR V0, FXMVECTOR V1, FXMVECTOR T)
+	{
+		return XMVectorAdd(V0, XMVectorMultiply(T, XMVectorSubtract(V1, V0)));
+	}
+
+	//
+	// 3D vector.
+	//
+
+	inline XMVECTOR XM_CALLCONV XMVector3Dot(FXMVECTOR V1, FXMVECTOR V2)
+	{
+		float a[4], b[4];
+		Internal::Store(a, V1);
+		Internal::Store(b, V2);
+		return XMVectorReplicate(a[0] * b[0] + a[1] * b[1] + a[2] * b[2]);
+	}
+
+	inline XMVECTOR XM_CALLCONV XMVector3Cross(FXMVECTOR V1, FXMVECTOR V2)
+	{
+		float a[4], b[4];
+		Internal::Store(a, V1);
+		Internal::Store(b, V2);
+		return XMVectorSet(a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0], 0.0f);
+	}
+
+	inline XMVECTOR XM_CALLCONV XMVector3LengthSq(FXMVECTOR V) { return XMVector3Dot(V, V); }
+	inline XMVECTOR XM_CALLCONV XMVector3Length(FXMVECTOR V) { return XMVectorSqrt(XMVector3LengthSq(V)); }
+	inline XMVECTOR XM_CALLCONV XMVector3ReciprocalLength(FXMVECTOR V) { return XMVectorReciprocalSqrt(XMVector3LengthSq(V)); }
+
+	// A zero length vector stays zero.
+	inline XMVECTOR XM_CALLCONV XMVector3Normalize(FXMVECTOR V)
+	{
+		const float length = XMVectorGetX(XMVector3Length(V));
+		return length > 0.0f ? XMVectorScale(V, 1.0f / length) : XMVectorZero();
+	}
+
+	inline bool XM_CALLCONV XMVector3Equal(FXMVECTOR V1, FXMVECTOR V2)
+	{
+		float a[4], b[4];
+		Internal::Store(a, V1);
+		Internal::Store(b, V2);
+		return a[0] == b[0] && a[1] == b[1] && a[2] == b[2];
+	}
+
+	// Row vector times M, V.w taken as InW.
+	inline XMVECTOR XM_CALLCONV XMVector3TransformW(FXMVECTOR V, FXMMATRIX M, float InW)
+	{
+		float v[4];
+		Internal::Store(v, V);
+		XMVECTOR result = XMVectorScale(M.r[0], v[0]);
+		result = XMVectorAdd(result, XMVectorScale(M.r[1], v[1]));
+		result = XMVectorAdd(result, XMVectorScale(M.r[2], v[2]));
+		return InW == 0.0f ? result : XMVectorAdd(result, XMVectorScale(M.r[3], InW));
+	}
+
+	inline XMVECTOR XM_CALLCONV XMVector3Transform(FXMVECTOR V, FXMMATRIX M) { return XMVector3TransformW(V, M, 1.0f); }
+	inline XMVECTOR XM_CALLCONV XMVector3TransformNormal(FXMVECTOR V, FXMMATRIX M) { return XMVector3TransformW(V, M, 0.0f); }
+
+	//
+	// 4D vector.
+	//
+
+	inline XMVECTOR XM_CALLCONV XMVector4Dot(FXMVECTOR V1, FXMVECTOR V2)
+	{
+		float a[4], b[4];
+		Internal::Store(a, V1);
+		Internal::Store(b, V2);
+		return XMVectorReplicate(a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3]);
+	}
+
+	inline XMVECTOR XM_CALLCONV XMVector4Normalize(FXMVECTOR V)
+	{
+		const float length = sqrtf(XMVectorGetX(XMVector4Dot(V, V)));
+		return length > 0.0f ? XMVectorScale(V, 1.0f / length) : XMVectorZero();
+	}
+
+	inline XMVECTOR XM_CALLCONV XMVector4Transform(FXMVECTOR V, FXMMATRIX M)
+	{
+		float v[4];
+		Internal::Store(v, V);
+		XMVECTOR result = XMVectorScale(M.r[0], v[0]);
+		result = XMVectorAdd(result, XMVectorScale(M.r[1], v[1]));
+		result = XMVectorAdd(result, XMVectorScale(M.r[2], v[2]));
+		return XMVectorAdd(result, XMVectorScale(M.r[3], v[3]));
+	}
+
+	// Divided by the length of its normal.
+	inline XMVECTOR XM_CALLCONV XMPlaneNormalize(FXMVECTOR P)
+	{
+		const float length = XMVectorGetX(XMVector3Length(P));
+		return length > 0.0f ? XMVectorScale(P, 1.0f / length) : XMVectorZero();
+	}
+
+	//
+	// Quaternion, (x, y, z) the axis part and w the angle part.
+	//
+
+	inline XMVECTOR XM_CALLCONV XMQuaternionIdentity() { return g_XMIdentityR3; }
+
+	// Q2 * Q1, Q1 rotation first.
+	inline XMVECTOR XM_CALLCONV XMQuaternionMultiply(FXMVECTOR Q1, FXMVECTOR Q2)
+	{
+		float a[4], b[4];
+		Internal::Store(a, Q1);
+		Internal::Store(b, Q2);
+		return XMVectorSet(
+			(b[3] * a[0]) + (b[0] * a[3]) + (b[1] * a[2]) - (b[2] * a[1]),
+			(b[3] * a[1]) - (b[0] * a[2]) + (b[1] * a[3]) + (b[2] * a[0]),
+			(b[3] * a[2]) + (b[0] * a[1]) - (b[1] * a[0]) + (b[2] * a[3]),
+			(b[3] * a[3]) - (b[0] * a[0]) - (b[1] * a[1]) - (b[2] * a[2]));
+	}
+
+	inline XMVECTOR XM_CALLCONV XMQuaternionConjugate(FXMVECTOR Q)
+	{
+		float q[4];
+		Internal::Store(q, Q);
+		return XMVectorSet(-q[0], -q[1], -q[2], q[3]);
+	}
+
+	inline XMVECTOR XM_CALLCONV XMQuaternionNormalize(FXMVECTOR Q) { return XMVector4Normalize(Q); }
+
+	inline XMVECTOR XM_CALLCONV XMQuaternionRotationNormal(FXMVECTOR NormalAxis, float Angle)
+	{
+		const float s = sinf(0.5f * Angle);
+		return XMVectorSetW(XMVectorScale(NormalAxis, s), cosf(0.5f * Angle));
+	}
+
+	inline XMVECTOR XM_CALLCONV XMQuaternionRotationAxis(FXMVECTOR Axis, float Angle)
+	{
+		return XMQuaternionRotationNormal(XMVector3Normalize(Axis), Angle);
+	}
+
+	// Roll about z first, then pitch about x, then yaw about y.
+	inline XMVECTOR XM_CALLCONV XMQuaternionRotationRollPitchYaw(float Pitch, float Yaw, float Roll)
+	{
+		const float cp = cosf(0.5f * Pitch), sp = sinf(0.5f * Pitch);
+		const float cy = cosf(0.5f * Yaw), sy = sinf(0.5f * Yaw);
+		const float cr = cosf(0.5f * Roll), sr = sinf(0.5f * Roll);
+
+		return XMVectorSet(
+			cr * sp * cy + sr * cp * sy,
+			cr * cp * sy - sr * sp * cy,
+			sr * cp * cy - cr * sp * sy,
+			cr * cp * cy + sr * sp * sy);
+	}
+
+	inline XMVECTOR XM_CALLCONV XMQuaternionRotationMatrix(FXMMATRIX M)
+	{
+		XMFLOAT4X4 m;
+		XMStoreFloat4x4(&m, M);
+
+		float q[4];
+		if (m._33 <= 0.0f)
+		{
+			const float dif10 = m._22 - m._11;
+			const float omr22 = 1.0f - m._33;
+			if (dif10 <= 0.0f)
+			{
+				const float fourXSqr = omr22 - dif10;
+				const float inv4x = 0.5f / sqrtf(fourXSqr);
+				q[0] = fourXSqr * inv4x;
+				q[1] = (m._12 + m._21) * inv4x;
+				q[2] = (m._13 + m._31) * inv4x;
+				q[3] = (m._23 - m._32) * inv4x;
+			}
+			else
+			{
+				const float fourYSqr = omr22 + dif10;
+				const float inv4y = 0.5f / sqrtf(fourYSqr);
+				q[0] = (m._12 + m._21) * inv4y;
+				q[1] = fourYSqr * inv4y;
+				q[2] = (m._23 + m._32) * inv4y;
+				q[3] = (m._31 - m._13) * inv4y;
+			}
+		}
+		else
+		{
+			const float sum10 = m._22 + m._11;
+			const float opr22 = 1.0f + m._33;
+			if (sum10 <= 0.0f)
+			{
+				const float fourZSqr = opr22 - sum10;
+				const float inv4z = 0.5f / sqrtf(fourZSqr);
+				q[0] = (m._13 + m._31) * inv4z;
+				q[1] = (m._23 + m._32) * inv4z;
+				q[2] = fourZSqr * inv4z;
+				q[3] = (m._12 - m._21) * inv4z;
+			}
+			else
+			{
+				const float fourWSqr = opr22 + sum10;
+				const float inv4w = 0.5f / sqrtf(fourWSqr);
+				q[0] = (m._23 - m._32) * inv4w;
+				q[1] = (m._31 - m._13) * inv4w;
+				q[2] = (m._12 - m._21) * inv4w;
+				q[3] = fourWSqr * inv4w;
+			}
+		}
+
+		return Internal::Load(q);
+	}
+
+	// Q * V * ~Q.
+	inline XMVECTOR XM_CALLCONV XMVector3Rotate(FXMVECTOR V, FXMVECTOR RotationQuaternion)
+	{
+		const XMVECTOR A = XMVectorAndInt(V, g_XMMask3);
+		const XMVECTOR Result = XMQuaternionMultiply(XMQuaternionConjugate(RotationQuaternion), A);
+		return XMQuaternionMultiply(Result, RotationQuaternion);
+	}
+
+	//
+	// Matrix, row vectors: v' = v * M.
+	//
+
+	inline XMMATRIX XM_CALLCONV XMMatrixIdentity()
+	{
+		return XMMATRIX(g_XMIdentityR0, g_XMIdentityR1, g_XMIdentityR2, g_XMIdentityR3);
+	}
+
+	inline XMMATRIX XM_CALLCONV XMMatrixMultiply(FXMMATRIX M1, CXMMATRIX M2)
+	{
+		XMMATRIX result;
+		for (int i = 0; i < 4; ++i)
+		{
+			result.r[i] = XMVector4Transform(M1.r[i], M2);
+		}
+		return result;
+	}
+
+	inline XMMATRIX XM_CALLCONV XMMatrixTranspose(FXMMATRIX M)
+	{
+		XMFLOAT4X4 m;
+		XMStoreFloat4x4(&m, M);
+		return XMMATRIX(
+			m._11, m._21, m._31, m._41,
+			m._12, m._22, m._32, m._42,
+			m._13, m._23, m._33, m._43,
+			m._14, m._24, m._34, m._44);
+	}
+
+	// Cofactors over the determinant, all zero for a singular matrix.
+	inline XMMATRIX XM_CALLCONV XMMatrixInverse(XMVECTOR* pDeterminant, FXMMATRIX M)
+	{
+		XMFLOAT4X4 m;
+		XMStoreFloat4x4(&m, M);
+		const float* a = &m.m[0][0];
+
+		float inv[16];
+		inv[0] = a[5] * a[10] * a[15] - a[5] * a[11] * a[14] - a[9] * a[6] * a[15] + a[9] * a[7] * a[14] + a[13] * a[6] * a[11] - a[13] * a[7] * a[10];
+		inv[4] = -a[4] * a[10] * a[15] + a[4] * a[11] * a[14] + a[8] * a[6] * a[15] - a[8] * a[7] * a[14] - a[12] * a[6] * a[11] + a[12] * a[7] * a[10];
+		inv[8] = a[4] * a[9] * a[15] - a[4] * a[11] * a[13] - a[8] * a[5] * a[15] + a[8] * a[7] * a[13] + a[12] * a[5] * a[11] - a[12] * a[7] * a[9];
+		inv[12] = -a[4] * a[9] * a[14] + a[4] * a[10] * a[13] + a[8] * a[5] * a[14] - a[8] * a[6] * a[13] - a[12] * a[5] * a[10] + a[12] * a[6] * a[9];
+		inv[1] = -a[1] * a[10] * a[15] + a[1] * a[11] * a[14] + a[9] * a[2] * a[15] - a[9] * a[3] * a[14] - a[13] * a[2] * a[11] + a[13] * a[3] * a[10];
+		inv[5] = a[0] * a[10] * a[15] - a[0] * a[11] * a[14] - a[8] * a[2] * a[15] + a[8] * a[3] * a[14] + a[12] * a[2] * a[11] - a[12] * a[3] * a[10];
+		inv[9] = -a[0] * a[9] * a[15] + a[0] * a[11] * a[13] + a[8] * a[1] * a[15] - a[8] * a[3] * a[13] - a[12] * a[1] * a[11] + a[12] * a[3] * a[9];
+		inv[13] = a[0] * a[9] * a[14] - a[0] * a[10] * a[13] - a[8] * a[1] * a[14] + a[8] * a[2] * a[13] + a[12] * a[1] * a[10] - a[12] * a[2] * a[9];
+		inv[2] = a[1] * a[6] * a[15] - a[1] * a[7] * a[14] - a[5] * a[2] * a[15] + a[5] * a[3] * a[14] + a[13] * a[2] * a[7] - a[13] * a[3] * a[6];
+		inv[6] = -a[0] * a[6] * a[15] + a[0] * a[7] * a[14] + a[4] * a[2] * a[15] - a[4] * a[3] * a[14] - a[12] * a[2] * a[7] + a[12] * a[3] * a[6];
+		inv[10] = a[0] * a[5] * a[15] - a[0] * a[7] * a[13] - a[4] * a[1] * a[15] + a[4] * a[3] * a[13] + a[12] * a[1] * a[7] - a[12] * a[3] * a[5];
+		inv[14] = -a[0] * a[5] * a[14] + a[0] * a[6] * a[13] + a[4] * a[1] * a[14] - a[4] * a[2] * a[13] - a[12] * a[1] * a[6] + a[12] * a[2] * a[5];
+		inv[3] = -a[1] * a[6] * a[11] + a[1] * a[7] * a[10] + a[5] * a[2] * a[11] - a[5] * a[3] * a[10] - a[9] * a[2] * a[7] + a[9] * a[3] * a[6];
+		inv[7] = a[0] * a[6] * a[11] - a[0] * a[7] * a[10] - a[4] * a[2] * a[11] + a[4] * a[3] * a[10] + a[8] * a[2] * a[7] - a[8] * a[3] * a[6];
+		inv[11] = -a[0] * a[5] * a[11] + a[0] * a[7] * a[9] + a[4] * a[1] * a[11] - a[4] * a[3] * a[9] - a[8] * a[1] * a[7] + a[8] * a[3] * a[5];
+		inv[15] = a[0] * a[5] * a[10] - a[0] * a[6] * a[9] - a[4] * a[1] * a[10] + a[4] * a[2] * a[9] + a[8] * a[1] * a[6] - a[8] * a[2] * a[5];
+
+		const float determinant = a[0] * inv[0] + a[1] * inv[4] + a[2] * inv[8] + a[3] * inv[12];
+		if (pDeterminant != nullptr)
+		{
+			*pDeterminant = XMVectorReplicate(determinant);
+		}
+
+		const float scale = determinant != 0.0f ? 1.0f / determinant : 0.0f;
+		for (float& value : inv)
+		{
+			value *= scale;
+		}
+		return XMLoadFloat4x4(reinterpret_cast<const XMFLOAT4X4*>(inv));
+	}
+
+	inline XMMATRIX XM_CALLCONV XMMatrixScaling(float ScaleX, float ScaleY, float ScaleZ)
+	{
+		return XMMATRIX(
+			ScaleX, 0.0f, 0.0f, 0.0f,
+			0.0f, ScaleY, 0.0f, 0.0f,
+			0.0f, 0.0f, ScaleZ, 0.0f,
+			0.0f, 0.0f, 0.0f, 1.0f);
+	}
+
+	inline XMMATRIX XM_CALLCONV XMMatrixScalingFromVector(FXMVECTOR Scale)
+	{
+		float s[4];
+		Internal::Store(s, Scale);
+		return XMMatrixScaling(s[0], s[1], s[2]);
+	}
+
+	inline XMMATRIX XM_CALLCONV XMMatrixTranslation(float OffsetX, float OffsetY, float OffsetZ)
+	{
+		return XMMATRIX(
+			1.0f, 0.0f, 0.0f, 0.0f,
+			0.0f, 1.0f, 0.0f, 0.0f,
+			0.0f, 0.0f, 1.0f, 0.0f,
+			OffsetX, OffsetY, OffsetZ, 1.0f);
+	}
+
+	inline XMMATRIX XM_CALLCONV XMMatrixRotationX(float Angle)
+	{
+		const float s = sinf(Angle), c = cosf(Angle);
+		return XMMATRIX(
+			1.0f, 0.0f, 0.0f, 0.0f,
+			0.0f, c, s, 0.0f,
+			0.0f, -s, c, 0.0f,
+			0.0f, 0.0f, 0.0f, 1.0f);
+	}
+
+	inline XMMATRIX XM_CALLCONV XMMatrixRotationY(float Angle)
+	{
+		const float s = sinf(Angle), c = cosf(Angle);
+		return XMMATRIX(
+			c, 0.0f, -s, 0.0f,
+			0.0f, 1.0f, 0.0f, 0.0f,
+			s, 0.0f, c, 0.0f,
+			0.0f, 0.0f, 0.0f, 1.0f);
+	}
+
+	inline XMMATRIX XM_CALLCONV XMMatrixRotationZ(float Angle)
+	{
+		const float s = sinf(Angle), c = cosf(Angle);
+		return XMMATRIX(
+			c, s, 0.0f, 0.0f,
+			-s, c, 0.0f, 0.0f,
+			0.0f, 0.0f, 1.0f, 0.0f,
+			0.0f, 0.0f, 0.0f, 1.0f);
+	}
+
+	inline XMMATRIX XM_CALLCONV XMMatrixRotationQuaternion(FXMVECTOR Quaternion)
+	{
+		float q[4];
+		Internal::Store(q, Quaternion);
+		const float x = q[0], y = q[1], z = q[2], w = q[3];
+
+		return XMMATRIX(
+			1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y + z * w), 2.0f * (x * z - y * w), 0.0f,
+			2.0f * (x * y - z * w), 1.0f - 2.0f * (x * x + z * z), 2.0f * (y * z + x * w), 0.0f,
+			2.0f * (x * z + y * w), 2.0f * (y * z - x * w), 1.0f - 2.0f * (x * x + y * y), 0.0f,
+			0.0f, 0.0f, 0.0f, 1.0f);
+	}
+
+	inline XMMATRIX XM_CALLCONV XMMatrixLookToLH(FXMVECTOR EyePosition, FXMVECTOR EyeDirection, FXMVECTOR UpDirection)
+	{
+		const XMVECTOR R2 = XMVector3Normalize(EyeDirection);
+		const XMVECTOR R0 = XMVector3Normalize(XMVector3Cross(UpDirection, R2));
+		const XMVECTOR R1 = XMVector3Cross(R2, R0);
+		const XMVECTOR NegEye = XMVectorNegate(EyePosition);
+
+		XMMATRIX M(
+			XMVectorSetW(R0, XMVectorGetX(XMVector3Dot(R0, NegEye))),
+			XMVectorSetW(R1, XMVectorGetX(XMVector3Dot(R1, NegEye))),
+			XMVectorSetW(R2, XMVectorGetX(XMVector3Dot(R2, NegEye))),
+			g_XMIdentityR3);
+		return XMMatrixTranspose(M);
+	}
+
+	inline XMMATRIX XM_CALLCONV XMMatrixLookAtLH(FXMVECTOR EyePosition, FXMVECTOR FocusPosition, FXMVECTOR UpDirection)
+	{
+		return XMMatrixLookToLH(EyePosition, XMVectorSubtract(FocusPosition, EyePosition), UpDirection);
+	}
+
+	inline XMMATRIX XM_CALLCONV XMMatrixPerspectiveFovLH(float FovAngleY, float AspectRatio, float NearZ, float FarZ)
+	{
+		const float height = 1.0f / tanf(0.5f * FovAngleY);
+		const float width = height / AspectRatio;
+		const float range = FarZ / (FarZ - NearZ);
+		return XMMATRIX(
+			width, 0.0f, 0.0f, 0.0f,
+			0.0f, height, 0.0f, 0.0f,
+			0.0f, 0.0f, range, 1.0f,
+			0.0f, 0.0f, -range * NearZ, 0.0f);
+	}
+
+	inline XMMATRIX XM_CALLCONV XMMatrixOrthographicLH(float ViewWidth, float ViewHeight, float NearZ, float FarZ)
+	{
+		const float range = 1.0f / (FarZ - NearZ);
+		return XMMATRIX(
+			2.0f / ViewWidth, 0.0f, 0.0f, 0.0f,
+			0.0f, 2.0f / ViewHeight, 0.0f, 0.0f,
+			0.0f, 0.0f, range, 0.0f,
+			0.0f, 0.0f, -range * NearZ, 1.0f);
+	}
+}
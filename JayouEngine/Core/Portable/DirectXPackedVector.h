@@ -0,0 +1,166 @@
+//
+// DirectXPackedVector.h
+// Non Windows builds only, the packed formats of DirectXPackedVector.h the vertex codecs use. Rounds as the SDK does,
+// to nearest even.
+
+#pragma once
+
+#include "DirectXMath.h"
+
+namespace DirectX
+{
+	namespace PackedVector
+	{
+		typedef uint16_t HALF;
+
+		struct XMHALF2
+		{
+			HALF x;
+			HALF y;
+		};
+
+		struct XMSHORTN2
+		{
+			int16_t x;
+			int16_t y;
+		};
+
+		struct XMUSHORTN4
+		{
+			uint16_t x;
+			uint16_t y;
+			uint16_t z;
+			uint16_t w;
+		};
+
+		struct XMUBYTEN4
+		{
+			uint8_t x;
+			uint8_t y;
+			uint8_t z;
+			uint8_t w;
+		};
+
+		inline HALF XMConvertFloatToHalf(float Value)
+		{
+			uint32_t bits;
+			memcpy(&bits, &Value, sizeof(bits));
+			const uint32_t sign = (bits >> 16) & 0x8000u;
+			const uint32_t magnitude = bits & 0x7fffffffu;
+
+			if (magnitude >= 0x7f800000u)
+				return (HALF)(sign | 0x7c00u | (magnitude > 0x7f800000u ? 0x200u : 0u));
+
+			// Too large for a half, infinity as the SDK's F16C path gives.
+			if (magnitude >= 0x477ff000u)
+				return (HALF)(sign | 0x7c00u);
+
+			// Denormal half, shift the mantissa in with its implicit bit and round.
+			if (magnitude < 0x38800000u)
+			{
+				if (magnitude < 0x33000000u)
+					return (HALF)sign;
+				const uint32_t exponent = magnitude >> 23;
+				const uint32_t mantissa = (magnitude & 0x7fffffu) | 0x800000u;
+				const uint32_t shift = 126 - exponent;
+				const uint32_t half = mantissa >> shift;
+				const uint32_t rest = mantissa & ((1u << shift) - 1);
+				const uint32_t halfway = 1u << (shift - 1);
+				return (HALF)(sign | (half + (rest > halfway || (rest == halfway && (half & 1)) ? 1 : 0)));
+			}
+
+			// Rebias the exponent, round the 13 dropped bits to nearest even, a carry moves into the exponent.
+			const uint32_t rebased = magnitude - 0x38000000u;
+			const uint32_t rounded = rebased + 0xfffu + ((rebased >> 13) & 1u);
+			return (HALF)(sign | (rounded >> 13));
+		}
+
+		inline float XMConvertHalfToFloat(HALF Value)
+		{
+			const uint32_t sign = (uint32_t)(Value & 0x8000u) << 16;
+			uint32_t exponent = (Value >> 10) & 0x1fu;
+			uint32_t mantissa = Value & 0x3ffu;
+
+			uint32_t bits;
+			if (exponent == 0x1fu)
+			{
+				bits = sign | 0x7f800000u | (mantissa << 13);
+			}
+			else if (exponent != 0)
+			{
+				bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+			}
+			else if (mantissa != 0)
+			{
+				// Denormal half, normalized as a float.
+				exponent = 113;
+				while ((mantissa & 0x400u) == 0)
+				{
+					mantissa <<= 1;
+					exponent--;
+				}
+				bits = sign | (exponent << 23) | ((mantissa & 0x3ffu) << 13);
+			}
+			else
+			{
+				bits = sign;
+			}
+
+			float result;
+			memcpy(&result, &bits, sizeof(result));
+			return result;
+		}
+
+		inline XMVECTOR XM_CALLCONV XMLoadHalf2(const XMHALF2* pSource)
+		{
+			return XMVectorSet(XMConvertHalfToFloat(pSource->x), XMConvertHalfToFloat(pSource->y), 0.0f, 0.0f);
+		}
+
+		inline void XM_CALLCONV XMStoreHalf2(XMHALF2* pDestination, FXMVECTOR V)
+		{
+			pDestination->x = XMConvertFloatToHalf(XMVectorGetX(V));
+			pDestination->y = XMConvertFloatToHalf(XMVectorGetY(V));
+		}
+
+		inline XMVECTOR XM_CALLCONV XMLoadShortN2(const XMSHORTN2* pSource)
+		{
+			// -32768 and -32767 both load as -1.
+			return XMVectorSet(std::fmax(pSource->x / 32767.0f, -1.0f), std::fmax(pSource->y / 32767.0f, -1.0f), 0.0f, 0.0f);
+		}
+
+		inline void XM_CALLCONV XMStoreShortN2(XMSHORTN2* pDestination, FXMVECTOR V)
+		{
+			const XMVECTOR N = XMVectorRound(XMVectorScale(XMVectorClamp(V, g_XMNegativeOne, g_XMOne), 32767.0f));
+			pDestination->x = (int16_t)XMVectorGetX(N);
+			pDestination->y = (int16_t)XMVectorGetY(N);
+		}
+
+		inline XMVECTOR XM_CALLCONV XMLoadUShortN4(const XMUSHORTN4* pSource)
+		{
+			return XMVectorScale(XMVectorSet(pSource->x, pSource->y, pSource->z, pSource->w), 1.0f / 65535.0f);
+		}
+
+		inline void XM_CALLCONV XMStoreUShortN4(XMUSHORTN4* pDestination, FXMVECTOR V)
+		{
+			const XMVECTOR N = XMVectorRound(XMVectorScale(XMVectorSaturate(V), 65535.0f));
+			pDestination->x = (uint16_t)XMVectorGetX(N);
+			pDestination->y = (uint16_t)XMVectorGetY(N);
+			pDestination->z = (uint16_t)XMVectorGetZ(N);
+			pDestination->w = (uint16_t)XMVectorGetW(N);
+		}
+
+		inline XMVECTOR XM_CALLCONV XMLoadUByteN4(const XMUBYTEN4* pSource)
+		{
+			return XMVectorScale(XMVectorSet(pSource->x, pSource->y, pSource->z, pSource->w), 1.0f / 255.0f);
+		}
+
+		inline void XM_CALLCONV XMStoreUByteN4(XMUBYTEN4* pDestination, FXMVECTOR V)
+		{
+			const XMVECTOR N = XMVectorRound(XMVectorScale(XMVectorSaturate(V), 255.0f));
+			pDestination->x = (uint8_t)XMVectorGetX(N);
+			pDestination->y = (uint8_t)XMVectorGetY(N);
+			pDestination->z = (uint8_t)XMVectorGetZ(N);
+			pDestination->w = (uint8_t)XMVectorGetW(N);
+		}
+	}
+}
@@ -8,7 +8,32 @@
 #define NumTextures 1024
 #endif
 
+// Light cluster grid, see LightClusterBuilder.
+#ifndef NumClustersX
+#define NumClustersX 16
+#endif
+#ifndef NumClustersY
+#define NumClustersY 9
+#endif
+#ifndef NumClustersZ
+#define NumClustersZ 24
+#endif
+
 StructuredBuffer<LightData> gLightData : register(t0, space0);
+// Offset into gLightIndices, point light count | spot light count << 16.
+StructuredBuffer<uint2> gLightClusters : register(t1, space0);
+// Directional lights first, then the lights of each cluster.
+StructuredBuffer<uint> gLightIndices : register(t2, space0);
+// Transforms of instanced draws, one per render item.
+struct InstanceData
+{
+    float4x4 World;
+    float4x4 InvTWorld;
+};
+
+StructuredBuffer<InstanceData> gInstanceData : register(t3, space0);
+// Instances of every instanced draw of the frame, see InstanceBatcher.
+StructuredBuffer<uint> gInstanceIndices : register(t4, space0);
 StructuredBuffer<MaterialData> gMaterialData : register(t0, space1);
 // Depth, Shadow, Diffuse, Normal, ORM, Position.
 Texture2D gGBuffers[6] : register(t0, space2);
@@ -42,6 +67,18 @@ cbuffer PerObjectCBuffer : register(b0)
     int ObjectConstantPad0;
     int ObjectConstantPad1;
     int ObjectConstantPad2;
+    
+    // VF_PackedVertex dequantization, identity otherwise.
+    float3 gPositionScale;
+    float ObjectConstantPad3;
+    float3 gPositionBias;
+    float ObjectConstantPad4;
+};
+
+// Start of the draw in gInstanceIndices.
+cbuffer PerDrawCBuffer : register(b2)
+{
+    uint gInstanceOffset;
 };
 
 cbuffer PerPassCBuffer : register(b1)
@@ -77,11 +114,37 @@ cbuffer PerPassCBuffer : register(b1)
     uint gNumSpotLights;
     
     int gCubeMapIndex;
+    
+    float gClusterSliceScale;
+    float gClusterSliceBias;
     int PassConstantPad0;
-    int PassConstantPad1;
-    int PassConstantPad2;
 };
 
+//---------------------------------------------------------------------------------------
+// Instanced draws, instanceID is SV_InstanceID.
+//---------------------------------------------------------------------------------------
+InstanceData GetInstanceData(uint instanceID)
+{
+    return gInstanceData[gInstanceIndices[gInstanceOffset + instanceID]];
+}
+
+//---------------------------------------------------------------------------------------
+// VF_PackedVertex, see VertexPacker.
+//---------------------------------------------------------------------------------------
+float3 DequantizePosition(float3 packedPosL)
+{
+    return packedPosL * gPositionScale + gPositionBias;
+}
+
+float3 DecodeOctahedral(float2 e)
+{
+    // z = 1 - |x| - |y|, the lower half is folded over the diagonals.
+    float3 n = float3(e.xy, 1.0f - abs(e.x) - abs(e.y));
+    float t = saturate(-n.z);
+    n.xy += (n.xy >= 0.0f) ? -t : t;
+    return normalize(n);
+}
+
 //---------------------------------------------------------------------------------------
 // Transforms a normal map sample to world space.
 //---------------------------------------------------------------------------------------
@@ -113,6 +176,16 @@ float ConvertDepthToLinear(float4x4 Proj, float Depth)
     return linearDepth;
 }
 
+//---------------------------------------------------------------------------------------
+// Light cluster of a pixel, screen tiles times exponential view depth slices.
+//---------------------------------------------------------------------------------------
+uint ComputeLightCluster(float2 PixelPos, float LinearDepth)
+{
+    uint2 tile = min(uint2(PixelPos * gInvRenderTargetSize * float2(NumClustersX, NumClustersY)), uint2(NumClustersX - 1, NumClustersY - 1));
+    uint slice = (uint) clamp(log2(LinearDepth) * gClusterSliceScale + gClusterSliceBias, 0.0f, NumClustersZ - 1.0f);
+    return (slice * NumClustersY + tile.y) * NumClustersX + tile.x;
+}
+
 float3 CalcWorldPosFromLinearDepth(float4x4 Proj, float4x4 gInvView, float2 NDCPos, float LinearDepth)
 {
     float4 position;
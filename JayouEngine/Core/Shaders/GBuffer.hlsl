@@ -31,20 +31,28 @@ struct GBufferOut
     float4 Pos : SV_Target3;
 };
 
-VertexOut VS(VertexIn vin)
+VertexOut VS(VertexIn vin, uint instanceID : SV_InstanceID)
 {
     VertexOut vout = (VertexOut) 0.0f;
 
+    InstanceData instData = GetInstanceData(instanceID);
+
 	// Fetch the material data.
     MaterialData matData = gMaterialData[gMaterialIndex];
     
+#ifdef PACKED_VERTEX
+    vin.PosL = DequantizePosition(vin.PosL);
+    vin.NormalL = DecodeOctahedral(vin.NormalL.xy);
+    vin.TangentU = DecodeOctahedral(vin.TangentU.xy);
+#endif
+    
     // Transform to world space.
-    float4 posW = mul(gWorld, float4(vin.PosL, 1.0f));
+    float4 posW = mul(instData.World, float4(vin.PosL, 1.0f));
     vout.PosW = posW.xyz;
 
     // If nonuniform scaling; otherwise, need to use inverse-transpose of world matrix.
-    vout.NormalW = mul((float3x3) gInvTWorld, vin.NormalL);
-    vout.TangentW = mul((float3x3) gInvTWorld, vin.TangentU);
+    vout.NormalW = mul((float3x3) instData.InvTWorld, vin.NormalL);
+    vout.TangentW = mul((float3x3) instData.InvTWorld, vin.TangentU);
 
     // Transform to homogeneous clip space.
     vout.PosH = mul(gViewProj, posW);
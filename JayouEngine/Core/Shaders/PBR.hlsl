@@ -57,21 +57,26 @@ float4 PS(VertexOut pin) : SV_Target
        
     for (uint i = 0; i < gNumDirLights; ++i)
     {
-        info.Light = gLightData[i];
+        info.Light = gLightData[gLightIndices[i]];
         color += shadowFactor * ComputeDirectionalLight(info);
         // The Default First Dir Cast Shadow.
         shadowFactor = 1.0f;
     }
+    
+    // Only the point & spot lights binned into this pixel's cluster.
+    uint2 cluster = gLightClusters[ComputeLightCluster(pin.PosH.xy, linearDepth)];
+    uint numPointLights = cluster.y & 0xffff;
+    uint numSpotLights = cluster.y >> 16;
         
-    for (uint j = gNumDirLights; j < gNumDirLights + gNumPointLights; ++j)
+    for (uint j = 0; j < numPointLights; ++j)
     {
-        info.Light = gLightData[j];
+        info.Light = gLightData[gLightIndices[cluster.x + j]];
         color += ComputePointLight(info);
     }
     
-    for (uint k = gNumDirLights + gNumPointLights; k < gNumDirLights + gNumPointLights + gNumSpotLights; ++k)
+    for (uint k = numPointLights; k < numPointLights + numSpotLights; ++k)
     {
-        info.Light = gLightData[k];
+        info.Light = gLightData[gLightIndices[cluster.x + k]];
         color += ComputeSpotLight(info);
     }
     
@@ -7,7 +7,9 @@
 struct VertexIn
 {
 	float3 PosL    : POSITION;
+#ifndef POSITION_ONLY
 	float2 TexC    : TEXCOORD;
+#endif
 };
 
 struct VertexOut
@@ -16,19 +18,27 @@ struct VertexOut
 	float2 TexC    : TEXCOORD;
 };
 
-VertexOut VS(VertexIn vin)
+VertexOut VS(VertexIn vin, uint instanceID : SV_InstanceID)
 {
 	VertexOut vout = (VertexOut)0.0f;
 
+	InstanceData instData = GetInstanceData(instanceID);
+
 	MaterialData matData = gMaterialData[gMaterialIndex];
 	
+#ifdef PACKED_VERTEX
+    vin.PosL = DequantizePosition(vin.PosL);
+#endif
+	
     // Transform to world space.
-    float4 posW = mul(gWorld, float4(vin.PosL, 1.0f));
+    float4 posW = mul(instData.World, float4(vin.PosL, 1.0f));
 
     // Transform to homogeneous clip space.
     vout.PosH = mul(gViewProj, posW);
 	
+#ifndef POSITION_ONLY
     vout.TexC = mul(matData.MatTransform, float4(vin.TexC, 0.0f, 1.0f)).xy;
+#endif
 	
     return vout;
 }
@@ -32,11 +32,16 @@ VertexOut VS(VertexIn vin, uint vertexID : SV_VertexID)
     return vout;
 }
 
-VertexOut WireframeVS(VertexIn vin, uint vertexID : SV_VertexID)
+// Instanced, see GetInstanceData.
+VertexOut WireframeVS(VertexIn vin, uint vertexID : SV_VertexID, uint instanceID : SV_InstanceID)
 {
     VertexOut vout;
     
-    vout.PosW = mul(gWorld, float4(vin.PosL, 1.0f));
+#ifdef PACKED_VERTEX
+    vin.PosL = DequantizePosition(vin.PosL);
+#endif
+    
+    vout.PosW = mul(GetInstanceData(instanceID).World, float4(vin.PosL, 1.0f));
 	
 	// Transform to homogeneous clip space.
     vout.PosH = mul(gViewProj, vout.PosW);
@@ -0,0 +1,184 @@
+//
+// DirtyListTests.cpp
+//
+
+#include "TestFramework.h"
+#include "Core/Common/DirtyList.h"
+#include "Core/Math/Math.h"
+
+using namespace DirectX;
+using namespace Tests;
+using namespace Utility::GeometryManager;
+
+namespace
+{
+	const uint32 NumFrameResources = 3;
+
+	class TestObject : public Core::IObject
+	{
+	};
+
+	// A frame of the renderer: the next frame resource catches up with every object stale in it.
+	uint32 UpdateFrame(DirtyList& InOutList, uint32& InOutFrame)
+	{
+		const uint32 frameResource = InOutFrame++ % NumFrameResources;
+		return InOutList.Update(frameResource, [](Core::IObject* InObject) { InObject->bIsDirty = false; });
+	}
+}
+
+TEST_CASE(DirtyList_UploadCounts)
+{
+	std::vector<TestObject> objects(1000);
+	DirtyList list;
+	list.Reset(NumFrameResources);
+	for (TestObject& object : objects)
+	{
+		list.Add(&object);
+	}
+	CHECK(list.GetNumDirty() == 1000);
+
+	// New objects go up once to every frame resource, then nothing is left to do.
+	uint32 frame = 0;
+	for (uint32 i = 0; i < NumFrameResources; ++i)
+	{
+		CHECK(UpdateFrame(list, frame) == 1000);
+	}
+	CHECK(list.GetNumDirty() == 0);
+	CHECK(UpdateFrame(list, frame) == 0);
+
+	// Marked twice between two updates, still one upload per frame resource.
+	objects[3].MarkAsDirty();
+	objects[3].MarkAsDirty();
+	objects[500].MarkAsDirty();
+	CHECK(list.GetNumDirty() == 2);
+	for (uint32 i = 0; i < NumFrameResources; ++i)
+	{
+		CHECK(UpdateFrame(list, frame) == 2);
+	}
+	CHECK(UpdateFrame(list, frame) == 0 && list.GetNumDirty() == 0);
+
+	// Marked again while the other frame resources are catching up, the ones already updated see it again.
+	objects[7].MarkAsDirty();
+	CHECK(UpdateFrame(list, frame) == 1);
+	objects[7].MarkAsDirty();
+	uint32 numUploads = 0;
+	for (uint32 i = 0; i < NumFrameResources; ++i)
+	{
+		numUploads += UpdateFrame(list, frame);
+	}
+	CHECK(numUploads == NumFrameResources);
+	CHECK(UpdateFrame(list, frame) == 0);
+
+	// Removed while dirty, the list forgets it and keeps the others.
+	objects[10].MarkAsDirty();
+	objects[11].MarkAsDirty();
+	list.Remove(&objects[10]);
+	CHECK(objects[10].DirtyList == nullptr && objects[10].DirtySlot == -1);
+	CHECK(list.GetNumDirty() == 1);
+
+	std::vector<Core::IObject*> visited;
+	list.Update(frame++ % NumFrameResources, [&](Core::IObject* InObject) { visited.push_back(InObject); });
+	CHECK(visited.size() == 1 && visited[0] == &objects[11]);
+
+	list.Reset(NumFrameResources);
+	CHECK(list.GetNumDirty() == 0 && objects[11].DirtySlot == -1);
+}
+
+TEST_CASE(DirtyList_AffineInverseTranspose)
+{
+	TestRandom random(43);
+	bool bMatches = true;
+	for (uint32 i = 0; i < 1000; ++i)
+	{
+		const XMMATRIX world = XMMatrixMultiply(XMMatrixMultiply(
+			XMMatrixScaling(random.NextFloat(0.1f, 10), random.NextFloat(0.1f, 10), random.NextFloat(0.1f, 10)),
+			XMMatrixRotationQuaternion(XMQuaternionNormalize(XMVectorSet(random.NextFloat(-1, 1), random.NextFloat(-1, 1), random.NextFloat(-1, 1), random.NextFloat(-1, 1))))),
+			XMMatrixTranslation(random.NextFloat(-100, 100), random.NextFloat(-100, 100), random.NextFloat(-100, 100)));
+
+		XMFLOAT4X4 fast, expected;
+		XMStoreFloat4x4(&fast, (XMMATRIX)Math::AffineInverseTranspose(Math::Matrix4(world)));
+		XMStoreFloat4x4(&expected, XMMatrixTranspose(XMMatrixInverse(nullptr, world)));
+		for (uint32 r = 0; r < 4; ++r)
+		{
+			for (uint32 c = 0; c < 4; ++c)
+			{
+				bMatches &= fabsf(fast.m[r][c] - expected.m[r][c]) <= 1e-4f * (1.0f + fabsf(expected.m[r][c]));
+			}
+		}
+	}
+	CHECK(bMatches);
+}
+
+TEST_CASE(DirtyList_Benchmark)
+{
+	// 100k static objects, as a big scene between edits.
+	std::vector<TestObject> objects(100000);
+	DirtyList list;
+	list.Reset(NumFrameResources);
+	for (TestObject& object : objects)
+	{
+		list.Add(&object);
+	}
+
+	uint32 frame = 0;
+	const double firstMs = MeasureMs(1, [&]() { UpdateFrame(list, frame); });
+	while (list.GetNumDirty() > 0)
+	{
+		UpdateFrame(list, frame);
+	}
+
+	uint32 numUpdated = 0;
+	const double steadyMs = MeasureMs(100, [&]() { numUpdated += UpdateFrame(list, frame); });
+	CHECK(numUpdated == 0);
+
+	// What every frame cost before: a look at every object.
+	uint32 numDirty = 0;
+	const double scanMs = MeasureMs(10, [&]()
+	{
+		for (TestObject& object : objects)
+		{
+			numDirty += object.bIsDirty ? 1 : 0;
+		}
+	});
+
+	// 100 edited objects.
+	for (uint32 i = 0; i < 100; ++i)
+	{
+		objects[i * 997].MarkAsDirty();
+	}
+	uint32 numEdited = 0;
+	const double editMs = MeasureMs(1, [&]() { numEdited = UpdateFrame(list, frame); });
+	CHECK(numEdited == 100);
+
+	// The InvTWorld of 100k different worlds, summed so none is optimized away.
+	std::vector<XMFLOAT4X4> worlds(100000);
+	for (uint32 i = 0; i < (uint32)worlds.size(); ++i)
+	{
+		XMStoreFloat4x4(&worlds[i], XMMatrixMultiply(XMMatrixScaling(2, 3, 4), XMMatrixTranslation((float)i, 6, 7)));
+	}
+	XMVECTOR sum = XMVectorZero();
+	const double fastMs = MeasureMs(10, [&]()
+	{
+		for (const XMFLOAT4X4& world : worlds)
+		{
+			sum = XMVectorAdd(sum, ((XMMATRIX)Math::AffineInverseTranspose(Math::Matrix4(XMLoadFloat4x4(&world)))).r[0]);
+		}
+	});
+	const double invertMs = MeasureMs(10, [&]()
+	{
+		for (const XMFLOAT4X4& world : worlds)
+		{
+			sum = XMVectorAdd(sum, ((XMMATRIX)Math::Transpose(Math::Invert(Math::Matrix4(XMLoadFloat4x4(&world))))).r[0]);
+		}
+	});
+
+	Report("%u objects: first upload %.3f ms, static frame %.4f ms (full scan %.3f ms, %u dirty), 100 edits %.4f ms",
+		(uint32)objects.size(), firstMs, steadyMs, scanMs, numDirty, editMs);
+	Report("100k InvTWorld: affine %.3f ms, Transpose(Invert) %.3f ms (%g)", fastMs, invertMs, XMVectorGetX(sum));
+
+	// Only the static frame is checked, the InvTWorld paths are close with the scalar DirectXMath of non Windows builds.
+	if (bCheckTimings)
+	{
+		CHECK(steadyMs < 0.01);
+	}
+}
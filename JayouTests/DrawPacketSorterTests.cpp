@@ -0,0 +1,148 @@
+//
+// DrawPacketSorterTests.cpp
+//
+
+#include "TestFramework.h"
+#include "Core/Common/DrawPacketSorter.h"
+
+#include <algorithm>
+
+using namespace Tests;
+using namespace Utility::GeometryManager;
+
+namespace
+{
+	// A frame's worth of keys: a few layers and pipelines, opaque and transparent, in packet order as built.
+	std::vector<uint64> CreateKeys(uint32 InCount, uint32 InSeed)
+	{
+		TestRandom random(InSeed);
+		std::vector<uint64> keys(InCount);
+		for (uint32 i = 0; i < InCount; ++i)
+		{
+			const uint32 layer = random.NextUInt(4);
+			const float depth = DrawPacketSorter::NormalizeDepth(random.NextFloat(0.1f, 1000.0f), 0.1f, 1000.0f);
+			keys[i] = layer == 2 ?
+				DrawPacketSorter::MakeTransparentKey(layer, random.NextUInt(3), depth, random.NextUInt(300), i) :
+				DrawPacketSorter::MakeOpaqueKey(layer, random.NextUInt(3), depth, random.NextUInt(5000), random.NextUInt(300), i);
+		}
+		return keys;
+	}
+}
+
+TEST_CASE(DrawPacketSorter_MatchesStdSort)
+{
+	DrawPacketSorter sorter;
+
+	// Below and above the size std::sort handles, and one where most digits are the same for every key.
+	for (uint32 numKeys : { 0u, 1u, 100u, 257u, 5000u, 100000u })
+	{
+		std::vector<uint64> keys = CreateKeys(numKeys, numKeys);
+		std::vector<uint64> expected = keys;
+		std::sort(expected.begin(), expected.end());
+
+		sorter.Sort(keys);
+		CHECK(keys == expected);
+	}
+
+	std::vector<uint64> keys(3000);
+	for (uint32 i = 0; i < (uint32)keys.size(); ++i)
+	{
+		keys[i] = DrawPacketSorter::MakeOpaqueKey(1, 0, 0.5f, 7, (uint32)keys.size() - i, i);
+	}
+	std::vector<uint64> expected = keys;
+	std::sort(expected.begin(), expected.end());
+	sorter.Sort(keys);
+	CHECK(keys == expected);
+}
+
+TEST_CASE(DrawPacketSorter_DrawOrder)
+{
+	TestRandom random(31);
+	const uint32 numPackets = 4000;
+
+	std::vector<float> depths(numPackets);
+	std::vector<uint64> opaque(numPackets), transparent(numPackets);
+	for (uint32 i = 0; i < numPackets; ++i)
+	{
+		depths[i] = random.NextFloat(0.5f, 800.0f);
+		const float depth = DrawPacketSorter::NormalizeDepth(depths[i], 0.5f, 800.0f);
+		opaque[i] = DrawPacketSorter::MakeOpaqueKey(0, 1, depth, 3, 3, i);
+		transparent[i] = DrawPacketSorter::MakeTransparentKey(2, 1, depth, 3, i);
+	}
+
+	DrawPacketSorter sorter;
+	sorter.Sort(opaque);
+	sorter.Sort(transparent);
+
+	// Opaque front to back to the depth step of their field, transparent back to front to theirs.
+	bool bFrontToBack = true, bBackToFront = true;
+	for (uint32 i = 1; i < numPackets; ++i)
+	{
+		const float previous = depths[DrawPacketSorter::GetPacket(opaque[i - 1])];
+		bFrontToBack &= depths[DrawPacketSorter::GetPacket(opaque[i])] >= previous * 0.99f;
+		bBackToFront &= depths[DrawPacketSorter::GetPacket(transparent[i])] <= depths[DrawPacketSorter::GetPacket(transparent[i - 1])] * 1.0001f;
+	}
+	CHECK(bFrontToBack);
+	CHECK(bBackToFront);
+
+	// Layer first, then the pipeline, whatever the depth.
+	std::vector<uint64> keys = { DrawPacketSorter::MakeOpaqueKey(1, 0, 0.0f, 0, 0, 0), DrawPacketSorter::MakeOpaqueKey(0, 2, 1.0f, 0, 0, 1),
+		DrawPacketSorter::MakeOpaqueKey(0, 1, 1.0f, 0, 0, 2), DrawPacketSorter::MakeTransparentKey(2, 0, 0.0f, 0, 3) };
+	sorter.Sort(keys);
+	CHECK(DrawPacketSorter::GetPacket(keys[0]) == 2 && DrawPacketSorter::GetPacket(keys[1]) == 1);
+	CHECK(DrawPacketSorter::GetPacket(keys[2]) == 0 && DrawPacketSorter::GetPacket(keys[3]) == 3);
+	CHECK(DrawPacketSorter::GetLayer(keys[3]) == 2 && DrawPacketSorter::GetPipeline(keys[1]) == 2);
+}
+
+TEST_CASE(DrawPacketSorter_DepthUsesTheWholeField)
+{
+	CHECK(DrawPacketSorter::NormalizeDepth(0.1f, 0.1f, 1000.0f) == 0.0f);
+	CHECK(DrawPacketSorter::NormalizeDepth(1000.0f, 0.1f, 1000.0f) == 1.0f);
+	CHECK(DrawPacketSorter::NormalizeDepth(0.01f, 0.1f, 1000.0f) == 0.0f);
+	CHECK(DrawPacketSorter::NormalizeDepth(5000.0f, 0.1f, 1000.0f) == 1.0f);
+	CHECK(fabsf(DrawPacketSorter::NormalizeDepth(50.0f, 0.0f, 100.0f) - 0.5f) < 1e-6f);
+
+	// Logarithmic: the same ratio of depths is the same step anywhere in the range.
+	const float near1 = DrawPacketSorter::NormalizeDepth(1.0f, 0.1f, 1000.0f);
+	const float near2 = DrawPacketSorter::NormalizeDepth(2.0f, 0.1f, 1000.0f);
+	const float far1 = DrawPacketSorter::NormalizeDepth(100.0f, 0.1f, 1000.0f);
+	const float far2 = DrawPacketSorter::NormalizeDepth(200.0f, 0.1f, 1000.0f);
+	CHECK(fabsf((near2 - near1) - (far2 - far1)) < 1e-5f);
+
+	// The near and far ends are the first and last value of the 10 and 24 bit fields.
+	const uint64 opaqueNear = DrawPacketSorter::MakeOpaqueKey(0, 0, 0.0f, 0, 0, 0);
+	const uint64 opaqueFar = DrawPacketSorter::MakeOpaqueKey(0, 0, 1.0f, 0, 0, 0);
+	CHECK(((opaqueNear >> 46) & 0x3ff) == 0 && ((opaqueFar >> 46) & 0x3ff) == 0x3ff);
+
+	const uint64 transparentNear = DrawPacketSorter::MakeTransparentKey(0, 0, 0.0f, 0, 0);
+	const uint64 transparentFar = DrawPacketSorter::MakeTransparentKey(0, 0, 1.0f, 0, 0);
+	CHECK(((transparentNear >> 32) & 0xffffff) == 0xffffff && ((transparentFar >> 32) & 0xffffff) == 0);
+
+	// Every opaque depth value is reached.
+	std::vector<bool> bUsed(1024, false);
+	for (uint32 i = 0; i <= 100000; ++i)
+	{
+		bUsed[(DrawPacketSorter::MakeOpaqueKey(0, 0, i / 100000.0f, 0, 0, 0) >> 46) & 0x3ff] = true;
+	}
+	CHECK(std::find(bUsed.begin(), bUsed.end(), false) == bUsed.end());
+}
+
+TEST_CASE(DrawPacketSorter_Benchmark)
+{
+	const std::vector<uint64> keys = CreateKeys(100000, 37);
+
+	DrawPacketSorter sorter;
+	std::vector<uint64> sorted;
+	const double radixMs = MeasureMs(20, [&]() { sorted = keys; sorter.Sort(sorted); });
+	const double stdMs = MeasureMs(20, [&]() { sorted = keys; std::sort(sorted.begin(), sorted.end()); });
+	const double copyMs = MeasureMs(20, [&]() { sorted = keys; });
+
+	Report("%u keys: radix sort %.3f ms (budget 1 ms), std::sort %.3f ms, copies included (%.3f ms)", (uint32)keys.size(), radixMs, stdMs, copyMs);
+
+	// The 1 ms budget for 100k packets is a frame budget on the target machines and is only reported, a shared or
+	// throttled machine misses it by itself. What the radix sort buys over std::sort does not depend on the machine.
+	if (bCheckTimings)
+	{
+		CHECK(radixMs * 3.0 < stdMs);
+	}
+}
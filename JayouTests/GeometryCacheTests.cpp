@@ -0,0 +1,135 @@
+//
+// GeometryCacheTests.cpp
+//
+
+#include "TestFramework.h"
+#include "Core/Common/GeometryCache.h"
+
+using namespace Tests;
+using namespace Utility::GeometryManager;
+
+namespace
+{
+	// Stands in for the GPU buffers of a RenderItem.
+	struct TestRenderData
+	{
+		uint32 Content = 0;
+	};
+
+	struct TestItem
+	{
+		uint32                          Content = 0;
+		std::shared_ptr<TestRenderData> RenderData;
+		uint64                          GeometryHash = 0;
+		int32                           GeometryUser = -1;
+	};
+
+	typedef GeometryCache<TestItem, TestRenderData> TestCache;
+
+	// What GWorld::CreateRenderItemGeometry does, InHash may collide on purpose.
+	void Upload(TestCache& InCache, TestItem& InItem, uint64 InHash)
+	{
+		InCache.Remove(&InItem);
+		InItem.RenderData = InCache.Share(InHash, &InItem, [&](const TestItem& InSource) { return InSource.Content == InItem.Content; });
+		if (InItem.RenderData == nullptr)
+		{
+			InItem.RenderData = std::make_shared<TestRenderData>();
+			InItem.RenderData->Content = InItem.Content;
+			InCache.Add(InHash, &InItem, InItem.RenderData);
+		}
+	}
+}
+
+TEST_CASE(GeometryCache_SharesUntilTheLastUser)
+{
+	TestCache cache;
+	TestItem items[4];
+	for (TestItem& item : items)
+	{
+		item.Content = 7;
+		Upload(cache, item, 1);
+	}
+	CHECK(cache.GetNumEntries() == 1 && cache.GetNumUsers(1) == 4 && cache.GetSource(1) == &items[0]);
+	CHECK(items[1].RenderData == items[0].RenderData && items[3].RenderData == items[0].RenderData);
+
+	// The item that uploaded it goes, the others still share it and new items still find it.
+	cache.Remove(&items[0]);
+	items[0].RenderData = nullptr;
+	CHECK(cache.GetNumUsers(1) == 3 && cache.GetSource(1) != nullptr && cache.GetSource(1) != &items[0]);
+	CHECK(items[0].GeometryUser == -1);
+
+	TestItem late;
+	late.Content = 7;
+	Upload(cache, late, 1);
+	CHECK(late.RenderData == items[1].RenderData && cache.GetNumUsers(1) == 4);
+
+	// A rebuild with other content leaves the shared entry and uploads its own.
+	items[2].Content = 8;
+	Upload(cache, items[2], 2);
+	CHECK(items[2].RenderData != items[1].RenderData && cache.GetNumEntries() == 2 && cache.GetNumUsers(1) == 3);
+
+	// Every position stays right through the swaps.
+	bool bPositions = true;
+	for (TestItem* item : { &items[1], &items[3], &late })
+	{
+		bPositions &= item->GeometryHash == 1 && item->GeometryUser >= 0 && item->GeometryUser < 3;
+	}
+	CHECK(bPositions);
+
+	cache.Remove(&items[1]);
+	cache.Remove(&late);
+	cache.Remove(&items[3]);
+	CHECK(cache.GetNumUsers(1) == 0 && cache.GetSource(1) == nullptr && cache.GetNumEntries() == 1);
+	cache.Remove(&items[3]);
+	CHECK(cache.GetNumEntries() == 1);
+}
+
+TEST_CASE(GeometryCache_HashCollision)
+{
+	TestCache cache;
+	TestItem a, b, c;
+	a.Content = 1;
+	b.Content = 2;
+	c.Content = 2;
+
+	// Same hash, other content: B uploads its own copy and stays out of the cache, the entry is A's.
+	Upload(cache, a, 5);
+	Upload(cache, b, 5);
+	CHECK(a.RenderData != b.RenderData && b.GeometryUser == -1 && cache.GetNumUsers(5) == 1 && cache.GetSource(5) == &a);
+
+	// So C, the same as B, does not find B and is not given A's.
+	Upload(cache, c, 5);
+	CHECK(c.RenderData != a.RenderData && c.RenderData != b.RenderData && c.GeometryUser == -1);
+	cache.Remove(&b);
+	CHECK(cache.GetNumUsers(5) == 1);
+}
+
+TEST_CASE(GeometryCache_RemoveBenchmark)
+{
+	// 100k items over 100 meshes, as 1000 copies of an imported model.
+	const uint32 numItems = 100000;
+	TestCache cache;
+	std::vector<TestItem> items(numItems);
+	for (uint32 i = 0; i < numItems; ++i)
+	{
+		items[i].Content = i % 100;
+		Upload(cache, items[i], items[i].Content);
+	}
+	CHECK(cache.GetNumEntries() == 100 && cache.GetNumUsers(0) == 1000);
+
+	// One removal out of 100k, the source included, then back in.
+	uint32 next = 0;
+	const double removeMs = MeasureMs(1000, [&]()
+	{
+		TestItem& item = items[(next++ * 7919) % numItems];
+		cache.Remove(&item);
+		Upload(cache, item, item.Content);
+	});
+	CHECK(cache.GetNumEntries() == 100 && cache.GetNumUsers(0) == 1000);
+
+	Report("Remove and share again, 1 of %u items: %.3f us", numItems, removeMs * 1000.0);
+	if (bCheckTimings)
+	{
+		CHECK(removeMs < 0.01);
+	}
+}
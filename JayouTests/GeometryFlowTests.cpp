@@ -0,0 +1,168 @@
+//
+// GeometryFlowTests.cpp
+//
+
+#include "TestMeshes.h"
+#include "Core/Common/MeshletBuilder.h"
+#include "Core/Common/MeshSimplifier.h"
+
+#ifndef JAYOU_NO_ASSIMP
+#include "Core/Common/AssimpImporter.h"
+#endif
+
+#include <unordered_map>
+
+using namespace Tests;
+
+namespace
+{
+	uint64 GetGeometryBytes(const Geometry& InGeo)
+	{
+		uint64 bytes = InGeo.Data.Vertices.size() * sizeof(Vertex) + InGeo.Data.Indices32.size() * sizeof(uint32) + InGeo.Meshlets.size() * sizeof(Meshlet);
+		for (const MeshLOD& lod : InGeo.LODs)
+		{
+			bytes += lod.Indices32.size() * sizeof(uint32);
+		}
+		return bytes;
+	}
+
+	// Where the buffers of a geometry live, they must not change along the way.
+	struct GeometryBuffers
+	{
+		const Vertex*  Vertices;
+		const uint32*  Indices;
+		const uint32*  LOD;
+		const Meshlet* Meshlets;
+
+		explicit GeometryBuffers(const Geometry& InGeo) :
+			Vertices(InGeo.Data.Vertices.data()), Indices(InGeo.Data.Indices32.data()),
+			LOD(InGeo.LODs.empty() ? nullptr : InGeo.LODs[0].Indices32.data()), Meshlets(InGeo.Meshlets.data()) {}
+
+		bool operator==(const GeometryBuffers& InOther) const
+		{
+			return Vertices == InOther.Vertices && Indices == InOther.Indices && LOD == InOther.LOD && Meshlets == InOther.Meshlets;
+		}
+	};
+
+	// What a render item keeps of its geometry, see GWorld::AddRenderItem.
+	struct CachedGeometry
+	{
+		GeometryData<Vertex> Data;
+		std::vector<MeshLOD> LODs;
+		std::vector<Meshlet> Meshlets;
+	};
+}
+
+TEST_CASE(GeometryFlow_MovedNotCopied)
+{
+	// A converted mesh as the importer leaves it, LODs and meshlets included.
+	std::vector<Geometry> geometries(1);
+	Geometry& source = geometries[0];
+	source.Name = "Flow_0";
+	source.Data = WinUtility::GeometryManager::GeometryCreator::CreateSphere(1.0f, 192, 128);
+	source.Meshlets = MeshletBuilder::BuildMeshlets(source.Data);
+	SimplifyDesc simplifyDesc;
+	simplifyDesc.NumLODs = 2;
+	MeshSimplifier::GenerateLODs(source, simplifyDesc);
+	CHECK(source.LODs.size() == 2);
+
+	const GeometryBuffers buffers(source);
+	const uint64 meshBytes = GetGeometryBytes(source);
+
+	// The steps between the importer and the render item: into the importer's map, out through TakeGeometries and
+	// into the item. Only map nodes and names may be allocated, no mesh data.
+	ResetPeakAllocatedBytes();
+	const uint64 startBytes = GetAllocatedBytes();
+
+	std::unordered_map<std::string, Geometry> imported;
+	for (Geometry& geo : geometries)
+	{
+		imported[geo.Name.ToString()] = std::move(geo);
+	}
+	std::unordered_map<std::string, Geometry> taken = std::move(imported);
+	CHECK(imported.empty() || imported.begin()->second.Data.Vertices.empty());
+
+	Geometry& geo = taken.begin()->second;
+	CHECK(GeometryBuffers(geo) == buffers);
+
+	CachedGeometry item;
+	item.Data = std::move(geo.Data);
+	item.LODs = std::move(geo.LODs);
+	item.Meshlets = std::move(geo.Meshlets);
+
+	const uint64 flowBytes = GetPeakAllocatedBytes() - startBytes;
+	CHECK(item.Data.Vertices.data() == buffers.Vertices && item.Data.Indices32.data() == buffers.Indices);
+	CHECK(item.LODs[0].Indices32.data() == buffers.LOD && item.Meshlets.data() == buffers.Meshlets);
+	CHECK(geo.Data.Vertices.empty() && geo.LODs.empty());
+
+	// The flow before: by value loops and copies into the map, the item and its CPU buffer.
+	ResetPeakAllocatedBytes();
+	const uint64 copyStartBytes = GetAllocatedBytes();
+	{
+		std::unordered_map<std::string, Geometry> copies;
+		for (auto pair : taken)
+		{
+			Geometry copy = pair.second;
+			copies[pair.first] = copy;
+		}
+		CachedGeometry copiedItem;
+		for (auto pair : copies)
+		{
+			copiedItem.Data = pair.second.Data;
+		}
+		copiedItem.Data = item.Data;
+		copiedItem.LODs = item.LODs;
+		copiedItem.Meshlets = item.Meshlets;
+		std::vector<Vertex> vertexBufferCPU = copiedItem.Data.Vertices;
+	}
+	const uint64 copyBytes = GetPeakAllocatedBytes() - copyStartBytes;
+
+	Report("%.1f MB mesh: moved along with %.1f KB allocated, copied along with %.1f MB", meshBytes / 1048576.0, flowBytes / 1024.0, copyBytes / 1048576.0);
+	CHECK(flowBytes < meshBytes / 100);
+}
+
+#ifndef JAYOU_NO_ASSIMP
+
+TEST_CASE(GeometryFlow_ImportPeakMemory)
+{
+	// A dense grid, large enough for the conversion to dominate.
+	std::vector<TestMesh> meshes;
+	meshes.push_back({ "Grid", WinUtility::GeometryManager::GeometryCreator::CreatePlane(100.0f, 100.0f, 700, 700) });
+	const std::string path = "JayouTests_GeometryFlow.obj";
+	CHECK(WriteObj(path, meshes));
+
+	ImportGeoDesc desc;
+	desc.Name = "Grid";
+	desc.PathName = path;
+	desc.NumLODs = 0;
+	desc.bBuildMeshlets = false;
+	desc.bOptimizeMesh = false;
+	desc.bUseMeshCache = false;
+
+	AssimpImporter importer;
+	ResetPeakAllocatedBytes();
+	const uint64 startBytes = GetAllocatedBytes();
+	bool bImported = false;
+	const double importMs = MeasureMs(1, [&]() { bImported = importer.Import(desc); });
+	const uint64 peakBytes = GetPeakAllocatedBytes() - startBytes;
+	CHECK(bImported);
+	remove(path.c_str());
+	if (!bImported)
+		return;
+
+	// Taken out by move, the importer keeps nothing.
+	CHECK(importer.GetAllGeometries().size() == 1);
+	const Vertex* vertices = importer.GetAllGeometries().begin()->second.Data.Vertices.data();
+	std::unordered_map<std::string, Geometry> geometries = importer.TakeGeometries();
+	CHECK(importer.GetAllGeometries().empty());
+	CHECK(geometries.size() == 1 && geometries.begin()->second.Data.Vertices.data() == vertices);
+
+	const uint64 meshBytes = GetGeometryBytes(geometries.begin()->second);
+	Report("%u vertices, %.1f MB mesh: import %.0f ms, peak %.1f MB over the start (Assimp's scene included)",
+		(uint32)geometries.begin()->second.Data.Vertices.size(), meshBytes / 1048576.0, importMs, peakBytes / 1048576.0);
+
+	// The copy chain this replaced peaked at about 8 times the mesh on top of the scene.
+	CHECK(peakBytes < 6 * meshBytes);
+}
+
+#endif // JAYOU_NO_ASSIMP
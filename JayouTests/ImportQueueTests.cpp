@@ -0,0 +1,178 @@
+//
+// ImportQueueTests.cpp
+//
+
+#include "TestMeshes.h"
+
+#ifndef JAYOU_NO_ASSIMP
+
+#include "Core/Common/ImportQueue.h"
+#include "Core/Common/MeshCache.h"
+
+#include <chrono>
+#include <thread>
+
+using namespace Tests;
+
+namespace
+{
+	// What is left of a task once it is drained.
+	struct FinishedImport
+	{
+		std::string Name;
+		bool        bSucceeded = false;
+		bool        bCancelled = false;
+		std::string Error;
+		uint32      NumGeometries = 0;
+		uint32      NumBVHs = 0;
+		float       Progress = 0.0f;
+	};
+
+	// Drains InQueue once a "frame" until InCount tasks came out, or a minute went by.
+	std::vector<FinishedImport> DrainUntil(ImportQueue& InQueue, uint32 InCount)
+	{
+		std::vector<FinishedImport> finished;
+		const auto start = std::chrono::steady_clock::now();
+		while (finished.size() < InCount && std::chrono::steady_clock::now() - start < std::chrono::minutes(1))
+		{
+			InQueue.Drain([&](ImportTask& InTask)
+			{
+				FinishedImport import;
+				import.Name = InTask.Desc.Name;
+				import.bSucceeded = InTask.bSucceeded;
+				import.bCancelled = InTask.Progress.bCancel;
+				import.Error = InTask.bSucceeded ? std::string() : InTask.Importer.GetLastError();
+				import.NumGeometries = (uint32)InTask.Geometries.size();
+				for (const auto& pair : InTask.BVHs)
+				{
+					import.NumBVHs += pair.second.IsEmpty() ? 0 : 1;
+				}
+				import.Progress = InTask.Progress.Progress;
+				finished.push_back(import);
+			});
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		return finished;
+	}
+
+	ImportGeoDesc MakeDesc(const std::string& InName, const std::string& InPath)
+	{
+		ImportGeoDesc desc;
+		desc.Name = InName;
+		desc.PathName = InPath;
+		desc.NumLODs = 1;
+		desc.bUseMeshCache = false;
+		return desc;
+	}
+}
+
+TEST_CASE(ImportQueue_CompletesAndReportsFailures)
+{
+	const std::string path = "JayouTests_ImportQueue.obj";
+	CHECK(WriteObj(path, CreateTestMeshes()));
+
+	// Add returns before the import is done, the tasks are there for the progress panel meanwhile.
+	ImportQueue queue;
+	const ImportTask* first = queue.Add(MakeDesc("First", path));
+	queue.Add(MakeDesc("Missing", "JayouTests_ImportQueue_Missing.obj"));
+	queue.Add(MakeDesc("Second", path));
+	CHECK(queue.GetTasks().size() == 3 && queue.GetTasks()[0].get() == first);
+
+	const std::vector<FinishedImport> finished = DrainUntil(queue, 3);
+	remove(path.c_str());
+	CHECK(finished.size() == 3 && queue.GetTasks().empty());
+	CHECK(queue.Drain([](ImportTask&) {}) == 0);
+
+	uint32 numSucceeded = 0;
+	for (const FinishedImport& import : finished)
+	{
+		if (import.Name == "Missing")
+		{
+			// Handed out all the same, with the reason.
+			CHECK(!import.bSucceeded && !import.Error.empty() && import.NumGeometries == 0);
+		}
+		else
+		{
+			CHECK(import.bSucceeded && !import.bCancelled && import.Error.empty());
+			CHECK(import.NumGeometries == 4 && import.NumBVHs == 4 && import.Progress == 1.0f);
+			numSucceeded++;
+		}
+	}
+	CHECK(numSucceeded == 2);
+}
+
+TEST_CASE(ImportQueue_Cancellation)
+{
+	const std::string path = "JayouTests_ImportQueueCancel.obj";
+	CHECK(WriteObj(path, CreateTestMeshes()));
+
+	// Cancelled while queued or running: it stops at its next progress update and still comes out, marked.
+	ImportQueue queue;
+	ImportTask* cancelled = queue.Add(MakeDesc("Cancelled", path));
+	queue.Add(MakeDesc("Kept", path));
+	cancelled->Progress.bCancel = true;
+
+	const std::vector<FinishedImport> finished = DrainUntil(queue, 2);
+	CHECK(finished.size() == 2);
+	for (const FinishedImport& import : finished)
+	{
+		if (import.Name == "Cancelled")
+		{
+			CHECK(import.bCancelled && (import.bSucceeded || import.Error == "Import cancelled"));
+		}
+		else
+		{
+			CHECK(import.bSucceeded && !import.bCancelled);
+		}
+	}
+
+	// CancelAll waits for the running ones and hands nothing out, neither do its jobs later.
+	for (uint32 i = 0; i < 4; ++i)
+	{
+		queue.Add(MakeDesc("Dropped" + std::to_string(i), path));
+	}
+	queue.CancelAll();
+	CHECK(queue.GetTasks().empty());
+	std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	CHECK(queue.Drain([](ImportTask&) {}) == 0);
+
+	// And the queue still works after.
+	queue.Add(MakeDesc("After", path));
+	const std::vector<FinishedImport> after = DrainUntil(queue, 1);
+	CHECK(after.size() == 1 && after[0].bSucceeded);
+	remove(path.c_str());
+}
+
+TEST_CASE(ImportQueue_MeshCache)
+{
+	const std::string path = "JayouTests_ImportQueueCache.obj";
+	const std::string cachePath = MeshCache::GetCachePath(path);
+	CHECK(WriteObj(path, CreateTestMeshes()));
+	remove(cachePath.c_str());
+
+	// The first import writes the cache, the second loads it, BVHs included.
+	ImportQueue queue;
+	ImportGeoDesc desc = MakeDesc("Cached", path);
+	desc.bUseMeshCache = true;
+	queue.Add(desc);
+	const std::vector<FinishedImport> imported = DrainUntil(queue, 1);
+
+	FILE* cacheFile = fopen(cachePath.c_str(), "rb");
+	CHECK(cacheFile != nullptr);
+	if (cacheFile != nullptr)
+		fclose(cacheFile);
+
+	queue.Add(desc);
+	const std::vector<FinishedImport> loaded = DrainUntil(queue, 1);
+	remove(path.c_str());
+	remove(cachePath.c_str());
+
+	CHECK(imported.size() == 1 && loaded.size() == 1);
+	if (imported.size() == 1 && loaded.size() == 1)
+	{
+		CHECK(imported[0].bSucceeded && loaded[0].bSucceeded);
+		CHECK(loaded[0].NumGeometries == imported[0].NumGeometries && loaded[0].NumBVHs == imported[0].NumBVHs);
+	}
+}
+
+#endif // JAYOU_NO_ASSIMP
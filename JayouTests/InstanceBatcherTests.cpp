@@ -0,0 +1,132 @@
+//
+// InstanceBatcherTests.cpp
+//
+
+#include "TestFramework.h"
+#include "Core/Common/DrawPacketSorter.h"
+#include "Core/Common/InstanceBatcher.h"
+
+#include <set>
+
+using namespace Tests;
+using namespace Utility::GeometryManager;
+
+namespace
+{
+	InstanceBatchKey MakeBatchKey(uint64 InGeometry, uint32 InMaterial, bool bInCanBatch = true)
+	{
+		InstanceBatchKey key;
+		key.Geometry = InGeometry;
+		key.Material = InMaterial;
+		key.bCanBatch = bInCanBatch;
+		return key;
+	}
+}
+
+TEST_CASE(InstanceBatcher_SameGeometryIsOneDraw)
+{
+	// The same model placed 500 times.
+	InstanceBatcher batcher;
+	batcher.Reset();
+	batcher.BeginPass();
+	for (uint32 i = 0; i < 500; ++i)
+	{
+		batcher.Add(i, MakeBatchKey(0x1234, 2), 1000 + i);
+	}
+
+	CHECK(batcher.GetBatches().size() == 1);
+	CHECK(batcher.GetBatches()[0].Packet == 0 && batcher.GetBatches()[0].InstanceCount == 500);
+
+	bool bPacked = batcher.GetInstanceIndices().size() == 500;
+	for (uint32 i = 0; bPacked && i < 500; ++i)
+	{
+		bPacked = batcher.GetInstanceIndices()[i] == 1000 + i;
+	}
+	CHECK(bPacked);
+
+	// Another material, another variant, or a packet that must be drawn alone each break the batch.
+	batcher.Reset();
+	batcher.BeginPass();
+	batcher.Add(0, MakeBatchKey(1, 0), 0);
+	batcher.Add(1, MakeBatchKey(1, 1), 1);
+	InstanceBatchKey lod = MakeBatchKey(1, 1);
+	lod.Variant = 1;
+	batcher.Add(2, lod, 2);
+	batcher.Add(3, MakeBatchKey(1, 1, false), 3);
+	batcher.Add(4, MakeBatchKey(1, 1, false), 4);
+	batcher.Add(5, MakeBatchKey(1, 1), 5);
+	batcher.Add(6, MakeBatchKey(1, 1), 6);
+	CHECK(batcher.GetBatches().size() == 6);
+	CHECK(batcher.GetBatches().back().Packet == 5 && batcher.GetBatches().back().InstanceCount == 2);
+}
+
+TEST_CASE(InstanceBatcher_SortedScene)
+{
+	// 20 models with 3 materials each scattered over a scene, sorted as the renderer sorts its draws.
+	TestRandom random(41);
+	const uint32 numPackets = 5000;
+	std::vector<InstanceBatchKey> batchKeys(numPackets);
+	std::vector<uint64> sortKeys(numPackets);
+	for (uint32 i = 0; i < numPackets; ++i)
+	{
+		const uint32 geometry = random.NextUInt(20);
+		const uint32 material = random.NextUInt(3);
+		batchKeys[i] = MakeBatchKey(0x9e3779b97f4a7c15ull * (geometry + 1), material, i % 97 != 0);
+
+		// One depth bucket, so geometry and material decide the order.
+		sortKeys[i] = DrawPacketSorter::MakeOpaqueKey(0, 0, 0.5f, geometry, material, i);
+	}
+
+	DrawPacketSorter sorter;
+	sorter.Sort(sortKeys);
+
+	InstanceBatcher batcher;
+	batcher.Reset();
+
+	// Two passes share the instance index list.
+	for (uint32 pass = 0; pass < 2; ++pass)
+	{
+		batcher.BeginPass();
+		CHECK(batcher.GetPassInstanceOffset() == pass * numPackets);
+
+		for (uint64 key : sortKeys)
+		{
+			const uint32 packet = DrawPacketSorter::GetPacket(key);
+			batcher.Add(packet, batchKeys[packet], packet);
+		}
+		CHECK(batcher.GetNumPassInstances() == numPackets);
+
+		// Every packet drawn once, every instance of a batch with the key of its first packet.
+		std::set<uint32> drawn;
+		uint32 numAlone = 0;
+		bool bSameKey = true;
+		uint32 nextOffset = batcher.GetPassInstanceOffset();
+		for (const InstanceBatch& batch : batcher.GetBatches())
+		{
+			bSameKey &= batch.InstanceOffset == nextOffset && batch.InstanceCount > 0;
+			nextOffset = batch.InstanceOffset + batch.InstanceCount;
+
+			const InstanceBatchKey& first = batchKeys[batch.Packet];
+			numAlone += first.bCanBatch ? 0 : 1;
+			for (uint32 i = 0; i < batch.InstanceCount; ++i)
+			{
+				const uint32 packet = batcher.GetInstanceIndices()[batch.InstanceOffset + i];
+				bSameKey &= first.bCanBatch ? first.CanJoin(batchKeys[packet]) : batch.InstanceCount == 1;
+				drawn.insert(packet);
+			}
+		}
+		CHECK(bSameKey);
+		CHECK(drawn.size() == numPackets);
+
+		// At most one batch per model and material, split only by the packets drawn alone.
+		const uint32 numBatches = (uint32)batcher.GetBatches().size();
+		CHECK(numBatches <= 60 + 2 * numAlone);
+		if (pass == 0)
+		{
+			Report("%u packets, %u draws (%u not batchable)", numPackets, numBatches, numAlone);
+		}
+	}
+
+	batcher.Reset();
+	CHECK(batcher.GetInstanceIndices().empty() && batcher.GetPassInstanceOffset() == 0);
+}
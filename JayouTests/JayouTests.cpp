@@ -0,0 +1,34 @@
+//
+// JayouTests.cpp
+//
+
+#include "TestFramework.h"
+
+// JayouTests [name filter]: runs the tests whose name contains the filter, all of them without one.
+int main(int argc, char* argv[])
+{
+	const std::string filter = argc > 1 ? argv[1] : "";
+
+	uint32 numRun = 0, numFailed = 0;
+	for (const Tests::TestCase& test : Tests::GetTests())
+	{
+		if (std::string(test.Name).find(filter) == std::string::npos)
+			continue;
+
+		printf("[ RUN  ] %s\n", test.Name);
+		fflush(stdout);
+
+		const uint32 failuresBefore = Tests::GetNumFailures();
+		test.Function();
+		const bool bPassed = Tests::GetNumFailures() == failuresBefore;
+
+		printf("[ %s ] %s\n", bPassed ? " OK " : "FAIL", test.Name);
+		fflush(stdout);
+
+		numRun++;
+		numFailed += bPassed ? 0 : 1;
+	}
+
+	printf("%u tests, %u failed\n", numRun, numFailed);
+	return numRun != 0 && numFailed == 0 ? 0 : 1;
+}
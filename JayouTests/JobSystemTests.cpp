@@ -0,0 +1,200 @@
+//
+// JobSystemTests.cpp
+//
+
+#include "TestFramework.h"
+#include "Core/Common/ThreadManager.h"
+
+#include <cmath>
+
+using namespace Tests;
+using namespace Utility::ThreadManager;
+
+TEST_CASE(JobSystem_ParallelForCoversEveryIndex)
+{
+	JobSystem& jobSystem = JobSystem::Get();
+	CHECK(jobSystem.GetNumThreads() >= 2);
+
+	for (uint32 count : { 0u, 1u, 7u, 1000u, 100003u })
+	{
+		for (uint32 grainSize : { 0u, 1u, 3u, 64u, 5000u })
+		{
+			std::vector<std::atomic<uint32>> visits(count);
+			for (std::atomic<uint32>& visit : visits)
+			{
+				visit = 0;
+			}
+
+			std::atomic<bool> bRangesOk(true);
+			jobSystem.ParallelFor(count, grainSize, [&](uint32 InBegin, uint32 InEnd)
+			{
+				if (InBegin >= InEnd || InEnd > count || (grainSize > 1 && InEnd - InBegin > grainSize))
+					bRangesOk = false;
+
+				for (uint32 i = InBegin; i < InEnd; ++i)
+				{
+					visits[i]++;
+				}
+			});
+
+			bool bOnce = true;
+			for (const std::atomic<uint32>& visit : visits)
+			{
+				bOnce &= visit.load() == 1;
+			}
+			CHECK(bOnce);
+			CHECK(bRangesOk);
+		}
+	}
+}
+
+TEST_CASE(JobSystem_ParallelReduceIsDeterministic)
+{
+	JobSystem& jobSystem = JobSystem::Get();
+
+	const uint64 sum = jobSystem.ParallelReduce<uint64>(1000000, 1000, 0,
+		[](uint32 InBegin, uint32 InEnd) { uint64 s = 0; for (uint32 i = InBegin; i < InEnd; ++i) s += i; return s; },
+		[](uint64 a, uint64 b) { return a + b; });
+	CHECK(sum == 999999ull * 1000000ull / 2);
+
+	// Folded in range order, so float rounding comes out the same as a serial loop over the same ranges.
+	auto map = [](uint32 InBegin, uint32 InEnd) { float s = 0.0f; for (uint32 i = InBegin; i < InEnd; ++i) s += sqrtf((float)i); return s; };
+	float serial = 0.0f;
+	for (uint32 begin = 0; begin < 300000; begin += 777)
+	{
+		serial += map(begin, std::min(begin + 777, 300000u));
+	}
+
+	bool bSame = true;
+	for (uint32 i = 0; i < 10; ++i)
+	{
+		bSame &= jobSystem.ParallelReduce<float>(300000, 777, 0.0f, map, [](float a, float b) { return a + b; }) == serial;
+	}
+	CHECK(bSame);
+	CHECK(jobSystem.ParallelReduce<uint32>(0, 16, 5, [](uint32, uint32) { return 1u; }, [](uint32 a, uint32 b) { return a + b; }) == 5);
+}
+
+TEST_CASE(JobSystem_Dependencies)
+{
+	JobSystem& jobSystem = JobSystem::Get();
+
+	// A second group runs only once the first is done, and then a third.
+	std::atomic<uint32> numFirst(0), numSecond(0);
+	std::atomic<bool> bOrdered(true);
+	JobCounter first, second, third;
+	for (uint32 i = 0; i < 64; ++i)
+	{
+		jobSystem.Run([&]() { std::this_thread::sleep_for(std::chrono::microseconds(50)); numFirst++; }, &first);
+	}
+	for (uint32 i = 0; i < 16; ++i)
+	{
+		jobSystem.Run([&]() { if (numFirst.load() != 64) bOrdered = false; numSecond++; }, &second, &first);
+	}
+	jobSystem.Run([&]() { if (numSecond.load() != 16) bOrdered = false; }, &third, &second);
+
+	jobSystem.Wait(third);
+	CHECK(first.IsDone() && second.IsDone() && third.IsDone());
+	CHECK(numFirst.load() == 64 && numSecond.load() == 16);
+	CHECK(bOrdered);
+
+	// A dependency already done queues the job right away.
+	JobCounter after;
+	std::atomic<bool> bRan(false);
+	jobSystem.Run([&]() { bRan = true; }, &after, &first);
+	jobSystem.Wait(after);
+	CHECK(bRan);
+
+	// Jobs start and wait for jobs of their own without deadlocking, the waits help.
+	std::atomic<uint32> numLeaves(0);
+	JobCounter outer;
+	for (uint32 i = 0; i < 8; ++i)
+	{
+		jobSystem.Run([&]()
+		{
+			JobCounter inner;
+			for (uint32 j = 0; j < 8; ++j)
+			{
+				jobSystem.Run([&]() { numLeaves++; }, &inner);
+			}
+			jobSystem.Wait(inner);
+		}, &outer);
+	}
+	jobSystem.Wait(outer);
+	CHECK(numLeaves.load() == 64);
+}
+
+TEST_CASE(JobSystem_SetNumThreads)
+{
+	JobSystem& jobSystem = JobSystem::Get();
+	const uint32 numThreads = jobSystem.GetNumThreads();
+
+	// One thread still keeps a worker for the jobs nobody waits for.
+	for (uint32 setThreads : { 16u, 1u, 5u, 0u })
+	{
+		jobSystem.SetNumThreads(setThreads);
+		const uint32 expected = std::max(2u, setThreads > 0 ? setThreads : std::thread::hardware_concurrency());
+		CHECK(jobSystem.GetNumThreads() == expected);
+
+		const uint32 sum = jobSystem.ParallelReduce(10000u, 7u, 0u,
+			[](uint32 InBegin, uint32 InEnd) { return (InEnd - 1) * InEnd / 2 - (InBegin > 0 ? (InBegin - 1) * InBegin / 2 : 0); },
+			[](uint32 InA, uint32 InB) { return InA + InB; });
+		CHECK(sum == 9999u * 10000u / 2);
+
+		// Picked up by a worker with nobody helping.
+		std::atomic<bool> bRan(false);
+		jobSystem.Run([&]() { bRan = true; });
+		while (!bRan.load())
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	jobSystem.SetNumThreads(numThreads);
+	CHECK(jobSystem.GetNumThreads() == numThreads);
+}
+
+TEST_CASE(JobSystem_Benchmark)
+{
+	JobSystem& jobSystem = JobSystem::Get();
+
+	// Scheduling overhead: empty jobs through Run and Wait.
+	const uint32 numJobs = 10000;
+	const double runMs = MeasureMs(5, [&]()
+	{
+		JobCounter counter;
+		for (uint32 i = 0; i < numJobs; ++i)
+		{
+			jobSystem.Run([]() {}, &counter);
+		}
+		jobSystem.Wait(counter);
+	});
+
+	const double emptyForMs = MeasureMs(100, [&]() { jobSystem.ParallelFor(1024, 1, [](uint32, uint32) {}); });
+
+	// Scaling: the same work on the calling thread alone and spread over every thread.
+	std::vector<float> values(1 << 20);
+	auto work = [&](uint32 InBegin, uint32 InEnd)
+	{
+		for (uint32 i = InBegin; i < InEnd; ++i)
+		{
+			values[i] = sqrtf((float)i) * sinf((float)i);
+		}
+	};
+	const uint32 count = (uint32)values.size();
+	const double serialMs = MeasureMs(3, [&]() { work(0, count); });
+	const double parallelMs = MeasureMs(3, [&]() { jobSystem.ParallelFor(count, 4096, work); });
+
+	Report("%u threads: Run + Wait %.2f us per job, empty ParallelFor of 1024 ranges %.1f us", jobSystem.GetNumThreads(), runMs * 1000.0 / numJobs, emptyForMs * 1000.0);
+	Report("1M sqrt * sin: 1 thread %.3f ms, ParallelFor %.3f ms, %.2fx", serialMs, parallelMs, serialMs / std::max(parallelMs, 1e-6));
+
+	if (bCheckTimings)
+	{
+		CHECK(runMs * 1000.0 / numJobs < 5.0);
+
+		// Scaling is only there to show with more than one core.
+		if (std::thread::hardware_concurrency() >= 4)
+		{
+			CHECK(parallelMs * 1.5 < serialMs);
+		}
+	}
+}
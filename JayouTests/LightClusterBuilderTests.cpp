@@ -0,0 +1,209 @@
+//
+// LightClusterBuilderTests.cpp
+//
+
+#include "TestFramework.h"
+#include "Core/Common/LightClusterBuilder.h"
+
+#include <algorithm>
+
+using namespace Tests;
+using namespace Utility::GeometryManager;
+
+namespace
+{
+	const float NearZ = 0.5f;
+	const float FarZ = 500.0f;
+
+	struct ClusterCamera
+	{
+		XMFLOAT4X4 View;
+		XMFLOAT4X4 Proj;
+	};
+
+	ClusterCamera CreateCamera()
+	{
+		ClusterCamera camera;
+		XMStoreFloat4x4(&camera.View, XMMatrixLookToLH(XMVectorSet(5, 3, -20, 1), XMVectorSet(0.2f, -0.1f, 1, 0), XMVectorSet(0, 1, 0, 0)));
+		XMStoreFloat4x4(&camera.Proj, XMMatrixPerspectiveFovLH(0.25f * XM_PI, 16.0f / 9.0f, NearZ, FarZ));
+		return camera;
+	}
+
+	// Point and spot lights in front of the camera, a few behind it and past the far plane.
+	std::vector<ClusterLight> CreateLights(uint32 InCount, uint32 InFirstIndex, uint32 InSeed)
+	{
+		TestRandom random(InSeed);
+		std::vector<ClusterLight> lights(InCount);
+		for (uint32 i = 0; i < InCount; ++i)
+		{
+			ClusterLight& light = lights[i];
+			light.Position = XMFLOAT3(random.NextFloat(-150, 150), random.NextFloat(-20, 30), random.NextFloat(-60, 550));
+			light.Range = random.NextFloat(1, 25);
+			light.bSpotLight = i % 3 == 0;
+			XMStoreFloat3(&light.Direction, XMVector3Normalize(XMVectorSet(random.NextFloat(-1, 1), random.NextFloat(-1, 1), random.NextFloat(-1, 1), 0)));
+			light.SpotPower = random.NextFloat(2, 64);
+			light.LightIndex = InFirstIndex + i;
+		}
+		return lights;
+	}
+
+	XMFLOAT3 ToView(const XMFLOAT4X4& InView, const XMFLOAT3& InPosition)
+	{
+		XMFLOAT3 position;
+		XMStoreFloat3(&position, XMVector3Transform(XMLoadFloat3(&InPosition), XMLoadFloat4x4(&InView)));
+		return position;
+	}
+
+	// The cluster a pixel at view space InPosition reads, as PBR.hlsl finds it.
+	uint32 GetCluster(const LightClusterBuilder& InBuilder, const XMFLOAT4X4& InProj, const XMFLOAT3& InViewPosition)
+	{
+		const float ndcX = InViewPosition.x * InProj._11 / InViewPosition.z;
+		const float ndcY = InViewPosition.y * InProj._22 / InViewPosition.z;
+		const uint32 i = std::min((uint32)((ndcX * 0.5f + 0.5f) * LightClusterBuilder::NumClustersX), LightClusterBuilder::NumClustersX - 1);
+		const uint32 j = std::min((uint32)((0.5f - ndcY * 0.5f) * LightClusterBuilder::NumClustersY), LightClusterBuilder::NumClustersY - 1);
+		const int32 slice = (int32)floorf(log2f(InViewPosition.z) * InBuilder.GetSliceScale() + InBuilder.GetSliceBias());
+		const uint32 k = (uint32)std::min(std::max(slice, 0), (int32)LightClusterBuilder::NumClustersZ - 1);
+		return (k * LightClusterBuilder::NumClustersY + j) * LightClusterBuilder::NumClustersX + i;
+	}
+
+	// Whether the light reaches InPosition at all, a little inside its range and cone so rounding does not decide.
+	bool LightsPoint(const ClusterLight& InLight, const XMFLOAT3& InPosition)
+	{
+		const XMVECTOR toPoint = XMVectorSubtract(XMLoadFloat3(&InPosition), XMLoadFloat3(&InLight.Position));
+		const float distance = XMVectorGetX(XMVector3Length(toPoint));
+		if (distance > InLight.Range * 0.999f)
+			return false;
+		if (!InLight.bSpotLight || distance < 1e-4f)
+			return true;
+
+		const float cosAngle = XMVectorGetX(XMVector3Dot(toPoint, XMLoadFloat3(&InLight.Direction))) / distance;
+		return cosAngle > 0.0f && powf(cosAngle, InLight.SpotPower) > LightClusterBuilder::SpotCutoff * 1.01f;
+	}
+
+	bool SameClusters(const LightClusterBuilder& InA, const LightClusterBuilder& InB)
+	{
+		const std::vector<LightCluster>& a = InA.GetClusters();
+		const std::vector<LightCluster>& b = InB.GetClusters();
+		bool bSame = a.size() == b.size() && InA.GetLightIndices() == InB.GetLightIndices();
+		for (size_t c = 0; bSame && c < a.size(); ++c)
+		{
+			bSame = a[c].Offset == b[c].Offset && a[c].Counts == b[c].Counts;
+		}
+		return bSame;
+	}
+}
+
+TEST_CASE(LightClusterBuilder_MatchesBruteForce)
+{
+	const ClusterCamera camera = CreateCamera();
+	const std::vector<uint32> globalLights = { 0, 1 };
+
+	// Below and above the count that builds the slices on the job system, and the renderer's MaxLights.
+	for (uint32 numLights : { 0u, 7u, 200u, 1022u })
+	{
+		const std::vector<ClusterLight> lights = CreateLights(numLights, (uint32)globalLights.size(), numLights);
+
+		LightClusterBuilder reference;
+		reference.SetProjection(camera.Proj, NearZ, FarZ);
+		reference.Build(camera.View, lights, globalLights, CIS_Scalar);
+
+		LightClusterBuilder builder;
+		builder.SetProjection(camera.Proj, NearZ, FarZ);
+		for (ECullInstructionSet instructionSet : { CIS_SSE, CIS_AVX })
+		{
+			if (instructionSet <= FrustumCuller::GetBestInstructionSet())
+			{
+				const uint32 size = builder.Build(camera.View, lights, globalLights, instructionSet);
+				CHECK(size == builder.GetLightIndices().size());
+				CHECK(SameClusters(builder, reference));
+				CHECK(builder.GetMaxLightsPerCluster() == reference.GetMaxLightsPerCluster());
+			}
+		}
+
+		// The global lights lead the list, every cluster stays inside it.
+		const std::vector<uint32>& indices = builder.GetLightIndices();
+		CHECK(indices.size() >= globalLights.size() && std::equal(globalLights.begin(), globalLights.end(), indices.begin()));
+
+		bool bInside = builder.GetClusters().size() == LightClusterBuilder::NumClusters;
+		for (const LightCluster& cluster : builder.GetClusters())
+		{
+			bInside &= cluster.Offset >= globalLights.size() && cluster.Offset + cluster.GetPointCount() + cluster.GetSpotCount() <= indices.size();
+		}
+		CHECK(bInside);
+	}
+}
+
+TEST_CASE(LightClusterBuilder_CoversLitPoints)
+{
+	const ClusterCamera camera = CreateCamera();
+	const std::vector<ClusterLight> lights = CreateLights(600, 0, 17);
+
+	LightClusterBuilder builder;
+	builder.SetProjection(camera.Proj, NearZ, FarZ);
+	builder.Build(camera.View, lights, std::vector<uint32>());
+
+	const std::vector<LightCluster>& clusters = builder.GetClusters();
+	const std::vector<uint32>& indices = builder.GetLightIndices();
+
+	// Points around every light, each light reaching one must be in the list of that point's cluster, point lights first.
+	TestRandom random(23);
+	uint32 numChecked = 0;
+	bool bCovered = true, bOrdered = true;
+	for (const ClusterLight& light : lights)
+	{
+		for (uint32 s = 0; s < 8; ++s)
+		{
+			const float r = light.Range;
+			const XMFLOAT3 position(light.Position.x + random.NextFloat(-r, r), light.Position.y + random.NextFloat(-r, r), light.Position.z + random.NextFloat(-r, r));
+			const XMFLOAT3 viewPosition = ToView(camera.View, position);
+			if (viewPosition.z < NearZ || viewPosition.z > FarZ || !LightsPoint(light, position))
+				continue;
+
+			const float ndcX = viewPosition.x * camera.Proj._11 / viewPosition.z;
+			const float ndcY = viewPosition.y * camera.Proj._22 / viewPosition.z;
+			if (fabsf(ndcX) >= 1.0f || fabsf(ndcY) >= 1.0f)
+				continue;
+
+			const LightCluster& cluster = clusters[GetCluster(builder, camera.Proj, viewPosition)];
+			const uint32* begin = &indices[0] + cluster.Offset;
+			const uint32* points = begin + cluster.GetPointCount();
+			const uint32* end = points + cluster.GetSpotCount();
+
+			const uint32* found = light.bSpotLight ? std::find(points, end, light.LightIndex) : std::find(begin, points, light.LightIndex);
+			bCovered &= found != (light.bSpotLight ? end : points);
+			++numChecked;
+		}
+	}
+	for (const LightCluster& cluster : clusters)
+	{
+		for (uint32 i = 0; i < cluster.GetPointCount() + cluster.GetSpotCount(); ++i)
+		{
+			bOrdered &= lights[indices[cluster.Offset + i]].bSpotLight == (i >= cluster.GetPointCount());
+		}
+	}
+	CHECK(bCovered);
+	CHECK(bOrdered);
+	CHECK(numChecked > 500);
+
+	// Binning is worth it: a cluster holds a small part of the lights.
+	CHECK(builder.GetMaxLightsPerCluster() < lights.size() / 4);
+}
+
+TEST_CASE(LightClusterBuilder_Benchmark)
+{
+	const ClusterCamera camera = CreateCamera();
+	const std::vector<ClusterLight> lights = CreateLights(1024, 0, 29);
+
+	LightClusterBuilder builder;
+	builder.SetProjection(camera.Proj, NearZ, FarZ);
+
+	const double scalarMs = MeasureMs(3, [&]() { builder.Build(camera.View, lights, std::vector<uint32>(), CIS_Scalar); });
+	const double ms = MeasureMs(10, [&]() { builder.Build(camera.View, lights, std::vector<uint32>()); });
+	Report("%u lights, %u clusters: brute force %.3f ms, SIMD and threads %.3f ms, %u indices, at most %u per cluster",
+		(uint32)lights.size(), LightClusterBuilder::NumClusters, scalarMs, ms, (uint32)builder.GetLightIndices().size(), builder.GetMaxLightsPerCluster());
+
+	if (bCheckTimings)
+	{
+		CHECK(ms < scalarMs);
+	}
+}
@@ -0,0 +1,323 @@
+//
+// MeshCacheTests.cpp
+//
+
+#include "TestMeshes.h"
+#include "Core/Common/MeshCache.h"
+#include "Core/Common/MeshletBuilder.h"
+#include "Core/Common/MeshOptimizer.h"
+#include "Core/Common/MeshSimplifier.h"
+
+#ifndef JAYOU_NO_ASSIMP
+#include "Core/Common/AssimpImporter.h"
+#endif
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+using namespace Tests;
+using namespace Core;
+
+namespace
+{
+	// What the importer does to a mesh before it caches it.
+	void ProcessGeometry(const char* InName, const GeometryData<Vertex>& InData, std::unordered_map<std::string, Geometry>& OutGeometries,
+		std::unordered_map<std::string, TriangleBVH>& OutBVHs)
+	{
+		Geometry& geo = OutGeometries[InName];
+		geo.Name = InName;
+		geo.Data = InData;
+		MeshOptimizer::Optimize(geo.Data);
+		SimplifyDesc desc;
+		desc.NumLODs = 3;
+		MeshSimplifier::GenerateLODs(geo, desc);
+		geo.Meshlets = MeshletBuilder::BuildMeshlets(geo.Data);
+		geo.CalcBounds();
+
+		std::vector<XMFLOAT3> positions;
+		for (const Vertex& vertex : geo.Data.Vertices)
+		{
+			positions.push_back(vertex.Position);
+		}
+		OutBVHs[InName].Build(positions, geo.Data.Indices32);
+	}
+
+	void CreateScene(std::unordered_map<std::string, Geometry>& OutGeometries, std::vector<ImportNode>& OutNodes,
+		std::unordered_map<std::string, TriangleBVH>& OutBVHs)
+	{
+		for (TestMesh& mesh : CreateTestMeshes())
+		{
+			ProcessGeometry(mesh.Name, mesh.Data, OutGeometries, OutBVHs);
+		}
+
+		OutNodes.push_back({ "Root", -1, Matrix4(kIdentity), {} });
+		OutNodes.push_back({ "Shapes", 0, Matrix4(XMMatrixTranslation(1.0f, 2.0f, 3.0f)), { "Sphere", "Cylinder" } });
+		OutNodes.push_back({ "Ground", 0, Matrix4(XMMatrixScaling(2.0f, 1.0f, 2.0f)), { "Plane" } });
+		OutNodes.push_back({ "Ball", 1, Matrix4(XMMatrixRotationY(0.5f)), { "Geosphere" } });
+	}
+
+	bool SameBytes(const void* InA, const void* InB, size_t InSize)
+	{
+		return memcmp(InA, InB, InSize) == 0;
+	}
+
+	template<typename T>
+	bool SameArray(const std::vector<T>& InA, const std::vector<T>& InB)
+	{
+		return InA.size() == InB.size() && (InA.empty() || SameBytes(InA.data(), InB.data(), InA.size() * sizeof(T)));
+	}
+
+	bool SameGeometry(const Geometry& InA, const Geometry& InB)
+	{
+		bool bSame = SameArray(InA.Data.Vertices, InB.Data.Vertices) && InA.Data.Indices32 == InB.Data.Indices32 &&
+			SameArray(InA.Meshlets, InB.Meshlets) && InA.LODs.size() == InB.LODs.size() &&
+			SameBytes(&InA.Bounds.Origin, &InB.Bounds.Origin, sizeof(XMFLOAT3)) &&
+			SameBytes(&InA.Bounds.BoxExtent, &InB.Bounds.BoxExtent, sizeof(XMFLOAT3)) &&
+			InA.Bounds.SphereRadius == InB.Bounds.SphereRadius;
+		for (size_t l = 0; l < InA.LODs.size() && bSame; ++l)
+		{
+			bSame = InA.LODs[l].Indices32 == InB.LODs[l].Indices32 && InA.LODs[l].Error == InB.LODs[l].Error;
+		}
+		return bSame;
+	}
+
+	bool SameNode(const ImportNode& InA, const ImportNode& InB)
+	{
+		XMFLOAT4X4 a, b;
+		XMStoreFloat4x4(&a, InA.LocalTransform);
+		XMStoreFloat4x4(&b, InB.LocalTransform);
+		return InA.Name == InB.Name && InA.Parent == InB.Parent && InA.Geometries == InB.Geometries && SameBytes(&a, &b, sizeof(a));
+	}
+
+	std::vector<char> ReadBytes(const std::string& InPath)
+	{
+		std::ifstream file(InPath, std::ios::binary);
+		return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}
+
+	void WriteBytes(const std::string& InPath, const std::vector<char>& InBytes)
+	{
+		std::ofstream file(InPath, std::ios::binary | std::ios::trunc);
+		file.write(InBytes.data(), InBytes.size());
+	}
+
+	// A failed load must leave what the caller had alone.
+	bool LoadFails(const std::string& InPath, const MeshCacheKey& InKey)
+	{
+		std::unordered_map<std::string, Geometry> geometries;
+		geometries["Untouched"].Name = "Untouched";
+		std::vector<ImportNode> nodes(1);
+		nodes[0].Name = "Untouched";
+		std::unordered_map<std::string, TriangleBVH> bvhs;
+
+		const bool bLoaded = MeshCache::Load(InPath, InKey, geometries, nodes, bvhs);
+		return !bLoaded && geometries.size() == 1 && geometries.count("Untouched") == 1 && nodes.size() == 1 && nodes[0].Name == "Untouched" && bvhs.empty();
+	}
+}
+
+TEST_CASE(MeshCache_RoundTrip)
+{
+	std::unordered_map<std::string, Geometry> geometries;
+	std::vector<ImportNode> nodes;
+	std::unordered_map<std::string, TriangleBVH> bvhs;
+	CreateScene(geometries, nodes, bvhs);
+
+	const std::string path = MeshCache::GetCachePath("JayouTests_Scene.obj");
+	ImportGeoDesc desc;
+	const MeshCacheKey key = MeshCache::MakeKey(desc, 0x1234567890abcdefull, 4096);
+	CHECK(MeshCache::Save(path, key, geometries, nodes, bvhs));
+
+	std::unordered_map<std::string, Geometry> loadedGeometries;
+	std::vector<ImportNode> loadedNodes;
+	std::unordered_map<std::string, TriangleBVH> loadedBVHs;
+	CHECK(MeshCache::Load(path, key, loadedGeometries, loadedNodes, loadedBVHs));
+
+	// Bit for bit, LODs with their errors, meshlets with their bounds and cones.
+	CHECK(loadedGeometries.size() == geometries.size());
+	bool bSameGeometries = true;
+	uint32 numLODs = 0;
+	for (const auto& pair : geometries)
+	{
+		auto loaded = loadedGeometries.find(pair.first);
+		bSameGeometries &= loaded != loadedGeometries.end() && loaded->second.Name == pair.first && SameGeometry(pair.second, loaded->second);
+		numLODs += (uint32)pair.second.LODs.size();
+	}
+	CHECK(bSameGeometries);
+	CHECK(numLODs > 0);
+
+	CHECK(loadedNodes.size() == nodes.size());
+	bool bSameNodes = loadedNodes.size() == nodes.size();
+	for (size_t i = 0; i < nodes.size() && bSameNodes; ++i)
+	{
+		bSameNodes = SameNode(nodes[i], loadedNodes[i]);
+	}
+	CHECK(bSameNodes);
+
+	// The loaded BVHs answer as the built ones do.
+	CHECK(loadedBVHs.size() == bvhs.size());
+	bool bSameHits = true;
+	TestRandom random(5);
+	for (const auto& pair : bvhs)
+	{
+		const TriangleBVH& loaded = loadedBVHs[pair.first];
+		bSameHits &= loaded.GetNumNodes() == pair.second.GetNumNodes() && loaded.GetNumTriangles() == pair.second.GetNumTriangles();
+		for (uint32 i = 0; i < 100; ++i)
+		{
+			const XMFLOAT3 origin(random.NextFloat(-5.0f, 5.0f), random.NextFloat(-5.0f, 5.0f), random.NextFloat(-5.0f, 5.0f));
+			const XMFLOAT3 direction(-origin.x, -origin.y, -origin.z);
+			TriangleHit built, cached;
+			const bool bBuiltHit = pair.second.IntersectNearest(origin, direction, built);
+			const bool bCachedHit = loaded.IntersectNearest(origin, direction, cached);
+			bSameHits &= bBuiltHit == bCachedHit && (!bBuiltHit || (built.Triangle == cached.Triangle && built.Distance == cached.Distance));
+		}
+	}
+	CHECK(bSameHits);
+
+	remove(path.c_str());
+}
+
+TEST_CASE(MeshCache_RejectsStaleAndDamagedFiles)
+{
+	std::unordered_map<std::string, Geometry> geometries;
+	std::vector<ImportNode> nodes;
+	std::unordered_map<std::string, TriangleBVH> bvhs;
+	CreateScene(geometries, nodes, bvhs);
+
+	const std::string path = MeshCache::GetCachePath("JayouTests_Stale.obj");
+	ImportGeoDesc desc;
+	const MeshCacheKey key = MeshCache::MakeKey(desc, 42, 4096);
+	CHECK(MeshCache::Save(path, key, geometries, nodes, bvhs));
+	const std::vector<char> bytes = ReadBytes(path);
+	CHECK(bytes.size() > 64);
+
+	// The source changed, or the import settings did.
+	CHECK(LoadFails(path, MeshCache::MakeKey(desc, 43, 4096)));
+	CHECK(LoadFails(path, MeshCache::MakeKey(desc, 42, 4097)));
+	ImportGeoDesc noLODs = desc;
+	noLODs.NumLODs = 0;
+	CHECK(LoadFails(path, MeshCache::MakeKey(noLODs, 42, 4096)));
+	ImportGeoDesc noMeshlets = desc;
+	noMeshlets.bBuildMeshlets = false;
+	CHECK(LoadFails(path, MeshCache::MakeKey(noMeshlets, 42, 4096)));
+	CHECK(LoadFails("JayouTests_Missing.jmesh", key));
+
+	// Written by another version, or not a cache at all. Magic then Version lead the header.
+	std::vector<char> otherVersion = bytes;
+	const uint32 version = MeshCache::Version + 1;
+	memcpy(&otherVersion[4], &version, sizeof(version));
+	WriteBytes(path, otherVersion);
+	CHECK(LoadFails(path, key));
+
+	std::vector<char> otherMagic = bytes;
+	otherMagic[0] ^= 0x20;
+	WriteBytes(path, otherMagic);
+	CHECK(LoadFails(path, key));
+
+	// Cut short anywhere, a range past the end is never followed.
+	bool bTruncatedRejected = true;
+	for (size_t size : { (size_t)0, (size_t)3, (size_t)32, bytes.size() / 4, bytes.size() / 2, bytes.size() - 1 })
+	{
+		WriteBytes(path, std::vector<char>(bytes.begin(), bytes.begin() + size));
+		bTruncatedRejected &= LoadFails(path, key);
+	}
+	CHECK(bTruncatedRejected);
+
+	// Whole again, it loads.
+	WriteBytes(path, bytes);
+	std::unordered_map<std::string, Geometry> loadedGeometries;
+	std::vector<ImportNode> loadedNodes;
+	std::unordered_map<std::string, TriangleBVH> loadedBVHs;
+	CHECK(MeshCache::Load(path, key, loadedGeometries, loadedNodes, loadedBVHs));
+
+	remove(path.c_str());
+}
+
+TEST_CASE(MeshCache_ReloadBenchmark)
+{
+	// About what a mid sized asset imports to.
+	std::vector<TestMesh> meshes;
+	meshes.push_back({ "Sphere", WinUtility::GeometryManager::GeometryCreator::CreateSphere(1.0f, 256, 192) });
+	meshes.push_back({ "Plane", WinUtility::GeometryManager::GeometryCreator::CreatePlane(10.0f, 10.0f, 256, 256) });
+	meshes.push_back({ "Cylinder", WinUtility::GeometryManager::GeometryCreator::CreateCylinder(1.0f, 0.5f, 3.0f, 256, 128) });
+
+	std::unordered_map<std::string, Geometry> geometries;
+	std::unordered_map<std::string, TriangleBVH> bvhs;
+	const double processMs = MeasureMs(1, [&]()
+	{
+		for (const TestMesh& mesh : meshes)
+		{
+			ProcessGeometry(mesh.Name, mesh.Data, geometries, bvhs);
+		}
+	});
+
+	std::vector<ImportNode> nodes;
+	nodes.push_back({ "Root", -1, Matrix4(kIdentity), { "Sphere", "Plane", "Cylinder" } });
+
+	const std::string path = MeshCache::GetCachePath("JayouTests_Benchmark.obj");
+	ImportGeoDesc desc;
+	const MeshCacheKey key = MeshCache::MakeKey(desc, 7, 7);
+	CHECK(MeshCache::Save(path, key, geometries, nodes, bvhs));
+
+	uint32 numTriangles = 0;
+	for (const auto& pair : geometries)
+	{
+		numTriangles += (uint32)pair.second.Data.Indices32.size() / 3;
+	}
+
+	bool bLoaded = true;
+	const double loadMs = MeasureMs(5, [&]()
+	{
+		std::unordered_map<std::string, Geometry> loadedGeometries;
+		std::vector<ImportNode> loadedNodes;
+		std::unordered_map<std::string, TriangleBVH> loadedBVHs;
+		bLoaded &= MeshCache::Load(path, key, loadedGeometries, loadedNodes, loadedBVHs);
+	});
+	CHECK(bLoaded);
+
+	// Optimize, simplify, meshlets and BVH are what the cache saves, parsing the source comes on top of that.
+	if (bCheckTimings)
+	{
+		CHECK(loadMs < processMs);
+	}
+	Report("%u triangles, %u bytes: processing %.1f ms, cache load %.2f ms (%.0fx)", numTriangles, (uint32)ReadBytes(path).size(),
+		processMs, loadMs, processMs / std::max(loadMs, 1e-3));
+
+	remove(path.c_str());
+}
+
+#ifndef JAYOU_NO_ASSIMP
+
+TEST_CASE(MeshCache_ReloadVersusImport)
+{
+	const std::string path = "JayouTests_MeshCache.obj";
+	CHECK(WriteObj(path, CreateTestMeshes()));
+	remove(MeshCache::GetCachePath(path).c_str());
+
+	ImportGeoDesc desc;
+	desc.Name = "MeshCache";
+	desc.PathName = path;
+	desc.bUseMeshCache = true;
+
+	// The first import parses and processes the source and writes the cache, the second one only loads it.
+	AssimpImporter importer, cachedImporter;
+	bool bImported = false, bCachedImported = false;
+	const double importMs = MeasureMs(1, [&]() { bImported = importer.Import(desc); });
+	const double cachedMs = MeasureMs(1, [&]() { bCachedImported = cachedImporter.Import(desc); });
+	CHECK(bImported && bCachedImported);
+
+	const std::unordered_map<std::string, Geometry> geos = importer.TakeGeometries();
+	const std::unordered_map<std::string, Geometry> cachedGeos = cachedImporter.TakeGeometries();
+	CHECK(!geos.empty() && geos.size() == cachedGeos.size());
+	for (const auto& pair : geos)
+	{
+		const auto cached = cachedGeos.find(pair.first);
+		CHECK(cached != cachedGeos.end() && SameGeometry(pair.second, cached->second));
+	}
+	Report("%u meshes: import %.0f ms, from the cache %.1f ms", (uint32)geos.size(), importMs, cachedMs);
+
+	remove(MeshCache::GetCachePath(path).c_str());
+	remove(path.c_str());
+}
+
+#endif // JAYOU_NO_ASSIMP
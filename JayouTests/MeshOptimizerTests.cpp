@@ -0,0 +1,126 @@
+//
+// MeshOptimizerTests.cpp
+//
+
+#include "TestMeshes.h"
+#include "Core/Common/MeshOptimizer.h"
+
+using namespace Tests;
+
+namespace
+{
+	// The same triangles, a corner rotation of the same winding counts as the same triangle.
+	bool SameTriangles(const GeometryData<Vertex>& InA, const GeometryData<Vertex>& InB)
+	{
+		auto key = [](const GeometryData<Vertex>& InData)
+		{
+			const std::vector<XMFLOAT3> positions = GetTrianglePositions(InData);
+			std::vector<std::array<float, 9>> triangles(positions.size() / 3);
+			for (size_t t = 0; t < triangles.size(); ++t)
+			{
+				// Start at the smallest corner.
+				size_t first = 0;
+				for (size_t k = 1; k < 3; ++k)
+				{
+					const XMFLOAT3& a = positions[t * 3 + k];
+					const XMFLOAT3& b = positions[t * 3 + first];
+					if (std::tie(a.x, a.y, a.z) < std::tie(b.x, b.y, b.z))
+						first = k;
+				}
+				for (size_t k = 0; k < 3; ++k)
+				{
+					const XMFLOAT3& p = positions[t * 3 + (first + k) % 3];
+					triangles[t][k * 3 + 0] = p.x;
+					triangles[t][k * 3 + 1] = p.y;
+					triangles[t][k * 3 + 2] = p.z;
+				}
+			}
+			std::sort(triangles.begin(), triangles.end());
+			return triangles;
+		};
+		return key(InA) == key(InB);
+	}
+}
+
+TEST_CASE(MeshOptimizer_LowersACMR)
+{
+	for (TestMesh& mesh : CreateTestMeshes())
+	{
+		// As GeometryCreator builds it and in file order of a careless exporter.
+		for (int shuffled = 0; shuffled < 2; ++shuffled)
+		{
+			GeometryData<Vertex> data = mesh.Data;
+			if (shuffled)
+			{
+				ShuffleTriangles(data.Indices32);
+			}
+			const GeometryData<Vertex> source = data;
+
+			MeshOptimizeStats stats;
+			const double ms = MeasureMs(1, [&]() { stats = MeshOptimizer::Optimize(data); });
+
+			Report("%-10s %-8s %6u tris  ACMR %.3f -> %.3f  ATVR %.3f -> %.3f  %.2f ms", mesh.Name, shuffled ? "shuffled" : "created",
+				stats.NumTriangles, stats.Before.ACMR, stats.After.ACMR, stats.Before.ATVR, stats.After.ATVR, ms);
+
+			CHECK(stats.After.ACMR <= stats.Before.ACMR);
+			CHECK(stats.After.ACMR >= 0.5f && stats.After.ATVR >= 1.0f);
+			CHECK(SameTriangles(source, data));
+
+			// Far from the 3.0 of no reuse at all, whatever order it came in. Transforming each vertex once is the
+			// floor, the geosphere does not share its subdivided vertices.
+			const float minACMR = (float)data.Vertices.size() / stats.NumTriangles;
+			CHECK(stats.After.ACMR < std::max(0.85f, 1.05f * minACMR));
+			if (shuffled)
+			{
+				CHECK(stats.Before.ACMR > 1.5f);
+			}
+		}
+	}
+}
+
+TEST_CASE(MeshOptimizer_FetchInFirstUseOrder)
+{
+	GeometryData<Vertex> data = WinUtility::GeometryManager::GeometryCreator::CreateSphere(1.0f, 32, 24);
+	ShuffleTriangles(data.Indices32);
+
+	// A vertex no triangle uses is dropped.
+	data.Vertices.push_back(Vertex());
+
+	const uint32 numReferenced = (uint32)data.Vertices.size() - 1;
+	MeshOptimizer::Optimize(data);
+	CHECK(data.Vertices.size() == numReferenced);
+
+	// Each index is at most one past the largest before it.
+	uint32 next = 0;
+	bool bFirstUseOrder = true;
+	for (uint32 index : data.Indices32)
+	{
+		bFirstUseOrder &= index <= next;
+		next = std::max(next, index + 1);
+	}
+	CHECK(bFirstUseOrder);
+	CHECK(next == numReferenced);
+}
+
+TEST_CASE(MeshOptimizer_AnalyzeVertexCache)
+{
+	// One triangle per three new vertices misses every time.
+	std::vector<uint32> separate;
+	for (uint32 i = 0; i < 300; ++i)
+	{
+		separate.push_back(i);
+	}
+	const VertexCacheStats separateStats = MeshOptimizer::AnalyzeVertexCache(separate, 300);
+	CHECK(separateStats.NumTransformed == 300);
+	CHECK(separateStats.ACMR == 3.0f && separateStats.ATVR == 1.0f);
+
+	// A strip as a list reuses two of three corners.
+	std::vector<uint32> strip;
+	for (uint32 i = 0; i < 100; ++i)
+	{
+		strip.insert(strip.end(), { i, i + 1, i + 2 });
+	}
+	const VertexCacheStats stripStats = MeshOptimizer::AnalyzeVertexCache(strip, 102);
+	CHECK(stripStats.NumTransformed == 102);
+	CHECK(stripStats.ATVR == 1.0f);
+}
@@ -0,0 +1,156 @@
+//
+// MeshSimplifierTests.cpp
+//
+
+#include "TestMeshes.h"
+#include "Core/Common/MeshSimplifier.h"
+
+#include <map>
+#include <tuple>
+
+using namespace Tests;
+
+namespace
+{
+	// Vertices of about the same position, the attribute wedges of it. GeometryCreator closes its seams with sin/cos of
+	// 2 pi, a few ulps off the first column.
+	std::vector<std::vector<uint32>> GetWedgeGroups(const std::vector<Vertex>& InVertices)
+	{
+		std::map<std::tuple<int32, int32, int32>, std::vector<uint32>> groups;
+		for (uint32 v = 0; v < (uint32)InVertices.size(); ++v)
+		{
+			const XMFLOAT3& p = InVertices[v].Position;
+			groups[std::make_tuple((int32)roundf(p.x * 1e4f), (int32)roundf(p.y * 1e4f), (int32)roundf(p.z * 1e4f))].push_back(v);
+		}
+
+		std::vector<std::vector<uint32>> result;
+		for (auto& pair : groups)
+		{
+			result.push_back(std::move(pair.second));
+		}
+		return result;
+	}
+
+	float PointTriangleDistance(const XMFLOAT3& InP, const XMFLOAT3& InA, const XMFLOAT3& InB, const XMFLOAT3& InC)
+	{
+		// Closest point on the triangle, Ericson's Real-Time Collision Detection 5.1.5.
+		const XMVECTOR p = XMLoadFloat3(&InP), a = XMLoadFloat3(&InA), b = XMLoadFloat3(&InB), c = XMLoadFloat3(&InC);
+		const XMVECTOR ab = XMVectorSubtract(b, a), ac = XMVectorSubtract(c, a), ap = XMVectorSubtract(p, a);
+		auto dot = [](FXMVECTOR InX, FXMVECTOR InY) { return XMVectorGetX(XMVector3Dot(InX, InY)); };
+		auto distance = [&](FXMVECTOR InQ) { return XMVectorGetX(XMVector3Length(XMVectorSubtract(p, InQ))); };
+
+		const float d1 = dot(ab, ap), d2 = dot(ac, ap);
+		if (d1 <= 0.0f && d2 <= 0.0f)
+			return distance(a);
+
+		const XMVECTOR bp = XMVectorSubtract(p, b);
+		const float d3 = dot(ab, bp), d4 = dot(ac, bp);
+		if (d3 >= 0.0f && d4 <= d3)
+			return distance(b);
+
+		const float vc = d1 * d4 - d3 * d2;
+		if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+			return distance(XMVectorAdd(a, XMVectorScale(ab, d1 / (d1 - d3))));
+
+		const XMVECTOR cp = XMVectorSubtract(p, c);
+		const float d5 = dot(ab, cp), d6 = dot(ac, cp);
+		if (d6 >= 0.0f && d5 <= d6)
+			return distance(c);
+
+		const float vb = d5 * d2 - d1 * d6;
+		if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+			return distance(XMVectorAdd(a, XMVectorScale(ac, d2 / (d2 - d6))));
+
+		const float va = d3 * d6 - d5 * d4;
+		if (va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f)
+			return distance(XMVectorAdd(b, XMVectorScale(XMVectorSubtract(c, b), (d4 - d3) / ((d4 - d3) + (d5 - d6)))));
+
+		const float denom = 1.0f / (va + vb + vc);
+		return distance(XMVectorAdd(a, XMVectorAdd(XMVectorScale(ab, vb * denom), XMVectorScale(ac, vc * denom))));
+	}
+
+	// How far the base mesh vertices are from the simplified surface, brute force.
+	float MaxDeviation(const std::vector<Vertex>& InVertices, const std::vector<uint32>& InLODIndices)
+	{
+		float maxDistance = 0.0f;
+		for (const Vertex& vertex : InVertices)
+		{
+			float distance = std::numeric_limits<float>::max();
+			for (size_t i = 0; i < InLODIndices.size(); i += 3)
+			{
+				distance = std::min(distance, PointTriangleDistance(vertex.Position,
+					InVertices[InLODIndices[i]].Position, InVertices[InLODIndices[i + 1]].Position, InVertices[InLODIndices[i + 2]].Position));
+			}
+			maxDistance = std::max(maxDistance, distance);
+		}
+		return maxDistance;
+	}
+}
+
+TEST_CASE(MeshSimplifier_KeepsSeams)
+{
+	for (TestMesh& mesh : CreateTestMeshes())
+	{
+		Geometry geo;
+		geo.Data = mesh.Data;
+		SimplifyDesc desc;
+		desc.NumLODs = 4;
+		MeshSimplifier::GenerateLODs(geo, desc);
+
+		// A UV seam is a position with two wedges. Collapses move both sides together, so a LOD uses both or neither,
+		// one side left behind would tear the texture open.
+		uint32 numSeams = 0;
+		bool bSeamsWhole = true;
+		for (const MeshLOD& lod : geo.LODs)
+		{
+			std::vector<uint8> bUsed(geo.Data.Vertices.size(), 0);
+			for (uint32 index : lod.Indices32)
+			{
+				bUsed[index] = 1;
+			}
+
+			for (const std::vector<uint32>& wedges : GetWedgeGroups(geo.Data.Vertices))
+			{
+				if (wedges.size() != 2)
+					continue;
+				numSeams++;
+				bSeamsWhole &= bUsed[wedges[0]] == bUsed[wedges[1]];
+			}
+		}
+		CHECK(bSeamsWhole);
+		Report("%s: %u LODs, %u seam vertices checked", mesh.Name, (uint32)geo.LODs.size(), numSeams);
+	}
+}
+
+TEST_CASE(MeshSimplifier_BoundsTheChainError)
+{
+	for (float maxError : { 0.01f, 0.05f, 0.25f })
+	{
+		Geometry geo;
+		geo.Data = WinUtility::GeometryManager::GeometryCreator::CreateSphere(1.0f, 48, 32);
+		SimplifyDesc desc;
+		desc.NumLODs = 6;
+		desc.MaxError = maxError;
+		desc.MinTriangles = 16;
+		MeshSimplifier::GenerateLODs(geo, desc);
+
+		// The last level carries the sum of all of them, which must stay within MaxError * radius for the whole chain.
+		const float limit = maxError * geo.Data.CalcBounds().SphereRadius;
+		float previous = 0.0f;
+		bool bIncreasing = true;
+		for (const MeshLOD& lod : geo.LODs)
+		{
+			bIncreasing &= lod.Error >= previous;
+			previous = lod.Error;
+		}
+		CHECK(bIncreasing);
+		CHECK(previous <= limit * 1.0001f);
+
+		// The error is a bound on plane distances, the base vertices must be about that close to the coarsest level.
+		const float deviation = geo.LODs.empty() ? 0.0f : MaxDeviation(geo.Data.Vertices, geo.LODs.back().Indices32);
+		CHECK(deviation <= limit * 1.0001f);
+		Report("MaxError %.2f: %u LODs, %u -> %u triangles, error %.4f, measured deviation %.4f, limit %.4f", maxError,
+			(uint32)geo.LODs.size(), (uint32)geo.Data.Indices32.size() / 3, geo.LODs.empty() ? 0u : (uint32)geo.LODs.back().Indices32.size() / 3,
+			previous, deviation, limit);
+	}
+}
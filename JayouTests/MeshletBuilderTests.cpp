@@ -0,0 +1,170 @@
+//
+// MeshletBuilderTests.cpp
+//
+
+#include "TestMeshes.h"
+#include "Core/Common/MeshletBuilder.h"
+#include "Core/Common/TransformHierarchy.h"
+
+using namespace Tests;
+
+namespace
+{
+	XMFLOAT3 TriangleNormal(const GeometryData<Vertex>& InData, uint32 InFirstIndex)
+	{
+		const XMVECTOR p0 = XMLoadFloat3(&InData.Vertices[InData.Indices32[InFirstIndex + 0]].Position);
+		const XMVECTOR p1 = XMLoadFloat3(&InData.Vertices[InData.Indices32[InFirstIndex + 1]].Position);
+		const XMVECTOR p2 = XMLoadFloat3(&InData.Vertices[InData.Indices32[InFirstIndex + 2]].Position);
+
+		XMFLOAT3 normal;
+		XMStoreFloat3(&normal, XMVector3Cross(XMVectorSubtract(p1, p0), XMVectorSubtract(p2, p0)));
+		return normal;
+	}
+}
+
+TEST_CASE(MeshletBuilder_PartitionsTheMesh)
+{
+	for (TestMesh& mesh : CreateTestMeshes())
+	{
+		GeometryData<Vertex> data = mesh.Data;
+		const std::vector<XMFLOAT3> sourcePositions = GetTrianglePositions(data);
+
+		std::vector<Meshlet> meshlets;
+		const double ms = MeasureMs(1, [&]() { meshlets = MeshletBuilder::BuildMeshlets(data); });
+
+		// Consecutive ranges covering the whole index buffer, each within the limits.
+		uint32 next = 0;
+		bool bContiguous = true, bWithinLimits = true, bVertexCounts = true, bBounded = true;
+		for (const Meshlet& meshlet : meshlets)
+		{
+			bContiguous &= meshlet.StartIndexLocation == next && meshlet.IndexCount % 3 == 0 && meshlet.IndexCount != 0;
+			next = meshlet.StartIndexLocation + meshlet.IndexCount;
+
+			std::vector<uint32> vertices(data.Indices32.begin() + meshlet.StartIndexLocation, data.Indices32.begin() + next);
+			std::sort(vertices.begin(), vertices.end());
+			vertices.erase(std::unique(vertices.begin(), vertices.end()), vertices.end());
+
+			bVertexCounts &= vertices.size() == meshlet.VertexCount;
+			bWithinLimits &= meshlet.VertexCount <= MeshletBuilder::MaxVertices && meshlet.IndexCount / 3 <= MeshletBuilder::MaxTriangles;
+
+			// Box and sphere hold every vertex of the cluster.
+			const BoxSphereBounds& bounds = meshlet.Bounds;
+			const float epsilon = 1e-5f;
+			for (uint32 v : vertices)
+			{
+				const XMFLOAT3& p = data.Vertices[v].Position;
+				const float dx = p.x - bounds.Origin.x, dy = p.y - bounds.Origin.y, dz = p.z - bounds.Origin.z;
+				bBounded &= fabsf(dx) <= bounds.BoxExtent.x + epsilon && fabsf(dy) <= bounds.BoxExtent.y + epsilon && fabsf(dz) <= bounds.BoxExtent.z + epsilon;
+				bBounded &= sqrtf(dx * dx + dy * dy + dz * dz) <= bounds.SphereRadius + epsilon;
+			}
+		}
+		CHECK(bContiguous && next == data.Indices32.size());
+		CHECK(bWithinLimits);
+		CHECK(bVertexCounts);
+		CHECK(bBounded);
+
+		// Only the triangle order changed, every triangle kept its corners.
+		std::vector<XMFLOAT3> positions = GetTrianglePositions(data);
+		auto triangleLess = [](const XMFLOAT3* a, const XMFLOAT3* b)
+		{
+			for (int k = 0; k < 3; ++k)
+			{
+				if (std::tie(a[k].x, a[k].y, a[k].z) != std::tie(b[k].x, b[k].y, b[k].z))
+					return std::tie(a[k].x, a[k].y, a[k].z) < std::tie(b[k].x, b[k].y, b[k].z);
+			}
+			return false;
+		};
+		auto sortedTriangles = [&](const std::vector<XMFLOAT3>& InPositions)
+		{
+			std::vector<const XMFLOAT3*> triangles;
+			for (size_t i = 0; i < InPositions.size(); i += 3)
+			{
+				triangles.push_back(&InPositions[i]);
+			}
+			std::sort(triangles.begin(), triangles.end(), triangleLess);
+			return triangles;
+		};
+		const std::vector<const XMFLOAT3*> before = sortedTriangles(sourcePositions);
+		const std::vector<const XMFLOAT3*> after = sortedTriangles(positions);
+		bool bSameTriangles = before.size() == after.size();
+		for (size_t i = 0; bSameTriangles && i < before.size(); ++i)
+		{
+			bSameTriangles = !triangleLess(before[i], after[i]) && !triangleLess(after[i], before[i]);
+		}
+		CHECK(bSameTriangles);
+
+		uint32 numVertices = 0;
+		for (const Meshlet& meshlet : meshlets)
+		{
+			numVertices += meshlet.VertexCount;
+		}
+		Report("%-10s %6u tris  %4u meshlets  %.1f tris %.1f verts per meshlet  %.2f ms", mesh.Name, (uint32)data.Indices32.size() / 3,
+			(uint32)meshlets.size(), (float)data.Indices32.size() / 3 / meshlets.size(), (float)numVertices / meshlets.size(), ms);
+	}
+}
+
+TEST_CASE(MeshletBuilder_ConeCullsOnlyBackfaces)
+{
+	for (TestMesh& mesh : CreateTestMeshes())
+	{
+		GeometryData<Vertex> data = mesh.Data;
+		const std::vector<Meshlet> meshlets = MeshletBuilder::BuildMeshlets(data);
+
+		// Eyes all around the mesh, near and far.
+		TestRandom random(3);
+		uint32 numTests = 0, numCulled = 0;
+		bool bConservative = true;
+		for (uint32 e = 0; e < 64; ++e)
+		{
+			const XMVECTOR direction = XMVector3Normalize(XMVectorSet(random.NextFloat(-1, 1), random.NextFloat(-1, 1), random.NextFloat(-1, 1), 0.0f));
+			XMFLOAT3 eye;
+			XMStoreFloat3(&eye, XMVectorScale(direction, random.NextFloat(2.0f, 20.0f)));
+
+			for (const Meshlet& meshlet : meshlets)
+			{
+				numTests++;
+				if (!MeshletBuilder::IsBackfacing(meshlet, eye))
+					continue;
+				numCulled++;
+
+				// Every triangle of a culled cluster faces away, the rasterizer would have dropped it too.
+				for (uint32 i = meshlet.StartIndexLocation; i < meshlet.StartIndexLocation + meshlet.IndexCount; i += 3)
+				{
+					const XMFLOAT3 n = TriangleNormal(data, i);
+					const XMFLOAT3& p = data.Vertices[data.Indices32[i]].Position;
+					bConservative &= n.x * (p.x - eye.x) + n.y * (p.y - eye.y) + n.z * (p.z - eye.z) >= -1e-6f;
+				}
+			}
+		}
+		CHECK(bConservative);
+
+		Report("%-10s %5.1f%% of meshlet tests culled by the cone", mesh.Name, 100.0f * numCulled / numTests);
+	}
+}
+
+TEST_CASE(MeshletBuilder_UniformScaleOfTheWorld)
+{
+	// Children with a uniform scale of their own, what RenderItem::Scale holds, under different parents.
+	TransformHierarchy hierarchy;
+	const Matrix4 childLocal(XMMatrixMultiply(XMMatrixMultiply(XMMatrixScaling(2.0f, 2.0f, 2.0f), XMMatrixRotationZ(XM_PIDIV4)), XMMatrixTranslation(1.0f, 0.0f, 0.0f)));
+	const int32 uniformParent = hierarchy.Insert(TransformHierarchy::NullNode, Matrix4(XMMatrixMultiply(XMMatrixScaling(3.0f, 3.0f, 3.0f), XMMatrixRotationY(1.0f))));
+	const int32 stretchedParent = hierarchy.Insert(TransformHierarchy::NullNode, Matrix4(XMMatrixScaling(1.0f, 3.0f, 1.0f)));
+	const int32 shearedParent = hierarchy.Insert(TransformHierarchy::NullNode, Matrix4(XMMatrixScaling(1.0f, 3.0f, sqrtf(5.0f))));
+	const int32 underUniform = hierarchy.Insert(uniformParent, childLocal);
+	const int32 underStretched = hierarchy.Insert(stretchedParent, Matrix4(XMMatrixScaling(2.0f, 2.0f, 2.0f)));
+	const int32 underSheared = hierarchy.Insert(shearedParent, childLocal);
+	hierarchy.Update();
+
+	CHECK(MeshletBuilder::HasUniformScale(childLocal));
+	CHECK(MeshletBuilder::HasUniformScale(hierarchy.GetWorld(underUniform)));
+	CHECK(!MeshletBuilder::HasUniformScale(hierarchy.GetWorld(underStretched)));
+
+	// Rotated 45 degrees under (1, 3, sqrt 5) all three world axes are sqrt 20 long, only they are no longer orthogonal.
+	const XMMATRIX sheared = hierarchy.GetWorld(underSheared);
+	const float lengthX = XMVectorGetX(XMVector3Length(sheared.r[0]));
+	CHECK(fabsf(lengthX - XMVectorGetX(XMVector3Length(sheared.r[1]))) < 1e-4f && fabsf(lengthX - XMVectorGetX(XMVector3Length(sheared.r[2]))) < 1e-4f);
+	CHECK(!MeshletBuilder::HasUniformScale(sheared));
+
+	CHECK(!MeshletBuilder::HasUniformScale(XMMatrixScaling(1.0f, 1.001f, 1.0f)));
+	CHECK(MeshletBuilder::HasUniformScale(XMMatrixScaling(1000.0f, 1000.0f, 1000.0f)));
+}
@@ -0,0 +1,148 @@
+//
+// NameTableTests.cpp
+//
+
+#include "TestFramework.h"
+#include "Core/Common/NameTable.h"
+
+using namespace Tests;
+using namespace Utility;
+
+namespace
+{
+	// InCount items named through MakeUniqueName the way GWorld names what it adds, all InName or each one its own.
+	void AddNamed(const std::string& InName, uint32 InCount, bool bSameName, std::unordered_map<NameId, uint32>& InOutRegistry,
+		std::unordered_map<NameId, uint32>& InOutSuffixes)
+	{
+		for (uint32 i = 0; i < InCount; ++i)
+		{
+			const NameId name = bSameName ? NameId(InName) : NameId(InName + "_mesh" + std::to_string(i));
+			InOutRegistry[MakeUniqueName(name, InOutRegistry, InOutSuffixes)] = i;
+		}
+	}
+}
+
+TEST_CASE(NameTable_InterningIsStable)
+{
+	NameTable& table = NameTable::Get();
+	CHECK(NameId().empty() && NameId("").empty() && NameId("").GetIndex() == 0 && table.Find("", 0) == 0);
+
+	const NameId box("NameTable_Box");
+	const char* boxChars = box.c_str();
+	CHECK(NameId(std::string("NameTable_Box")) == box && box.ToString() == "NameTable_Box" && box.size() == 13);
+	CHECK(table.Find("NameTable_Missing", 17) == 0 && table.Find("NameTable_Box", 13) == box.GetIndex());
+
+	// A prefix, an extension and one character off are other names.
+	CHECK(NameId("NameTable_Bo") != box && NameId("NameTable_Box_") != box && NameId("NameTable_Boy") != box);
+
+	// Many more names, rehashes and new chunks, and a string longer than a chunk: nothing moves.
+	const uint32 numNamesBefore = table.GetNumNames();
+	std::vector<NameId> names;
+	for (uint32 i = 0; i < 100000; ++i)
+	{
+		names.push_back(NameId("NameTable_Stable" + std::to_string(i)));
+	}
+	const std::string longString(200000, 'x');
+	const NameId longName(longString);
+	names.push_back(NameId("NameTable_AfterLong"));
+	CHECK(table.GetNumNames() == numNamesBefore + 100002);
+
+	CHECK(box.c_str() == boxChars && strcmp(boxChars, "NameTable_Box") == 0 && NameId("NameTable_Box") == box);
+	CHECK(longName.ToString() == longString && NameId(longString) == longName);
+
+	bool bStable = true;
+	for (uint32 i = 0; i < 100000; ++i)
+	{
+		const std::string expected = "NameTable_Stable" + std::to_string(i);
+		bStable &= names[i].ToString() == expected && NameId(expected) == names[i] && table.Find(expected.data(), expected.size()) == names[i].GetIndex();
+	}
+	CHECK(bStable && names.back().ToString() == "NameTable_AfterLong");
+}
+
+TEST_CASE(NameTable_CollidingLookups)
+{
+	// Names landing in the same bucket of any table up to 65536 buckets, one long probe run.
+	const uint32 targetBits = (uint32)HashMemory("NameTable_Collide", 17, 0) & 0xFFFF;
+	std::vector<std::string> colliding;
+	for (uint32 i = 0; colliding.size() < 24; ++i)
+	{
+		const std::string candidate = "NameTable_Collide" + std::to_string(i);
+		if (((uint32)HashMemory(candidate.data(), candidate.size(), 0) & 0xFFFF) == targetBits)
+			colliding.push_back(candidate);
+	}
+
+	// Half interned, the other half must not be found through the run.
+	std::vector<NameId> names;
+	for (size_t i = 0; i < colliding.size(); i += 2)
+	{
+		names.push_back(NameId(colliding[i]));
+	}
+
+	bool bFound = true, bDistinct = true;
+	for (size_t i = 0; i < colliding.size(); ++i)
+	{
+		const uint32 index = NameTable::Get().Find(colliding[i].data(), colliding[i].size());
+		bFound &= (i % 2 == 0) ? index == names[i / 2].GetIndex() : index == 0;
+	}
+	for (size_t i = 0; i < names.size(); ++i)
+	{
+		for (size_t j = i + 1; j < names.size(); ++j)
+		{
+			bDistinct &= names[i] != names[j];
+		}
+	}
+	CHECK(bFound && bDistinct);
+}
+
+TEST_CASE(NameTable_MakeUniqueName)
+{
+	std::unordered_map<NameId, uint32> registry, suffixes;
+	const NameId box("NameTable_UniqueBox");
+	CHECK(MakeUniqueName(box, registry, suffixes) == box);
+	registry[box] = 0;
+
+	CHECK(MakeUniqueName(box, registry, suffixes) == NameId("NameTable_UniqueBox_1"));
+	registry[NameId("NameTable_UniqueBox_1")] = 1;
+
+	// Taken by hand, skipped.
+	registry[NameId("NameTable_UniqueBox_2")] = 2;
+	CHECK(MakeUniqueName(box, registry, suffixes) == NameId("NameTable_UniqueBox_3"));
+	registry[NameId("NameTable_UniqueBox_3")] = 3;
+
+	// Suffixes count up, a freed one is not given again, and a suffixed name gets a suffix of its own.
+	registry.erase(NameId("NameTable_UniqueBox_1"));
+	CHECK(MakeUniqueName(box, registry, suffixes) == NameId("NameTable_UniqueBox_4"));
+	CHECK(MakeUniqueName(NameId("NameTable_UniqueBox_2"), registry, suffixes) == NameId("NameTable_UniqueBox_2_1"));
+	CHECK(MakeUniqueName(NameId("NameTable_UniqueBox_1"), registry, suffixes) == NameId("NameTable_UniqueBox_1"));
+
+	// Each name counts on its own.
+	const NameId sphere("NameTable_UniqueSphere");
+	registry[sphere] = 4;
+	CHECK(MakeUniqueName(sphere, registry, suffixes) == NameId("NameTable_UniqueSphere_1"));
+}
+
+TEST_CASE(NameTable_NamingScalesLinearly)
+{
+	// The names of 1k and 10k imported meshes, all of one name (the same model over and over) and all distinct.
+	double sameMs[2], distinctMs[2];
+	const uint32 counts[2] = { 1000, 10000 };
+	for (uint32 run = 0; run < 2; ++run)
+	{
+		std::unordered_map<NameId, uint32> registry, suffixes;
+		const std::string prefix = "NameTable_Import" + std::to_string(counts[run]);
+		sameMs[run] = MeasureMs(1, [&]() { AddNamed(prefix, counts[run], true, registry, suffixes); });
+		CHECK(registry.size() == counts[run] && registry.count(NameId(prefix + "_" + std::to_string(counts[run] - 1))) == 1);
+
+		distinctMs[run] = MeasureMs(1, [&]() { AddNamed(prefix, counts[run], false, registry, suffixes); });
+		CHECK(registry.size() == counts[run] * 2);
+	}
+
+	Report("Naming 1k / 10k meshes: one name %.2f / %.2f ms (%.1fx), distinct names %.2f / %.2f ms (%.1fx)",
+		sameMs[0], sameMs[1], sameMs[1] / sameMs[0], distinctMs[0], distinctMs[1], distinctMs[1] / distinctMs[0]);
+
+	// Ten times the meshes, about ten times the time. Quadratic would be a hundred.
+	if (bCheckTimings)
+	{
+		CHECK(sameMs[1] < sameMs[0] * 30.0 && distinctMs[1] < distinctMs[0] * 30.0);
+	}
+}
@@ -0,0 +1,216 @@
+//
+// ParallelImportTests.cpp
+//
+
+#include "TestMeshes.h"
+#include "Core/Common/MeshSimplifier.h"
+#include "Core/Common/ThreadManager.h"
+
+#ifndef JAYOU_NO_ASSIMP
+#include "Core/Common/AssimpImporter.h"
+#endif
+
+#include <cstring>
+#include <functional>
+#include <thread>
+#include <unordered_map>
+
+using namespace Tests;
+using namespace Utility::ThreadManager;
+
+namespace
+{
+	template<typename T>
+	bool SameBytes(const std::vector<T>& InA, const std::vector<T>& InB)
+	{
+		return InA.size() == InB.size() && (InA.empty() || memcmp(InA.data(), InB.data(), InA.size() * sizeof(T)) == 0);
+	}
+
+	// Vertices, indices, LODs, meshlets and bounds, byte for byte.
+	bool SameGeometry(const Geometry& InA, const Geometry& InB)
+	{
+		if (!SameBytes(InA.Data.Vertices, InB.Data.Vertices) || !SameBytes(InA.Data.Indices32, InB.Data.Indices32) || !SameBytes(InA.Meshlets, InB.Meshlets))
+			return false;
+
+		if (memcmp(&InA.Bounds, &InB.Bounds, sizeof(BoxSphereBounds)) != 0 || InA.LODs.size() != InB.LODs.size())
+			return false;
+
+		for (size_t i = 0; i < InA.LODs.size(); ++i)
+		{
+			if (!SameBytes(InA.LODs[i].Indices32, InB.LODs[i].Indices32) || memcmp(&InA.LODs[i].Error, &InB.LODs[i].Error, sizeof(float)) != 0)
+				return false;
+		}
+		return true;
+	}
+
+	// The test meshes InNumCopies times over, so there are more meshes than threads. Names live in OutNames.
+	std::vector<TestMesh> CreateManyTestMeshes(uint32 InNumCopies, std::vector<std::string>& OutNames)
+	{
+		const std::vector<TestMesh> meshes = CreateTestMeshes();
+		OutNames.clear();
+		OutNames.reserve(InNumCopies * meshes.size());
+
+		std::vector<TestMesh> copies;
+		for (uint32 copy = 0; copy < InNumCopies; ++copy)
+		{
+			for (const TestMesh& mesh : meshes)
+			{
+				OutNames.push_back(std::string(mesh.Name) + std::to_string(copy));
+				copies.push_back({ OutNames.back().c_str(), mesh.Data });
+			}
+		}
+		return copies;
+	}
+
+	// InRun(false) once, then InRun(true) on 2 to 16 threads of the job system, which is left as it was.
+	void ReportThreadSweep(const char* InWhat, const std::function<void(bool)>& InRun)
+	{
+		JobSystem& jobSystem = JobSystem::Get();
+		const uint32 numThreads = jobSystem.GetNumThreads();
+
+		const double serialMs = MeasureMs(1, [&]() { InRun(false); });
+		Report("%s, %u hardware threads: serial %.0f ms", InWhat, std::thread::hardware_concurrency(), serialMs);
+		for (uint32 sweepThreads : { 2u, 4u, 8u, 16u })
+		{
+			jobSystem.SetNumThreads(sweepThreads);
+			const double parallelMs = MeasureMs(1, [&]() { InRun(true); });
+			Report("  %2u threads %.0f ms, %.2fx", sweepThreads, parallelMs, serialMs / parallelMs);
+		}
+		jobSystem.SetNumThreads(numThreads);
+	}
+}
+
+TEST_CASE(ParallelImport_LODsMatchSerial)
+{
+	std::vector<TestMesh> meshes = CreateTestMeshes();
+	std::vector<Geometry> parallelGeos(meshes.size());
+	std::vector<Geometry> serialGeos(meshes.size());
+	std::vector<Geometry*> parallelPtrs, serialPtrs;
+	for (size_t i = 0; i < meshes.size(); ++i)
+	{
+		parallelGeos[i].Data = meshes[i].Data;
+		serialGeos[i].Data = meshes[i].Data;
+		parallelPtrs.push_back(&parallelGeos[i]);
+		serialPtrs.push_back(&serialGeos[i]);
+	}
+
+	SimplifyDesc desc;
+	desc.NumLODs = 3;
+	desc.bParallel = true;
+	const double parallelMs = MeasureMs(1, [&]() { MeshSimplifier::GenerateLODs(parallelPtrs, desc); });
+	desc.bParallel = false;
+	const double serialMs = MeasureMs(1, [&]() { MeshSimplifier::GenerateLODs(serialPtrs, desc); });
+
+	size_t numLODs = 0;
+	for (size_t i = 0; i < meshes.size(); ++i)
+	{
+		CHECK(SameGeometry(parallelGeos[i], serialGeos[i]));
+		numLODs += parallelGeos[i].LODs.size();
+	}
+	CHECK(numLODs > 0);
+	Report("%u meshes: LODs %.2f ms parallel, %.2f ms serial", (uint32)meshes.size(), parallelMs, serialMs);
+}
+
+TEST_CASE(ParallelImport_LODsThreadSweep)
+{
+	std::vector<std::string> names;
+	const std::vector<TestMesh> meshes = CreateManyTestMeshes(4, names);
+	std::vector<Geometry> serialGeos;
+
+	ReportThreadSweep("LODs of 16 meshes", [&](bool bParallel)
+	{
+		std::vector<Geometry> geos(meshes.size());
+		std::vector<Geometry*> geoPtrs;
+		for (size_t i = 0; i < meshes.size(); ++i)
+		{
+			geos[i].Data = meshes[i].Data;
+			geoPtrs.push_back(&geos[i]);
+		}
+
+		SimplifyDesc desc;
+		desc.NumLODs = 3;
+		desc.bParallel = bParallel;
+		MeshSimplifier::GenerateLODs(geoPtrs, desc);
+
+		// Every thread count gives the serial result.
+		if (!bParallel)
+		{
+			serialGeos = std::move(geos);
+			return;
+		}
+		bool bSame = geos.size() == serialGeos.size();
+		for (size_t i = 0; i < geos.size() && bSame; ++i)
+		{
+			bSame = SameGeometry(geos[i], serialGeos[i]);
+		}
+		CHECK(bSame);
+	});
+	CHECK(JobSystem::Get().GetNumThreads() == std::max(2u, std::thread::hardware_concurrency()));
+}
+
+#ifndef JAYOU_NO_ASSIMP
+
+TEST_CASE(ParallelImport_MatchesSerial)
+{
+	const std::string path = "JayouTests_ParallelImport.obj";
+	CHECK(WriteObj(path, CreateTestMeshes()));
+
+	ImportGeoDesc desc;
+	desc.Name = "ParallelImport";
+	desc.PathName = path;
+	desc.NumLODs = 3;
+	desc.bUseMeshCache = false;
+
+	AssimpImporter parallelImporter, serialImporter;
+	bool bParallelImported = false, bSerialImported = false;
+	desc.bParallel = true;
+	const double parallelMs = MeasureMs(1, [&]() { bParallelImported = parallelImporter.Import(desc); });
+	desc.bParallel = false;
+	const double serialMs = MeasureMs(1, [&]() { bSerialImported = serialImporter.Import(desc); });
+	remove(path.c_str());
+	CHECK(bParallelImported && bSerialImported);
+	if (!bParallelImported || !bSerialImported)
+		return;
+
+	const std::unordered_map<std::string, Geometry> parallelGeos = parallelImporter.TakeGeometries();
+	const std::unordered_map<std::string, Geometry> serialGeos = serialImporter.TakeGeometries();
+	CHECK(parallelGeos.size() > 1 && parallelGeos.size() == serialGeos.size());
+	for (const auto& pair : parallelGeos)
+	{
+		const auto serial = serialGeos.find(pair.first);
+		CHECK(serial != serialGeos.end());
+		if (serial != serialGeos.end())
+		{
+			CHECK(SameGeometry(pair.second, serial->second));
+		}
+	}
+	Report("%u meshes: import %.0f ms parallel, %.0f ms serial", (uint32)parallelGeos.size(), parallelMs, serialMs);
+}
+
+TEST_CASE(ParallelImport_ImportThreadSweep)
+{
+	const std::string path = "JayouTests_ImportThreadSweep.obj";
+	std::vector<std::string> names;
+	CHECK(WriteObj(path, CreateManyTestMeshes(4, names)));
+
+	ImportGeoDesc desc;
+	desc.Name = "ImportThreadSweep";
+	desc.PathName = path;
+	desc.NumLODs = 3;
+	desc.bUseMeshCache = false;
+
+	uint32 numImported = 0;
+	ReportThreadSweep("Import of 16 meshes", [&](bool bParallel)
+	{
+		AssimpImporter importer;
+		desc.bParallel = bParallel;
+		if (importer.Import(desc))
+		{
+			numImported++;
+		}
+	});
+	remove(path.c_str());
+	CHECK(numImported == 5);
+}
+
+#endif // JAYOU_NO_ASSIMP
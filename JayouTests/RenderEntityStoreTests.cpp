@@ -0,0 +1,168 @@
+//
+// RenderEntityStoreTests.cpp
+// Windows only, the store keeps RenderItems and those hold D3D resources.
+//
+
+#include "TestFramework.h"
+
+#ifdef _WINDOWS
+
+#include "Core/Common/RenderEntityStore.h"
+
+#include <memory>
+#include <unordered_map>
+
+using namespace Tests;
+using namespace WinUtility::GeometryManager;
+
+namespace
+{
+	std::vector<std::unique_ptr<RenderItem>> CreateRenderItems(uint32 InCount, uint32 InSeed)
+	{
+		TestRandom random(InSeed);
+		std::vector<std::unique_ptr<RenderItem>> items(InCount);
+		for (uint32 i = 0; i < InCount; ++i)
+		{
+			items[i].reset(new RenderItem());
+			items[i]->Index = (int32)i;
+			items[i]->MaterialIndex = (int32)random.NextUInt(50);
+			items[i]->bCastShadow = random.NextUInt(4) != 0;
+			items[i]->WorldBounds = BoundingBox(XMFLOAT3(random.NextFloat(-100, 100), random.NextFloat(-100, 100), random.NextFloat(-100, 100)), XMFLOAT3(1, 1, 1));
+		}
+		return items;
+	}
+
+	// Every live entity's components are those of its owner, at the index the entity maps to.
+	bool IsConsistent(const RenderEntityStore& InStore, const std::vector<std::unique_ptr<RenderItem>>& InItems)
+	{
+		uint32 numLive = 0;
+		bool bConsistent = true;
+		for (const std::unique_ptr<RenderItem>& item : InItems)
+		{
+			if (item->Entity == RenderEntityStore::NullEntity)
+				continue;
+
+			++numLive;
+			const uint32 index = InStore.GetIndex(item->Entity);
+			bConsistent &= index < InStore.GetNumEntities() && InStore.GetOwners()[index] == item.get();
+			if (!bConsistent)
+				break;
+
+			bConsistent &= InStore.GetObjectIndices()[index] == (uint32)item->Index;
+			bConsistent &= InStore.GetMaterialIndices()[index] == (uint32)item->MaterialIndex;
+			bConsistent &= memcmp(&InStore.GetWorldBounds()[index], &item->WorldBounds, sizeof(BoundingBox)) == 0;
+			bConsistent &= ((InStore.GetFlags()[index] & RenderEntityStore::EF_CastShadow) != 0) == item->bCastShadow;
+		}
+		return bConsistent && numLive == InStore.GetNumEntities();
+	}
+}
+
+TEST_CASE(RenderEntityStore_SwapRemove)
+{
+	std::vector<std::unique_ptr<RenderItem>> items = CreateRenderItems(2000, 47);
+
+	RenderEntityStore store;
+	for (std::unique_ptr<RenderItem>& item : items)
+	{
+		store.Create(item.get(), true);
+	}
+	CHECK(store.GetNumEntities() == items.size());
+	CHECK(IsConsistent(store, items));
+
+	// Destroy half in random order, the last entity moves into every freed index and must be re-culled.
+	TestRandom random(53);
+	std::vector<int32> freed;
+	bool bConsistent = true, bMovedFlagged = true;
+	for (uint32 i = 0; i < 1000; ++i)
+	{
+		RenderItem* item = items[random.NextUInt((uint32)items.size())].get();
+		if (item->Entity == RenderEntityStore::NullEntity)
+			continue;
+
+		const uint32 index = store.GetIndex(item->Entity);
+		const bool bLast = index + 1 == store.GetNumEntities();
+		for (uint32 e = 0; e < store.GetNumEntities(); ++e)
+		{
+			store.ClearFlag(e, RenderEntityStore::EF_BoundsChanged);
+		}
+
+		freed.push_back(item->Entity);
+		store.Destroy(item->Entity);
+		bConsistent &= item->Entity == RenderEntityStore::NullEntity;
+
+		if (!bLast)
+		{
+			bMovedFlagged &= (store.GetFlags()[index] & RenderEntityStore::EF_BoundsChanged) != 0;
+		}
+	}
+	CHECK(bConsistent);
+	CHECK(bMovedFlagged);
+	CHECK(IsConsistent(store, items));
+
+	// Entity ids are reused, the most recently freed first, and a changed owner is synced.
+	std::unique_ptr<RenderItem> extra(new RenderItem());
+	const int32 entity = store.Create(extra.get(), false);
+	CHECK(entity == freed.back());
+	CHECK((store.GetFlags()[store.GetIndex(entity)] & RenderEntityStore::EF_Opaque) == 0);
+	items.push_back(std::move(extra));
+
+	items[0]->MaterialIndex = 77;
+	items[0]->WorldBounds.Center.x += 5.0f;
+	if (items[0]->Entity != RenderEntityStore::NullEntity)
+	{
+		store.Sync(items[0]->Entity);
+	}
+	CHECK(IsConsistent(store, items));
+}
+
+TEST_CASE(RenderEntityStore_Benchmark)
+{
+	const uint32 numItems = 100000;
+	std::vector<std::unique_ptr<RenderItem>> items = CreateRenderItems(numItems, 59);
+
+	// The layout the store replaced: RenderItems by name, hot data read through the owner.
+	std::unordered_map<std::string, RenderItem*> itemsByName;
+	for (std::unique_ptr<RenderItem>& item : items)
+	{
+		itemsByName[std::to_string(item->Index)] = item.get();
+	}
+
+	RenderEntityStore store;
+	for (std::unique_ptr<RenderItem>& item : items)
+	{
+		store.Create(item.get(), true);
+	}
+
+	// What culling and draw sorting read each frame: visibility, bounds and material.
+	float sum = 0.0f;
+	const double mapMs = MeasureMs(5, [&]()
+	{
+		for (const auto& pair : itemsByName)
+		{
+			const RenderItem* item = pair.second;
+			if (item->bIsVisible)
+				sum += item->WorldBounds.Center.x + (float)item->MaterialIndex;
+		}
+	});
+
+	const double storeMs = MeasureMs(5, [&]()
+	{
+		const std::vector<uint8>& flags = store.GetFlags();
+		const std::vector<BoundingBox>& bounds = store.GetWorldBounds();
+		const std::vector<uint32>& materials = store.GetMaterialIndices();
+		for (uint32 i = 0; i < store.GetNumEntities(); ++i)
+		{
+			if (flags[i] & RenderEntityStore::EF_Visible)
+				sum += bounds[i].Center.x + (float)materials[i];
+		}
+	});
+
+	Report("%u items: map of RenderItems %.3f ms, dense components %.3f ms, %.1fx (%g)", numItems, mapMs, storeMs, mapMs / std::max(storeMs, 1e-6), sum);
+
+	if (bCheckTimings)
+	{
+		CHECK(storeMs < mapMs);
+	}
+}
+
+#endif // _WINDOWS
@@ -0,0 +1,292 @@
+//
+// SceneBVHTests.cpp
+//
+
+#include "TestFramework.h"
+#include "Core/Common/SceneBVH.h"
+
+#include <limits>
+
+using namespace Tests;
+using namespace Utility::GeometryManager;
+
+namespace
+{
+	// Objects with their bounds as the tree was last told, the brute force side of the comparison.
+	struct Scene
+	{
+		std::vector<Core::IObject> Objects;
+		std::vector<BoundingBox>   Bounds;
+		std::vector<int32>         Proxies;
+		std::vector<uint32>        Masks;
+
+		explicit Scene(uint32 InCapacity) : Objects(InCapacity), Bounds(InCapacity), Proxies(InCapacity, SceneBVH::NullProxy), Masks(InCapacity, 0) {}
+
+		uint32 IndexOf(const Core::IObject* InObject) const { return (uint32)(InObject - Objects.data()); }
+	};
+
+	BoundingBox RandomBox(TestRandom& InRandom, float InWorldSize)
+	{
+		const XMFLOAT3 center(InRandom.NextFloat(-InWorldSize, InWorldSize), InRandom.NextFloat(-InWorldSize, InWorldSize), InRandom.NextFloat(-InWorldSize, InWorldSize));
+		const XMFLOAT3 extents(InRandom.NextFloat(0.1f, 3.0f), InRandom.NextFloat(0.1f, 3.0f), InRandom.NextFloat(0.1f, 3.0f));
+		return BoundingBox(center, extents);
+	}
+
+	BoundingBox Scaled(const BoundingBox& InBox, float InScale)
+	{
+		return BoundingBox(InBox.Center, XMFLOAT3(InBox.Extents.x * InScale, InBox.Extents.y * InScale, InBox.Extents.z * InScale));
+	}
+
+	// Entry distance into the box, +infinity on a miss, as the tree measures it.
+	float RayEntry(const BoundingBox& InBox, const XMFLOAT3& InOrigin, const XMFLOAT3& InDirection, float InMaxDistance)
+	{
+		const float origin[3] = { InOrigin.x, InOrigin.y, InOrigin.z };
+		const float direction[3] = { InDirection.x, InDirection.y, InDirection.z };
+		const float center[3] = { InBox.Center.x, InBox.Center.y, InBox.Center.z };
+		const float extents[3] = { InBox.Extents.x, InBox.Extents.y, InBox.Extents.z };
+
+		float tmin = 0.0f, tmax = InMaxDistance;
+		for (int i = 0; i < 3; ++i)
+		{
+			const float t0 = (center[i] - extents[i] - origin[i]) / direction[i];
+			const float t1 = (center[i] + extents[i] - origin[i]) / direction[i];
+			tmin = std::max(tmin, std::min(t0, t1));
+			tmax = std::min(tmax, std::max(t0, t1));
+		}
+		return tmin <= tmax ? tmin : std::numeric_limits<float>::infinity();
+	}
+
+	// The tree must report everything whose exact bounds pass, and nothing whose fat bounds (a little padded) do not.
+	template<typename TPasses>
+	bool MatchesBruteForce(const SceneBVH& InTree, const Scene& InScene, uint32 InMask, const std::vector<uint8>& InReported, TPasses&& InPasses)
+	{
+		bool bMatches = true;
+		for (uint32 i = 0; i < (uint32)InScene.Objects.size(); ++i)
+		{
+			if (InScene.Proxies[i] == SceneBVH::NullProxy || (InScene.Masks[i] & InMask) == 0)
+			{
+				bMatches &= InReported[i] == 0;
+				continue;
+			}
+
+			if (InPasses(InScene.Bounds[i]))
+				bMatches &= InReported[i] == 1;
+			else if (!InPasses(Scaled(InTree.GetFatBounds(InScene.Proxies[i]), 1.01f)))
+				bMatches &= InReported[i] == 0;
+		}
+		return bMatches;
+	}
+
+	bool CheckQueries(const SceneBVH& InTree, const Scene& InScene, TestRandom& InRandom)
+	{
+		bool bMatches = true;
+		std::vector<uint8> reported(InScene.Objects.size());
+		auto record = [&](Core::IObject* InObject) { reported[InScene.IndexOf(InObject)]++; };
+
+		for (uint32 q = 0; q < 8; ++q)
+		{
+			const uint32 mask = q % 2 == 0 ? ~0u : 2u;
+
+			// Box.
+			const BoundingBox box(XMFLOAT3(InRandom.NextFloat(-50.0f, 50.0f), InRandom.NextFloat(-50.0f, 50.0f), InRandom.NextFloat(-50.0f, 50.0f)),
+				XMFLOAT3(InRandom.NextFloat(1.0f, 25.0f), InRandom.NextFloat(1.0f, 25.0f), InRandom.NextFloat(1.0f, 25.0f)));
+			std::fill(reported.begin(), reported.end(), 0);
+			InTree.QueryBox(box, mask, record);
+			bMatches &= MatchesBruteForce(InTree, InScene, mask, reported, [&](const BoundingBox& InBox) { return box.Intersects(InBox); });
+
+			// Sphere.
+			const BoundingSphere sphere(box.Center, InRandom.NextFloat(1.0f, 30.0f));
+			std::fill(reported.begin(), reported.end(), 0);
+			InTree.QuerySphere(sphere, mask, record);
+			bMatches &= MatchesBruteForce(InTree, InScene, mask, reported, [&](const BoundingBox& InBox) { return sphere.Contains(InBox) != DISJOINT; });
+
+			// Frustum, a 90 degree camera somewhere in the scene turned about y.
+			const float angle = InRandom.NextFloat(0.0f, XM_2PI);
+			XMFLOAT4 orientation(0.0f, sinf(angle * 0.5f), 0.0f, cosf(angle * 0.5f));
+			const BoundingFrustum frustum(box.Center, orientation, 1.0f, -1.0f, 0.75f, -0.75f, 0.5f, 60.0f);
+			std::fill(reported.begin(), reported.end(), 0);
+			InTree.QueryFrustum(frustum, mask, record);
+			bMatches &= MatchesBruteForce(InTree, InScene, mask, reported, [&](const BoundingBox& InBox) { return frustum.Contains(InBox) != DISJOINT; });
+
+			// Ray, every box it enters, then only the nearest as picking asks for it.
+			const XMFLOAT3 origin(InRandom.NextFloat(-80.0f, 80.0f), InRandom.NextFloat(-80.0f, 80.0f), -90.0f);
+			const XMFLOAT3 direction(InRandom.NextFloat(-0.5f, 0.5f), InRandom.NextFloat(-0.5f, 0.5f), 1.0f);
+			const float maxDistance = 200.0f;
+			std::fill(reported.begin(), reported.end(), 0);
+			InTree.QueryRay(origin, direction, maxDistance, mask, [&](Core::IObject* InObject, float) { record(InObject); return maxDistance; });
+			bMatches &= MatchesBruteForce(InTree, InScene, mask, reported, [&](const BoundingBox& InBox) { return RayEntry(InBox, origin, direction, maxDistance) <= maxDistance; });
+
+			float nearest = std::numeric_limits<float>::infinity();
+			InTree.QueryRay(origin, direction, maxDistance, mask, [&](Core::IObject* InObject, float)
+			{
+				nearest = std::min(nearest, RayEntry(InScene.Bounds[InScene.IndexOf(InObject)], origin, direction, maxDistance));
+				return std::min(nearest, maxDistance);
+			});
+			float bruteNearest = std::numeric_limits<float>::infinity();
+			for (uint32 i = 0; i < (uint32)InScene.Objects.size(); ++i)
+			{
+				if (InScene.Proxies[i] != SceneBVH::NullProxy && (InScene.Masks[i] & mask) != 0)
+					bruteNearest = std::min(bruteNearest, RayEntry(InScene.Bounds[i], origin, direction, maxDistance));
+			}
+			bMatches &= nearest == bruteNearest;
+		}
+		return bMatches;
+	}
+}
+
+TEST_CASE(SceneBVH_MatchesBruteForceUnderEdits)
+{
+	const uint32 capacity = 3000;
+	Scene scene(capacity);
+	SceneBVH tree;
+	TestRandom random(5);
+
+	uint32 numAlive = 0, numReinserted = 0, numMoves = 0;
+	bool bQueries = true, bCounts = true, bHeights = true, bFat = true;
+	for (uint32 step = 0; step < 20000; ++step)
+	{
+		const uint32 i = random.NextUInt(capacity);
+		const uint32 op = random.NextUInt(10);
+		if (scene.Proxies[i] == SceneBVH::NullProxy)
+		{
+			// Empty slot, insert.
+			scene.Bounds[i] = RandomBox(random, 50.0f);
+			scene.Masks[i] = 1u << random.NextUInt(3);
+			scene.Proxies[i] = tree.Insert(scene.Bounds[i], &scene.Objects[i], scene.Masks[i]);
+			numAlive++;
+		}
+		else if (op < 2)
+		{
+			tree.Remove(scene.Proxies[i]);
+			scene.Proxies[i] = SceneBVH::NullProxy;
+			numAlive--;
+		}
+		else
+		{
+			// Mostly small moves that stay in the fat bounds, some jumps across the scene.
+			BoundingBox& bounds = scene.Bounds[i];
+			if (op < 8)
+			{
+				bounds.Center.x += random.NextFloat(-0.05f, 0.05f) * bounds.Extents.x;
+				bounds.Center.z += random.NextFloat(-0.05f, 0.05f) * bounds.Extents.z;
+			}
+			else
+			{
+				bounds = RandomBox(random, 50.0f);
+			}
+			numReinserted += tree.Move(scene.Proxies[i], bounds) ? 1 : 0;
+			numMoves++;
+			bFat &= tree.GetFatBounds(scene.Proxies[i]).Contains(bounds) == CONTAINS;
+		}
+
+		bCounts &= tree.GetNumProxies() == numAlive;
+		if (step % 500 == 499)
+		{
+			bQueries &= CheckQueries(tree, scene, random);
+
+			// Rotations keep it about AVL balanced.
+			const float log2n = log2f((float)std::max(numAlive, 2u));
+			bHeights &= tree.GetHeight() <= (int32)(2.0f * log2n) + 2;
+		}
+	}
+	CHECK(bCounts);
+	CHECK(bQueries);
+	CHECK(bHeights);
+	CHECK(bFat);
+	CHECK(numReinserted > 0 && numReinserted < numMoves);
+	Report("%u proxies, height %d, %u of %u moves reinserted", numAlive, tree.GetHeight(), numReinserted, numMoves);
+
+	// Emptied, the tree holds nothing and takes new proxies again.
+	for (uint32 i = 0; i < capacity; ++i)
+	{
+		if (scene.Proxies[i] != SceneBVH::NullProxy)
+		{
+			tree.Remove(scene.Proxies[i]);
+			scene.Proxies[i] = SceneBVH::NullProxy;
+		}
+	}
+	CHECK(tree.GetNumProxies() == 0 && tree.GetHeight() == 0);
+	uint32 numVisited = 0;
+	tree.QueryBox(BoundingBox(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(1000.0f, 1000.0f, 1000.0f)), ~0u, [&](Core::IObject*) { numVisited++; });
+	CHECK(numVisited == 0);
+}
+
+TEST_CASE(SceneBVH_Benchmark)
+{
+	const uint32 count = 100000;
+	Scene scene(count);
+	SceneBVH tree;
+	TestRandom random(9);
+	for (uint32 i = 0; i < count; ++i)
+	{
+		scene.Bounds[i] = RandomBox(random, 500.0f);
+		scene.Masks[i] = ~0u;
+	}
+
+	const double insertMs = MeasureMs(1, [&]()
+	{
+		for (uint32 i = 0; i < count; ++i)
+		{
+			scene.Proxies[i] = tree.Insert(scene.Bounds[i], &scene.Objects[i]);
+		}
+	});
+
+	// A frame of 1000 animated items, small steps.
+	const double moveMs = MeasureMs(5, [&]()
+	{
+		for (uint32 i = 0; i < 1000; ++i)
+		{
+			BoundingBox& bounds = scene.Bounds[i * 97];
+			bounds.Center.y += 0.01f;
+			tree.Move(scene.Proxies[i * 97], bounds);
+		}
+	});
+
+	// Picking: nearest box along a ray, and a selection box, against the linear scans they replace.
+	const XMFLOAT3 origin(3.0f, 7.0f, -600.0f), direction(0.01f, -0.02f, 1.0f);
+	const float maxDistance = 2000.0f;
+	float treeNearest = 0.0f, scanNearest = 0.0f;
+	const double rayMs = MeasureMs(20, [&]()
+	{
+		treeNearest = std::numeric_limits<float>::infinity();
+		tree.QueryRay(origin, direction, maxDistance, ~0u, [&](Core::IObject* InObject, float)
+		{
+			treeNearest = std::min(treeNearest, RayEntry(scene.Bounds[scene.IndexOf(InObject)], origin, direction, maxDistance));
+			return std::min(treeNearest, maxDistance);
+		});
+	});
+	const double rayScanMs = MeasureMs(20, [&]()
+	{
+		scanNearest = std::numeric_limits<float>::infinity();
+		for (uint32 i = 0; i < count; ++i)
+		{
+			scanNearest = std::min(scanNearest, RayEntry(scene.Bounds[i], origin, direction, maxDistance));
+		}
+	});
+	CHECK(treeNearest == scanNearest);
+
+	const BoundingBox selection(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(40.0f, 40.0f, 40.0f));
+	uint32 treeHits = 0, scanHits = 0;
+	const double boxMs = MeasureMs(20, [&]()
+	{
+		treeHits = 0;
+		tree.QueryBox(selection, ~0u, [&](Core::IObject* InObject) { treeHits += selection.Intersects(scene.Bounds[scene.IndexOf(InObject)]) ? 1 : 0; });
+	});
+	const double boxScanMs = MeasureMs(20, [&]()
+	{
+		scanHits = 0;
+		for (uint32 i = 0; i < count; ++i)
+		{
+			scanHits += selection.Intersects(scene.Bounds[i]) ? 1 : 0;
+		}
+	});
+	CHECK(treeHits == scanHits);
+
+	Report("%u boxes: insert %.1f ms, 1000 moves %.3f ms, height %d", count, insertMs, moveMs, tree.GetHeight());
+	Report("nearest ray hit %.4f ms (scan %.3f ms), box query %.4f ms with %u hits (scan %.3f ms)", rayMs, rayScanMs, boxMs, treeHits, boxScanMs);
+	if (bCheckTimings)
+	{
+		CHECK(rayMs * 10.0 < rayScanMs);
+		CHECK(boxMs * 10.0 < boxScanMs);
+	}
+}
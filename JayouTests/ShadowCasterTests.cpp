@@ -0,0 +1,193 @@
+//
+// ShadowCasterTests.cpp
+//
+
+#include "TestFramework.h"
+#include "Core/Common/FrustumCuller.h"
+
+#include <limits>
+
+using namespace Tests;
+using namespace Utility::GeometryManager;
+
+namespace
+{
+	// Largest signed distance of a box corner to InPlane, the box is behind the plane when it is negative.
+	float MaxDistance(const BoundingBox& InBox, const XMFLOAT4& InPlane)
+	{
+		XMFLOAT3 corners[BoundingBox::CORNER_COUNT];
+		InBox.GetCorners(corners);
+
+		float maxDistance = -std::numeric_limits<float>::max();
+		for (const XMFLOAT3& corner : corners)
+		{
+			maxDistance = std::max(maxDistance, corner.x * InPlane.x + corner.y * InPlane.y + corner.z * InPlane.z + InPlane.w);
+		}
+		return maxDistance;
+	}
+
+	///<summary>
+	/// What a caster is, spelled out: not behind a side or the far plane of the light, and some part of the box swept
+	/// along the light reaching into the camera frustum. A plane is linear along the sweep, so the swept box is
+	/// behind it exactly when the box at both ends is. OutAmbiguous marks boxes within rounding of a plane.
+	///</summary>
+	bool IsReferenceCaster(const BoundingBox& InBox, const XMFLOAT4 InLightPlanes[6], const XMFLOAT4 InCameraPlanes[6],
+		const XMFLOAT3& InLightDirection, float InSweepLength, bool& OutAmbiguous)
+	{
+		BoundingBox swept = InBox;
+		swept.Center.x += InLightDirection.x * InSweepLength;
+		swept.Center.y += InLightDirection.y * InSweepLength;
+		swept.Center.z += InLightDirection.z * InSweepLength;
+
+		bool bCaster = true;
+		OutAmbiguous = false;
+		for (uint32 p = 0; p < 6; ++p)
+		{
+			// The near plane of the light is left open.
+			if (p != 4)
+			{
+				const float distance = MaxDistance(InBox, InLightPlanes[p]);
+				bCaster &= distance >= 0.0f;
+				OutAmbiguous |= fabsf(distance) < 1e-3f;
+			}
+
+			const float distance = std::max(MaxDistance(InBox, InCameraPlanes[p]), MaxDistance(swept, InCameraPlanes[p]));
+			bCaster &= distance >= 0.0f;
+			OutAmbiguous |= fabsf(distance) < 1e-3f;
+		}
+		return bCaster;
+	}
+
+	struct ShadowSetup
+	{
+		XMFLOAT4 LightPlanes[6];
+		XMFLOAT4 CameraPlanes[6];
+		XMFLOAT3 LightDirection;
+		float    SweepLength;
+	};
+
+	// A camera at the origin looking along +z, a directional light's orthographic frustum 400 units wide around it.
+	ShadowSetup CreateSetup(const XMFLOAT3& InLightDirection)
+	{
+		ShadowSetup setup;
+		XMStoreFloat3(&setup.LightDirection, XMVector3Normalize(XMLoadFloat3(&InLightDirection)));
+
+		const XMVECTOR lightDirection = XMLoadFloat3(&setup.LightDirection);
+		const XMMATRIX lightView = XMMatrixLookToLH(XMVectorScale(lightDirection, -200.0f), lightDirection, XMVectorSet(0, 0, 1, 0));
+		FrustumCuller::ExtractPlanes(XMMatrixMultiply(lightView, XMMatrixOrthographicLH(400.0f, 400.0f, 1.0f, 400.0f)), setup.LightPlanes);
+		setup.SweepLength = 400.0f - 1.0f;
+
+		const XMMATRIX view = XMMatrixLookToLH(XMVectorSet(0, 2, 0, 1), XMVectorSet(0, 0, 1, 0), XMVectorSet(0, 1, 0, 0));
+		FrustumCuller::ExtractPlanes(XMMatrixMultiply(view, XMMatrixPerspectiveFovLH(0.25f * XM_PI, 1.0f, 1.0f, 100.0f)), setup.CameraPlanes);
+		return setup;
+	}
+
+	std::vector<BoundingBox> CreateBoxes(uint32 InCount, uint32 InSeed)
+	{
+		TestRandom random(InSeed);
+		std::vector<BoundingBox> boxes(InCount);
+		for (BoundingBox& box : boxes)
+		{
+			box.Center = XMFLOAT3(random.NextFloat(-300, 300), random.NextFloat(-150, 250), random.NextFloat(-300, 300));
+			box.Extents = XMFLOAT3(random.NextFloat(0.2f, 4), random.NextFloat(0.2f, 4), random.NextFloat(0.2f, 4));
+		}
+		return boxes;
+	}
+
+	uint32 CullShadowCasters(FrustumCuller& InCuller, const std::vector<BoundingBox>& InBoxes, const ShadowSetup& InSetup,
+		std::vector<uint32>& OutCasters, ECullInstructionSet InInstructionSet)
+	{
+		InCuller.Resize((uint32)InBoxes.size());
+		for (uint32 i = 0; i < (uint32)InBoxes.size(); ++i)
+		{
+			InCuller.SetBounds(i, InBoxes[i]);
+		}
+		return InCuller.CullShadowCasters(InSetup.LightPlanes, InSetup.CameraPlanes, InSetup.LightDirection, InSetup.SweepLength, OutCasters, InInstructionSet);
+	}
+}
+
+TEST_CASE(ShadowCasters_Placement)
+{
+	const ShadowSetup setup = CreateSetup(XMFLOAT3(0.0f, -1.0f, 0.0f));
+
+	std::vector<BoundingBox> boxes;
+	boxes.push_back(BoundingBox(XMFLOAT3(0, 2, 30), XMFLOAT3(1, 1, 1)));     // In view.
+	boxes.push_back(BoundingBox(XMFLOAT3(0, 60, 30), XMFLOAT3(1, 1, 1)));    // Above the view, shadows into it.
+	boxes.push_back(BoundingBox(XMFLOAT3(0, -60, 30), XMFLOAT3(1, 1, 1)));   // Below the view, shadows away from it.
+	boxes.push_back(BoundingBox(XMFLOAT3(0, 250, 30), XMFLOAT3(1, 1, 1)));   // Between the light and its near plane.
+	boxes.push_back(BoundingBox(XMFLOAT3(300, 60, 30), XMFLOAT3(1, 1, 1)));  // Beside the light frustum.
+	boxes.push_back(BoundingBox(XMFLOAT3(0, 60, -30), XMFLOAT3(1, 1, 1)));   // Above and behind the camera.
+
+	FrustumCuller culler;
+	std::vector<uint32> casters;
+	for (ECullInstructionSet instructionSet : { CIS_Scalar, CIS_SSE, CIS_AVX })
+	{
+		if (instructionSet <= FrustumCuller::GetBestInstructionSet())
+		{
+			CullShadowCasters(culler, boxes, setup, casters, instructionSet);
+			CHECK((casters == std::vector<uint32>{ 0, 1, 3 }));
+		}
+	}
+}
+
+TEST_CASE(ShadowCasters_MatchReference)
+{
+	const std::vector<BoundingBox> boxes = CreateBoxes(20011, 9);
+
+	FrustumCuller culler;
+	std::vector<uint32> casters;
+	for (const XMFLOAT3& lightDirection : { XMFLOAT3(0.3f, -1.0f, 0.2f), XMFLOAT3(-1.0f, -0.5f, 0.7f), XMFLOAT3(0.0f, -0.2f, -1.0f) })
+	{
+		const ShadowSetup setup = CreateSetup(lightDirection);
+		CullShadowCasters(culler, boxes, setup, casters, FrustumCuller::GetBestInstructionSet());
+
+		std::vector<bool> bCaster(boxes.size(), false);
+		for (uint32 i : casters)
+		{
+			bCaster[i] = true;
+		}
+
+		bool bMatches = true;
+		for (size_t i = 0; i < boxes.size(); ++i)
+		{
+			bool bAmbiguous = false;
+			const bool bExpected = IsReferenceCaster(boxes[i], setup.LightPlanes, setup.CameraPlanes, setup.LightDirection, setup.SweepLength, bAmbiguous);
+			bMatches &= bAmbiguous || bCaster[i] == bExpected;
+		}
+		CHECK(bMatches);
+
+		// The pass still drops most of the scene.
+		CHECK(!casters.empty() && casters.size() < boxes.size() / 4);
+
+		for (ECullInstructionSet instructionSet : { CIS_Scalar, CIS_SSE })
+		{
+			std::vector<uint32> other;
+			if (instructionSet <= FrustumCuller::GetBestInstructionSet())
+			{
+				culler.CullShadowCasters(setup.LightPlanes, setup.CameraPlanes, setup.LightDirection, setup.SweepLength, other, instructionSet);
+				CHECK(other == casters);
+			}
+		}
+	}
+}
+
+TEST_CASE(ShadowCasters_Benchmark)
+{
+	const std::vector<BoundingBox> boxes = CreateBoxes(100000, 13);
+	const ShadowSetup setup = CreateSetup(XMFLOAT3(0.3f, -1.0f, 0.2f));
+
+	FrustumCuller culler;
+	std::vector<uint32> casters;
+	CullShadowCasters(culler, boxes, setup, casters, FrustumCuller::GetBestInstructionSet());
+
+	const double ms = MeasureMs(20, [&]()
+	{
+		culler.CullShadowCasters(setup.LightPlanes, setup.CameraPlanes, setup.LightDirection, setup.SweepLength, casters);
+	});
+	Report("%u boxes, %u casters drawn instead of all of them, %.3f ms", (uint32)boxes.size(), (uint32)casters.size(), ms);
+
+	if (bCheckTimings)
+	{
+		CHECK(ms < 1.0);
+	}
+}
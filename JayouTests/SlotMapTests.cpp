@@ -0,0 +1,217 @@
+//
+// SlotMapTests.cpp
+//
+
+#include "TestFramework.h"
+#include "Core/Common/SlotMap.h"
+#include "Core/Common/DirtyList.h"
+#include "Core/Common/GeometryCache.h"
+#include "Core/Common/SceneBVH.h"
+#include "Core/Common/TransformHierarchy.h"
+
+#include <algorithm>
+
+using namespace Tests;
+using namespace Utility::GeometryManager;
+
+namespace
+{
+	class TestObject : public Core::IObject
+	{
+	};
+
+	struct TestRenderData
+	{
+	};
+
+	// What GWorld::GarbageCollection touches of a RenderItem.
+	class TestRenderItem : public Core::IObject
+	{
+	public:
+
+		std::shared_ptr<TestRenderData> RenderData;
+		uint64                          GeometryHash = 0;
+		int32                           GeometryUser = -1;
+		int32                           SceneProxy = SceneBVH::NullProxy;
+		int32                           TransformNode = TransformHierarchy::NullNode;
+	};
+}
+
+TEST_CASE(SlotMap_StaleHandles)
+{
+	std::vector<TestObject> objects(100);
+	SlotMap slots;
+	for (TestObject& object : objects)
+	{
+		slots.Insert(&object);
+	}
+	CHECK(objects[0].Index == 0 && objects[99].Index == 99);
+	CHECK(slots.GetCapacity() == 100 && slots.GetNumObjects() == 100);
+
+	const Core::SlotHandle handle = objects[42].GetHandle();
+	CHECK(slots.Get(handle) == &objects[42]);
+
+	// Removed, its handle resolves to nothing, the other slots do not move and nothing grows.
+	slots.Remove(&objects[42]);
+	slots.Remove(&objects[7]);
+	CHECK(objects[42].Index == SlotMap::NullSlot);
+	CHECK(slots.Get(handle) == nullptr);
+	CHECK(slots.Get(objects[43].GetHandle()) == &objects[43] && objects[43].Index == 43);
+	CHECK(slots.GetCapacity() == 100 && slots.GetNumObjects() == 98);
+
+	// The most recently freed slot is reused first, under a new generation.
+	TestObject first, second, third;
+	slots.Insert(&first);
+	slots.Insert(&second);
+	CHECK(first.Index == 7 && second.Index == 42);
+	CHECK(slots.Get(handle) == nullptr);
+	CHECK(slots.Get(second.GetHandle()) == &second);
+	CHECK(second.Generation != handle.Generation);
+
+	slots.Insert(&third);
+	CHECK(third.Index == 100 && slots.GetCapacity() == 101);
+
+	// Out of range and null handles.
+	Core::SlotHandle invalid;
+	CHECK(slots.Get(invalid) == nullptr);
+	invalid.Index = 1000;
+	CHECK(slots.Get(invalid) == nullptr);
+
+	// A slot freed and reused many times still tells its generations apart.
+	Core::SlotHandle old = first.GetHandle();
+	for (uint32 i = 0; i < 1000; ++i)
+	{
+		slots.Remove(&first);
+		slots.Insert(&first);
+	}
+	CHECK(first.Index == 7 && slots.Get(old) == nullptr && slots.Get(first.GetHandle()) == &first);
+}
+
+TEST_CASE(SlotMap_Benchmark)
+{
+	const uint32 numObjects = 100000;
+	std::vector<TestObject> objects(numObjects);
+	SlotMap slots;
+	for (TestObject& object : objects)
+	{
+		slots.Insert(&object);
+	}
+
+	// One item out of 100k, then put back so every repeat deletes from a full map.
+	const double removeMs = MeasureMs(100, [&]()
+	{
+		slots.Remove(&objects[numObjects / 2]);
+		slots.Insert(&objects[numObjects / 2]);
+	});
+	CHECK(slots.GetCapacity() == numObjects);
+
+	// What GarbageCollection did before: erase from the vector and renumber everything after it.
+	std::vector<Core::IObject*> list(numObjects);
+	for (uint32 i = 0; i < numObjects; ++i)
+	{
+		list[i] = &objects[i];
+	}
+	const double eraseMs = MeasureMs(10, [&]()
+	{
+		Core::IObject* object = list[numObjects / 2];
+		list.erase(std::find(list.begin(), list.end(), object));
+		for (uint32 i = 0; i < (uint32)list.size(); ++i)
+		{
+			list[i]->Index = (int32)i;
+		}
+		list.insert(list.begin() + numObjects / 2, object);
+	});
+
+	Report("Deleting 1 of %u: slot map %.2f us, erase and renumber %.2f us", numObjects, removeMs * 1000.0, eraseMs * 1000.0);
+
+	if (bCheckTimings)
+	{
+		CHECK(removeMs < 0.01);
+	}
+}
+
+TEST_CASE(SlotMap_DeletePathBenchmark)
+{
+	// 100k items, 1000 imported models of 100 meshes each under a group node, sharing the geometry of their model.
+	const uint32 numGroups = 1000, numPerGroup = 100, numItems = numGroups * numPerGroup;
+	std::vector<TestRenderItem> items(numItems);
+	std::unordered_map<uint32, TestRenderItem*> registry;
+	SlotMap slots;
+	DirtyList dirtyList;
+	dirtyList.Reset(3);
+	SceneBVH scene;
+	TransformHierarchy transforms;
+	GeometryCache<TestRenderItem, TestRenderData> geometryCache;
+
+	TestRandom random(5);
+	for (uint32 group = 0; group < numGroups; ++group)
+	{
+		const int32 groupNode = transforms.Insert(TransformHierarchy::NullNode, Matrix4(XMMatrixTranslation((float)group, 0.0f, 0.0f)));
+		for (uint32 i = 0; i < numPerGroup; ++i)
+		{
+			TestRenderItem& item = items[group * numPerGroup + i];
+			const XMFLOAT3 center(random.NextFloat(-1000.0f, 1000.0f), random.NextFloat(-1000.0f, 1000.0f), random.NextFloat(-1000.0f, 1000.0f));
+			item.SceneProxy = scene.Insert(BoundingBox(center, XMFLOAT3(1.0f, 1.0f, 1.0f)), &item);
+			item.TransformNode = transforms.Insert(groupNode, Matrix4(XMMatrixIdentity()), &item);
+			slots.Insert(&item);
+			dirtyList.Add(&item);
+			registry[group * numPerGroup + i] = &item;
+
+			item.RenderData = geometryCache.Share(i, &item, [](const TestRenderItem&) { return true; });
+			if (item.RenderData == nullptr)
+			{
+				item.RenderData = std::make_shared<TestRenderData>();
+				geometryCache.Add(i, &item, item.RenderData);
+			}
+		}
+	}
+	transforms.Update();
+	for (uint32 frame = 0; frame < 3; ++frame)
+	{
+		dirtyList.Update(frame, [](Core::IObject*) {});
+	}
+	CHECK(dirtyList.GetNumDirty() == 0 && geometryCache.GetNumEntries() == numPerGroup);
+
+	// GarbageCollection and the UpdateTransforms after it, for one item at a time, the first one the source of its mesh.
+	uint32 next = 0;
+	auto deleteOne = [&]()
+	{
+		const uint32 id = (next % numGroups) * numPerGroup + next * 7 % numPerGroup;
+		next++;
+		registry[id]->MarkAsDeleted();
+
+		std::vector<TestRenderItem*> deleted;
+		dirtyList.ForEach([&](Core::IObject* InObject)
+		{
+			if (InObject->CanbeDeletedNow())
+				deleted.push_back(static_cast<TestRenderItem*>(InObject));
+		});
+		for (TestRenderItem* item : deleted)
+		{
+			scene.Remove(item->SceneProxy);
+			item->SceneProxy = SceneBVH::NullProxy;
+			dirtyList.Remove(item);
+			transforms.Remove(item->TransformNode);
+			item->TransformNode = TransformHierarchy::NullNode;
+			slots.Remove(item);
+			geometryCache.Remove(item);
+			item->RenderData = nullptr;
+			registry.erase(id);
+		}
+		transforms.Update();
+	};
+
+	const double firstMs = MeasureMs(1, deleteOne);
+	const double deleteMs = MeasureMs(999, deleteOne);
+	CHECK(registry.size() == numItems - 1000 && slots.GetNumObjects() == numItems - 1000);
+	CHECK(transforms.GetNumNodes() == numItems - 1000 + numGroups && geometryCache.GetNumEntries() == numPerGroup);
+
+	// Shared data survives its uploader, every mesh lost 10 of its users.
+	CHECK(geometryCache.GetNumUsers(0) == numGroups - 10 && geometryCache.GetSource(0) != nullptr && geometryCache.GetSource(0)->RenderData != nullptr);
+
+	Report("Deleting 1 of %u items: %.2f us, the first %.2f us", numItems, deleteMs * 1000.0, firstMs * 1000.0);
+	if (bCheckTimings)
+	{
+		CHECK(deleteMs < 0.1);
+	}
+}
@@ -0,0 +1,136 @@
+//
+// TestFramework.cpp
+//
+
+#include "TestFramework.h"
+
+#include <atomic>
+#include <cstdarg>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+	uint32 g_numFailures = 0;
+
+	// Ahead of every allocation, keeps the alignment malloc gives.
+	const size_t AllocationHeader = 16;
+
+	std::atomic<uint64> g_allocatedBytes(0);
+	std::atomic<uint64> g_peakAllocatedBytes(0);
+
+	void* Allocate(size_t InSize)
+	{
+		uint8* memory = (uint8*)malloc(InSize + AllocationHeader);
+		if (memory == nullptr)
+			return nullptr;
+
+		*(size_t*)memory = InSize;
+
+		const uint64 allocated = g_allocatedBytes += InSize;
+		uint64 peak = g_peakAllocatedBytes.load();
+		while (allocated > peak && !g_peakAllocatedBytes.compare_exchange_weak(peak, allocated))
+		{
+		}
+
+		return memory + AllocationHeader;
+	}
+
+	void Free(void* InMemory)
+	{
+		if (InMemory == nullptr)
+			return;
+
+		uint8* memory = (uint8*)InMemory - AllocationHeader;
+		g_allocatedBytes -= *(size_t*)memory;
+		free(memory);
+	}
+}
+
+void* operator new(size_t InSize)
+{
+	void* memory = Allocate(InSize);
+	if (memory == nullptr)
+		throw std::bad_alloc();
+	return memory;
+}
+
+void* operator new[](size_t InSize)
+{
+	return operator new(InSize);
+}
+
+void* operator new(size_t InSize, const std::nothrow_t&) noexcept
+{
+	return Allocate(InSize);
+}
+
+void* operator new[](size_t InSize, const std::nothrow_t&) noexcept
+{
+	return Allocate(InSize);
+}
+
+void operator delete(void* InMemory) noexcept
+{
+	Free(InMemory);
+}
+
+void operator delete[](void* InMemory) noexcept
+{
+	Free(InMemory);
+}
+
+void operator delete(void* InMemory, const std::nothrow_t&) noexcept
+{
+	Free(InMemory);
+}
+
+void operator delete[](void* InMemory, const std::nothrow_t&) noexcept
+{
+	Free(InMemory);
+}
+
+std::vector<Tests::TestCase>& Tests::GetTests()
+{
+	// Built on first use, the registrars of other files run before main in any order.
+	static std::vector<TestCase> tests;
+	return tests;
+}
+
+uint32 Tests::GetNumFailures()
+{
+	return g_numFailures;
+}
+
+void Tests::ReportFailure(const char* InFile, int InLine, const char* InExpression)
+{
+	printf("    FAILED %s(%d): %s\n", InFile, InLine, InExpression);
+	g_numFailures++;
+}
+
+uint64 Tests::GetAllocatedBytes()
+{
+	return g_allocatedBytes.load();
+}
+
+uint64 Tests::GetPeakAllocatedBytes()
+{
+	return g_peakAllocatedBytes.load();
+}
+
+void Tests::ResetPeakAllocatedBytes()
+{
+	g_peakAllocatedBytes = g_allocatedBytes.load();
+}
+
+void Tests::Report(const char* InFormat, ...)
+{
+	printf("    ");
+
+	va_list args;
+	va_start(args, InFormat);
+	vprintf(InFormat, args);
+	va_end(args);
+
+	printf("\n");
+}
@@ -0,0 +1,107 @@
+//
+// TestFramework.h
+//
+
+#pragma once
+
+#include "Core/Common/TypeDef.h"
+
+#include <chrono>
+#include <cstdio>
+
+namespace Tests
+{
+	typedef void(*PFTEST)(void);
+
+	struct TestCase
+	{
+		const char* Name;
+		PFTEST      Function;
+	};
+
+	// Every TEST_CASE of the executable, in the order the files were linked.
+	std::vector<TestCase>& GetTests();
+
+	struct TestRegistrar
+	{
+		TestRegistrar(const char* InName, PFTEST InFunction) { GetTests().push_back({ InName, InFunction }); }
+	};
+
+	// Failed CHECKs so far, of all tests.
+	uint32 GetNumFailures();
+
+	// A failed CHECK, the test goes on so one run shows every failure.
+	void ReportFailure(const char* InFile, int InLine, const char* InExpression);
+
+	///<summary>
+	/// A measured number, printed under the running test. Reports only inform, what must hold is a CHECK.
+	///</summary>
+	void Report(const char* InFormat, ...);
+
+	// Timing bounds hold for optimized builds, a debug build only reports.
+#ifdef NDEBUG
+	const bool bCheckTimings = true;
+#else
+	const bool bCheckTimings = false;
+#endif
+
+	///<summary>
+	/// Bytes allocated with new and not deleted yet, the executable replaces the global operator new and delete to count
+	/// them. Memory a library allocates on its own (malloc, another heap) is not seen.
+	///</summary>
+	uint64 GetAllocatedBytes();
+
+	// The most GetAllocatedBytes was since the last ResetPeakAllocatedBytes.
+	uint64 GetPeakAllocatedBytes();
+	void   ResetPeakAllocatedBytes();
+
+	///<summary>
+	/// Best of InRepeats runs of InFunction in milliseconds, the least disturbed one.
+	///</summary>
+	template<typename TFunction>
+	double MeasureMs(uint32 InRepeats, TFunction&& InFunction)
+	{
+		double best = std::numeric_limits<double>::max();
+		for (uint32 i = 0; i < InRepeats; ++i)
+		{
+			const auto start = std::chrono::steady_clock::now();
+			InFunction();
+			best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+		}
+		return best;
+	}
+
+	// Deterministic numbers for test data, the same on every platform (unlike the distributions of <random>).
+	class TestRandom
+	{
+	public:
+
+		explicit TestRandom(uint32 InSeed = 1) : m_state(InSeed * 0x9e3779b97f4a7c15ull + 1) {}
+
+		uint32 NextUInt()
+		{
+			m_state ^= m_state >> 12;
+			m_state ^= m_state << 25;
+			m_state ^= m_state >> 27;
+			return (uint32)((m_state * 0x2545f4914f6cdd1dull) >> 32);
+		}
+
+		// [0, InBound).
+		uint32 NextUInt(uint32 InBound) { return (uint32)(((uint64)NextUInt() * InBound) >> 32); }
+
+		// [InMin, InMax).
+		float NextFloat(float InMin = 0.0f, float InMax = 1.0f) { return InMin + (InMax - InMin) * (NextUInt() >> 8) * (1.0f / 16777216.0f); }
+
+	private:
+
+		uint64 m_state;
+	};
+}
+
+#define TEST_CASE(Name) \
+	static void Name(); \
+	static Tests::TestRegistrar Name##Registrar(#Name, &Name); \
+	static void Name()
+
+#define CHECK(x) \
+	do { if (!(x)) Tests::ReportFailure(__FILE__, __LINE__, #x); } while (0)
@@ -0,0 +1,94 @@
+//
+// TestMeshes.h
+//
+
+#pragma once
+
+#include "TestFramework.h"
+#include "Core/Common/GeometryManager.h"
+
+namespace Tests
+{
+	using namespace Utility::GeometryManager;
+
+	struct TestMesh
+	{
+		const char*          Name;
+		GeometryData<Vertex> Data;
+	};
+
+	///<summary>
+	/// GeometryCreator meshes of a few thousand to a few ten thousand triangles, shapes the importer also sees:
+	/// long strips (sphere, cylinder), a recursive subdivision (geosphere) and a flat grid.
+	///</summary>
+	inline std::vector<TestMesh> CreateTestMeshes()
+	{
+		std::vector<TestMesh> meshes;
+		meshes.push_back({ "Sphere", WinUtility::GeometryManager::GeometryCreator::CreateSphere(1.0f, 96, 64) });
+		meshes.push_back({ "Geosphere", WinUtility::GeometryManager::GeometryCreator::CreateGeosphere(1.0f, 5) });
+		meshes.push_back({ "Cylinder", WinUtility::GeometryManager::GeometryCreator::CreateCylinder(1.0f, 0.5f, 3.0f, 64, 48) });
+		meshes.push_back({ "Plane", WinUtility::GeometryManager::GeometryCreator::CreatePlane(10.0f, 10.0f, 128, 128) });
+		return meshes;
+	}
+
+	///<summary>
+	/// The triangles in random order, the way exporters that do not care about the post-transform cache write them.
+	/// Each triangle keeps its winding.
+	///</summary>
+	inline void ShuffleTriangles(std::vector<uint32>& InOutIndices, uint32 InSeed = 1)
+	{
+		TestRandom random(InSeed);
+		const uint32 numTriangles = (uint32)InOutIndices.size() / 3;
+		for (uint32 i = numTriangles; i > 1; --i)
+		{
+			const uint32 j = random.NextUInt(i);
+			for (uint32 k = 0; k < 3; ++k)
+			{
+				std::swap(InOutIndices[(i - 1) * 3 + k], InOutIndices[j * 3 + k]);
+			}
+		}
+	}
+
+	///<summary>
+	/// InMeshes as one Wavefront .obj, an "o" object per mesh, so importers see a multi mesh asset.
+	/// False if the file can not be written.
+	///</summary>
+	inline bool WriteObj(const std::string& InPath, const std::vector<TestMesh>& InMeshes)
+	{
+		FILE* file = fopen(InPath.c_str(), "w");
+		if (file == nullptr)
+			return false;
+
+		// Indices are 1 based and global to the file.
+		uint32 base = 1;
+		for (const TestMesh& mesh : InMeshes)
+		{
+			fprintf(file, "o %s\n", mesh.Name);
+			for (const Vertex& vertex : mesh.Data.Vertices)
+			{
+				fprintf(file, "v %.7g %.7g %.7g\nvn %.7g %.7g %.7g\nvt %.7g %.7g\n", vertex.Position.x, vertex.Position.y, vertex.Position.z,
+					vertex.Normal.x, vertex.Normal.y, vertex.Normal.z, vertex.TexC.x, vertex.TexC.y);
+			}
+			for (size_t i = 0; i < mesh.Data.Indices32.size(); i += 3)
+			{
+				const uint32 a = base + mesh.Data.Indices32[i], b = base + mesh.Data.Indices32[i + 1], c = base + mesh.Data.Indices32[i + 2];
+				fprintf(file, "f %u/%u/%u %u/%u/%u %u/%u/%u\n", a, a, a, b, b, b, c, c, c);
+			}
+			base += (uint32)mesh.Data.Vertices.size();
+		}
+
+		return fclose(file) == 0;
+	}
+
+	// Position of each corner, triangle by triangle, so meshes with different vertex orders compare.
+	inline std::vector<XMFLOAT3> GetTrianglePositions(const GeometryData<Vertex>& InData)
+	{
+		std::vector<XMFLOAT3> positions;
+		positions.reserve(InData.Indices32.size());
+		for (uint32 index : InData.Indices32)
+		{
+			positions.push_back(InData.Vertices[index].Position);
+		}
+		return positions;
+	}
+}
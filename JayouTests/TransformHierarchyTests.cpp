@@ -0,0 +1,255 @@
+//
+// TransformHierarchyTests.cpp
+//
+
+#include "TestFramework.h"
+#include "Core/Common/TransformHierarchy.h"
+#include "Core/Common/ThreadManager.h"
+
+#include <algorithm>
+
+using namespace Tests;
+using namespace Utility::GeometryManager;
+
+namespace
+{
+	class TestObject : public Core::IObject
+	{
+	};
+
+	// Mild scales so products down a deep chain stay within float precision.
+	XMMATRIX RandomLocal(TestRandom& InRandom)
+	{
+		const XMMATRIX scale = XMMatrixScaling(InRandom.NextFloat(0.8f, 1.25f), InRandom.NextFloat(0.8f, 1.25f), InRandom.NextFloat(0.8f, 1.25f));
+		const XMMATRIX rotation = XMMatrixMultiply(XMMatrixMultiply(XMMatrixRotationX(InRandom.NextFloat(-3.0f, 3.0f)),
+			XMMatrixRotationY(InRandom.NextFloat(-3.0f, 3.0f))), XMMatrixRotationZ(InRandom.NextFloat(-3.0f, 3.0f)));
+		const XMMATRIX translation = XMMatrixTranslation(InRandom.NextFloat(-10.0f, 10.0f), InRandom.NextFloat(-10.0f, 10.0f), InRandom.NextFloat(-10.0f, 10.0f));
+		return XMMatrixMultiply(XMMatrixMultiply(scale, rotation), translation);
+	}
+
+	bool NearlyEqual(const XMMATRIX& InA, const XMMATRIX& InB, float InTolerance = 1e-4f)
+	{
+		XMFLOAT4X4 a, b;
+		XMStoreFloat4x4(&a, InA);
+		XMStoreFloat4x4(&b, InB);
+		for (uint32 row = 0; row < 4; ++row)
+		{
+			for (uint32 column = 0; column < 4; ++column)
+			{
+				if (fabsf(a.m[row][column] - b.m[row][column]) > InTolerance * (1.0f + fabsf(a.m[row][column])))
+					return false;
+			}
+		}
+		return true;
+	}
+
+	// The hierarchy as plain parent links, worlds multiplied up the chain every time.
+	struct ReferenceHierarchy
+	{
+		std::vector<int32>      Parents;
+		std::vector<XMFLOAT4X4> Locals;
+		std::vector<uint8>      bAlive;
+
+		XMMATRIX GetWorld(int32 InNode) const
+		{
+			XMMATRIX world = XMMatrixIdentity();
+			for (int32 node = InNode; node != TransformHierarchy::NullNode; node = Parents[node])
+			{
+				world = XMMatrixMultiply(world, XMLoadFloat4x4(&Locals[node]));
+			}
+			return world;
+		}
+
+		bool IsDescendant(int32 InNode, int32 InAncestor) const
+		{
+			for (int32 node = InNode; node != TransformHierarchy::NullNode; node = Parents[node])
+			{
+				if (node == InAncestor)
+					return true;
+			}
+			return false;
+		}
+	};
+
+	bool SameAsReference(const TransformHierarchy& InHierarchy, const ReferenceHierarchy& InReference)
+	{
+		bool bSame = true;
+		for (int32 node = 0; node < (int32)InReference.Parents.size() && bSame; ++node)
+		{
+			if (!InReference.bAlive[node])
+				continue;
+			bSame = InHierarchy.GetParent(node) == InReference.Parents[node] && NearlyEqual(InHierarchy.GetWorld(node), InReference.GetWorld(node));
+		}
+		return bSame;
+	}
+}
+
+TEST_CASE(TransformHierarchy_MatchesReference)
+{
+	// Past the threshold where Update splits the levels across the job system.
+	const uint32 numNodes = 20000;
+	TestRandom random(11);
+	std::vector<TestObject> objects(numNodes);
+	TransformHierarchy hierarchy;
+	ReferenceHierarchy reference;
+	for (uint32 i = 0; i < numNodes; ++i)
+	{
+		const int32 parent = i < 16 ? TransformHierarchy::NullNode : (int32)random.NextUInt(i);
+		const XMMATRIX local = RandomLocal(random);
+		CHECK(hierarchy.Insert(parent, Matrix4(local), &objects[i]) == (int32)i);
+		reference.Parents.push_back(parent);
+		reference.Locals.emplace_back();
+		XMStoreFloat4x4(&reference.Locals.back(), local);
+		reference.bAlive.push_back(1);
+	}
+
+	CHECK(hierarchy.Update() == numNodes);
+	CHECK(hierarchy.GetNumNodes() == numNodes && hierarchy.GetNumLevels() > 4);
+	CHECK(SameAsReference(hierarchy, reference));
+
+	// Changed locals, only their subtrees are reported.
+	std::vector<uint8> bMoved(numNodes, 0);
+	for (uint32 i = 0; i < 300; ++i)
+	{
+		const int32 node = (int32)random.NextUInt(numNodes);
+		const XMMATRIX local = RandomLocal(random);
+		hierarchy.SetLocal(node, Matrix4(local));
+		XMStoreFloat4x4(&reference.Locals[node], local);
+		bMoved[node] = 1;
+	}
+	uint32 numExpected = 0;
+	for (int32 node = 0; node < (int32)numNodes; ++node)
+	{
+		bool bUnderMoved = false;
+		for (int32 ancestor = node; ancestor != TransformHierarchy::NullNode && !bUnderMoved; ancestor = reference.Parents[ancestor])
+		{
+			bUnderMoved = bMoved[ancestor] != 0;
+		}
+		numExpected += bUnderMoved ? 1 : 0;
+	}
+	CHECK(hierarchy.Update() == numExpected);
+	CHECK(SameAsReference(hierarchy, reference));
+	CHECK(hierarchy.Update() == 0);
+
+	// Moved under other parents, keeping their locals, never under their own subtree.
+	for (uint32 i = 0; i < 300; ++i)
+	{
+		const int32 node = (int32)random.NextUInt(numNodes);
+		const int32 parent = (int32)random.NextUInt(numNodes);
+		if (reference.IsDescendant(parent, node))
+			continue;
+		hierarchy.SetParent(node, parent);
+		reference.Parents[node] = parent;
+	}
+	hierarchy.Update();
+	CHECK(SameAsReference(hierarchy, reference));
+
+	// Inner nodes removed, their children move up and keep their worlds.
+	for (uint32 i = 0; i < 300; ++i)
+	{
+		const int32 node = (int32)random.NextUInt(numNodes);
+		if (!reference.bAlive[node])
+			continue;
+
+		const XMMATRIX local = XMLoadFloat4x4(&reference.Locals[node]);
+		for (int32 child = 0; child < (int32)numNodes; ++child)
+		{
+			if (reference.bAlive[child] && reference.Parents[child] == node)
+			{
+				reference.Parents[child] = reference.Parents[node];
+				XMStoreFloat4x4(&reference.Locals[child], XMMatrixMultiply(XMLoadFloat4x4(&reference.Locals[child]), local));
+			}
+		}
+		hierarchy.Remove(node, false);
+		reference.bAlive[node] = 0;
+	}
+	hierarchy.Update();
+	CHECK(SameAsReference(hierarchy, reference));
+	CHECK(hierarchy.GetNumNodes() == (uint32)std::count(reference.bAlive.begin(), reference.bAlive.end(), 1));
+}
+
+TEST_CASE(TransformHierarchy_ReparentKeepsWorld)
+{
+	TestObject objects[3];
+	TransformHierarchy hierarchy;
+	const int32 a = hierarchy.Insert(TransformHierarchy::NullNode,
+		Matrix4(XMMatrixMultiply(XMMatrixMultiply(XMMatrixScaling(1.0f, 3.0f, 0.5f), XMMatrixRotationY(0.7f)), XMMatrixTranslation(5.0f, 0.0f, 0.0f))), &objects[0]);
+	const int32 b = hierarchy.Insert(TransformHierarchy::NullNode,
+		Matrix4(XMMatrixMultiply(XMMatrixRotationX(-1.2f), XMMatrixTranslation(0.0f, -4.0f, 2.0f))), &objects[1]);
+	const int32 c = hierarchy.Insert(a, Matrix4(XMMatrixMultiply(XMMatrixRotationZ(0.3f), XMMatrixTranslation(1.0f, 2.0f, 3.0f))), &objects[2]);
+	hierarchy.Update();
+	const XMMATRIX worldUnderA = hierarchy.GetWorld(c);
+
+	// Same place in the world, a new local relative to B, and from then on it moves with B.
+	hierarchy.SetParent(c, b, true);
+	CHECK(hierarchy.Update() == 1);
+	CHECK(hierarchy.GetParent(c) == b);
+	CHECK(NearlyEqual(hierarchy.GetWorld(c), worldUnderA));
+	CHECK(NearlyEqual(XMMatrixMultiply(hierarchy.GetLocal(c), hierarchy.GetWorld(b)), worldUnderA));
+
+	const XMMATRIX localUnderB = hierarchy.GetLocal(c);
+	hierarchy.SetLocal(b, Matrix4(XMMatrixTranslation(0.0f, 10.0f, 0.0f)));
+	CHECK(hierarchy.Update() == 2);
+	CHECK(NearlyEqual(hierarchy.GetWorld(c), XMMatrixMultiply(localUnderB, XMMatrixTranslation(0.0f, 10.0f, 0.0f))));
+
+	// To the root the local becomes the world.
+	const XMMATRIX worldUnderB = hierarchy.GetWorld(c);
+	hierarchy.SetParent(c, TransformHierarchy::NullNode, true);
+	hierarchy.Update();
+	CHECK(NearlyEqual(hierarchy.GetWorld(c), worldUnderB) && NearlyEqual(hierarchy.GetLocal(c), worldUnderB));
+
+	// Without bKeepWorld the local stays and the world follows the new parent.
+	const XMMATRIX local = hierarchy.GetLocal(c);
+	hierarchy.SetParent(c, a);
+	hierarchy.Update();
+	CHECK(NearlyEqual(hierarchy.GetLocal(c), local) && NearlyEqual(hierarchy.GetWorld(c), XMMatrixMultiply(local, hierarchy.GetWorld(a))));
+
+	// Removing the parent also keeps the world.
+	const XMMATRIX worldBeforeRemove = hierarchy.GetWorld(c);
+	hierarchy.Remove(a);
+	hierarchy.Update();
+	CHECK(hierarchy.GetParent(c) == TransformHierarchy::NullNode && NearlyEqual(hierarchy.GetWorld(c), worldBeforeRemove));
+}
+
+TEST_CASE(TransformHierarchy_PropagationBenchmark)
+{
+	// A million nodes, eight children each, seven levels deep.
+	const uint32 numNodes = 1000000;
+	TransformHierarchy hierarchy;
+	const Matrix4 local(XMMatrixMultiply(XMMatrixRotationY(0.01f), XMMatrixTranslation(0.0f, 0.0f, 1.0f)));
+	for (uint32 i = 0; i < numNodes; ++i)
+	{
+		hierarchy.Insert(i == 0 ? TransformHierarchy::NullNode : (int32)((i - 1) / 8), local);
+	}
+	const double firstMs = MeasureMs(1, [&]() { CHECK(hierarchy.Update() == numNodes); });
+
+	// The root moves, everything follows.
+	uint32 step = 0;
+	const double fullMs = MeasureMs(5, [&]()
+	{
+		hierarchy.SetLocal(0, Matrix4(XMMatrixTranslation((float)++step, 0.0f, 0.0f)));
+		CHECK(hierarchy.Update() == numNodes);
+	});
+
+	// A thousand leaves move, the rest of the hierarchy is skipped.
+	TestRandom random(3);
+	const double partialMs = MeasureMs(5, [&]()
+	{
+		for (uint32 i = 0; i < 1000; ++i)
+		{
+			hierarchy.SetLocal((int32)(numNodes - 1 - random.NextUInt(100000)), local);
+		}
+		CHECK(hierarchy.Update() <= 1000);
+	});
+
+	const uint32 numThreads = Utility::ThreadManager::JobSystem::Get().GetNumThreads();
+	Report("1M nodes, %u levels, %u threads: first update %.1f ms (sorting included), all moved %.2f ms, 1000 leaves %.3f ms",
+		hierarchy.GetNumLevels(), numThreads, firstMs, fullMs, partialMs);
+
+	// The request asks for a few milliseconds on 8 cores.
+	if (bCheckTimings && numThreads >= 8)
+	{
+		CHECK(fullMs < 10.0);
+	}
+	CHECK(partialMs < fullMs);
+}
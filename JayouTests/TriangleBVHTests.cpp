@@ -0,0 +1,173 @@
+//
+// TriangleBVHTests.cpp
+//
+
+#include "TestMeshes.h"
+#include "Core/Common/TriangleBVH.h"
+
+using namespace Tests;
+
+namespace
+{
+	// Every triangle against the ray, as AppEntry::Pick did before the BVH. Double sided, Moller-Trumbore.
+	void BruteForceHits(const GeometryData<Vertex>& InData, const XMFLOAT3& InOrigin, const XMFLOAT3& InDirection, std::vector<TriangleHit>& OutHits)
+	{
+		OutHits.clear();
+
+		const XMVECTOR origin = XMLoadFloat3(&InOrigin);
+		const XMVECTOR direction = XMLoadFloat3(&InDirection);
+		for (uint32 t = 0; t < (uint32)InData.Indices32.size() / 3; ++t)
+		{
+			const XMVECTOR p0 = XMLoadFloat3(&InData.Vertices[InData.Indices32[t * 3 + 0]].Position);
+			const XMVECTOR e1 = XMVectorSubtract(XMLoadFloat3(&InData.Vertices[InData.Indices32[t * 3 + 1]].Position), p0);
+			const XMVECTOR e2 = XMVectorSubtract(XMLoadFloat3(&InData.Vertices[InData.Indices32[t * 3 + 2]].Position), p0);
+
+			const XMVECTOR p = XMVector3Cross(direction, e2);
+			const float determinant = XMVectorGetX(XMVector3Dot(e1, p));
+			if (fabsf(determinant) < 1e-12f)
+				continue;
+
+			const float invDeterminant = 1.0f / determinant;
+			const XMVECTOR s = XMVectorSubtract(origin, p0);
+			const float u = XMVectorGetX(XMVector3Dot(s, p)) * invDeterminant;
+			if (u < 0.0f || u > 1.0f)
+				continue;
+
+			const XMVECTOR q = XMVector3Cross(s, e1);
+			const float v = XMVectorGetX(XMVector3Dot(direction, q)) * invDeterminant;
+			if (v < 0.0f || u + v > 1.0f)
+				continue;
+
+			const float distance = XMVectorGetX(XMVector3Dot(e2, q)) * invDeterminant;
+			if (distance < 0.0f)
+				continue;
+
+			TriangleHit hit;
+			hit.Distance = distance;
+			hit.Triangle = t;
+			hit.U = u;
+			hit.V = v;
+			OutHits.push_back(hit);
+		}
+
+		std::sort(OutHits.begin(), OutHits.end(), [](const TriangleHit& a, const TriangleHit& b) { return a.Distance < b.Distance; });
+	}
+
+	struct Ray
+	{
+		XMFLOAT3 Origin;
+		XMFLOAT3 Direction;
+	};
+
+	// From all around the unit meshes towards points inside them, and a few that miss.
+	std::vector<Ray> CreateRays(uint32 InCount, uint32 InSeed)
+	{
+		TestRandom random(InSeed);
+		std::vector<Ray> rays(InCount);
+		for (uint32 i = 0; i < InCount; ++i)
+		{
+			const XMVECTOR origin = XMVectorScale(XMVector3Normalize(XMVectorSet(random.NextFloat(-1, 1), random.NextFloat(-1, 1), random.NextFloat(-1, 1), 0.0f)), 4.0f);
+			const XMVECTOR target = i % 8 == 0 ?
+				XMVectorScale(origin, -2.0f + random.NextFloat(0.0f, 4.0f)) + XMVectorSet(random.NextFloat(-9, 9), random.NextFloat(-9, 9), random.NextFloat(-9, 9), 0.0f) :
+				XMVectorSet(random.NextFloat(-1, 1), random.NextFloat(-1, 1), random.NextFloat(-1, 1), 0.0f);
+
+			XMStoreFloat3(&rays[i].Origin, origin);
+			XMStoreFloat3(&rays[i].Direction, XMVectorSubtract(target, origin));
+		}
+		return rays;
+	}
+}
+
+TEST_CASE(TriangleBVH_MatchesBruteForce)
+{
+	for (TestMesh& mesh : CreateTestMeshes())
+	{
+		TriangleBVH bvh;
+		bvh.Build(mesh.Data.Vertices, mesh.Data.Indices32);
+		CHECK(bvh.GetNumTriangles() == mesh.Data.Indices32.size() / 3);
+
+		const std::vector<Ray> rays = CreateRays(500, 7);
+
+		uint32 numHits = 0;
+		bool bNearest = true, bAny = true, bAll = true, bLimited = true;
+		std::vector<TriangleHit> expected, hits;
+		for (const Ray& ray : rays)
+		{
+			BruteForceHits(mesh.Data, ray.Origin, ray.Direction, expected);
+			numHits += expected.empty() ? 0 : 1;
+
+			// The nearest distance, a ray through a shared edge may report either triangle.
+			TriangleHit nearest;
+			const bool bHit = bvh.IntersectNearest(ray.Origin, ray.Direction, nearest);
+			bNearest &= bHit == !expected.empty();
+			if (bHit && !expected.empty())
+			{
+				bNearest &= fabsf(nearest.Distance - expected[0].Distance) <= 1e-4f * (1.0f + expected[0].Distance);
+			}
+
+			bAny &= bvh.IntersectAny(ray.Origin, ray.Direction) == !expected.empty();
+
+			bvh.IntersectAll(ray.Origin, ray.Direction, hits);
+			bAll &= hits.size() == expected.size();
+			for (size_t i = 0; bAll && i < hits.size(); ++i)
+			{
+				bAll &= fabsf(hits[i].Distance - expected[i].Distance) <= 1e-4f * (1.0f + expected[i].Distance);
+			}
+
+			// Nothing at or beyond InMaxDistance.
+			if (!expected.empty())
+			{
+				const float maxDistance = expected[0].Distance * 0.5f;
+				bLimited &= !bvh.IntersectNearest(ray.Origin, ray.Direction, nearest, maxDistance);
+				bLimited &= !bvh.IntersectAny(ray.Origin, ray.Direction, maxDistance);
+			}
+		}
+		CHECK(bNearest);
+		CHECK(bAny);
+		CHECK(bAll);
+		CHECK(bLimited);
+		CHECK(numHits > rays.size() / 2);
+	}
+}
+
+TEST_CASE(TriangleBVH_Benchmark)
+{
+	// The kind of mesh a click lands on, 100k+ triangles.
+	GeometryData<Vertex> data = WinUtility::GeometryManager::GeometryCreator::CreateSphere(1.0f, 384, 256);
+	const uint32 numTriangles = (uint32)data.Indices32.size() / 3;
+
+	TriangleBVH bvh;
+	const double buildMs = MeasureMs(1, [&]() { bvh.Build(data.Vertices, data.Indices32); });
+
+	const std::vector<Ray> rays = CreateRays(200, 11);
+	std::vector<TriangleHit> hits;
+	const double bruteMs = MeasureMs(1, [&]()
+	{
+		for (const Ray& ray : rays)
+		{
+			BruteForceHits(data, ray.Origin, ray.Direction, hits);
+		}
+	});
+
+	TriangleHit hit;
+	uint32 numHits = 0;
+	const double bvhMs = MeasureMs(5, [&]()
+	{
+		numHits = 0;
+		for (const Ray& ray : rays)
+		{
+			numHits += bvh.IntersectNearest(ray.Origin, ray.Direction, hit) ? 1 : 0;
+		}
+	});
+
+	Report("%u tris, %u nodes, build %.1f ms", numTriangles, bvh.GetNumNodes(), buildMs);
+	Report("%u rays (%u hits): brute force %.3f ms/ray, BVH %.4f ms/ray, %.0fx", (uint32)rays.size(), numHits,
+		bruteMs / rays.size(), bvhMs / rays.size(), bruteMs / std::max(bvhMs, 1e-6));
+
+	// A pick must not stall the UI: well under a millisecond per ray, and far ahead of the loop it replaced.
+	if (bCheckTimings)
+	{
+		CHECK(bvhMs / rays.size() < 0.1);
+		CHECK(bruteMs > 20.0 * bvhMs);
+	}
+}
@@ -0,0 +1,160 @@
+//
+// VertexPackerTests.cpp
+//
+
+#include "TestMeshes.h"
+#include "Core/Common/VertexPacker.h"
+
+#include <limits>
+
+using namespace Tests;
+
+namespace
+{
+	XMFLOAT3 RandomDirection(TestRandom& InRandom)
+	{
+		for (;;)
+		{
+			const XMFLOAT3 v(InRandom.NextFloat(-1.0f, 1.0f), InRandom.NextFloat(-1.0f, 1.0f), InRandom.NextFloat(-1.0f, 1.0f));
+			const float lengthSq = v.x * v.x + v.y * v.y + v.z * v.z;
+			if (lengthSq > 1e-4f && lengthSq <= 1.0f)
+			{
+				const float invLength = 1.0f / sqrtf(lengthSq);
+				return XMFLOAT3(v.x * invLength, v.y * invLength, v.z * invLength);
+			}
+		}
+	}
+
+	// Random attributes in a box off the origin, UVs past 1 as tiling meshes have them.
+	std::vector<Vertex> CreateRandomVertices(uint32 InCount, uint32 InSeed)
+	{
+		TestRandom random(InSeed);
+		std::vector<Vertex> vertices(InCount);
+		for (Vertex& vertex : vertices)
+		{
+			vertex.Position = XMFLOAT3(random.NextFloat(-40.0f, 60.0f), random.NextFloat(5.0f, 7.0f), random.NextFloat(-0.5f, 0.5f));
+			vertex.Normal = RandomDirection(random);
+			vertex.TangentU = RandomDirection(random);
+			vertex.TexC = XMFLOAT2(random.NextFloat(-2.0f, 4.0f), random.NextFloat(0.0f, 1.0f));
+			vertex.Color = XMFLOAT4(random.NextFloat(), random.NextFloat(), random.NextFloat(), random.NextFloat());
+		}
+		return vertices;
+	}
+}
+
+TEST_CASE(VertexPacker_PositionErrorWithinStep)
+{
+	const std::vector<Vertex> vertices = CreateRandomVertices(100000, 1);
+	std::vector<PackedVertex> packed;
+	XMFLOAT3 scale, bias;
+	VertexPacker::PackVertices(vertices, packed, scale, bias);
+	std::vector<Vertex> unpacked;
+	VertexPacker::UnpackVertices(packed, scale, bias, unpacked);
+	CHECK(unpacked.size() == vertices.size());
+
+	// 16 bits over the bounds of the mesh, rounded, so at most half a step per axis (and a few float ulps).
+	const float step[3] = { scale.x / 65535.0f, scale.y / 65535.0f, scale.z / 65535.0f };
+	float worst[3] = {};
+	bool bWithinStep = true;
+	for (size_t i = 0; i < vertices.size(); ++i)
+	{
+		const float source[3] = { vertices[i].Position.x, vertices[i].Position.y, vertices[i].Position.z };
+		const float result[3] = { unpacked[i].Position.x, unpacked[i].Position.y, unpacked[i].Position.z };
+		for (uint32 axis = 0; axis < 3; ++axis)
+		{
+			const float error = fabsf(source[axis] - result[axis]);
+			worst[axis] = std::max(worst[axis], error / step[axis]);
+			bWithinStep &= error <= 0.5f * step[axis] + 4.0f * std::numeric_limits<float>::epsilon() * fabsf(source[axis]);
+		}
+	}
+	CHECK(bWithinStep);
+
+	const PackedVertexError error = VertexPacker::MeasureError(vertices, packed, scale, bias);
+	CHECK(error.Position <= 0.5f * sqrtf(step[0] * step[0] + step[1] * step[1] + step[2] * step[2]) * 1.01f);
+	Report("position: worst %.3f / %.3f / %.3f of a step, %.6f units", worst[0], worst[1], worst[2], error.Position);
+}
+
+TEST_CASE(VertexPacker_OctahedralAngleError)
+{
+	const std::vector<Vertex> vertices = CreateRandomVertices(100000, 2);
+	std::vector<PackedVertex> packed;
+	XMFLOAT3 scale, bias;
+	VertexPacker::PackVertices(vertices, packed, scale, bias);
+	const PackedVertexError error = VertexPacker::MeasureError(vertices, packed, scale, bias);
+
+	// Two snorm16, a cell of about 2 / 32767 on the octahedron, well under a hundredth of a degree.
+	CHECK(error.NormalAngle < 0.01f);
+	CHECK(error.TangentAngle < 0.01f);
+
+	// Axis aligned and octant edge directions, where the fold of the octahedron is.
+	std::vector<Vertex> edges(6);
+	const XMFLOAT3 directions[6] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+	for (uint32 i = 0; i < 6; ++i)
+	{
+		edges[i].Normal = directions[i];
+		edges[i].TangentU = XMFLOAT3(0.70710678f, 0.0f, directions[i].x != 0.0f ? 0.70710678f : -0.70710678f);
+	}
+	VertexPacker::PackVertices(edges, packed, scale, bias);
+	const PackedVertexError edgeError = VertexPacker::MeasureError(edges, packed, scale, bias);
+	CHECK(edgeError.NormalAngle < 0.01f && edgeError.TangentAngle < 0.01f);
+
+	Report("normal %.5f, tangent %.5f degrees, on the folds %.5f / %.5f", error.NormalAngle, error.TangentAngle, edgeError.NormalAngle, edgeError.TangentAngle);
+}
+
+TEST_CASE(VertexPacker_TexCoordAndColorError)
+{
+	const std::vector<Vertex> vertices = CreateRandomVertices(100000, 3);
+	std::vector<PackedVertex> packed;
+	XMFLOAT3 scale, bias;
+	VertexPacker::PackVertices(vertices, packed, scale, bias);
+	std::vector<Vertex> unpacked;
+	VertexPacker::UnpackVertices(packed, scale, bias, unpacked);
+
+	// Halves keep 11 significant bits, rounded: half an ulp, 2^-11 of the value at most. RGBA8 rounds to 1/255.
+	bool bTexC = true, bColor = true;
+	for (size_t i = 0; i < vertices.size(); ++i)
+	{
+		const XMFLOAT2& source = vertices[i].TexC;
+		const XMFLOAT2& result = unpacked[i].TexC;
+		bTexC &= fabsf(source.x - result.x) <= fabsf(source.x) / 2048.0f + 1e-7f && fabsf(source.y - result.y) <= fabsf(source.y) / 2048.0f + 1e-7f;
+
+		const XMFLOAT4& color = vertices[i].Color;
+		const XMFLOAT4& packedColor = unpacked[i].Color;
+		const float limit = 0.5f / 255.0f + 1e-6f;
+		bColor &= fabsf(color.x - packedColor.x) <= limit && fabsf(color.y - packedColor.y) <= limit &&
+			fabsf(color.z - packedColor.z) <= limit && fabsf(color.w - packedColor.w) <= limit;
+	}
+	CHECK(bTexC);
+	CHECK(bColor);
+
+	const PackedVertexError error = VertexPacker::MeasureError(vertices, packed, scale, bias);
+	CHECK(error.TexC <= 4.0f / 2048.0f);
+	CHECK(error.Color <= 0.5f / 255.0f + 1e-6f);
+	Report("UV %.6f (UVs up to 4), color %.6f", error.TexC, error.Color);
+}
+
+TEST_CASE(VertexPacker_16BitIndexSwitch)
+{
+	GeometryData<Vertex> data;
+	data.Vertices.resize(65535);
+	data.Indices32 = { 0, 1, 65534, 65534, 1, 2 };
+	CHECK(data.CanUse16BitIndices());
+
+	// The largest index survives the narrowing.
+	const std::vector<uint16>& indices16 = data.GetIndices16();
+	CHECK(indices16.size() == data.Indices32.size());
+	bool bSame = true;
+	for (size_t i = 0; i < indices16.size(); ++i)
+	{
+		bSame &= indices16[i] == data.Indices32[i];
+	}
+	CHECK(bSame);
+
+	data.Vertices.resize(65536);
+	CHECK(!data.CanUse16BitIndices());
+	data.Vertices.resize(200000);
+	CHECK(!data.CanUse16BitIndices());
+
+	GeometryData<Vertex> empty;
+	CHECK(empty.CanUse16BitIndices());
+}
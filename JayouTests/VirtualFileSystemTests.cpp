@@ -0,0 +1,364 @@
+//
+// VirtualFileSystemTests.cpp
+//
+
+#include "TestMeshes.h"
+#include "Core/Common/Compression.h"
+#include "Core/Common/VirtualFileSystem.h"
+
+#ifndef JAYOU_NO_ASSIMP
+#include "Core/Common/VFSIOSystem.h"
+
+#include <assimp/DefaultIOSystem.h>
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#endif
+
+#include <cstring>
+
+using namespace Tests;
+using namespace Utility;
+
+namespace
+{
+	// Text like data, repeats within a few hundred bytes as meshes and scene files have them.
+	std::vector<uint8> CreateCompressible(uint32 InSize)
+	{
+		static const char* words[] = { "vertex ", "normal ", "0.500000 ", "1.000000 ", "-0.250000 ", "face ", "\n" };
+		TestRandom random(7);
+		std::vector<uint8> data;
+		while (data.size() < InSize)
+		{
+			const char* word = words[random.NextUInt(7)];
+			data.insert(data.end(), word, word + strlen(word));
+		}
+		data.resize(InSize);
+		return data;
+	}
+
+	std::vector<uint8> CreateRandom(uint32 InSize, uint32 InSeed)
+	{
+		TestRandom random(InSeed);
+		std::vector<uint8> data(InSize);
+		for (uint8& byte : data)
+		{
+			byte = (uint8)random.NextUInt();
+		}
+		return data;
+	}
+
+	bool RoundTrip(const std::vector<uint8>& InData, uint64& OutCompressedSize)
+	{
+		std::vector<uint8> compressed(Compression::CompressBound(InData.size()));
+		OutCompressedSize = Compression::Compress(InData.data(), InData.size(), compressed.data(), compressed.size());
+		if (OutCompressedSize == 0 && !InData.empty())
+			return false;
+
+		std::vector<uint8> decompressed(InData.size());
+		return Compression::Decompress(compressed.data(), OutCompressedSize, decompressed.data(), decompressed.size()) && decompressed == InData;
+	}
+
+	bool WriteFile(const std::string& InPath, const std::vector<uint8>& InData)
+	{
+		FILE* file = fopen(InPath.c_str(), "wb");
+		if (file == nullptr)
+			return false;
+		const bool bWritten = fwrite(InData.data(), 1, InData.size(), file) == InData.size();
+		return fclose(file) == 0 && bWritten;
+	}
+
+	bool SameBytes(const VFSFile& InFile, const std::vector<uint8>& InData)
+	{
+		return InFile.GetSize() == InData.size() && memcmp(InFile.GetData(), InData.data(), InData.size()) == 0;
+	}
+}
+
+TEST_CASE(Compression_RoundTrip)
+{
+	uint64 compressedSize = 0;
+
+	const std::vector<uint8> text = CreateCompressible(1 << 20);
+	CHECK(RoundTrip(text, compressedSize));
+	CHECK(compressedSize < text.size() / 2);
+	Report("text: %u -> %u bytes", (uint32)text.size(), (uint32)compressedSize);
+
+	// Nothing to find, the literals come out a little larger but still within the bound.
+	const std::vector<uint8> noise = CreateRandom(1 << 20, 1);
+	CHECK(RoundTrip(noise, compressedSize));
+	CHECK(compressedSize <= Compression::CompressBound(noise.size()));
+	Report("noise: %u -> %u bytes", (uint32)noise.size(), (uint32)compressedSize);
+
+	// Runs overlap their own output, short inputs have no room for a match.
+	CHECK(RoundTrip(std::vector<uint8>(100000, 0x5a), compressedSize));
+	CHECK(compressedSize < 1000);
+	for (uint32 size : { 1u, 4u, 12u, 13u, 65u })
+	{
+		CHECK(RoundTrip(CreateCompressible(size), compressedSize));
+	}
+}
+
+TEST_CASE(Compression_RejectsDamagedBlocks)
+{
+	const std::vector<uint8> text = CreateCompressible(64 * 1024);
+	std::vector<uint8> compressed(Compression::CompressBound(text.size()));
+	compressed.resize(Compression::Compress(text.data(), text.size(), compressed.data(), compressed.size()));
+	std::vector<uint8> output(text.size());
+
+	// Cut short anywhere, or told the wrong size.
+	bool bTruncated = false;
+	for (size_t size : { compressed.size() - 1, compressed.size() / 2, (size_t)1 })
+	{
+		bTruncated |= Compression::Decompress(compressed.data(), size, output.data(), output.size());
+	}
+	CHECK(!bTruncated);
+	CHECK(!Compression::Decompress(compressed.data(), compressed.size(), output.data(), output.size() - 1));
+	std::vector<uint8> larger(text.size() + 1);
+	CHECK(!Compression::Decompress(compressed.data(), compressed.size(), larger.data(), larger.size()));
+
+	// A match before the start of the output, a zero offset, literals past the end of the block.
+	const uint8 beforeStart[] = { 0x00, 0x01, 0x00, 0x10, 'a' };
+	const uint8 zeroOffset[] = { 0x10, 'a', 0x00, 0x00, 0x10, 'a' };
+	const uint8 longLiterals[] = { 0x50, 'a', 'b' };
+	const uint8 missingLength[] = { 0xf0 };
+	CHECK(!Compression::Decompress(beforeStart, sizeof(beforeStart), output.data(), 5));
+	CHECK(!Compression::Decompress(zeroOffset, sizeof(zeroOffset), output.data(), 6));
+	CHECK(!Compression::Decompress(longLiterals, sizeof(longLiterals), output.data(), 5));
+	CHECK(!Compression::Decompress(missingLength, sizeof(missingLength), output.data(), 15));
+
+	// Random damage must never read or write out of bounds, whether or not it is noticed.
+	TestRandom random(3);
+	uint32 numRejected = 0;
+	for (uint32 i = 0; i < 1000; ++i)
+	{
+		std::vector<uint8> damaged = compressed;
+		for (uint32 k = 0; k < 4; ++k)
+		{
+			damaged[random.NextUInt((uint32)damaged.size())] = (uint8)random.NextUInt();
+		}
+		numRejected += Compression::Decompress(damaged.data(), damaged.size(), output.data(), output.size()) ? 0 : 1;
+	}
+	Report("%u of 1000 randomly damaged blocks rejected", numRejected);
+}
+
+TEST_CASE(PakArchive_BuildLookupAndRead)
+{
+	// Flat in the working directory, packed from ".".
+	const std::vector<uint8> text = CreateCompressible(300000);
+	const std::vector<uint8> noise = CreateRandom(200000, 2);
+	const std::vector<uint8> small = CreateRandom(10, 3);
+	const std::vector<std::string> files = { "JayouTests_Pak_Text.obj", "JayouTests_Pak_Noise.bin", "JayouTests_Pak_Small.bin" };
+	CHECK(WriteFile(files[0], text) && WriteFile(files[1], noise) && WriteFile(files[2], small));
+
+	const std::string pakPath = "JayouTests_Pak.pak";
+	std::string error;
+	CHECK(PakArchive::Build(pakPath, ".", files, true, error));
+
+	{
+		PakArchive archive;
+		CHECK(archive.Open(pakPath));
+		CHECK(archive.GetNumEntries() == 3);
+
+		// However the name is spelled.
+		CHECK(archive.Contains("JayouTests_Pak_Text.obj") && archive.Contains("./jayoutests_pak_text.OBJ") && archive.Contains(".\\JayouTests_Pak_Noise.bin"));
+		CHECK(!archive.Contains("JayouTests_Pak_Text") && !archive.Contains("JayouTests_Pak_Missing.bin"));
+
+		// Noise is stored as is and read without a copy, straight from the mapping.
+		VFSFile file;
+		CHECK(archive.Read("JayouTests_Pak_Noise.bin", file));
+		CHECK(SameBytes(file, noise));
+		CHECK(file.IsMapped());
+		CHECK(file.GetData() >= archive.GetData() && file.GetData() + file.GetSize() <= archive.GetData() + archive.GetSize());
+		CHECK((uint64)(file.GetData() - archive.GetData()) % PakArchive::Alignment == 0);
+
+		// The text is compressed and decompressed on read.
+		VFSFile compressed;
+		CHECK(archive.Read("JayouTests_Pak_Text.obj", compressed));
+		CHECK(SameBytes(compressed, text));
+		CHECK(!compressed.IsMapped());
+		CHECK(archive.GetSize() < text.size() + noise.size());
+
+		VFSFile tiny;
+		CHECK(archive.Read("JayouTests_Pak_Small.bin", tiny) && SameBytes(tiny, small));
+
+		std::vector<std::string> names;
+		archive.ListFiles("", names);
+		CHECK(names.size() == 3);
+
+		const double lookupMs = MeasureMs(5, [&]()
+		{
+			uint32 found = 0;
+			for (uint32 i = 0; i < 100000; ++i)
+			{
+				found += archive.Contains(files[i % 3]) ? 1 : 0;
+			}
+			CHECK(found == 100000);
+		});
+		Report("archive %u bytes for %u, 100k lookups %.2f ms", (uint32)archive.GetSize(), (uint32)(text.size() + noise.size() + small.size()), lookupMs);
+	}
+
+	// Through the file system, under the archive path without its extension. The file outlives the mount.
+	VFSFile mounted;
+	CHECK(VirtualFileSystem::Get().Mount(pakPath));
+	CHECK(VirtualFileSystem::Get().IsPacked("JayouTests_Pak/JayouTests_Pak_Noise.bin"));
+	CHECK(VirtualFileSystem::Get().ReadFile("JayouTests_Pak/JayouTests_Pak_Noise.bin", mounted));
+	VirtualFileSystem::Get().UnmountAll();
+	CHECK(SameBytes(mounted, noise) && mounted.IsMapped());
+	mounted.Close();
+
+	// A damaged table of contents does not open.
+	std::vector<uint8> damaged;
+	{
+		MappedFile pak;
+		CHECK(pak.Open(pakPath));
+		damaged.assign(pak.GetData(), pak.GetData() + pak.GetSize());
+	}
+	damaged.resize(40);
+	CHECK(WriteFile(pakPath, damaged));
+	PakArchive truncated;
+	CHECK(!truncated.Open(pakPath));
+
+	remove(pakPath.c_str());
+	for (const std::string& file : files)
+	{
+		remove(file.c_str());
+	}
+}
+
+#ifndef JAYOU_NO_ASSIMP
+
+TEST_CASE(VFSIOStream_ReadSeekTell)
+{
+	const std::vector<uint8> data = CreateRandom(10, 4);
+	const std::string path = "JayouTests_IOStream.bin";
+	CHECK(WriteFile(path, data));
+
+	Core::VFSIOSystem system;
+	CHECK(system.Exists(path.c_str()) && !system.Exists("JayouTests_Missing.bin"));
+	CHECK(system.Open("JayouTests_Missing.bin") == nullptr);
+	CHECK(system.Open(path.c_str(), "wb") == nullptr && system.Open(path.c_str(), "ab") == nullptr);
+
+	Assimp::IOStream* stream = system.Open(path.c_str());
+	CHECK(stream != nullptr);
+	if (stream == nullptr)
+		return;
+	CHECK(stream->FileSize() == 10 && stream->Tell() == 0);
+
+	// As fread: whole elements are counted, a partial one at the end is read but not counted, nothing past the end.
+	uint8 buffer[16] = {};
+	CHECK(stream->Read(buffer, 4, 2) == 2 && stream->Tell() == 8 && memcmp(buffer, data.data(), 8) == 0);
+	memset(buffer, 0, sizeof(buffer));
+	CHECK(stream->Read(buffer, 4, 1) == 0 && stream->Tell() == 10 && memcmp(buffer, &data[8], 2) == 0 && buffer[2] == 0);
+	CHECK(stream->Read(buffer, 1, 4) == 0 && stream->Tell() == 10);
+	CHECK(stream->Read(buffer, 0, 4) == 0);
+	CHECK(stream->Write(buffer, 1, 4) == 0);
+
+	// Negative offsets come in wrapped around, as Assimp passes them.
+	CHECK(stream->Seek((size_t)-3, aiOrigin_END) == aiReturn_SUCCESS && stream->Tell() == 7);
+	CHECK(stream->Read(buffer, 1, 16) == 3 && memcmp(buffer, &data[7], 3) == 0);
+	CHECK(stream->Seek(0, aiOrigin_END) == aiReturn_SUCCESS && stream->Tell() == 10);
+	CHECK(stream->Seek((size_t)-4, aiOrigin_CUR) == aiReturn_SUCCESS && stream->Tell() == 6);
+	CHECK(stream->Seek(2, aiOrigin_CUR) == aiReturn_SUCCESS && stream->Tell() == 8);
+	CHECK(stream->Seek(0, aiOrigin_SET) == aiReturn_SUCCESS && stream->Tell() == 0);
+
+	// Out of range either way fails and leaves the position alone.
+	CHECK(stream->Seek(5, aiOrigin_SET) == aiReturn_SUCCESS);
+	CHECK(stream->Seek(11, aiOrigin_SET) == aiReturn_FAILURE && stream->Tell() == 5);
+	CHECK(stream->Seek(1, aiOrigin_END) == aiReturn_FAILURE && stream->Tell() == 5);
+	CHECK(stream->Seek((size_t)-11, aiOrigin_END) == aiReturn_FAILURE && stream->Tell() == 5);
+	CHECK(stream->Seek((size_t)-6, aiOrigin_CUR) == aiReturn_FAILURE && stream->Tell() == 5);
+	CHECK(stream->Seek(6, aiOrigin_CUR) == aiReturn_FAILURE && stream->Tell() == 5);
+	system.Close(stream);
+
+	remove(path.c_str());
+}
+
+TEST_CASE(VFSIOSystem_ImportsObjAndMtlFromPak)
+{
+	// The model references its materials by a name relative to itself, both only exist inside the archive.
+	const std::string objPath = "JayouTests_IOModel.obj", mtlPath = "JayouTests_IOModel.mtl";
+	CHECK(WriteObj(objPath, CreateTestMeshes()));
+	const std::string mtl = "newmtl Red\nKd 1 0 0\n\nnewmtl Green\nKd 0 1 0\n";
+	CHECK(WriteFile(mtlPath, std::vector<uint8>(mtl.begin(), mtl.end())));
+	{
+		MappedFile obj;
+		CHECK(obj.Open(objPath));
+		std::string text = "mtllib JayouTests_IOModel.mtl\nusemtl Red\n";
+		text.append((const char*)obj.GetData(), (size_t)obj.GetSize());
+		obj.Close();
+		CHECK(WriteFile(objPath, std::vector<uint8>(text.begin(), text.end())));
+	}
+
+	const std::string pakPath = "JayouTests_IOPak.pak";
+	std::string error;
+	CHECK(PakArchive::Build(pakPath, ".", { objPath, mtlPath }, true, error));
+	remove(objPath.c_str());
+	remove(mtlPath.c_str());
+	CHECK(VirtualFileSystem::Get().Mount(pakPath));
+
+	Assimp::Importer importer;
+	importer.SetIOHandler(new Core::VFSIOSystem());
+	CHECK(importer.GetIOHandler()->ComparePaths("JayouTests_IOPak/JayouTests_IOModel.obj", "jayoutests_iopak\\JayouTests_IOModel.OBJ"));
+	const aiScene* scene = importer.ReadFile("JayouTests_IOPak/JayouTests_IOModel.obj", aiProcess_Triangulate);
+	CHECK(scene != nullptr);
+	if (scene != nullptr)
+	{
+		CHECK(scene->mNumMeshes == (uint32)CreateTestMeshes().size());
+
+		// Read from the .mtl next to the model, Assimp adds its default material on top.
+		bool bFoundRed = false;
+		for (uint32 i = 0; i < scene->mNumMaterials; ++i)
+		{
+			aiString name;
+			aiColor3D diffuse;
+			scene->mMaterials[i]->Get(AI_MATKEY_NAME, name);
+			scene->mMaterials[i]->Get(AI_MATKEY_COLOR_DIFFUSE, diffuse);
+			bFoundRed |= strcmp(name.C_Str(), "Red") == 0 && diffuse.r == 1.0f && diffuse.g == 0.0f;
+		}
+		CHECK(bFoundRed && scene->mNumMaterials >= 2);
+	}
+
+	importer.FreeScene();
+	VirtualFileSystem::Get().UnmountAll();
+	remove(pakPath.c_str());
+}
+
+TEST_CASE(VFSIOSystem_ReadSpeed)
+{
+	const std::string path = "JayouTests_IOSpeed.obj";
+	std::vector<TestMesh> meshes;
+	meshes.push_back({ "Grid", WinUtility::GeometryManager::GeometryCreator::CreatePlane(100.0f, 100.0f, 400, 400) });
+	CHECK(WriteObj(path, meshes));
+
+	// The same loose file, once through fread buffers and once out of the mapping.
+	auto import = [&](Assimp::IOSystem* InSystem)
+	{
+		Assimp::Importer importer;
+		importer.SetIOHandler(InSystem);
+		CHECK(importer.ReadFile(path, 0) != nullptr);
+	};
+	const double defaultMs = MeasureMs(3, [&]() { import(new Assimp::DefaultIOSystem()); });
+	const double vfsMs = MeasureMs(3, [&]() { import(new Core::VFSIOSystem()); });
+
+	// Raw reads without the parser, 64 KB at a time as the OBJ loader streams.
+	auto readAll = [&](Assimp::IOSystem& InSystem)
+	{
+		Assimp::IOStream* stream = InSystem.Open(path.c_str());
+		std::vector<uint8> buffer(64 * 1024);
+		size_t total = 0;
+		while (size_t count = stream->Read(buffer.data(), 1, buffer.size()))
+		{
+			total += count;
+		}
+		CHECK(total == stream->FileSize());
+		InSystem.Close(stream);
+	};
+	Assimp::DefaultIOSystem defaultSystem;
+	Core::VFSIOSystem vfsSystem;
+	const double defaultReadMs = MeasureMs(5, [&]() { readAll(defaultSystem); });
+	const double vfsReadMs = MeasureMs(5, [&]() { readAll(vfsSystem); });
+
+	Report("OBJ import %.0f ms DefaultIOSystem, %.0f ms VFSIOSystem; reading it %.2f / %.2f ms", defaultMs, vfsMs, defaultReadMs, vfsReadMs);
+	remove(path.c_str());
+}
+
+#endif // JAYOU_NO_ASSIMP